@@ -229,6 +229,10 @@ typedef struct {
     int             hashSize;                   // hash table size (power of 2)
     fileInPack_t*   *hashTable;                 // hash table
     fileInPack_t*   buildBuffer;                // buffer with the filenames etc.
+    int             *headerLongs;               // checksum feed followed by the file crcs
+    int             numHeaderLongs;
+    int             fileSize;                   // pk3 size and mtime, -1 if not cacheable
+    int             fileTime;
 } pack_t;
 
 typedef struct {
@@ -283,11 +287,24 @@ typedef struct {
     int         zipFilePos;
     int         zipFileLen;
     qboolean    zipFile;
+    pack_t      *zipPak;        // pak the zip file was opened from
     char        name[MAX_ZPATH];
 } fileHandleData_t;
 
 static fileHandleData_t fsh[MAX_FILE_HANDLES];
 
+// files handed out by FS_ReadFile as views of the file on disk
+#define MAX_FILE_MAPPINGS   64
+
+typedef struct {
+    void        *data;          // what the caller got
+    void        *mapBase;
+    int         mapSize;
+} fileMapping_t;
+
+static fileMapping_t    fs_mappings[MAX_FILE_MAPPINGS];
+static cvar_t           *fs_mmapMinSize;
+
 // TTimo - https://zerowing.idsoftware.com/bugzilla/show_bug.cgi?id=540
 // wether we did a reorder on the current search path when joining the server
 static qboolean fs_reordered;
@@ -391,6 +408,229 @@ static long FS_HashFileName( const char *fname, int hashSize ) {
     return hash;
 }
 
+/*
+=================================================================================
+
+GLOBAL FILE INDEX
+
+Maps every file found in a pk3 to the first search path that provides it,
+so that a lookup doesn't have to probe the hash of every single pak.
+Loose files in directories are still checked on disk, but lookups that
+fail everywhere are remembered in a small miss cache until something is
+written through the filesystem or the search paths change.
+
+=================================================================================
+*/
+
+#define FS_MISSCACHE_SIZE   2048
+
+typedef struct fileIndexEntry_s {
+    const char                  *name;          // points into the pak buildBuffer
+    searchpath_t                *search;        // first pak search path containing the file
+    searchpath_t                *pureSearch;    // first pure pak containing it, NULL if none
+    struct fileIndexEntry_s     *next;
+} fileIndexEntry_t;
+
+typedef struct {
+    long        hash;
+    char        *name;
+} fileMissEntry_t;
+
+static fileIndexEntry_t     *fs_indexEntries;
+static fileIndexEntry_t     **fs_indexTable;
+static int                  fs_indexSize;           // hash table size (power of 2)
+static int                  fs_numIndexEntries;
+
+static fileMissEntry_t      fs_missCache[FS_MISSCACHE_SIZE];
+static int                  fs_indexHits;
+static int                  fs_missHits;
+
+/*
+================
+FS_HashIndexName
+
+Full path hash, extension included, ignoring case and separator
+distinctions the same way FS_FilenameCompare does.
+================
+*/
+static long FS_HashIndexName( const char *fname ) {
+    unsigned long   hash;
+    int             c;
+
+    hash = 5381;
+    while ( ( c = *fname++ ) != '\0' ) {
+        if ( c >= 'A' && c <= 'Z' ) {
+            c += 'a' - 'A';
+        }
+        if ( c == '\\' || c == ':' ) {
+            c = '/';
+        }
+        hash = ( hash << 5 ) + hash + c;
+    }
+    return (long)( hash & 0x7fffffff );
+}
+
+/*
+================
+FS_FlushMissCache
+
+Forget every cached miss, called whenever a file may have appeared
+================
+*/
+static void FS_FlushMissCache( void ) {
+    int     i;
+
+    for ( i = 0 ; i < FS_MISSCACHE_SIZE ; i++ ) {
+        if ( fs_missCache[i].name ) {
+            Z_Free( fs_missCache[i].name );
+            fs_missCache[i].name = NULL;
+        }
+    }
+}
+
+static qboolean FS_IsCachedMiss( const char *filename, long hash ) {
+    fileMissEntry_t *miss;
+
+    miss = &fs_missCache[hash & ( FS_MISSCACHE_SIZE - 1 )];
+    return miss->name && miss->hash == hash && !FS_FilenameCompare( miss->name, filename );
+}
+
+static void FS_AddCachedMiss( const char *filename, long hash ) {
+    fileMissEntry_t *miss;
+
+    miss = &fs_missCache[hash & ( FS_MISSCACHE_SIZE - 1 )];
+    if ( miss->name ) {
+        Z_Free( miss->name );
+    }
+    miss->hash = hash;
+    miss->name = CopyString( filename );
+}
+
+/*
+================
+FS_FreeFileIndex
+================
+*/
+static void FS_FreeFileIndex( void ) {
+    if ( fs_indexEntries ) {
+        Z_Free( fs_indexEntries );
+    }
+    if ( fs_indexTable ) {
+        Z_Free( fs_indexTable );
+    }
+    fs_indexEntries = NULL;
+    fs_indexTable = NULL;
+    fs_indexSize = 0;
+    fs_numIndexEntries = 0;
+
+    FS_FlushMissCache();
+}
+
+/*
+================
+FS_BuildFileIndex
+
+Walks the search paths in priority order and records the winning pak
+for every file name. Must be redone whenever the search order or the
+pure pak list changes.
+================
+*/
+static void FS_BuildFileIndex( void ) {
+    searchpath_t        *search;
+    pack_t              *pak;
+    fileIndexEntry_t    *entry;
+    qboolean            pure;
+    long                hash;
+    int                 i;
+
+    FS_FreeFileIndex();
+
+    if ( !fs_packFiles ) {
+        return;
+    }
+
+    for ( fs_indexSize = 1; fs_indexSize < fs_packFiles; fs_indexSize <<= 1 ) {
+    }
+
+    fs_indexEntries = Z_Malloc( fs_packFiles * sizeof( *fs_indexEntries ) );
+    fs_indexTable = Z_Malloc( fs_indexSize * sizeof( *fs_indexTable ) );
+
+    for ( search = fs_searchpaths ; search ; search = search->next ) {
+        if ( !search->pack ) {
+            continue;
+        }
+
+        pak = search->pack;
+        pure = FS_PakIsPure( pak );
+
+        for ( i = 0 ; i < pak->numfiles ; i++ ) {
+            if ( !pak->buildBuffer[i].name ) {
+                continue;
+            }
+
+            hash = FS_HashIndexName( pak->buildBuffer[i].name ) & ( fs_indexSize - 1 );
+
+            for ( entry = fs_indexTable[hash] ; entry ; entry = entry->next ) {
+                if ( !FS_FilenameCompare( entry->name, pak->buildBuffer[i].name ) ) {
+                    break;
+                }
+            }
+
+            if ( !entry ) {
+                if ( fs_numIndexEntries >= fs_packFiles ) {
+                    continue;
+                }
+                entry = &fs_indexEntries[fs_numIndexEntries++];
+                entry->name = pak->buildBuffer[i].name;
+                entry->search = search;
+                entry->next = fs_indexTable[hash];
+                fs_indexTable[hash] = entry;
+            }
+
+            if ( pure && !entry->pureSearch ) {
+                entry->pureSearch = search;
+            }
+        }
+    }
+}
+
+/*
+================
+FS_IndexLookup
+
+Returns the index entry for a file, or NULL if no pak contains it
+================
+*/
+static fileIndexEntry_t *FS_IndexLookup( const char *filename, long hash ) {
+    fileIndexEntry_t    *entry;
+
+    for ( entry = fs_indexTable[hash & ( fs_indexSize - 1 )] ; entry ; entry = entry->next ) {
+        if ( !FS_FilenameCompare( entry->name, filename ) ) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/*
+=================
+FS_PakHandle
+
+Paks set up from the directory cache open their zip on first use
+=================
+*/
+static unzFile FS_PakHandle( pack_t *pak )
+{
+    if ( !pak->handle ) {
+        pak->handle = unzOpen( pak->pakFilename );
+
+        if ( !pak->handle ) {
+            Com_Error( ERR_FATAL, "Couldn't open %s", pak->pakFilename );
+        }
+    }
+    return pak->handle;
+}
+
 static fileHandle_t FS_HandleForFile(void) {
     int     i;
 
@@ -682,6 +922,7 @@ fileHandle_t FS_SV_FOpenFileWrite( const char *filename ) {
     }
 
     FS_CheckFilenameIsMutable( ospath, __func__ );
+    FS_FlushMissCache();
 
     if( FS_CreatePath( ospath ) ) {
         return 0;
@@ -826,6 +1067,7 @@ void FS_SV_Rename( const char *from, const char *to, qboolean safe ) {
     if ( safe ) {
         FS_CheckFilenameIsMutable( to_ospath, __func__ );
     }
+    FS_FlushMissCache();
 
     rename(from_ospath, to_ospath);
 }
@@ -856,6 +1098,7 @@ void FS_Rename( const char *from, const char *to ) {
     }
 
     FS_CheckFilenameIsMutable( to_ospath, __func__ );
+    FS_FlushMissCache();
 
     rename(from_ospath, to_ospath);
 }
@@ -915,6 +1158,7 @@ fileHandle_t FS_FOpenFileWrite( const char *filename ) {
     }
 
     FS_CheckFilenameIsMutable( ospath, __func__ );
+    FS_FlushMissCache();
 
     if( FS_CreatePath( ospath ) ) {
         return 0;
@@ -963,6 +1207,7 @@ fileHandle_t FS_FOpenFileAppend( const char *filename ) {
     }
 
     FS_CheckFilenameIsMutable( ospath, __func__ );
+    FS_FlushMissCache();
 
     if( FS_CreatePath( ospath ) ) {
         return 0;
@@ -1006,6 +1251,7 @@ fileHandle_t FS_FCreateOpenPipeFile( const char *filename ) {
     }
 
     FS_CheckFilenameIsMutable( ospath, __func__ );
+    FS_FlushMissCache();
 
     fifo = Sys_Mkfifo( ospath );
     if( fifo ) {
@@ -1116,6 +1362,22 @@ qboolean FS_IsDemoExt(const char *filename, int namelen)
     return qfalse;
 }
 
+/*
+===========
+FS_IsPureExempt
+
+Loose files a pure server still lets clients read from a directory
+===========
+*/
+static qboolean FS_IsPureExempt(const char *filename, int len)
+{
+    return FS_IsExt(filename, ".cfg", len) ||       // for config files
+           FS_IsExt(filename, ".menu", len) ||      // menu files
+           FS_IsExt(filename, ".game", len) ||      // menu files
+           FS_IsExt(filename, ".dat", len) ||       // for journal files
+           FS_IsDemoExt(filename, len);             // demos
+}
+
 /*
 ===========
 FS_FOpenFileReadDir
@@ -1288,10 +1550,11 @@ long FS_FOpenFileReadDir(const char *filename, searchpath_t *search, fileHandle_
                             Com_Error(ERR_FATAL, "Couldn't open %s", pak->pakFilename);
                     }
                     else
-                        fsh[*file].handleFiles.file.z = pak->handle;
+                        fsh[*file].handleFiles.file.z = FS_PakHandle(pak);
 
                     Q_strncpyz(fsh[*file].name, filename, sizeof(fsh[*file].name));
                     fsh[*file].zipFile = qtrue;
+                    fsh[*file].zipPak = pak;
 
                     // set the file position in the zip file (also sets the current file info)
                     unzSetOffset(fsh[*file].handleFiles.file.z, pakFile->pos);
@@ -1326,17 +1589,10 @@ long FS_FOpenFileReadDir(const char *filename, searchpath_t *search, fileHandle_
         //   this test can make the search fail although the file is in the directory
         // I had the problem on https://zerowing.idsoftware.com/bugzilla/show_bug.cgi?id=8
         // turned out I used FS_FileExists instead
-        if(!unpure && fs_numServerPaks)
+        if(!unpure && fs_numServerPaks && !FS_IsPureExempt(filename, len))
         {
-            if(!FS_IsExt(filename, ".cfg", len) &&      // for config files
-               !FS_IsExt(filename, ".menu", len) &&     // menu files
-               !FS_IsExt(filename, ".game", len) &&     // menu files
-               !FS_IsExt(filename, ".dat", len) &&      // for journal files
-               !FS_IsDemoExt(filename, len))            // demos
-            {
-                *file = 0;
-                return -1;
-            }
+            *file = 0;
+            return -1;
         }
 
         dir = search->dir;
@@ -1379,13 +1635,42 @@ separate file or a ZIP file.
 */
 long FS_FOpenFileRead(const char *filename, fileHandle_t *file, qboolean uniqueFILE)
 {
-    searchpath_t *search;
-    long len;
+    searchpath_t *search, *winner;
+    fileIndexEntry_t *entry;
+    const char *qpath;
+    long len, hash;
     qboolean isLocalConfig;
 
     if(!fs_searchpaths)
         Com_Error(ERR_FATAL, "Filesystem call made without initialization");
 
+    if(filename == NULL)
+        Com_Error(ERR_FATAL, "FS_FOpenFileRead: NULL 'filename' parameter passed");
+
+    // qpaths are not supposed to have a leading slash
+    qpath = filename;
+    if(qpath[0] == '/' || qpath[0] == '\\')
+        qpath++;
+
+    hash = FS_HashIndexName(qpath);
+
+    if(FS_IsCachedMiss(qpath, hash))
+    {
+        fs_missHits++;
+        goto notfound;
+    }
+
+    // only the pak the index picked needs to be looked at, existence checks
+    // don't care about purity while opening does
+    entry = fs_indexTable ? FS_IndexLookup(qpath, hash) : NULL;
+    if(entry)
+    {
+        winner = file ? entry->pureSearch : entry->search;
+        fs_indexHits++;
+    }
+    else
+        winner = NULL;
+
     isLocalConfig = !strcmp(filename, "autoexec.cfg") || !strcmp(filename, Q3CONFIG_CFG);
     for(search = fs_searchpaths; search; search = search->next)
     {
@@ -1393,6 +1678,9 @@ long FS_FOpenFileRead(const char *filename, fileHandle_t *file, qboolean uniqueF
         if (isLocalConfig && search->pack)
             continue;
 
+        if (search->pack && search != winner)
+            continue;
+
         len = FS_FOpenFileReadDir(filename, search, file, uniqueFILE, qfalse);
 
         if(file == NULL)
@@ -1408,6 +1696,13 @@ long FS_FOpenFileRead(const char *filename, fileHandle_t *file, qboolean uniqueF
 
     }
 
+    // only remember names no pak knows about, a pak that merely failed the
+    // pure check may still satisfy an existence query.  The same goes for
+    // directories an open on a pure server did not look in.
+    if(!entry && (!file || !fs_numServerPaks || FS_IsPureExempt(qpath, strlen(qpath))))
+        FS_AddCachedMiss(qpath, hash);
+
+notfound:
 #ifdef FS_MISSING
     if(missingFiles)
         fprintf(missingFiles, "%s\n", filename);
@@ -1743,7 +2038,16 @@ CONVENIENCE FUNCTIONS FOR ENTIRE FILES
 ======================================================================================
 */
 
-int FS_FileIsInPAK(const char *filename, int *pChecksum ) {
+/*
+===========
+FS_FindPakForFile
+
+Returns the first pure-allowed pak holding the file, or NULL.  With
+loose set a directory earlier in the search path that a read would
+take the file from ends the search as well.
+===========
+*/
+static pack_t *FS_FindPakForFile( const char *filename, qboolean loose ) {
     searchpath_t    *search;
     pack_t          *pak;
     fileInPack_t    *pakFile;
@@ -1766,7 +2070,7 @@ int FS_FileIsInPAK(const char *filename, int *pChecksum ) {
     // The searchpaths do guarantee that something will always
     // be prepended, so we don't need to worry about "c:" or "//limbo"
     if ( strstr( filename, ".." ) || strstr( filename, "::" ) ) {
-        return -1;
+        return NULL;
     }
 
     //
@@ -1774,6 +2078,10 @@ int FS_FileIsInPAK(const char *filename, int *pChecksum ) {
     //
 
     for ( search = fs_searchpaths ; search ; search = search->next ) {
+        if ( loose && search->dir && ( !fs_numServerPaks || FS_IsPureExempt( filename, strlen( filename ) ) )
+            && FS_FOpenFileReadDir( filename, search, NULL, qfalse, qfalse ) > 0 ) {
+            return NULL;
+        }
         //
         if (search->pack) {
             hash = FS_HashFileName(filename, search->pack->hashSize);
@@ -1791,16 +2099,112 @@ int FS_FileIsInPAK(const char *filename, int *pChecksum ) {
             do {
                 // case and separator insensitive comparisons
                 if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
-                    if (pChecksum) {
-                        *pChecksum = pak->pure_checksum;
-                    }
-                    return 1;
+                    return pak;
                 }
                 pakFile = pakFile->next;
             } while(pakFile != NULL);
         }
     }
-    return -1;
+    return NULL;
+}
+
+int FS_FileIsInPAK(const char *filename, int *pChecksum ) {
+    pack_t  *pak;
+
+    pak = FS_FindPakForFile( filename, qfalse );
+    if ( !pak ) {
+        return -1;
+    }
+
+    if (pChecksum) {
+        *pChecksum = pak->pure_checksum;
+    }
+    return 1;
+}
+
+/*
+===========
+FS_FilePakName
+
+Returns "game/pak" for the pak a file is read from, or NULL if it is
+read from a directory or not found.  The regular checksum, unlike the pure one, does not change
+with the server.
+===========
+*/
+const char *FS_FilePakName( const char *filename, int *pChecksum ) {
+    static char name[MAX_OSPATH * 2 + 1];
+    pack_t      *pak;
+
+    pak = FS_FindPakForFile( filename, qtrue );
+    if ( !pak ) {
+        return NULL;
+    }
+
+    if ( pChecksum ) {
+        *pChecksum = pak->checksum;
+    }
+    Com_sprintf( name, sizeof( name ), "%s/%s", pak->pakGamename, pak->pakBasename );
+    return name;
+}
+
+/*
+============
+FS_MapFileData
+
+Hands out the data of an open file as a copy-on-write view of the file
+on disk instead of reading it into a buffer. Only pk3 entries that are
+stored uncompressed qualify, compressed entries still have to be
+inflated. Loose files are always read: they get edited during a session,
+and a mapped file that shrinks raises SIGBUS instead of a read error.
+Returns NULL when the file has to be read normally.
+============
+*/
+static byte *FS_MapFileData( fileHandle_t h, long len )
+{
+    fileMapping_t   *map;
+    FILE            *f;
+    long            offset;
+    byte            *data;
+    int             i;
+
+    if ( !fs_mmapMinSize->integer || len < fs_mmapMinSize->integer || !fsh[h].zipFile ) {
+        return NULL;
+    }
+
+    for ( i = 0 ; i < MAX_FILE_MAPPINGS ; i++ ) {
+        if ( !fs_mappings[i].data ) {
+            break;
+        }
+    }
+    if ( i == MAX_FILE_MAPPINGS ) {
+        return NULL;
+    }
+    map = &fs_mappings[i];
+
+    offset = unzGetCurrentFileStoredPos( fsh[h].handleFiles.file.z );
+    if ( !offset || !fsh[h].zipPak ) {
+        return NULL;
+    }
+
+    // the view stays valid after the file is closed
+    f = Sys_FOpen( fsh[h].zipPak->pakFilename, "rb" );
+    if ( !f ) {
+        return NULL;
+    }
+    data = Sys_MapFile( f, offset, len, &map->mapBase, &map->mapSize );
+    fclose( f );
+
+    if ( !data ) {
+        return NULL;
+    }
+
+    map->data = data;
+
+    if ( fs_debug->integer ) {
+        Com_Printf( "FS_ReadFile: %s mapped (%ld bytes)\n", fsh[h].name, len );
+    }
+
+    return data;
 }
 
 /*
@@ -1915,13 +2319,16 @@ long FS_ReadFileDir(const char *qpath, void *searchPath, qboolean unpure, void *
     fs_loadCount++;
     fs_loadStack++;
 
-    buf = Hunk_AllocateTempMemory(len+1);
-    *buffer = buf;
+    buf = FS_MapFileData( h, len );
+    if ( !buf ) {
+        buf = Hunk_AllocateTempMemory(len+1);
 
-    FS_Read (buf, len, h);
+        FS_Read (buf, len, h);
 
-    // guarantee that it will have a trailing 0 for string operations
-    buf[len] = 0;
+        // guarantee that it will have a trailing 0 for string operations
+        buf[len] = 0;
+    }
+    *buffer = buf;
     FS_FCloseFile( h );
 
     // if we are journalling and it is a config file, write it to the journal file
@@ -1953,6 +2360,8 @@ FS_FreeFile
 =============
 */
 void FS_FreeFile( void *buffer ) {
+    int     i;
+
     if ( !fs_searchpaths ) {
         Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
     }
@@ -1961,7 +2370,17 @@ void FS_FreeFile( void *buffer ) {
     }
     fs_loadStack--;
 
-    Hunk_FreeTempMemory( buffer );
+    for ( i = 0 ; i < MAX_FILE_MAPPINGS ; i++ ) {
+        if ( fs_mappings[i].data == buffer ) {
+            Sys_UnmapFile( fs_mappings[i].mapBase, fs_mappings[i].mapSize );
+            Com_Memset( &fs_mappings[i], 0, sizeof( fs_mappings[i] ) );
+            break;
+        }
+    }
+
+    if ( i == MAX_FILE_MAPPINGS ) {
+        Hunk_FreeTempMemory( buffer );
+    }
 
     // if all of our temp files are free, clear all of our space
     if ( fs_loadStack == 0 ) {
@@ -2008,6 +2427,409 @@ ZIP FILE LOADING
 ==========================================================================
 */
 
+/*
+=================================================================================
+
+PAK DIRECTORY CACHE
+
+The parsed central directory and the header crcs of every pk3 are kept in
+a cache file under fs_homepath, keyed by the path, size and modification
+time of the pk3. Unchanged paks are then set up without opening the zip at
+all, the zip handle is only opened once a file is actually read from it.
+
+=================================================================================
+*/
+
+#define PAKCACHE_FILENAME   "pakcache.dat"
+#define PAKCACHE_IDENT      (('C'<<24)+('K'<<16)+('A'<<8)+'P')
+#define PAKCACHE_VERSION    1
+
+typedef struct {
+    const char  *pakFilename;   // all pointers point into fs_pakCacheData
+    int         fileSize;
+    int         fileTime;
+    int         numfiles;
+    int         numHeaderLongs; // crcs only, the checksum feed is not stored
+    const byte  *files;         // pos and len for every file
+    const byte  *headerLongs;
+    const char  *names;         // numfiles nul terminated names
+    int         namesLen;
+} pakCacheEntry_t;
+
+static cvar_t           *fs_pakCache;
+static byte             *fs_pakCacheData;
+static pakCacheEntry_t  *fs_pakCacheEntries;
+static int              fs_numPakCacheEntries;
+static qboolean         fs_pakCacheDirty;
+static int              fs_pakCacheHits;
+
+static char *FS_PakCachePath( void ) {
+    static char ospath[MAX_OSPATH];
+
+    Com_sprintf( ospath, sizeof( ospath ), "%s%c%s", fs_homepath->string, PATH_SEP, PAKCACHE_FILENAME );
+    return ospath;
+}
+
+static int FS_PakCacheReadInt( const byte **data, const byte *end, qboolean *ok ) {
+    int     l;
+
+    if ( end - *data < sizeof( l ) ) {
+        *ok = qfalse;
+        return 0;
+    }
+    Com_Memcpy( &l, *data, sizeof( l ) );
+    *data += sizeof( l );
+    return LittleLong( l );
+}
+
+/*
+=================
+FS_FreePakCache
+=================
+*/
+static void FS_FreePakCache( void ) {
+    if ( fs_pakCacheEntries ) {
+        Z_Free( fs_pakCacheEntries );
+    }
+    if ( fs_pakCacheData ) {
+        Z_Free( fs_pakCacheData );
+    }
+    fs_pakCacheEntries = NULL;
+    fs_pakCacheData = NULL;
+    fs_numPakCacheEntries = 0;
+    fs_pakCacheDirty = qfalse;
+}
+
+/*
+=================
+FS_LoadPakCache
+
+Reads the cache file, anything that doesn't look right just
+means the cache is cold
+=================
+*/
+static void FS_LoadPakCache( void ) {
+    FILE            *f;
+    const byte      *data, *end;
+    pakCacheEntry_t *entry;
+    qboolean        ok;
+    int             len, count, i;
+
+    FS_FreePakCache();
+    fs_pakCacheHits = 0;
+
+    if ( !fs_pakCache->integer ) {
+        return;
+    }
+
+    f = Sys_FOpen( FS_PakCachePath(), "rb" );
+    if ( !f ) {
+        return;
+    }
+
+    len = FS_fplength( f );
+    if ( len <= 0 ) {
+        fclose( f );
+        return;
+    }
+
+    fs_pakCacheData = Z_Malloc( len );
+    if ( fread( fs_pakCacheData, 1, len, f ) != len ) {
+        fclose( f );
+        FS_FreePakCache();
+        return;
+    }
+    fclose( f );
+
+    ok = qtrue;
+    data = fs_pakCacheData;
+    end = data + len;
+
+    if ( FS_PakCacheReadInt( &data, end, &ok ) != PAKCACHE_IDENT ||
+         FS_PakCacheReadInt( &data, end, &ok ) != PAKCACHE_VERSION ) {
+        FS_FreePakCache();
+        return;
+    }
+
+    count = FS_PakCacheReadInt( &data, end, &ok );
+    if ( !ok || count <= 0 || count > MAX_SEARCH_PATHS * 4 ) {
+        FS_FreePakCache();
+        return;
+    }
+
+    fs_pakCacheEntries = Z_Malloc( count * sizeof( *fs_pakCacheEntries ) );
+
+    for ( i = 0 ; i < count ; i++ ) {
+        entry = &fs_pakCacheEntries[i];
+
+        len = FS_PakCacheReadInt( &data, end, &ok );
+        if ( !ok || len <= 0 || len > end - data || data[len - 1] != '\0' ) {
+            break;
+        }
+        entry->pakFilename = (const char *)data;
+        data += len;
+
+        entry->fileSize = FS_PakCacheReadInt( &data, end, &ok );
+        entry->fileTime = FS_PakCacheReadInt( &data, end, &ok );
+        entry->numfiles = FS_PakCacheReadInt( &data, end, &ok );
+        entry->numHeaderLongs = FS_PakCacheReadInt( &data, end, &ok );
+        entry->namesLen = FS_PakCacheReadInt( &data, end, &ok );
+
+        if ( !ok || entry->numfiles < 0 || entry->numHeaderLongs < 0 || entry->namesLen < 0 ||
+             entry->numHeaderLongs > entry->numfiles ||
+             end - data < ( entry->numfiles * 2 + entry->numHeaderLongs ) * sizeof( int ) + entry->namesLen ) {
+            break;
+        }
+
+        entry->files = data;
+        data += entry->numfiles * 2 * sizeof( int );
+        entry->headerLongs = data;
+        data += entry->numHeaderLongs * sizeof( int );
+        entry->names = (const char *)data;
+        data += entry->namesLen;
+
+        if ( entry->namesLen && entry->names[entry->namesLen - 1] != '\0' ) {
+            break;
+        }
+    }
+
+    fs_numPakCacheEntries = i;
+}
+
+static pakCacheEntry_t *FS_FindPakCacheEntry( const char *zipfile, int fileSize, int fileTime ) {
+    int     i;
+
+    for ( i = 0 ; i < fs_numPakCacheEntries ; i++ ) {
+        if ( fs_pakCacheEntries[i].fileSize == fileSize &&
+             fs_pakCacheEntries[i].fileTime == fileTime &&
+             !strcmp( fs_pakCacheEntries[i].pakFilename, zipfile ) ) {
+            return &fs_pakCacheEntries[i];
+        }
+    }
+    return NULL;
+}
+
+static void FS_PakCacheWriteInt( FILE *f, int l ) {
+    l = LittleLong( l );
+    fwrite( &l, sizeof( l ), 1, f );
+}
+
+/*
+=================
+FS_WritePakCache
+
+Writes the directories of all loaded paks, plus the still unused
+entries of the previous cache so that switching fs_game back and
+forth stays warm
+=================
+*/
+static void FS_WritePakCache( void ) {
+    searchpath_t    *search;
+    pack_t          *pak;
+    FILE            *f;
+    int             count, namesLen, numfiles;
+    int             i, j;
+
+    if ( !fs_pakCache->integer || !fs_pakCacheDirty ) {
+        FS_FreePakCache();
+        return;
+    }
+
+    count = 0;
+    for ( search = fs_searchpaths ; search ; search = search->next ) {
+        if ( search->pack && search->pack->fileSize >= 0 ) {
+            count++;
+        }
+    }
+    for ( i = 0 ; i < fs_numPakCacheEntries ; i++ ) {
+        if ( !fs_pakCacheEntries[i].pakFilename[0] ) {
+            continue;
+        }
+        for ( search = fs_searchpaths ; search ; search = search->next ) {
+            if ( search->pack && !strcmp( search->pack->pakFilename, fs_pakCacheEntries[i].pakFilename ) ) {
+                break;
+            }
+        }
+        if ( search ) {
+            fs_pakCacheEntries[i].pakFilename = "";
+        } else {
+            count++;
+        }
+    }
+
+    f = Sys_FOpen( FS_PakCachePath(), "wb" );
+    if ( !f ) {
+        FS_FreePakCache();
+        return;
+    }
+
+    FS_PakCacheWriteInt( f, PAKCACHE_IDENT );
+    FS_PakCacheWriteInt( f, PAKCACHE_VERSION );
+    FS_PakCacheWriteInt( f, count );
+
+    for ( search = fs_searchpaths ; search ; search = search->next ) {
+        pak = search->pack;
+        if ( !pak || pak->fileSize < 0 ) {
+            continue;
+        }
+
+        numfiles = 0;
+        namesLen = 0;
+        for ( i = 0 ; i < pak->numfiles ; i++ ) {
+            if ( pak->buildBuffer[i].name ) {
+                numfiles++;
+                namesLen += strlen( pak->buildBuffer[i].name ) + 1;
+            }
+        }
+
+        FS_PakCacheWriteInt( f, strlen( pak->pakFilename ) + 1 );
+        fwrite( pak->pakFilename, strlen( pak->pakFilename ) + 1, 1, f );
+        FS_PakCacheWriteInt( f, pak->fileSize );
+        FS_PakCacheWriteInt( f, pak->fileTime );
+        FS_PakCacheWriteInt( f, numfiles );
+        FS_PakCacheWriteInt( f, pak->numHeaderLongs - 1 );
+        FS_PakCacheWriteInt( f, namesLen );
+
+        for ( i = 0 ; i < pak->numfiles ; i++ ) {
+            if ( pak->buildBuffer[i].name ) {
+                FS_PakCacheWriteInt( f, pak->buildBuffer[i].pos );
+                FS_PakCacheWriteInt( f, pak->buildBuffer[i].len );
+            }
+        }
+        // the crcs are already stored little endian
+        fwrite( &pak->headerLongs[1], sizeof( int ), pak->numHeaderLongs - 1, f );
+        for ( i = 0 ; i < pak->numfiles ; i++ ) {
+            if ( pak->buildBuffer[i].name ) {
+                fwrite( pak->buildBuffer[i].name, strlen( pak->buildBuffer[i].name ) + 1, 1, f );
+            }
+        }
+    }
+
+    for ( i = 0 ; i < fs_numPakCacheEntries ; i++ ) {
+        pakCacheEntry_t *entry = &fs_pakCacheEntries[i];
+
+        if ( !entry->pakFilename[0] ) {
+            continue;
+        }
+
+        j = strlen( entry->pakFilename ) + 1;
+        FS_PakCacheWriteInt( f, j );
+        fwrite( entry->pakFilename, j, 1, f );
+        FS_PakCacheWriteInt( f, entry->fileSize );
+        FS_PakCacheWriteInt( f, entry->fileTime );
+        FS_PakCacheWriteInt( f, entry->numfiles );
+        FS_PakCacheWriteInt( f, entry->numHeaderLongs );
+        FS_PakCacheWriteInt( f, entry->namesLen );
+        fwrite( entry->files, entry->numfiles * 2 * sizeof( int ) +
+            entry->numHeaderLongs * sizeof( int ) + entry->namesLen, 1, f );
+    }
+
+    fclose( f );
+    FS_FreePakCache();
+}
+
+/*
+=================
+FS_AllocPak
+
+Sets up an empty pak with a hash table sized for numfiles
+=================
+*/
+static pack_t *FS_AllocPak( const char *zipfile, const char *basename, int numfiles )
+{
+    pack_t  *pack;
+    int     i;
+
+    // get the hash table size from the number of files in the zip
+    // because lots of custom pk3 files have less than 32 or 64 files
+    for (i = 1; i <= MAX_FILEHASH_SIZE; i <<= 1) {
+        if (i > numfiles) {
+            break;
+        }
+    }
+
+    pack = Z_Malloc( sizeof( pack_t ) + i * sizeof(fileInPack_t *) );
+    pack->hashSize = i;
+    pack->hashTable = (fileInPack_t **) (((char *) pack) + sizeof( pack_t ));
+    for(i = 0; i < pack->hashSize; i++) {
+        pack->hashTable[i] = NULL;
+    }
+
+    Q_strncpyz( pack->pakFilename, zipfile, sizeof( pack->pakFilename ) );
+    Q_strncpyz( pack->pakBasename, basename, sizeof( pack->pakBasename ) );
+
+    // strip .pk3 if needed
+    if ( strlen( pack->pakBasename ) > 4 && !Q_stricmp( pack->pakBasename + strlen( pack->pakBasename ) - 4, ".pk3" ) ) {
+        pack->pakBasename[strlen( pack->pakBasename ) - 4] = 0;
+    }
+
+    pack->numfiles = numfiles;
+    pack->fileSize = -1;
+    return pack;
+}
+
+/*
+=================
+FS_SetPakChecksums
+=================
+*/
+static void FS_SetPakChecksums( pack_t *pack )
+{
+    pack->headerLongs[0] = LittleLong( fs_checksumFeed );
+
+    pack->checksum = Com_BlockChecksum( &pack->headerLongs[ 1 ], sizeof(*pack->headerLongs) * ( pack->numHeaderLongs - 1 ) );
+    pack->pure_checksum = Com_BlockChecksum( pack->headerLongs, sizeof(*pack->headerLongs) * pack->numHeaderLongs );
+    pack->checksum = LittleLong( pack->checksum );
+    pack->pure_checksum = LittleLong( pack->pure_checksum );
+}
+
+/*
+=================
+FS_LoadCachedPak
+
+Builds a pak from its cached directory without opening the zip
+=================
+*/
+static pack_t *FS_LoadCachedPak( pakCacheEntry_t *entry, const char *zipfile, const char *basename )
+{
+    fileInPack_t    *buildBuffer;
+    pack_t          *pack;
+    const byte      *files;
+    char            *namePtr;
+    qboolean        ok;
+    long            hash;
+    int             i;
+
+    buildBuffer = Z_Malloc( ( entry->numfiles * sizeof( fileInPack_t ) ) + entry->namesLen );
+    namePtr = ((char *) buildBuffer) + entry->numfiles * sizeof( fileInPack_t );
+    Com_Memcpy( namePtr, entry->names, entry->namesLen );
+
+    pack = FS_AllocPak( zipfile, basename, entry->numfiles );
+
+    // sizes were validated when the cache was read
+    ok = qtrue;
+    files = entry->files;
+    for ( i = 0 ; i < entry->numfiles ; i++ ) {
+        buildBuffer[i].name = namePtr;
+        namePtr += strlen( namePtr ) + 1;
+        buildBuffer[i].pos = FS_PakCacheReadInt( &files, entry->headerLongs, &ok );
+        buildBuffer[i].len = FS_PakCacheReadInt( &files, entry->headerLongs, &ok );
+
+        hash = FS_HashFileName( buildBuffer[i].name, pack->hashSize );
+        buildBuffer[i].next = pack->hashTable[hash];
+        pack->hashTable[hash] = &buildBuffer[i];
+    }
+
+    pack->numHeaderLongs = entry->numHeaderLongs + 1;
+    pack->headerLongs = Z_Malloc( pack->numHeaderLongs * sizeof( int ) );
+    Com_Memcpy( &pack->headerLongs[1], entry->headerLongs, entry->numHeaderLongs * sizeof( int ) );
+    FS_SetPakChecksums( pack );
+
+    pack->buildBuffer = buildBuffer;
+    fs_pakCacheHits++;
+    return pack;
+}
+
 /*
 =================
 FS_LoadZipFile
@@ -2020,6 +2842,7 @@ static pack_t *FS_LoadZipFile(const char *zipfile, const char *basename)
 {
     fileInPack_t    *buildBuffer;
     pack_t          *pack;
+    pakCacheEntry_t *entry;
     unzFile         uf;
     int             err;
     unz_global_info gi;
@@ -2027,11 +2850,17 @@ static pack_t *FS_LoadZipFile(const char *zipfile, const char *basename)
     unz_file_info   file_info;
     int             i, len;
     long            hash;
-    int             fs_numHeaderLongs;
-    int             *fs_headerLongs;
+    int             fileSize, fileTime;
     char            *namePtr;
 
-    fs_numHeaderLongs = 0;
+    if ( !Sys_StatFile( zipfile, &fileSize, &fileTime ) ) {
+        fileSize = -1;
+    } else if ( ( entry = FS_FindPakCacheEntry( zipfile, fileSize, fileTime ) ) != NULL ) {
+        pack = FS_LoadCachedPak( entry, zipfile, basename );
+        pack->fileSize = fileSize;
+        pack->fileTime = fileTime;
+        return pack;
+    }
 
     uf = unzOpen(zipfile);
     err = unzGetGlobalInfo (uf,&gi);
@@ -2053,34 +2882,12 @@ static pack_t *FS_LoadZipFile(const char *zipfile, const char *basename)
 
     buildBuffer = Z_Malloc( (gi.number_entry * sizeof( fileInPack_t )) + len );
     namePtr = ((char *) buildBuffer) + gi.number_entry * sizeof( fileInPack_t );
-    fs_headerLongs = Z_Malloc( ( gi.number_entry + 1 ) * sizeof(int) );
-    fs_headerLongs[ fs_numHeaderLongs++ ] = LittleLong( fs_checksumFeed );
-
-    // get the hash table size from the number of files in the zip
-    // because lots of custom pk3 files have less than 32 or 64 files
-    for (i = 1; i <= MAX_FILEHASH_SIZE; i <<= 1) {
-        if (i > gi.number_entry) {
-            break;
-        }
-    }
-
-    pack = Z_Malloc( sizeof( pack_t ) + i * sizeof(fileInPack_t *) );
-    pack->hashSize = i;
-    pack->hashTable = (fileInPack_t **) (((char *) pack) + sizeof( pack_t ));
-    for(i = 0; i < pack->hashSize; i++) {
-        pack->hashTable[i] = NULL;
-    }
 
-    Q_strncpyz( pack->pakFilename, zipfile, sizeof( pack->pakFilename ) );
-    Q_strncpyz( pack->pakBasename, basename, sizeof( pack->pakBasename ) );
-
-    // strip .pk3 if needed
-    if ( strlen( pack->pakBasename ) > 4 && !Q_stricmp( pack->pakBasename + strlen( pack->pakBasename ) - 4, ".pk3" ) ) {
-        pack->pakBasename[strlen( pack->pakBasename ) - 4] = 0;
-    }
+    pack = FS_AllocPak( zipfile, basename, gi.number_entry );
+    pack->headerLongs = Z_Malloc( ( gi.number_entry + 1 ) * sizeof(int) );
+    pack->numHeaderLongs = 1;   // the checksum feed goes first
 
     pack->handle = uf;
-    pack->numfiles = gi.number_entry;
     unzGoToFirstFile(uf);
 
     for (i = 0; i < gi.number_entry; i++)
@@ -2090,7 +2897,7 @@ static pack_t *FS_LoadZipFile(const char *zipfile, const char *basename)
             break;
         }
         if (file_info.uncompressed_size > 0) {
-            fs_headerLongs[fs_numHeaderLongs++] = LittleLong(file_info.crc);
+            pack->headerLongs[pack->numHeaderLongs++] = LittleLong(file_info.crc);
         }
         Q_strlwr( filename_inzip );
         hash = FS_HashFileName(filename_inzip, pack->hashSize);
@@ -2105,14 +2912,16 @@ static pack_t *FS_LoadZipFile(const char *zipfile, const char *basename)
         unzGoToNextFile(uf);
     }
 
-    pack->checksum = Com_BlockChecksum( &fs_headerLongs[ 1 ], sizeof(*fs_headerLongs) * ( fs_numHeaderLongs - 1 ) );
-    pack->pure_checksum = Com_BlockChecksum( fs_headerLongs, sizeof(*fs_headerLongs) * fs_numHeaderLongs );
-    pack->checksum = LittleLong( pack->checksum );
-    pack->pure_checksum = LittleLong( pack->pure_checksum );
-
-    Z_Free(fs_headerLongs);
+    FS_SetPakChecksums( pack );
 
     pack->buildBuffer = buildBuffer;
+    pack->fileSize = fileSize;
+    pack->fileTime = fileTime;
+
+    if ( fileSize >= 0 ) {
+        fs_pakCacheDirty = qtrue;
+    }
+
     return pack;
 }
 
@@ -2126,7 +2935,9 @@ Frees a pak structure and releases all associated resources
 
 static void FS_FreePak(pack_t *thepak)
 {
-    unzClose(thepak->handle);
+    if (thepak->handle)
+        unzClose(thepak->handle);
+    Z_Free(thepak->headerLongs);
     Z_Free(thepak->buildBuffer);
     Z_Free(thepak);
 }
@@ -2792,6 +3603,8 @@ void FS_Path_f( void ) {
         }
     }
 
+    Com_Printf( "\n%d unique pak files indexed, %d index hits, %d cached misses\n",
+        fs_numIndexEntries, fs_indexHits, fs_missHits );
 
     Com_Printf( "\n" );
     for ( i = 1 ; i < MAX_FILE_HANDLES ; i++ ) {
@@ -3245,6 +4058,8 @@ void FS_Shutdown( qboolean closemfp ) {
         Z_Free(p);
     }
 
+    FS_FreeFileIndex();
+
     // any FS_ calls will now be an error until reinitialized
     fs_searchpaths = NULL;
 
@@ -3328,6 +4143,8 @@ static void FS_Startup( const char *gameName )
     }
     fs_homepath = Cvar_Get ("fs_homepath", homePath, CVAR_INIT|CVAR_PROTECTED );
     fs_gamedirvar = Cvar_Get ("fs_game", "", CVAR_INIT|CVAR_SYSTEMINFO );
+    fs_pakCache = Cvar_Get ("fs_pakCache", "1", CVAR_ARCHIVE );
+    fs_mmapMinSize = Cvar_Get ("fs_mmapMinSize", "65536", CVAR_ARCHIVE );
 
     if (!gameName[0]) {
         Cvar_ForceReset( "com_basegame" );
@@ -3350,6 +4167,8 @@ static void FS_Startup( const char *gameName )
         Com_Error( ERR_DROP, "Invalid fs_game '%s'", fs_gamedirvar->string );
     }
 
+    FS_LoadPakCache();
+
     // add search path elements in reverse priority order
     fs_gogpath = Cvar_Get ("fs_gogpath", Sys_GogPath(), CVAR_INIT|CVAR_PROTECTED );
     if (fs_gogpath->string[0]) {
@@ -3409,6 +4228,8 @@ static void FS_Startup( const char *gameName )
         }
     }
 
+    FS_WritePakCache();
+
 #ifndef STANDALONE
     if (!com_standalone->integer) {
         Com_ReadCDKey(BASEGAME);
@@ -3429,6 +4250,8 @@ static void FS_Startup( const char *gameName )
     // reorder the pure pk3 files according to server order
     FS_ReorderPurePaks();
 
+    FS_BuildFileIndex();
+
     // print the current search paths
     FS_Path_f();
 
@@ -3442,6 +4265,9 @@ static void FS_Startup( const char *gameName )
     }
 #endif
     Com_Printf( "%d files in pk3 files\n", fs_packFiles );
+    if ( fs_pakCacheHits ) {
+        Com_Printf( "%d pk3 directories from %s\n", fs_pakCacheHits, PAKCACHE_FILENAME );
+    }
 }
 
 #ifndef STANDALONE
@@ -3911,6 +4737,11 @@ void FS_PureServerSetLoadedPaks( const char *pakSums, const char *pakNames ) {
             fs_serverPakNames[i] = CopyString( Cmd_Argv( i ) );
         }
     }
+
+    // the pure winners depend on the server pak list
+    if ( fs_searchpaths ) {
+        FS_BuildFileIndex();
+    }
 }
 
 /*
@@ -4097,7 +4928,15 @@ qboolean FS_ConditionalRestart(int checksumFeed, qboolean disconnect)
     if(checksumFeed != fs_checksumFeed)
         FS_Restart(checksumFeed);
     else if(fs_numServerPaks && !fs_reordered)
+    {
         FS_ReorderPurePaks();
+        FS_BuildFileIndex();
+    }
+    else
+    {
+        // loose files may have been added while we weren't looking
+        FS_FlushMissCache();
+    }
 
     return qfalse;
 }
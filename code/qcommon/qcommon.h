@@ -621,6 +621,9 @@ char    **FS_ListFiles( const char *directory, const char *extension, int *numfi
 // if extension is "/", only subdirectories will be returned
 // the returned files will not include any directories or /
 
+char    **FS_ListFilteredFiles( const char *path, const char *extension, char *filter, int *numfiles, qboolean allowNonPureFilesOnDisk );
+// allowNonPureFilesOnDisk also lists directories while pure
+
 void    FS_FreeFileList( char **list );
 
 qboolean FS_FileExists( const char *file );
@@ -657,6 +660,9 @@ long        FS_FOpenFileRead( const char *qpath, fileHandle_t *file, qboolean un
 int     FS_FileIsInPAK(const char *filename, int *pChecksum );
 // returns 1 if a file is in the PAK file, otherwise -1
 
+const char *FS_FilePakName( const char *filename, int *pChecksum );
+// returns the game and name of the PAK file a file is read from, or NULL
+
 int     FS_Write( const void *buffer, int len, fileHandle_t f );
 
 int     FS_Read( void *buffer, int len, fileHandle_t f );
@@ -1129,6 +1135,9 @@ void        Sys_ShowIP(void);
 FILE    *Sys_FOpen( const char *ospath, const char *mode );
 qboolean Sys_Mkdir( const char *path );
 FILE    *Sys_Mkfifo( const char *ospath );
+qboolean Sys_StatFile( const char *ospath, int *size, int *mtime );
+void    *Sys_MapFile( FILE *f, int offset, int length, void **mapBase, int *mapSize );
+void    Sys_UnmapFile( void *mapBase, int mapSize );
 char    *Sys_Cwd( void );
 void    Sys_SetDefaultInstallPath(const char *path);
 char    *Sys_DefaultInstallPath(void);
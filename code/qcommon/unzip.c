@@ -1606,3 +1606,28 @@ extern int ZEXPORT unzSetOffset (file, pos)
     s->current_file_ok = (err == UNZ_OK);
     return err;
 }
+
+/*
+  Give the position of the data of the currently opened file in the zipfile,
+  or 0 if the file is compressed or encrypted and can't be used as is
+*/
+extern uLong ZEXPORT unzGetCurrentFileStoredPos (file)
+        unzFile file;
+{
+    unz_s* s;
+    file_in_zip_read_info_s* pfile_in_zip_read_info;
+
+    if (file==NULL)
+        return 0;
+    s=(unz_s*)file;
+    pfile_in_zip_read_info=s->pfile_in_zip_read;
+
+    if (pfile_in_zip_read_info==NULL)
+        return 0;
+    if (pfile_in_zip_read_info->compression_method!=0 ||
+        (s->cur_file_info.flag & 1)!=0)
+        return 0;
+
+    return pfile_in_zip_read_info->pos_in_zipfile +
+           pfile_in_zip_read_info->byte_before_the_zipfile;
+}
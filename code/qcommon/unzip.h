@@ -346,6 +346,10 @@ extern uLong ZEXPORT unzGetOffset (unzFile file);
 /* Set the current file offset */
 extern int ZEXPORT unzSetOffset (unzFile file, uLong pos);
 
+/* Get the position of the data of the currently opened file if it is
+   stored uncompressed, 0 otherwise */
+extern uLong ZEXPORT unzGetCurrentFileStoredPos (unzFile file);
+
 
 
 #ifdef __cplusplus
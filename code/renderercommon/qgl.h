@@ -110,6 +110,8 @@ extern void (APIENTRYP qglPointParameterfvEXT) (GLenum pname, GLfloat *params);
     GLE(void, ClearDepth, GLclampd depth) \
     GLE(void, DepthRange, GLclampd near_val, GLclampd far_val) \
     GLE(void, DrawBuffer, GLenum mode) \
+    GLE(void, GetTexImage, GLenum target, GLint level, GLenum format, GLenum type, GLvoid *pixels) \
+    GLE(void, GetTexLevelParameteriv, GLenum target, GLint level, GLenum pname, GLint *params) \
     GLE(void, PolygonMode, GLenum face, GLenum mode) \
 
 // OpenGL 1.0/1.1 but not OpenGL 3.2 core profile or OpenGL ES 1.x
@@ -144,6 +146,7 @@ extern void (APIENTRYP qglPointParameterfvEXT) (GLenum pname, GLfloat *params);
     GLE(void, ActiveTexture, GLenum texture) \
     GLE(void, CompressedTexImage2D, GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void *data) \
     GLE(void, CompressedTexSubImage2D, GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void *data) \
+    GLE(void, GetCompressedTexImage, GLenum target, GLint level, void *img) \
 
 // GL_ARB_occlusion_query, built-in to OpenGL 1.5 but not OpenGL ES 2.0
 #define QGL_ARB_occlusion_query_PROCS \
@@ -268,6 +271,39 @@ extern void (APIENTRYP qglPointParameterfvEXT) (GLenum pname, GLfloat *params);
     GLE(void, DeleteVertexArrays, GLsizei n, const GLuint *arrays) \
     GLE(void, GenVertexArrays, GLsizei n, GLuint *arrays) \
 
+// GL_ARB_draw_instanced and GL_ARB_instanced_arrays, built-in to OpenGL 3.3
+#define QGL_ARB_instanced_arrays_PROCS \
+    GLE(void, DrawElementsInstanced, GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instancecount) \
+    GLE(void, VertexAttribDivisor, GLuint index, GLuint divisor) \
+
+// GL_ARB_get_program_binary, built-in to OpenGL 4.1
+#define QGL_ARB_get_program_binary_PROCS \
+    GLE(void, GetProgramBinary, GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary) \
+    GLE(void, ProgramBinary, GLuint program, GLenum binaryFormat, const void *binary, GLsizei length) \
+    GLE(void, ProgramParameteri, GLuint program, GLenum pname, GLint value) \
+
+// GL_ARB_buffer_storage, built-in to OpenGL 4.4, with GL_ARB_map_buffer_range and GL_ARB_sync
+#define QGL_ARB_buffer_storage_PROCS \
+    GLE(void, BufferStorage, GLenum target, GLsizeiptr size, const void *data, GLbitfield flags) \
+    GLE(void *, MapBufferRange, GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) \
+    GLE(GLsync, FenceSync, GLenum condition, GLbitfield flags) \
+    GLE(GLenum, ClientWaitSync, GLsync sync, GLbitfield flags, GLuint64 timeout) \
+    GLE(void, DeleteSync, GLsync sync) \
+
+#ifndef GL_ARB_get_program_binary
+#define GL_ARB_get_program_binary
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT          0x8257
+#define GL_PROGRAM_BINARY_LENGTH                    0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS               0x87FE
+#define GL_PROGRAM_BINARY_FORMATS                   0x87FF
+#endif
+
+#ifndef GL_ARB_buffer_storage
+#define GL_ARB_buffer_storage
+#define GL_MAP_PERSISTENT_BIT                       0x0040
+#define GL_MAP_COHERENT_BIT                         0x0080
+#endif
+
 #ifndef GL_ARB_texture_compression_rgtc
 #define GL_ARB_texture_compression_rgtc
 #define GL_COMPRESSED_RED_RGTC1                       0x8DBB
@@ -332,6 +368,9 @@ QGL_3_0_PROCS;
 QGL_ARB_occlusion_query_PROCS;
 QGL_ARB_framebuffer_object_PROCS;
 QGL_ARB_vertex_array_object_PROCS;
+QGL_ARB_instanced_arrays_PROCS;
+QGL_ARB_get_program_binary_PROCS;
+QGL_ARB_buffer_storage_PROCS;
 QGL_EXT_direct_state_access_PROCS;
 #undef GLE
 
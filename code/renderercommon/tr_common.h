@@ -60,6 +60,8 @@ typedef struct image_s {
     imgType_t   type;
     imgFlags_t  flags;
 
+    int         readMsec, decodeMsec, uploadMsec;   // load timings for imagelist
+
     struct image_s* next;
 } image_t;
 
@@ -114,12 +116,33 @@ extern cvar_t *r_stereoEnabled;
 
 extern  cvar_t  *r_saveFontData;
 
+extern cvar_t *r_shadows;               // controls shadows: 0 = none, 1 = blur, 2 = stencil, 3 = black planar projection
+
+extern cvar_t *r_occlusion;             // software occlusion culling of world surfaces and entities
+extern cvar_t *r_occlusionDebug;        // 1 = show the occlusion buffer, 2 = also print counts
+
+extern cvar_t *r_imageThreads;          // worker threads for texture processing, -1 = one per spare core
+extern cvar_t *r_imagePrefetch;         // decode the images of a map on the worker threads before registering them
+extern cvar_t *r_imageCache;            // keep processed images in imagecache/ and upload them from there
+extern cvar_t *r_imageCacheCompress;    // block compress cached images the driver left uncompressed
+extern cvar_t *r_shaderCache;           // keep the indexed shader scripts in shadercache/
+extern cvar_t *r_retainImages;          // megabytes of textures unused by the current map kept for later maps, 0 = off
+
+extern cvar_t *r_simd;                  // use the SSE2/NEON loops in tr_simd.c and tr_we_simd.c
+extern cvar_t *r_weatherThreads;        // update weather particles on the worker threads
+extern cvar_t *r_weatherGrid;           // cell size of the world effect contents grid (16 at least), 0 = query the collision map
+extern cvar_t *r_weatherGridCache;      // cache the world effect contents grid on disk
+
 qboolean    R_GetModeInfo( int *width, int *height, float *windowAspect, int mode );
 
 float R_NoiseGet4f( float x, float y, float z, double t );
 void  R_NoiseInit( void );
 
 image_t     *R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags );
+qboolean    R_ModelFrameBounds( qhandle_t handle, int frame, int oldframe, vec3_t bounds[2] );
+
+#define MAX_PREFETCH_IMAGES 256         // names handed to R_PrefetchImages at a time
+void        R_PrefetchImages( const char **names, int numNames );
 image_t *R_CreateImage( const char *name, byte *pic, int width, int height, imgType_t type, imgFlags_t flags, int internalFormat );
 
 void R_IssuePendingRenderCommands( void );
@@ -128,6 +151,33 @@ qhandle_t        RE_RegisterShader( const char *name );
 qhandle_t        RE_RegisterShaderNoMip( const char *name );
 qhandle_t RE_RegisterShaderFromImage(const char *name, const int *lightmapIndex, const byte *styles, image_t *image, qboolean mipRawImage);
 
+extern const int    lightmaps2D[];      // MAXLIGHTMAPS entries, see tr_shader.c
+extern const byte   stylesDefault[];
+
+// software occlusion culling, tr_occlusion.c
+#define OCC_WIDTH   256
+#define OCC_HEIGHT  128
+#define OCC_OCCLUDER_SIZE   64  // surfaces smaller than this on every axis aren't drawn as occluders
+
+// Only solid, undeformed geometry that writes depth can hide things.
+// A macro, the shader_t of each renderer has these fields.
+#define R_ShaderIsOccluder( shader ) \
+    ( (shader)->sort == SS_OPAQUE && !(shader)->isSky && !(shader)->polygonOffset && !(shader)->numDeforms \
+    && (shader)->stages[0] \
+    && !( (shader)->stages[0]->stateBits & ( GLS_ATEST_BITS | GLS_SRCBLEND_BITS | GLS_DSTBLEND_BITS ) ) \
+    && ( (shader)->stages[0]->stateBits & GLS_DEPTHMASK_TRUE ) )
+
+void        R_OcclusionBeginView( const vec3_t origin, vec3_t axis[3], float fovX, float fovY );
+void        R_OcclusionEndView( void );
+qboolean    R_OcclusionActive( void );
+void        R_OcclusionAddTriangles( const float *xyz, int stride, const int *indexes, int numIndexes );
+void        R_OcclusionFinishOccluders( qboolean debug );
+qboolean    R_OcclusionCullBox( const vec3_t mins, const vec3_t maxs );
+qboolean    R_OcclusionCullLocalBox( vec3_t bounds[2], const vec3_t origin, vec3_t axis[3] );
+qboolean    R_EntityOccluded( const refEntity_t *ent, const vec3_t origin, vec3_t axis[3] );
+const byte  *R_OcclusionDebugPixels( void );
+void        R_OcclusionStats( int *numTris, int *numTested, int *numCulled );
+
 // font stuff
 void R_InitFreeType( void );
 void R_DoneFreeType( void );
@@ -149,6 +199,80 @@ void R_LoadTGA          ( const char *name, byte **pic, int *width, int *height
 
 void R_LoadPNGDataFile  ( const char *name, byte **pic, int *width, int *height );
 
+typedef struct
+{
+    char *ext;
+    void (*ImageLoader)( const char *, unsigned char **, int *, int * );
+} imageExtToLoaderMap_t;
+
+// loader file access and parallel decoding, tr_image_prefetch.c
+long    R_ImageReadFile( const char *name, void **buffer );
+void    R_ImageFreeFile( void *buffer );
+void    *R_ImageMalloc( int bytes );
+void    R_ImageFree( void *buffer );
+void    QDECL R_ImagePrintf( int printLevel, const char *fmt, ... ) __attribute__ ((format (printf, 2, 3)));
+void    QDECL R_ImageError( int errorLevel, const char *fmt, ... ) __attribute__ ((noreturn, format (printf, 2, 3)));
+int     R_ImageReadTime( void );
+
+long     R_ReadImageSource( const char *name, const imageExtToLoaderMap_t *loaders, int numLoaders,
+                char *path, int pathSize, int *loader, qboolean *renamed, void **buffer );
+void     R_PrefetchImageFiles( const char **names, int numNames, const imageExtToLoaderMap_t *loaders, int numLoaders );
+qboolean R_TakePrefetchedImage( const char *name, byte **pic, int *width, int *height, int *readMsec, int *decodeMsec );
+void     R_ClearPrefetchedImages( void );
+
+// on-disk cache of processed images, tr_image_cache.c
+#define IMAGECACHE_MAX_LEVELS   16
+
+typedef struct {
+    char        path[MAX_QPATH];        // cache file
+    uint64_t    sourceHash;
+    int         paramsKey;
+} imageCacheKey_t;
+
+typedef struct {
+    int         width, height;              // source image
+    int         uploadWidth, uploadHeight;  // level 0
+    int         internalFormat;
+    qboolean    compressed;
+    int         numLevels;
+    int         levelSize[IMAGECACHE_MAX_LEVELS];
+    byte        *levels[IMAGECACHE_MAX_LEVELS];
+    int         readMsec;
+    void        *buffer;
+} cachedImage_t;
+
+qboolean R_FindCachedImage( const char *name, const char *params, const imageExtToLoaderMap_t *loaders, int numLoaders,
+                imageCacheKey_t *key, cachedImage_t *cached );
+void     R_FreeCachedImage( cachedImage_t *cached );
+void     R_SaveCachedImage( const imageCacheKey_t *key, const image_t *image, GLenum encodeFormat );
+qboolean R_ImageCacheHasSource( const void *buffer, int length );
+void     R_ShutdownImageCache( void );
+
+int      R_BlockImageSize( GLenum format, int width, int height );
+void     R_CompressBlockImage( GLenum format, const byte *in, int width, int height, byte *out );
+
+// textures kept between maps, tr_image_retain.c
+int           R_RetainedImageKey( const char *params, const char *path, long length );
+qboolean      R_HaveRetainedImage( const char *name, int key );
+const image_t *R_AcquireRetainedImage( const char *name, int key );
+void          R_RetainImage( const image_t *image, int key );
+qboolean      R_ReleaseRetainedImage( const image_t *image );
+void          R_BeginRetainedImages( void );
+void          R_EvictRetainedImages( void );
+void          R_ShutdownRetainedImages( void );
+
+// shader script database, tr_shader_db.c
+void  R_LoadShaderDatabase( const char *altExt );
+char  *R_FindShaderText( const char *name );
+int   R_GetShaderImageNames( const char *name, char (*names)[MAX_QPATH], int maxNames );
+void  R_ClearShaderCache_f( void );
+
+// shared texture processing, tr_image_process.c
+int  R_ImageJobRows( int width, int height, int *rowsPerJob );
+void R_ResampleTextureRGBA( const byte *in, int inwidth, int inheight, byte *out, int outwidth, int outheight );
+void R_MipMapBoxRGBA( byte *in, int width, int height );
+void R_RemapTextureRGB( byte *data, int numPixels, const byte table[256] );
+
 /*
 ====================================================================
 
@@ -168,6 +292,31 @@ void        GLimp_SetGamma( unsigned char red[256],
         unsigned char green[256],
         unsigned char blue[256] );
 
+qboolean    GLimp_SpawnRenderThread( void (*function)( void ) );
+void        GLimp_ShutdownRenderThread( void );
+void        *GLimp_RendererSleep( void );
+void        GLimp_FrontEndSleep( void );
+void        GLimp_FrontEndAcquireContext( void );
+void        GLimp_WakeRenderer( void *data );
+qboolean    GLimp_RendererActive( void );
+
+void        GLimp_SpawnJobThreads( int count );
+void        GLimp_ShutdownJobThreads( void );
+void        GLimp_RunJobs( void (*function)( void *data, int index ), void *data, int count );
+int         GLimp_NumJobThreads( void );
+
+// SSE2 and NEON loops, see tr_simd.h
+#if !defined( C_ONLY ) && ( idx64 || id386 || \
+    ( ( defined( __ARM_NEON ) || defined( __ARM_NEON__ ) ) && !defined( __ARM_BIG_ENDIAN ) ) )
+#define idsimd 1
+#else
+#define idsimd 0
+#endif
+
+#if idsimd
+qboolean    RB_SIMDSupported( void );
+#endif
+
 /*
 ====================================================================
 
@@ -90,6 +90,8 @@ FT_Library ftLibrary = NULL;
 static int registeredFontCount = 0;
 static fontInfo_t registeredFont[MAX_FONTS];
 
+#define MAX_FONT_PAGES 16
+
 #ifdef BUILD_FREETYPE
 void R_GetGlyphInfo(FT_GlyphSlot glyph, int *left, int *right, int *width, int *top, int *bottom, int *height, int *pitch) {
     *left  = _FLOOR( glyph->metrics.horiBearingX );
@@ -330,6 +332,171 @@ float readFloat( void ) {
     return me.ffred;
 }
 
+/*
+===============
+R_LoadFontPage
+
+Loads the pixels of a pre-rendered glyph page, *pic is NULL if
+there is no image by that name
+===============
+*/
+static void R_LoadFontPage(const char *shaderName, byte **pic, int *width, int *height) {
+    static const struct {
+        const char  *ext;
+        void        (*load)(const char *name, byte **pic, int *width, int *height);
+    } loaders[] = {
+        { "tga", R_LoadTGA },
+        { "png", R_LoadPNG },
+        { "jpg", R_LoadJPG }
+    };
+    char    base[MAX_QPATH];
+    char    name[MAX_QPATH];
+    int     i;
+
+    *pic = NULL;
+    COM_StripExtension(shaderName, base, sizeof(base));
+
+    for (i = 0; i < ARRAY_LEN(loaders) && !*pic; i++) {
+        Com_sprintf(name, sizeof(name), "%s.%s", base, loaders[i].ext);
+        loaders[i].load(name, pic, width, height);
+    }
+}
+
+/*
+===============
+R_PackFontAtlas
+
+Copies the glyph pages of a pre-rendered font into a single image so a
+line of text is drawn as one batch whichever pages its glyphs are on.
+Only pages that are plain images drawn with the default 2D shader can
+be packed, a font with a page that has a shader script keeps its pages.
+Returns qfalse to keep using the separate pages.
+===============
+*/
+static qboolean R_PackFontAtlas(fontInfo_t *font, int pointSize) {
+    char        pageNames[MAX_FONT_PAGES][MAX_QPATH];
+    int         glyphPage[GLYPHS_PER_FONT];
+    char        name[MAX_QPATH];
+    byte        *pic, *atlas;
+    int         numPages, pageWidth, pageHeight, cols, rows;
+    int         width, height, atlasWidth, col, row;
+    int         i, j, y;
+    glyphInfo_t *glyph;
+    image_t     *image;
+    qhandle_t   h;
+
+    // find the pages used by the glyphs
+    numPages = 0;
+    for (i = GLYPH_START; i <= GLYPH_END; i++) {
+        glyphPage[i] = -1;
+        if (!font->glyphs[i].shaderName[0]) {
+            continue;
+        }
+
+        for (j = 0; j < numPages; j++) {
+            if (!Q_stricmp(pageNames[j], font->glyphs[i].shaderName)) {
+                break;
+            }
+        }
+        if (j == numPages) {
+            if (numPages == MAX_FONT_PAGES) {
+                return qfalse;
+            }
+            Q_strncpyz(pageNames[numPages++], font->glyphs[i].shaderName, sizeof(pageNames[0]));
+        }
+        glyphPage[i] = j;
+    }
+
+    if (numPages < 2) {
+        return qfalse;
+    }
+
+    for (i = 0; i < numPages; i++) {
+        COM_StripExtension(pageNames[i], name, sizeof(name));
+        if (R_FindShaderText(name)) {
+            return qfalse;
+        }
+    }
+
+    // lay the pages out on a power of two grid
+    cols = rows = 1;
+    while (cols * rows < numPages) {
+        if (cols <= rows) {
+            cols *= 2;
+        } else {
+            rows *= 2;
+        }
+    }
+
+    atlas = NULL;
+    pageWidth = pageHeight = 0;
+    for (i = 0; i < numPages; i++) {
+        R_LoadFontPage(pageNames[i], &pic, &width, &height);
+        if (!pic) {
+            break;
+        }
+
+        if (!atlas) {
+            pageWidth = width;
+            pageHeight = height;
+            if (pageWidth * cols > glConfig.maxTextureSize || pageHeight * rows > glConfig.maxTextureSize) {
+                ri.Free(pic);
+                break;
+            }
+
+            atlas = ri.Malloc(pageWidth * cols * pageHeight * rows * 4);
+            Com_Memset(atlas, 0, pageWidth * cols * pageHeight * rows * 4);
+        } else if (width != pageWidth || height != pageHeight) {
+            ri.Free(pic);
+            break;
+        }
+
+        col = i % cols;
+        row = i / cols;
+        atlasWidth = pageWidth * cols;
+        for (y = 0; y < pageHeight; y++) {
+            Com_Memcpy(atlas + ((row * pageHeight + y) * atlasWidth + col * pageWidth) * 4,
+                pic + y * pageWidth * 4, pageWidth * 4);
+        }
+
+        ri.Free(pic);
+    }
+
+    if (i < numPages) {
+        if (atlas) {
+            ri.Free(atlas);
+        }
+        return qfalse;
+    }
+
+    Com_sprintf(name, sizeof(name), "fonts/fontAtlas_%i", pointSize);
+    image = R_CreateImage(name, atlas, pageWidth * cols, pageHeight * rows, IMGTYPE_COLORALPHA, IMGFLAG_CLAMPTOEDGE, 0);
+    h = RE_RegisterShaderFromImage(name, lightmaps2D, stylesDefault, image, qfalse);
+    ri.Free(atlas);
+
+    // move the glyphs over to their spot in the atlas
+    for (i = GLYPH_START; i <= GLYPH_END; i++) {
+        if (glyphPage[i] < 0) {
+            continue;
+        }
+
+        glyph = &font->glyphs[i];
+        col = glyphPage[i] % cols;
+        row = glyphPage[i] / cols;
+
+        glyph->s = (col + glyph->s) / cols;
+        glyph->s2 = (col + glyph->s2) / cols;
+        glyph->t = (row + glyph->t) / rows;
+        glyph->t2 = (row + glyph->t2) / rows;
+        glyph->glyph = h;
+        Q_strncpyz(glyph->shaderName, name, sizeof(glyph->shaderName));
+    }
+
+    ri.Printf(PRINT_DEVELOPER, "...packed %i pages of %s into %ix%i\n", numPages, font->name, pageWidth * cols, pageHeight * rows);
+
+    return qtrue;
+}
+
 void RE_RegisterFont(const char *fontName, int pointSize, fontInfo_t *font) {
 #ifdef BUILD_FREETYPE
     FT_Face face;
@@ -397,8 +564,10 @@ void RE_RegisterFont(const char *fontName, int pointSize, fontInfo_t *font) {
 
 //      Com_Memcpy(font, faceData, sizeof(fontInfo_t));
         Q_strncpyz(font->name, name, sizeof(font->name));
-        for (i = GLYPH_START; i <= GLYPH_END; i++) {
-            font->glyphs[i].glyph = RE_RegisterShaderNoMip(font->glyphs[i].shaderName);
+        if (!R_PackFontAtlas(font, pointSize)) {
+            for (i = GLYPH_START; i <= GLYPH_END; i++) {
+                font->glyphs[i].glyph = RE_RegisterShaderNoMip(font->glyphs[i].shaderName);
+            }
         }
         Com_Memcpy(&registeredFont[registeredFontCount++], font, sizeof(fontInfo_t));
         ri.FS_FreeFile(faceData);
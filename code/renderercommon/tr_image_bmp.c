@@ -69,14 +69,14 @@ void R_LoadBMP( const char *name, byte **pic, int *width, int *height )
     //
     // load the file
     //
-    length = ri.FS_ReadFile( ( char * ) name, &buffer.v);
+    length = R_ImageReadFile( ( char * ) name, &buffer.v);
     if (!buffer.b || length < 0) {
         return;
     }
 
     if (length < 54)
     {
-        ri.Error( ERR_DROP, "LoadBMP: header too short (%s)", name );
+        R_ImageError( ERR_DROP, "LoadBMP: header too short (%s)", name );
     }
 
     buf_p = buffer.b;
@@ -116,33 +116,33 @@ void R_LoadBMP( const char *name, byte **pic, int *width, int *height )
     if ( bmpHeader.bitsPerPixel == 8 )
     {
         if (buf_p + sizeof(bmpHeader.palette) > end)
-            ri.Error( ERR_DROP, "LoadBMP: header too short (%s)", name );
+            R_ImageError( ERR_DROP, "LoadBMP: header too short (%s)", name );
 
         Com_Memcpy( bmpHeader.palette, buf_p, sizeof( bmpHeader.palette ) );
     }
 
     if (buffer.b + bmpHeader.bitmapDataOffset > end)
     {
-        ri.Error( ERR_DROP, "LoadBMP: invalid offset value in header (%s)", name );
+        R_ImageError( ERR_DROP, "LoadBMP: invalid offset value in header (%s)", name );
     }
 
     buf_p = buffer.b + bmpHeader.bitmapDataOffset;
 
     if ( bmpHeader.id[0] != 'B' && bmpHeader.id[1] != 'M' )
     {
-        ri.Error( ERR_DROP, "LoadBMP: only Windows-style BMP files supported (%s)", name );
+        R_ImageError( ERR_DROP, "LoadBMP: only Windows-style BMP files supported (%s)", name );
     }
     if ( bmpHeader.fileSize != length )
     {
-        ri.Error( ERR_DROP, "LoadBMP: header size does not match file size (%u vs. %u) (%s)", bmpHeader.fileSize, length, name );
+        R_ImageError( ERR_DROP, "LoadBMP: header size does not match file size (%u vs. %u) (%s)", bmpHeader.fileSize, length, name );
     }
     if ( bmpHeader.compression != 0 )
     {
-        ri.Error( ERR_DROP, "LoadBMP: only uncompressed BMP files supported (%s)", name );
+        R_ImageError( ERR_DROP, "LoadBMP: only uncompressed BMP files supported (%s)", name );
     }
     if ( bmpHeader.bitsPerPixel < 8 )
     {
-        ri.Error( ERR_DROP, "LoadBMP: monochrome and 4-bit BMP files not supported (%s)", name );
+        R_ImageError( ERR_DROP, "LoadBMP: monochrome and 4-bit BMP files not supported (%s)", name );
     }
 
     switch ( bmpHeader.bitsPerPixel )
@@ -153,7 +153,7 @@ void R_LoadBMP( const char *name, byte **pic, int *width, int *height )
         case 32:
             break;
         default:
-            ri.Error( ERR_DROP, "LoadBMP: illegal pixel_size '%hu' in file '%s'", bmpHeader.bitsPerPixel, name );
+            R_ImageError( ERR_DROP, "LoadBMP: illegal pixel_size '%hu' in file '%s'", bmpHeader.bitsPerPixel, name );
             break;
     }
 
@@ -166,11 +166,11 @@ void R_LoadBMP( const char *name, byte **pic, int *width, int *height )
     if(columns <= 0 || !rows || numPixels > 0x1FFFFFFF // 4*1FFFFFFF == 0x7FFFFFFC < 0x7FFFFFFF
         || ((numPixels * 4) / columns) / 4 != rows)
     {
-      ri.Error (ERR_DROP, "LoadBMP: %s has an invalid image size", name);
+      R_ImageError (ERR_DROP, "LoadBMP: %s has an invalid image size", name);
     }
     if(buf_p + numPixels*bmpHeader.bitsPerPixel/8 > end)
     {
-      ri.Error (ERR_DROP, "LoadBMP: file truncated (%s)", name);
+      R_ImageError (ERR_DROP, "LoadBMP: file truncated (%s)", name);
     }
 
     if ( width )
@@ -178,7 +178,7 @@ void R_LoadBMP( const char *name, byte **pic, int *width, int *height )
     if ( height )
         *height = rows;
 
-    bmpRGBA = ri.Malloc( numPixels * 4 );
+    bmpRGBA = R_ImageMalloc( numPixels * 4 );
     *pic = bmpRGBA;
 
 
@@ -233,6 +233,6 @@ void R_LoadBMP( const char *name, byte **pic, int *width, int *height )
         }
     }
 
-    ri.FS_FreeFile( buffer.v );
+    R_ImageFreeFile( buffer.v );
 
 }
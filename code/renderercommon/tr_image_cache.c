@@ -0,0 +1,814 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// tr_image_cache.c -- on-disk cache of processed images
+//
+// The first time an image is registered with r_imageCache on, the mip
+// chain the renderer uploaded is read back and written to imagecache/,
+// named after a hash of the source file and of everything that went
+// into processing it.  Later loads upload those levels directly and skip
+// decoding, resampling and mip-mapping.  Chains the driver left
+// uncompressed can be block compressed on the way out with
+// r_imageCacheCompress.
+//
+// The files are .dat and listed with the directories included, so a
+// client on a pure server still finds them.
+
+#include "tr_common.h"
+
+#define GLE(ret, name, ...) extern name##proc * qgl##name;
+QGL_1_1_PROCS;
+QGL_DESKTOP_1_1_PROCS;
+QGL_1_3_PROCS;
+#undef GLE
+
+#define IMAGECACHE_IDENT        (('C'<<24)+('T'<<16)+('M'<<8)+'I')
+#define IMAGECACHE_VERSION      1
+#define IMAGECACHE_DIR          "imagecache"
+#define IMAGECACHE_EXT          ".dat"
+
+typedef struct {
+    int         ident;
+    int         version;
+    int         paramsKey;
+    int         width, height;              // source image
+    int         uploadWidth, uploadHeight;  // level 0
+    int         internalFormat;
+    int         compressed;
+    int         numLevels;
+    int         levelSize[IMAGECACHE_MAX_LEVELS];
+} imageCacheHeader_t;
+
+// source hashes with a cache file, so the prefetcher can leave them alone
+static uint64_t     *cacheSources;
+static int          numCacheSources;
+static int          maxCacheSources;
+static qboolean     cacheSourcesListed;
+
+/*
+================
+R_ImageCacheHash
+
+FNV-1a over whole words, the source files can be several megabytes
+================
+*/
+static uint64_t R_ImageCacheHash( const byte *data, int length )
+{
+    uint64_t    hash = 0xcbf29ce484222325ULL;
+    uint64_t    word;
+    int         i;
+
+    for ( i = 0; i + 8 <= length; i += 8 ) {
+        Com_Memcpy( &word, data + i, sizeof( word ) );
+        hash = ( hash ^ word ) * 0x100000001b3ULL;
+    }
+
+    for ( ; i < length; i++ ) {
+        hash = ( hash ^ data[i] ) * 0x100000001b3ULL;
+    }
+
+    // fold the high bits back down, the word steps only carry upwards
+    hash ^= (uint64_t)length;
+    hash ^= hash >> 29;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+/*
+================
+R_ImageCacheParamsKey
+================
+*/
+static int R_ImageCacheParamsKey( const char *params )
+{
+    unsigned    hash = 2166136261U;
+
+    while ( *params ) {
+        hash = ( hash ^ (byte)*params++ ) * 16777619U;
+    }
+
+    return (int)hash;
+}
+
+/*
+================
+R_FindCacheSource
+================
+*/
+static int R_FindCacheSource( uint64_t hash )
+{
+    int     low, high, mid;
+
+    low = 0;
+    high = numCacheSources;
+    while ( low < high ) {
+        mid = ( low + high ) >> 1;
+        if ( cacheSources[mid] < hash ) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/*
+================
+R_AddCacheSource
+================
+*/
+static void R_AddCacheSource( uint64_t hash )
+{
+    int     i;
+
+    i = R_FindCacheSource( hash );
+    if ( i < numCacheSources && cacheSources[i] == hash ) {
+        return;
+    }
+
+    if ( numCacheSources == maxCacheSources ) {
+        uint64_t    *sources;
+
+        maxCacheSources = maxCacheSources ? maxCacheSources * 2 : 256;
+        sources = ri.Malloc( maxCacheSources * sizeof( *sources ) );
+        if ( cacheSources ) {
+            Com_Memcpy( sources, cacheSources, numCacheSources * sizeof( *sources ) );
+            ri.Free( cacheSources );
+        }
+        cacheSources = sources;
+    }
+
+    memmove( cacheSources + i + 1, cacheSources + i, ( numCacheSources - i ) * sizeof( *cacheSources ) );
+    cacheSources[i] = hash;
+    numCacheSources++;
+}
+
+/*
+================
+R_ListCacheSources
+================
+*/
+static void R_ListCacheSources( void )
+{
+    char        **files;
+    unsigned    high, low;
+    int         numFiles;
+    int         i;
+
+    cacheSourcesListed = qtrue;
+
+    files = ri.FS_ListFilteredFiles( IMAGECACHE_DIR, IMAGECACHE_EXT, NULL, &numFiles, qtrue );
+
+    for ( i = 0; i < numFiles; i++ ) {
+        if ( sscanf( files[i], "%8x%8x", &high, &low ) == 2 ) {
+            R_AddCacheSource( ( (uint64_t)high << 32 ) | low );
+        }
+    }
+
+    ri.FS_FreeFileList( files );
+}
+
+/*
+================
+R_ImageCacheHasSource
+
+True if some cache file was made from this source file, with
+whatever parameters
+================
+*/
+qboolean R_ImageCacheHasSource( const void *buffer, int length )
+{
+    uint64_t    hash;
+    int         i;
+
+    if ( !cacheSourcesListed ) {
+        R_ListCacheSources();
+    }
+
+    if ( !numCacheSources ) {
+        return qfalse;
+    }
+
+    hash = R_ImageCacheHash( buffer, length );
+    i = R_FindCacheSource( hash );
+
+    return ( i < numCacheSources && cacheSources[i] == hash );
+}
+
+/*
+================
+R_ReadCachedImage
+
+A file that is there but can't be read clears key->path, saving it
+again would only repeat the work on every load.
+================
+*/
+static qboolean R_ReadCachedImage( imageCacheKey_t *key, cachedImage_t *cached )
+{
+    union {
+        byte                *b;
+        imageCacheHeader_t  *h;
+        void                *v;
+    } buffer;
+    int     length, offset, size;
+    int     width, height;
+    int     i;
+
+    length = ri.FS_ReadFile( key->path, &buffer.v );
+    if ( !buffer.v ) {
+        if ( ri.FS_FileExists( key->path ) ) {
+            key->path[0] = '\0';
+        }
+        return qfalse;
+    }
+
+    if ( length < (int)sizeof( *buffer.h )
+        || LittleLong( buffer.h->ident ) != IMAGECACHE_IDENT
+        || LittleLong( buffer.h->version ) != IMAGECACHE_VERSION
+        || LittleLong( buffer.h->paramsKey ) != key->paramsKey ) {
+        ri.FS_FreeFile( buffer.v );
+        return qfalse;
+    }
+
+    cached->width = LittleLong( buffer.h->width );
+    cached->height = LittleLong( buffer.h->height );
+    cached->uploadWidth = LittleLong( buffer.h->uploadWidth );
+    cached->uploadHeight = LittleLong( buffer.h->uploadHeight );
+    cached->internalFormat = LittleLong( buffer.h->internalFormat );
+    cached->compressed = LittleLong( buffer.h->compressed );
+    cached->numLevels = LittleLong( buffer.h->numLevels );
+
+    if ( cached->width < 1 || cached->height < 1
+        || cached->uploadWidth < 1 || cached->uploadWidth > glConfig.maxTextureSize
+        || cached->uploadHeight < 1 || cached->uploadHeight > glConfig.maxTextureSize
+        || cached->numLevels < 1 || cached->numLevels > IMAGECACHE_MAX_LEVELS
+        || ( cached->compressed && !qglCompressedTexImage2D ) ) {
+        ri.FS_FreeFile( buffer.v );
+        return qfalse;
+    }
+
+    // an uncompressed level is read by the GL at its full size, so the
+    // file has to hold exactly that much
+    offset = sizeof( *buffer.h );
+    width = cached->uploadWidth;
+    height = cached->uploadHeight;
+    for ( i = 0; i < cached->numLevels; i++ ) {
+        size = LittleLong( buffer.h->levelSize[i] );
+
+        if ( size <= 0 || size > length - offset
+            || ( !cached->compressed && size != width * height * 4 ) ) {
+            ri.FS_FreeFile( buffer.v );
+            return qfalse;
+        }
+
+        cached->levelSize[i] = size;
+        cached->levels[i] = buffer.b + offset;
+        offset += size;
+
+        width = width > 1 ? width >> 1 : 1;
+        height = height > 1 ? height >> 1 : 1;
+    }
+
+    if ( offset != length ) {
+        ri.FS_FreeFile( buffer.v );
+        return qfalse;
+    }
+
+    cached->buffer = buffer.v;
+
+    return qtrue;
+}
+
+/*
+================
+R_FindCachedImage
+
+Resolves name the same way R_LoadImage does and looks for a cache file
+made from that source with these params.  On a miss key is still filled
+in for R_SaveCachedImage, unless there was no source to hash or the
+cache file is there but unreadable.
+================
+*/
+qboolean R_FindCachedImage( const char *name, const char *params, const imageExtToLoaderMap_t *loaders, int numLoaders,
+        imageCacheKey_t *key, cachedImage_t *cached )
+{
+    char        path[MAX_QPATH];
+    void        *source;
+    long        length;
+    qboolean    renamed;
+    int         loader;
+    int         start;
+
+    Com_Memset( key, 0, sizeof( *key ) );
+    Com_Memset( cached, 0, sizeof( *cached ) );
+
+    start = ri.Milliseconds();
+
+    length = R_ReadImageSource( name, loaders, numLoaders, path, sizeof( path ), &loader, &renamed, &source );
+    if ( !source ) {
+        return qfalse;
+    }
+
+    key->sourceHash = R_ImageCacheHash( source, length );
+    key->paramsKey = R_ImageCacheParamsKey( params );
+    ri.FS_FreeFile( source );
+
+    Com_sprintf( key->path, sizeof( key->path ), IMAGECACHE_DIR "/%08x%08x_%08x" IMAGECACHE_EXT,
+            (unsigned)( key->sourceHash >> 32 ), (unsigned)key->sourceHash, (unsigned)key->paramsKey );
+
+    if ( !R_ReadCachedImage( key, cached ) ) {
+        return qfalse;
+    }
+
+    if ( renamed ) {
+        ri.Printf( PRINT_DEVELOPER, "WARNING: %s not present, using %s instead\n", name, path );
+    }
+
+    cached->readMsec = ri.Milliseconds() - start;
+
+    return qtrue;
+}
+
+/*
+================
+R_FreeCachedImage
+================
+*/
+void R_FreeCachedImage( cachedImage_t *cached )
+{
+    if ( cached->buffer ) {
+        ri.FS_FreeFile( cached->buffer );
+        cached->buffer = NULL;
+    }
+}
+
+/*
+================
+R_SaveCachedImage
+
+Reads the levels of image back from the texture bound to GL_TEXTURE_2D
+and writes them under key.  If the driver stored them uncompressed and
+encodeFormat is set, they are block compressed to that format first.
+================
+*/
+void R_SaveCachedImage( const imageCacheKey_t *key, const image_t *image, GLenum encodeFormat )
+{
+    imageCacheHeader_t  *header;
+    byte        *out, *rgba = NULL;
+    int         levelSize[IMAGECACHE_MAX_LEVELS];
+    int         numLevels, compressed, internalFormat;
+    int         width, height;
+    int         total, offset;
+    GLint       value;
+    int         i;
+
+    if ( !key->path[0] ) {
+        return;
+    }
+
+    numLevels = 1;
+    if ( image->flags & IMGFLAG_MIPMAP ) {
+        for ( width = image->uploadWidth, height = image->uploadHeight; width > 1 || height > 1; numLevels++ ) {
+            width = width > 1 ? width >> 1 : 1;
+            height = height > 1 ? height >> 1 : 1;
+        }
+    }
+
+    if ( numLevels > IMAGECACHE_MAX_LEVELS ) {
+        return;
+    }
+
+    qglGetTexLevelParameteriv( GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &value );
+    compressed = ( value != 0 );
+
+    if ( compressed ) {
+        if ( !qglGetCompressedTexImage ) {
+            return;
+        }
+
+        qglGetTexLevelParameteriv( GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &value );
+        internalFormat = value;
+        encodeFormat = 0;
+    } else if ( encodeFormat ) {
+        internalFormat = encodeFormat;
+    } else {
+        internalFormat = image->internalFormat;
+    }
+
+    total = sizeof( *header );
+    width = image->uploadWidth;
+    height = image->uploadHeight;
+    for ( i = 0; i < numLevels; i++ ) {
+        if ( compressed ) {
+            qglGetTexLevelParameteriv( GL_TEXTURE_2D, i, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &value );
+            levelSize[i] = value;
+        } else if ( encodeFormat ) {
+            levelSize[i] = R_BlockImageSize( encodeFormat, width, height );
+        } else {
+            levelSize[i] = width * height * 4;
+        }
+
+        if ( levelSize[i] <= 0 ) {
+            return;
+        }
+
+        total += levelSize[i];
+
+        width = width > 1 ? width >> 1 : 1;
+        height = height > 1 ? height >> 1 : 1;
+    }
+
+    out = ri.Hunk_AllocateTempMemory( total );
+    if ( encodeFormat ) {
+        rgba = ri.Hunk_AllocateTempMemory( image->uploadWidth * image->uploadHeight * 4 );
+    }
+
+    offset = sizeof( *header );
+    width = image->uploadWidth;
+    height = image->uploadHeight;
+    for ( i = 0; i < numLevels; i++ ) {
+        if ( compressed ) {
+            qglGetCompressedTexImage( GL_TEXTURE_2D, i, out + offset );
+        } else if ( encodeFormat ) {
+            qglGetTexImage( GL_TEXTURE_2D, i, GL_RGBA, GL_UNSIGNED_BYTE, rgba );
+            R_CompressBlockImage( encodeFormat, rgba, width, height, out + offset );
+        } else {
+            qglGetTexImage( GL_TEXTURE_2D, i, GL_RGBA, GL_UNSIGNED_BYTE, out + offset );
+        }
+
+        offset += levelSize[i];
+
+        width = width > 1 ? width >> 1 : 1;
+        height = height > 1 ? height >> 1 : 1;
+    }
+
+    header = (imageCacheHeader_t *)out;
+    Com_Memset( header, 0, sizeof( *header ) );
+    header->ident = LittleLong( IMAGECACHE_IDENT );
+    header->version = LittleLong( IMAGECACHE_VERSION );
+    header->paramsKey = LittleLong( key->paramsKey );
+    header->width = LittleLong( image->width );
+    header->height = LittleLong( image->height );
+    header->uploadWidth = LittleLong( image->uploadWidth );
+    header->uploadHeight = LittleLong( image->uploadHeight );
+    header->internalFormat = LittleLong( internalFormat );
+    header->compressed = LittleLong( compressed || encodeFormat );
+    header->numLevels = LittleLong( numLevels );
+    for ( i = 0; i < numLevels; i++ ) {
+        header->levelSize[i] = LittleLong( levelSize[i] );
+    }
+
+    if ( qglGetError() == GL_NO_ERROR ) {
+        ri.FS_WriteFile( key->path, out, total );
+
+        if ( cacheSourcesListed ) {
+            R_AddCacheSource( key->sourceHash );
+        }
+    }
+
+    if ( rgba ) {
+        ri.Hunk_FreeTempMemory( rgba );
+    }
+    ri.Hunk_FreeTempMemory( out );
+}
+
+/*
+================
+R_ShutdownImageCache
+================
+*/
+void R_ShutdownImageCache( void )
+{
+    if ( cacheSources ) {
+        ri.Free( cacheSources );
+    }
+
+    cacheSources = NULL;
+    numCacheSources = 0;
+    maxCacheSources = 0;
+    cacheSourcesListed = qfalse;
+}
+
+/*
+=============================================================
+
+BLOCK COMPRESSION
+
+Bounding box encoders with the box inset a little, after J.M.P. van
+Waveren's "Real-Time DXT Compression".  Quality is below an exhaustive
+encoder but it's fast enough to run at load time, and it only runs
+once per image.
+
+=============================================================
+*/
+
+typedef struct {
+    const byte  *in;
+    byte        *out;
+    int         width, height;
+    int         blocksWide, blocksHigh;
+    int         rowsPerJob;     // rows of blocks
+    GLenum      format;
+} blockJob_t;
+
+/*
+================
+R_BlockImageSize
+================
+*/
+int R_BlockImageSize( GLenum format, int width, int height )
+{
+    int     numBlocks = ( ( width + 3 ) / 4 ) * ( ( height + 3 ) / 4 );
+
+    switch ( format ) {
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+            return numBlocks * 8;
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_RG_RGTC2:
+            return numBlocks * 16;
+        default:
+            return 0;
+    }
+}
+
+/*
+================
+R_FetchBlock
+
+Copies out a 4x4 block, repeating the edge texels of
+levels that are smaller than a block
+================
+*/
+static void R_FetchBlock( const byte *in, int width, int height, int bx, int by, byte block[64] )
+{
+    int     x, y, sx, sy;
+
+    for ( y = 0; y < 4; y++ ) {
+        sy = by * 4 + y;
+        if ( sy >= height ) {
+            sy = height - 1;
+        }
+
+        for ( x = 0; x < 4; x++ ) {
+            sx = bx * 4 + x;
+            if ( sx >= width ) {
+                sx = width - 1;
+            }
+
+            Com_Memcpy( block + ( y * 4 + x ) * 4, in + ( sy * width + sx ) * 4, 4 );
+        }
+    }
+}
+
+/*
+================
+R_EncodeColorBlock
+
+BC1 colour block, always in four colour mode
+================
+*/
+static void R_EncodeColorBlock( const byte block[64], byte out[8] )
+{
+    int             mins[3], maxs[3], inset;
+    int             colors[4][3];
+    unsigned short  c0, c1;
+    unsigned        indices;
+    int             i, j;
+
+    mins[0] = mins[1] = mins[2] = 255;
+    maxs[0] = maxs[1] = maxs[2] = 0;
+    for ( i = 0; i < 16; i++ ) {
+        for ( j = 0; j < 3; j++ ) {
+            if ( block[i * 4 + j] < mins[j] ) {
+                mins[j] = block[i * 4 + j];
+            }
+            if ( block[i * 4 + j] > maxs[j] ) {
+                maxs[j] = block[i * 4 + j];
+            }
+        }
+    }
+
+    for ( j = 0; j < 3; j++ ) {
+        inset = ( maxs[j] - mins[j] ) >> 4;
+        mins[j] += inset;
+        maxs[j] -= inset;
+    }
+
+    c0 = ( ( maxs[0] * 31 + 127 ) / 255 ) << 11 | ( ( maxs[1] * 63 + 127 ) / 255 ) << 5 | ( ( maxs[2] * 31 + 127 ) / 255 );
+    c1 = ( ( mins[0] * 31 + 127 ) / 255 ) << 11 | ( ( mins[1] * 63 + 127 ) / 255 ) << 5 | ( ( mins[2] * 31 + 127 ) / 255 );
+
+    out[0] = c0 & 255;
+    out[1] = c0 >> 8;
+    out[2] = c1 & 255;
+    out[3] = c1 >> 8;
+
+    // the box is ordered per channel, so c0 >= c1 and only a flat
+    // block would drop into three colour mode
+    indices = 0;
+    if ( c0 != c1 ) {
+        colors[0][0] = ( c0 >> 11 ) << 3 | ( c0 >> 13 );
+        colors[0][1] = ( ( c0 >> 5 ) & 63 ) << 2 | ( ( c0 >> 9 ) & 3 );
+        colors[0][2] = ( c0 & 31 ) << 3 | ( ( c0 >> 2 ) & 7 );
+        colors[1][0] = ( c1 >> 11 ) << 3 | ( c1 >> 13 );
+        colors[1][1] = ( ( c1 >> 5 ) & 63 ) << 2 | ( ( c1 >> 9 ) & 3 );
+        colors[1][2] = ( c1 & 31 ) << 3 | ( ( c1 >> 2 ) & 7 );
+
+        for ( j = 0; j < 3; j++ ) {
+            colors[2][j] = ( 2 * colors[0][j] + colors[1][j] ) / 3;
+            colors[3][j] = ( colors[0][j] + 2 * colors[1][j] ) / 3;
+        }
+
+        for ( i = 15; i >= 0; i-- ) {
+            const byte  *p = block + i * 4;
+            int         best = 0, bestDist = 0x7fffffff;
+            int         dist, d;
+            int         k;
+
+            for ( k = 0; k < 4; k++ ) {
+                d = p[0] - colors[k][0];
+                dist = d * d;
+                d = p[1] - colors[k][1];
+                dist += d * d;
+                d = p[2] - colors[k][2];
+                dist += d * d;
+
+                if ( dist < bestDist ) {
+                    bestDist = dist;
+                    best = k;
+                }
+            }
+
+            indices = ( indices << 2 ) | best;
+        }
+    }
+
+    out[4] = indices & 255;
+    out[5] = ( indices >> 8 ) & 255;
+    out[6] = ( indices >> 16 ) & 255;
+    out[7] = indices >> 24;
+}
+
+/*
+================
+R_EncodeChannelBlock
+
+BC3 alpha / BC4 block of one channel, in eight value mode
+================
+*/
+static void R_EncodeChannelBlock( const byte block[64], int channel, byte out[8] )
+{
+    int         values[8];
+    int         a0, a1, inset;
+    unsigned    lowBits, highBits;
+    int         i, k;
+
+    a0 = 0;
+    a1 = 255;
+    for ( i = 0; i < 16; i++ ) {
+        int     v = block[i * 4 + channel];
+
+        if ( v > a0 ) {
+            a0 = v;
+        }
+        if ( v < a1 ) {
+            a1 = v;
+        }
+    }
+
+    inset = ( a0 - a1 ) >> 5;
+    a0 -= inset;
+    a1 += inset;
+
+    out[0] = a0;
+    out[1] = a1;
+
+    values[0] = a0;
+    values[1] = a1;
+    for ( k = 1; k < 7; k++ ) {
+        values[k + 1] = ( ( 7 - k ) * a0 + k * a1 ) / 7;
+    }
+
+    // a flat block leaves every index at zero
+    lowBits = highBits = 0;
+    if ( a0 != a1 ) {
+        for ( i = 15; i >= 0; i-- ) {
+            int     v = block[i * 4 + channel];
+            int     best = 0, bestDist = 256;
+            int     dist;
+
+            for ( k = 0; k < 8; k++ ) {
+                dist = abs( v - values[k] );
+                if ( dist < bestDist ) {
+                    bestDist = dist;
+                    best = k;
+                }
+            }
+
+            // 48 bits of indices, 3 per texel
+            if ( i >= 8 ) {
+                highBits = ( highBits << 3 ) | best;
+            } else {
+                lowBits = ( lowBits << 3 ) | best;
+            }
+        }
+    }
+
+    out[2] = lowBits & 255;
+    out[3] = ( lowBits >> 8 ) & 255;
+    out[4] = ( lowBits >> 16 ) & 255;
+    out[5] = highBits & 255;
+    out[6] = ( highBits >> 8 ) & 255;
+    out[7] = ( highBits >> 16 ) & 255;
+}
+
+/*
+================
+R_CompressBlockRows
+================
+*/
+static void R_CompressBlockRows( void *data, int job )
+{
+    blockJob_t  *bj = data;
+    byte        block[64];
+    byte        *out;
+    int         blockSize;
+    int         bx, by, lastRow;
+
+    blockSize = ( bj->format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ) ? 8 : 16;
+
+    by = job * bj->rowsPerJob;
+    lastRow = by + bj->rowsPerJob;
+    if ( lastRow > bj->blocksHigh ) {
+        lastRow = bj->blocksHigh;
+    }
+
+    out = bj->out + by * bj->blocksWide * blockSize;
+    for ( ; by < lastRow; by++ ) {
+        for ( bx = 0; bx < bj->blocksWide; bx++, out += blockSize ) {
+            R_FetchBlock( bj->in, bj->width, bj->height, bx, by, block );
+
+            switch ( bj->format ) {
+                case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+                    R_EncodeColorBlock( block, out );
+                    break;
+                case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+                    R_EncodeChannelBlock( block, 3, out );
+                    R_EncodeColorBlock( block, out + 8 );
+                    break;
+                case GL_COMPRESSED_RG_RGTC2:
+                    R_EncodeChannelBlock( block, 0, out );
+                    R_EncodeChannelBlock( block, 1, out + 8 );
+                    break;
+            }
+        }
+    }
+}
+
+/*
+================
+R_CompressBlockImage
+
+Encodes an RGBA level as BC1 (DXT1), BC3 (DXT5) or BC5 (RGTC2),
+out must hold R_BlockImageSize bytes
+================
+*/
+void R_CompressBlockImage( GLenum format, const byte *in, int width, int height, byte *out )
+{
+    blockJob_t  bj;
+    int         numJobs, rows;
+
+    bj.in = in;
+    bj.out = out;
+    bj.width = width;
+    bj.height = height;
+    bj.blocksWide = ( width + 3 ) / 4;
+    bj.blocksHigh = ( height + 3 ) / 4;
+    bj.format = format;
+
+    R_ImageJobRows( width, height, &rows );
+    bj.rowsPerJob = ( rows + 3 ) / 4;
+    numJobs = ( bj.blocksHigh + bj.rowsPerJob - 1 ) / bj.rowsPerJob;
+
+    GLimp_RunJobs( R_CompressBlockRows, &bj, numJobs );
+}
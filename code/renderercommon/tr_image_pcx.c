@@ -74,15 +74,15 @@ void R_LoadPCX ( const char *filename, byte **pic, int *width, int *height)
     //
     // load the file
     //
-    len = ri.FS_ReadFile( ( char * ) filename, &raw.v);
+    len = R_ImageReadFile( ( char * ) filename, &raw.v);
     if (!raw.b || len < 0) {
         return;
     }
 
     if((unsigned)len < sizeof(pcx_t))
     {
-        ri.Printf (PRINT_ALL, "PCX truncated: %s\n", filename);
-        ri.FS_FreeFile (raw.v);
+        R_ImagePrintf (PRINT_ALL, "PCX truncated: %s\n", filename);
+        R_ImageFreeFile (raw.v);
         return;
     }
 
@@ -104,11 +104,11 @@ void R_LoadPCX ( const char *filename, byte **pic, int *width, int *height)
         || w >= 1024
         || h >= 1024)
     {
-        ri.Printf (PRINT_ALL, "Bad or unsupported pcx file %s (%dx%d@%d)\n", filename, w, h, pcx->bits_per_pixel);
+        R_ImagePrintf (PRINT_ALL, "Bad or unsupported pcx file %s (%dx%d@%d)\n", filename, w, h, pcx->bits_per_pixel);
         return;
     }
 
-    pix = pic8 = ri.Malloc ( size );
+    pix = pic8 = R_ImageMalloc ( size );
 
     raw.b = pcx->data;
     // FIXME: should use bytes_per_line but original q3 didn't do that either
@@ -137,22 +137,22 @@ void R_LoadPCX ( const char *filename, byte **pic, int *width, int *height)
 
     if(pix < pic8+size)
     {
-        ri.Printf (PRINT_ALL, "PCX file truncated: %s\n", filename);
-        ri.FS_FreeFile (pcx);
-        ri.Free (pic8);
+        R_ImagePrintf (PRINT_ALL, "PCX file truncated: %s\n", filename);
+        R_ImageFreeFile (pcx);
+        R_ImageFree (pic8);
     }
 
     if (raw.b-(byte*)pcx >= end - (byte*)769 || end[-769] != 0x0c)
     {
-        ri.Printf (PRINT_ALL, "PCX missing palette: %s\n", filename);
-        ri.FS_FreeFile (pcx);
-        ri.Free (pic8);
+        R_ImagePrintf (PRINT_ALL, "PCX missing palette: %s\n", filename);
+        R_ImageFreeFile (pcx);
+        R_ImageFree (pic8);
         return;
     }
 
     palette = end-768;
 
-    pix = out = ri.Malloc(4 * size );
+    pix = out = R_ImageMalloc(4 * size );
     for (i = 0 ; i < size ; i++)
     {
         unsigned char p = pic8[i];
@@ -170,6 +170,6 @@ void R_LoadPCX ( const char *filename, byte **pic, int *width, int *height)
 
     *pic = out;
 
-    ri.FS_FreeFile (pcx);
-    ri.Free (pic8);
+    R_ImageFreeFile (pcx);
+    R_ImageFree (pic8);
 }
@@ -233,7 +233,7 @@ static struct BufferedFile *ReadBufferedFile(const char *name)
      *  Allocate control struct.
      */
 
-    BF = ri.Malloc(sizeof(struct BufferedFile));
+    BF = R_ImageMalloc(sizeof(struct BufferedFile));
     if(!BF)
     {
         return(NULL);
@@ -252,7 +252,7 @@ static struct BufferedFile *ReadBufferedFile(const char *name)
      *  Read the file.
      */
 
-    BF->Length = ri.FS_ReadFile((char *) name, &buffer.v);
+    BF->Length = R_ImageReadFile((char *) name, &buffer.v);
     BF->Buffer = buffer.b;
 
     /*
@@ -261,7 +261,7 @@ static struct BufferedFile *ReadBufferedFile(const char *name)
 
     if(!(BF->Buffer && (BF->Length > 0)))
     {
-        ri.Free(BF);
+        R_ImageFree(BF);
 
         return(NULL);
     }
@@ -286,10 +286,10 @@ static void CloseBufferedFile(struct BufferedFile *BF)
     {
         if(BF->Buffer)
         {
-            ri.FS_FreeFile(BF->Buffer);
+            R_ImageFreeFile(BF->Buffer);
         }
 
-        ri.Free(BF);
+        R_ImageFree(BF);
     }
 }
 
@@ -623,7 +623,7 @@ static uint32_t DecompressIDATs(struct BufferedFile *BF, uint8_t **Buffer)
 
     BufferedFileRewind(BF, BytesToRewind);
 
-    CompressedData = ri.Malloc(CompressedDataLength);
+    CompressedData = R_ImageMalloc(CompressedDataLength);
     if(!CompressedData)
     {
         return(-1);
@@ -644,7 +644,7 @@ static uint32_t DecompressIDATs(struct BufferedFile *BF, uint8_t **Buffer)
         CH = BufferedFileRead(BF, PNG_ChunkHeader_Size);
         if(!CH)
         {
-            ri.Free(CompressedData);
+            R_ImageFree(CompressedData);
 
             return(-1);
         }
@@ -678,14 +678,14 @@ static uint32_t DecompressIDATs(struct BufferedFile *BF, uint8_t **Buffer)
             OrigCompressedData = BufferedFileRead(BF, Length);
             if(!OrigCompressedData)
             {
-                ri.Free(CompressedData);
+                R_ImageFree(CompressedData);
 
                 return(-1);
             }
 
             if(!BufferedFileSkip(BF, PNG_ChunkCRC_Size))
             {
-                ri.Free(CompressedData);
+                R_ImageFree(CompressedData);
 
                 return(-1);
             }
@@ -716,7 +716,7 @@ static uint32_t DecompressIDATs(struct BufferedFile *BF, uint8_t **Buffer)
     puffResult = puff(puffDest, &puffDestLen, puffSrc, &puffSrcLen);
     if(!((puffResult == 0) && (puffDestLen > 0)))
     {
-        ri.Free(CompressedData);
+        R_ImageFree(CompressedData);
 
         return(-1);
     }
@@ -725,10 +725,10 @@ static uint32_t DecompressIDATs(struct BufferedFile *BF, uint8_t **Buffer)
      *  Allocate the buffer for the uncompressed data.
      */
 
-    DecompressedData = ri.Malloc(puffDestLen);
+    DecompressedData = R_ImageMalloc(puffDestLen);
     if(!DecompressedData)
     {
-        ri.Free(CompressedData);
+        R_ImageFree(CompressedData);
 
         return(-1);
     }
@@ -751,7 +751,7 @@ static uint32_t DecompressIDATs(struct BufferedFile *BF, uint8_t **Buffer)
      *  The compressed data is not needed anymore.
      */
 
-    ri.Free(CompressedData);
+    R_ImageFree(CompressedData);
 
     /*
      *  Check if the last puff() was successful.
@@ -759,7 +759,7 @@ static uint32_t DecompressIDATs(struct BufferedFile *BF, uint8_t **Buffer)
 
     if(!((puffResult == 0) && (puffDestLen > 0)))
     {
-        ri.Free(DecompressedData);
+        R_ImageFree(DecompressedData);
 
         return(-1);
     }
@@ -2062,7 +2062,7 @@ static void LoadPNG(const char *name, byte **pic, int *width, int *height, qbool
     {
         CloseBufferedFile(ThePNG);
 
-        ri.Printf( PRINT_WARNING, "%s: invalid image size\n", name );
+        R_ImagePrintf( PRINT_WARNING, "%s: invalid image size\n", name );
 
         return;
     }
@@ -2417,10 +2417,10 @@ static void LoadPNG(const char *name, byte **pic, int *width, int *height, qbool
      *  Allocate output buffer.
      */
 
-    OutBuffer = ri.Malloc(IHDR_Width * IHDR_Height * Q3IMAGE_BYTESPERPIXEL);
+    OutBuffer = R_ImageMalloc(IHDR_Width * IHDR_Height * Q3IMAGE_BYTESPERPIXEL);
     if(!OutBuffer)
     {
-        ri.Free(DecompressedData);
+        R_ImageFree(DecompressedData);
         CloseBufferedFile(ThePNG);
 
         return;
@@ -2436,8 +2436,8 @@ static void LoadPNG(const char *name, byte **pic, int *width, int *height, qbool
         {
             if(!DecodeImageNonInterlaced(IHDR, OutBuffer, DecompressedData, DecompressedDataLength, HasTransparentColour, TransparentColour, OutPal))
             {
-                ri.Free(OutBuffer);
-                ri.Free(DecompressedData);
+                R_ImageFree(OutBuffer);
+                R_ImageFree(DecompressedData);
                 CloseBufferedFile(ThePNG);
 
                 return;
@@ -2450,8 +2450,8 @@ static void LoadPNG(const char *name, byte **pic, int *width, int *height, qbool
         {
             if(!DecodeImageInterlaced(IHDR, OutBuffer, DecompressedData, DecompressedDataLength, HasTransparentColour, TransparentColour, OutPal))
             {
-                ri.Free(OutBuffer);
-                ri.Free(DecompressedData);
+                R_ImageFree(OutBuffer);
+                R_ImageFree(DecompressedData);
                 CloseBufferedFile(ThePNG);
 
                 return;
@@ -2462,8 +2462,8 @@ static void LoadPNG(const char *name, byte **pic, int *width, int *height, qbool
 
         default :
         {
-            ri.Free(OutBuffer);
-            ri.Free(DecompressedData);
+            R_ImageFree(OutBuffer);
+            R_ImageFree(DecompressedData);
             CloseBufferedFile(ThePNG);
 
             return;
@@ -2494,7 +2494,7 @@ static void LoadPNG(const char *name, byte **pic, int *width, int *height, qbool
      *  DecompressedData is not needed anymore.
      */
 
-    ri.Free(DecompressedData);
+    R_ImageFree(DecompressedData);
 
     /*
      *  We have all data, so close the file.
@@ -0,0 +1,567 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// tr_image_prefetch.c -- file access for the image loaders and parallel
+// decoding of the images a map is about to register
+//
+// Files are read on the main thread, since the filesystem and the zone
+// aren't thread safe.  The loaders then run on the worker threads against
+// the buffers already in memory, and the decoded pictures wait here until
+// R_LoadImage takes them, so every upload still happens on the GL thread.
+
+#include "tr_common.h"
+#include <setjmp.h>
+
+#if defined( _MSC_VER )
+#define PREFETCH_THREAD __declspec( thread )
+#else
+#define PREFETCH_THREAD __thread
+#endif
+
+#define PREFETCH_HASH_SIZE      256
+#define PREFETCH_BATCH_FILES    64
+#define PREFETCH_BATCH_BYTES    ( 8 << 20 )     // compressed bytes read per decode batch
+#define PREFETCH_MAX_HELD       ( 192 << 20 )   // decoded bytes waiting to be uploaded
+
+// allocations made by a loader on a worker thread, so an aborted
+// decode can give all of them back
+typedef union prefetchAlloc_u {
+    struct {
+        union prefetchAlloc_u   *prev, *next;
+    } link;
+    double      align[2];
+} prefetchAlloc_t;
+
+typedef struct prefetchImage_s {
+    char        name[MAX_QPATH];        // as requested
+    char        path[MAX_QPATH];        // the file that was found
+    void        (*loader)( const char *, unsigned char **, int *, int * );
+
+    void        *buffer;
+    int         length;
+
+    byte        *pic;
+    int         width, height;
+    int         readMsec, decodeMsec;
+
+    qboolean    renamed;                // not found under the requested extension
+    int         messageLevel;
+    char        message[256];           // printed when the image is taken
+
+    prefetchAlloc_t allocs;
+    jmp_buf     abort;
+
+    struct prefetchImage_s  *next;
+} prefetchImage_t;
+
+static prefetchImage_t  *prefetchHash[PREFETCH_HASH_SIZE];
+static int              prefetchHeldBytes;
+
+static int              imageReadMsec;  // main thread file reads since R_ImageReadTime
+
+static PREFETCH_THREAD prefetchImage_t  *prefetchJob;
+
+/*
+================
+R_PrefetchHash
+================
+*/
+static int R_PrefetchHash( const char *name )
+{
+    unsigned    hash;
+
+    for ( hash = 0; *name; name++ ) {
+        hash = hash * 31 + tolower( *name );
+    }
+
+    return hash & ( PREFETCH_HASH_SIZE - 1 );
+}
+
+/*
+================
+R_FindPrefetchedImage
+================
+*/
+static prefetchImage_t **R_FindPrefetchedImage( const char *name )
+{
+    prefetchImage_t **link;
+
+    for ( link = &prefetchHash[R_PrefetchHash( name )]; *link; link = &( *link )->next ) {
+        if ( !strcmp( ( *link )->name, name ) ) {
+            return link;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+================
+R_FreePrefetchAllocs
+================
+*/
+static void R_FreePrefetchAllocs( prefetchImage_t *image )
+{
+    prefetchAlloc_t *alloc, *next;
+
+    for ( alloc = image->allocs.link.next; alloc != &image->allocs; alloc = next ) {
+        next = alloc->link.next;
+        free( alloc );
+    }
+
+    image->allocs.link.prev = image->allocs.link.next = &image->allocs;
+    image->pic = NULL;
+}
+
+/*
+=============================================================
+
+LOADER FILE ACCESS
+
+The image loaders go through these instead of ri so that the
+same code can decode on a worker thread
+
+=============================================================
+*/
+
+/*
+================
+R_ImageReadFile
+================
+*/
+long R_ImageReadFile( const char *name, void **buffer )
+{
+    long    length;
+    int     start;
+
+    if ( prefetchJob ) {
+        if ( Q_stricmp( name, prefetchJob->path ) ) {
+            *buffer = NULL;
+            return -1;
+        }
+
+        *buffer = prefetchJob->buffer;
+        return prefetchJob->length;
+    }
+
+    start = ri.Milliseconds();
+    length = ri.FS_ReadFile( name, buffer );
+    imageReadMsec += ri.Milliseconds() - start;
+
+    return length;
+}
+
+/*
+================
+R_ImageFreeFile
+================
+*/
+void R_ImageFreeFile( void *buffer )
+{
+    // prefetched buffers are released by the batch that read them
+    if ( !prefetchJob ) {
+        ri.FS_FreeFile( buffer );
+    }
+}
+
+/*
+================
+R_ImageMalloc
+================
+*/
+void *R_ImageMalloc( int bytes )
+{
+    prefetchAlloc_t *alloc;
+
+    if ( !prefetchJob ) {
+        return ri.Malloc( bytes );
+    }
+
+    alloc = malloc( sizeof( *alloc ) + bytes );
+    if ( !alloc ) {
+        R_ImageError( ERR_DROP, "R_ImageMalloc: failed on allocation of %i bytes", bytes );
+    }
+
+    alloc->link.prev = &prefetchJob->allocs;
+    alloc->link.next = prefetchJob->allocs.link.next;
+    alloc->link.next->link.prev = alloc;
+    prefetchJob->allocs.link.next = alloc;
+
+    return alloc + 1;
+}
+
+/*
+================
+R_ImageFree
+================
+*/
+void R_ImageFree( void *buffer )
+{
+    prefetchAlloc_t *alloc;
+
+    if ( !prefetchJob ) {
+        ri.Free( buffer );
+        return;
+    }
+
+    alloc = (prefetchAlloc_t *)buffer - 1;
+    alloc->link.prev->link.next = alloc->link.next;
+    alloc->link.next->link.prev = alloc->link.prev;
+    free( alloc );
+}
+
+/*
+================
+R_ImagePrintf
+
+Worker threads keep the message for R_TakePrefetchedImage
+================
+*/
+void QDECL R_ImagePrintf( int printLevel, const char *fmt, ... )
+{
+    va_list     argptr;
+    char        msg[1024];
+
+    va_start( argptr, fmt );
+    Q_vsnprintf( msg, sizeof( msg ), fmt, argptr );
+    va_end( argptr );
+
+    if ( !prefetchJob ) {
+        ri.Printf( printLevel, "%s", msg );
+        return;
+    }
+
+    if ( !prefetchJob->message[0] ) {
+        prefetchJob->messageLevel = printLevel;
+    }
+    Q_strcat( prefetchJob->message, sizeof( prefetchJob->message ), msg );
+}
+
+/*
+================
+R_ImageError
+
+A worker thread abandons the decode instead, R_LoadImage then loads
+the image again on the main thread and raises the error from there
+================
+*/
+void QDECL R_ImageError( int errorLevel, const char *fmt, ... )
+{
+    va_list     argptr;
+    char        msg[1024];
+
+    if ( prefetchJob ) {
+        longjmp( prefetchJob->abort, 1 );
+    }
+
+    va_start( argptr, fmt );
+    Q_vsnprintf( msg, sizeof( msg ), fmt, argptr );
+    va_end( argptr );
+
+    ri.Error( errorLevel, "%s", msg );
+}
+
+/*
+================
+R_ImageReadTime
+
+Returns the msec spent reading image files on the main
+thread since the last call
+================
+*/
+int R_ImageReadTime( void )
+{
+    int     msec;
+
+    msec = imageReadMsec;
+    imageReadMsec = 0;
+
+    return msec;
+}
+
+/*
+=============================================================
+
+PREFETCHING
+
+=============================================================
+*/
+
+/*
+================
+R_ReadImageSource
+
+Finds the file behind an image name the same way R_LoadImage does: the
+extension that was asked for first, then every loader in order of
+preference.  Returns the length, or -1 with *buffer NULL.  A NULL
+buffer only resolves the name, nothing is read.
+================
+*/
+long R_ReadImageSource( const char *name, const imageExtToLoaderMap_t *loaders, int numLoaders,
+        char *path, int pathSize, int *loader, qboolean *renamed, void **buffer )
+{
+    char        localName[MAX_QPATH];
+    const char  *ext;
+    long        length;
+    int         orgLoader = -1;
+    int         i;
+
+    if ( buffer ) {
+        *buffer = NULL;
+    }
+    *renamed = qfalse;
+
+    Q_strncpyz( localName, name, sizeof( localName ) );
+
+    ext = COM_GetExtension( localName );
+
+    if ( *ext ) {
+        for ( i = 0; i < numLoaders; i++ ) {
+            if ( !Q_stricmp( ext, loaders[i].ext ) ) {
+                break;
+            }
+        }
+
+        if ( i < numLoaders ) {
+            length = ri.FS_ReadFile( localName, buffer );
+            if ( ( !buffer || *buffer ) && length >= 0 ) {
+                Q_strncpyz( path, localName, pathSize );
+                *loader = i;
+                return length;
+            }
+
+            orgLoader = i;
+            COM_StripExtension( name, localName, sizeof( localName ) );
+        }
+    }
+
+    for ( i = 0; i < numLoaders; i++ ) {
+        char    altName[MAX_QPATH];
+
+        if ( i == orgLoader ) {
+            continue;
+        }
+
+        Com_sprintf( altName, sizeof( altName ), "%s.%s", localName, loaders[i].ext );
+
+        length = ri.FS_ReadFile( altName, buffer );
+        if ( ( !buffer || *buffer ) && length >= 0 ) {
+            Q_strncpyz( path, altName, pathSize );
+            *loader = i;
+            *renamed = ( orgLoader >= 0 );
+            return length;
+        }
+    }
+
+    if ( buffer ) {
+        *buffer = NULL;
+    }
+    return -1;
+}
+
+/*
+================
+R_DecodePrefetchJob
+================
+*/
+static void R_DecodePrefetchJob( void *data, int index )
+{
+    prefetchImage_t *image = ( (prefetchImage_t **)data )[index];
+    int             start;
+
+    start = ri.Milliseconds();
+
+    prefetchJob = image;
+
+    if ( !setjmp( image->abort ) ) {
+        image->loader( image->path, &image->pic, &image->width, &image->height );
+    } else {
+        image->pic = NULL;
+    }
+
+    prefetchJob = NULL;
+
+    // anything the loader left behind, the picture included, is freed
+    // when the image is taken
+    if ( !image->pic ) {
+        R_FreePrefetchAllocs( image );
+    }
+
+    image->decodeMsec = ri.Milliseconds() - start;
+}
+
+/*
+================
+R_PrefetchImageFiles
+
+Reads the named images in batches and decodes each batch on the
+worker threads.  Names that are already waiting or can't be found
+are skipped, they'll be loaded as usual by R_LoadImage.
+================
+*/
+void R_PrefetchImageFiles( const char **names, int numNames, const imageExtToLoaderMap_t *loaders, int numLoaders )
+{
+    prefetchImage_t *batch[PREFETCH_BATCH_FILES];
+    prefetchImage_t *image;
+    int             numBatch, batchBytes;
+    int             start;
+    int             i, j;
+
+    if ( !GLimp_NumJobThreads() ) {
+        return;
+    }
+
+    i = 0;
+    while ( i < numNames && prefetchHeldBytes < PREFETCH_MAX_HELD ) {
+        numBatch = 0;
+        batchBytes = 0;
+
+        for ( ; i < numNames && numBatch < PREFETCH_BATCH_FILES && batchBytes < PREFETCH_BATCH_BYTES; i++ ) {
+            int     hash, loader;
+
+            if ( !names[i][0] || strlen( names[i] ) >= MAX_QPATH || R_FindPrefetchedImage( names[i] ) ) {
+                continue;
+            }
+
+            image = ri.Malloc( sizeof( *image ) );
+            Com_Memset( image, 0, sizeof( *image ) );
+            Q_strncpyz( image->name, names[i], sizeof( image->name ) );
+            image->allocs.link.prev = image->allocs.link.next = &image->allocs;
+
+            start = ri.Milliseconds();
+            image->length = R_ReadImageSource( image->name, loaders, numLoaders,
+                    image->path, sizeof( image->path ), &loader, &image->renamed, &image->buffer );
+            if ( !image->buffer ) {
+                ri.Free( image );
+                continue;
+            }
+
+            // a cached copy will be uploaded instead of decoding this
+            if ( r_imageCache->integer && R_ImageCacheHasSource( image->buffer, image->length ) ) {
+                ri.FS_FreeFile( image->buffer );
+                ri.Free( image );
+                continue;
+            }
+
+            image->loader = loaders[loader].ImageLoader;
+            image->readMsec = ri.Milliseconds() - start;
+
+            hash = R_PrefetchHash( image->name );
+            image->next = prefetchHash[hash];
+            prefetchHash[hash] = image;
+
+            batch[numBatch++] = image;
+            batchBytes += image->length;
+        }
+
+        GLimp_RunJobs( R_DecodePrefetchJob, batch, numBatch );
+
+        // the file buffers are temp hunk memory, so give them back in reverse
+        for ( j = numBatch - 1; j >= 0; j-- ) {
+            image = batch[j];
+
+            ri.FS_FreeFile( image->buffer );
+            image->buffer = NULL;
+
+            if ( !image->pic ) {
+                prefetchImage_t **link = R_FindPrefetchedImage( image->name );
+
+                *link = image->next;
+                ri.Free( image );
+                continue;
+            }
+
+            prefetchHeldBytes += image->width * image->height * 4;
+        }
+    }
+}
+
+/*
+================
+R_TakePrefetchedImage
+
+Hands over a prefetched picture in ri.Malloc memory, returns
+qfalse if name wasn't prefetched or failed to decode
+================
+*/
+qboolean R_TakePrefetchedImage( const char *name, byte **pic, int *width, int *height, int *readMsec, int *decodeMsec )
+{
+    prefetchImage_t **link;
+    prefetchImage_t *image;
+    int             size;
+
+    link = R_FindPrefetchedImage( name );
+    if ( !link ) {
+        return qfalse;
+    }
+
+    image = *link;
+    *link = image->next;
+
+    if ( image->message[0] ) {
+        ri.Printf( image->messageLevel, "%s", image->message );
+    }
+
+    if ( image->renamed ) {
+        ri.Printf( PRINT_DEVELOPER, "WARNING: %s not present, using %s instead\n", name, image->path );
+    }
+
+    size = image->width * image->height * 4;
+
+    *pic = ri.Malloc( size );
+    Com_Memcpy( *pic, image->pic, size );
+    *width = image->width;
+    *height = image->height;
+    *readMsec = image->readMsec;
+    *decodeMsec = image->decodeMsec;
+
+    prefetchHeldBytes -= size;
+
+    R_FreePrefetchAllocs( image );
+    ri.Free( image );
+
+    return qtrue;
+}
+
+/*
+================
+R_ClearPrefetchedImages
+
+Drops whatever was prefetched but never registered
+================
+*/
+void R_ClearPrefetchedImages( void )
+{
+    prefetchImage_t *image;
+    int             i;
+
+    for ( i = 0; i < PREFETCH_HASH_SIZE; i++ ) {
+        while ( prefetchHash[i] ) {
+            image = prefetchHash[i];
+            prefetchHash[i] = image->next;
+
+            R_FreePrefetchAllocs( image );
+            ri.Free( image );
+        }
+    }
+
+    prefetchHeldBytes = 0;
+}
@@ -0,0 +1,364 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// tr_image_process.c -- resampling, mip generation and color remapping
+// shared by both renderers' texture upload paths
+
+#include "tr_common.h"
+
+#if idx64 || defined(__SSE2__)
+#define IMG_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#ifndef MIN
+#define MIN(a,b) ((a) < (b) ? (a) : (b))
+#endif
+
+#define IMAGE_JOB_PIXELS    32768   // output pixels handed to a worker at a time
+#define IMAGE_JOB_MIN       65536   // smaller images aren't worth waking the workers for
+
+/*
+================
+R_ImageJobRows
+
+Splits an image into row bands for GLimp_RunJobs, returns the number of bands
+================
+*/
+int R_ImageJobRows( int width, int height, int *rowsPerJob )
+{
+    if ( width * height < IMAGE_JOB_MIN || !GLimp_NumJobThreads() ) {
+        *rowsPerJob = height;
+        return 1;
+    }
+
+    *rowsPerJob = IMAGE_JOB_PIXELS / width;
+    if ( *rowsPerJob < 1 ) {
+        *rowsPerJob = 1;
+    }
+
+    return ( height + *rowsPerJob - 1 ) / *rowsPerJob;
+}
+
+
+/*
+====================================================================
+
+RESAMPLE
+
+====================================================================
+*/
+
+typedef struct {
+    const byte  *in;
+    byte        *out;
+    int         inwidth, inheight;
+    int         outwidth, outheight;
+    int         rowsPerJob;
+    const int   *p1, *p2;
+} resampleJob_t;
+
+/*
+================
+R_ResampleRows
+================
+*/
+static void R_ResampleRows( void *data, int job )
+{
+    const resampleJob_t *rj = data;
+    const unsigned  *inrow, *inrow2;
+    unsigned    *out;
+    int         i, j, k, last;
+
+    i = job * rj->rowsPerJob;
+    last = MIN( i + rj->rowsPerJob, rj->outheight );
+
+    for ( ; i < last ; i++ ) {
+        inrow = (const unsigned *)rj->in + rj->inwidth*(int)((i+0.25)*rj->inheight/rj->outheight);
+        inrow2 = (const unsigned *)rj->in + rj->inwidth*(int)((i+0.75)*rj->inheight/rj->outheight);
+        out = (unsigned *)rj->out + i * rj->outwidth;
+        j = 0;
+
+#ifdef IMG_SSE2
+        {
+            __m128i zero = _mm_setzero_si128();
+
+            for ( ; j + 4 <= rj->outwidth ; j += 4 ) {
+                const int   *p1 = rj->p1 + j, *p2 = rj->p2 + j;
+                __m128i     a = _mm_set_epi32( inrow[p1[3]], inrow[p1[2]], inrow[p1[1]], inrow[p1[0]] );
+                __m128i     b = _mm_set_epi32( inrow[p2[3]], inrow[p2[2]], inrow[p2[1]], inrow[p2[0]] );
+                __m128i     c = _mm_set_epi32( inrow2[p1[3]], inrow2[p1[2]], inrow2[p1[1]], inrow2[p1[0]] );
+                __m128i     d = _mm_set_epi32( inrow2[p2[3]], inrow2[p2[2]], inrow2[p2[1]], inrow2[p2[0]] );
+                __m128i     lo, hi;
+
+                lo = _mm_add_epi16( _mm_add_epi16( _mm_unpacklo_epi8( a, zero ), _mm_unpacklo_epi8( b, zero ) ),
+                                    _mm_add_epi16( _mm_unpacklo_epi8( c, zero ), _mm_unpacklo_epi8( d, zero ) ) );
+                hi = _mm_add_epi16( _mm_add_epi16( _mm_unpackhi_epi8( a, zero ), _mm_unpackhi_epi8( b, zero ) ),
+                                    _mm_add_epi16( _mm_unpackhi_epi8( c, zero ), _mm_unpackhi_epi8( d, zero ) ) );
+                _mm_storeu_si128( (__m128i *)( out + j ),
+                    _mm_packus_epi16( _mm_srli_epi16( lo, 2 ), _mm_srli_epi16( hi, 2 ) ) );
+            }
+        }
+#endif
+
+        for ( ; j < rj->outwidth ; j++ ) {
+            const byte  *pix1 = (const byte *)( inrow + rj->p1[j] );
+            const byte  *pix2 = (const byte *)( inrow + rj->p2[j] );
+            const byte  *pix3 = (const byte *)( inrow2 + rj->p1[j] );
+            const byte  *pix4 = (const byte *)( inrow2 + rj->p2[j] );
+
+            for ( k = 0 ; k < 4 ; k++ ) {
+                ((byte *)(out+j))[k] = (pix1[k] + pix2[k] + pix3[k] + pix4[k])>>2;
+            }
+        }
+    }
+}
+
+/*
+================
+R_ResampleTextureRGBA
+
+Used to resample images in a more general than quartering fashion.
+
+This will only be filtered properly if the resampled size
+is greater than half the original size.
+
+If a larger shrinking is needed, use the mipmap function
+before or after.
+================
+*/
+void R_ResampleTextureRGBA( const byte *in, int inwidth, int inheight, byte *out, int outwidth, int outheight )
+{
+    int     i;
+    unsigned    frac, fracstep;
+    int     p1[2048], p2[2048];
+    resampleJob_t   rj;
+
+    if (outwidth>2048)
+        ri.Error(ERR_DROP, "ResampleTexture: max width");
+
+    fracstep = inwidth*0x10000/outwidth;
+
+    frac = fracstep>>2;
+    for ( i=0 ; i<outwidth ; i++ ) {
+        p1[i] = frac>>16;
+        frac += fracstep;
+    }
+    frac = 3*(fracstep>>2);
+    for ( i=0 ; i<outwidth ; i++ ) {
+        p2[i] = frac>>16;
+        frac += fracstep;
+    }
+
+    rj.in = in;
+    rj.out = out;
+    rj.inwidth = inwidth;
+    rj.inheight = inheight;
+    rj.outwidth = outwidth;
+    rj.outheight = outheight;
+    rj.p1 = p1;
+    rj.p2 = p2;
+
+    GLimp_RunJobs( R_ResampleRows, &rj, R_ImageJobRows( outwidth, outheight, &rj.rowsPerJob ) );
+}
+
+
+/*
+====================================================================
+
+BOX FILTER MIPMAP
+
+====================================================================
+*/
+
+typedef struct {
+    const byte  *in;
+    byte        *out;
+    int         width;      // output size
+    int         height;
+    int         rowsPerJob;
+} mipJob_t;
+
+/*
+================
+R_MipMapBoxRows
+
+Rows are walked front to back, which keeps the single band case safe in place
+================
+*/
+static void R_MipMapBoxRows( void *data, int job )
+{
+    const mipJob_t  *mj = data;
+    const byte  *in;
+    byte        *out;
+    int         i, j, last, row;
+
+    row = mj->width * 8;
+    i = job * mj->rowsPerJob;
+    last = MIN( i + mj->rowsPerJob, mj->height );
+
+    for ( ; i < last ; i++ ) {
+        in = mj->in + i * row * 2;
+        out = mj->out + i * mj->width * 4;
+        j = 0;
+
+#ifdef IMG_SSE2
+        {
+            __m128i zero = _mm_setzero_si128();
+
+            for ( ; j + 4 <= mj->width ; j += 4, in += 32, out += 16 ) {
+                __m128  a0 = _mm_castsi128_ps( _mm_loadu_si128( (const __m128i *)in ) );
+                __m128  a1 = _mm_castsi128_ps( _mm_loadu_si128( (const __m128i *)( in + 16 ) ) );
+                __m128  b0 = _mm_castsi128_ps( _mm_loadu_si128( (const __m128i *)( in + row ) ) );
+                __m128  b1 = _mm_castsi128_ps( _mm_loadu_si128( (const __m128i *)( in + row + 16 ) ) );
+                __m128i ae = _mm_castps_si128( _mm_shuffle_ps( a0, a1, _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+                __m128i ao = _mm_castps_si128( _mm_shuffle_ps( a0, a1, _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+                __m128i be = _mm_castps_si128( _mm_shuffle_ps( b0, b1, _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+                __m128i bo = _mm_castps_si128( _mm_shuffle_ps( b0, b1, _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+                __m128i lo, hi;
+
+                lo = _mm_add_epi16( _mm_add_epi16( _mm_unpacklo_epi8( ae, zero ), _mm_unpacklo_epi8( ao, zero ) ),
+                                    _mm_add_epi16( _mm_unpacklo_epi8( be, zero ), _mm_unpacklo_epi8( bo, zero ) ) );
+                hi = _mm_add_epi16( _mm_add_epi16( _mm_unpackhi_epi8( ae, zero ), _mm_unpackhi_epi8( ao, zero ) ),
+                                    _mm_add_epi16( _mm_unpackhi_epi8( be, zero ), _mm_unpackhi_epi8( bo, zero ) ) );
+                _mm_storeu_si128( (__m128i *)out, _mm_packus_epi16( _mm_srli_epi16( lo, 2 ), _mm_srli_epi16( hi, 2 ) ) );
+            }
+        }
+#endif
+
+        for ( ; j < mj->width ; j++, out += 4, in += 8 ) {
+            out[0] = (in[0] + in[4] + in[row+0] + in[row+4])>>2;
+            out[1] = (in[1] + in[5] + in[row+1] + in[row+5])>>2;
+            out[2] = (in[2] + in[6] + in[row+2] + in[row+6])>>2;
+            out[3] = (in[3] + in[7] + in[row+3] + in[row+7])>>2;
+        }
+    }
+}
+
+/*
+================
+R_MipMapBoxRGBA
+
+Operates in place, quartering the size of the texture
+================
+*/
+void R_MipMapBoxRGBA( byte *in, int width, int height )
+{
+    int     i, numJobs;
+    byte    *out;
+    mipJob_t    mj;
+
+    if ( width == 1 && height == 1 ) {
+        return;
+    }
+
+    out = in;
+    width >>= 1;
+    height >>= 1;
+
+    if ( width == 0 || height == 0 ) {
+        width += height;    // get largest
+        for (i=0 ; i<width ; i++, out+=4, in+=8 ) {
+            out[0] = ( in[0] + in[4] )>>1;
+            out[1] = ( in[1] + in[5] )>>1;
+            out[2] = ( in[2] + in[6] )>>1;
+            out[3] = ( in[3] + in[7] )>>1;
+        }
+        return;
+    }
+
+    mj.in = in;
+    mj.width = width;
+    mj.height = height;
+    numJobs = R_ImageJobRows( width, height, &mj.rowsPerJob );
+
+    if ( numJobs == 1 ) {
+        mj.out = in;
+        R_MipMapBoxRows( &mj, 0 );
+        return;
+    }
+
+    // bands running side by side would overwrite each other's source rows
+    mj.out = ri.Hunk_AllocateTempMemory( width * height * 4 );
+    GLimp_RunJobs( R_MipMapBoxRows, &mj, numJobs );
+    Com_Memcpy( in, mj.out, width * height * 4 );
+    ri.Hunk_FreeTempMemory( mj.out );
+}
+
+
+/*
+====================================================================
+
+COLOR REMAPPING
+
+====================================================================
+*/
+
+typedef struct {
+    byte        *data;
+    int         numPixels;
+    int         pixelsPerJob;
+    const byte  *table;
+} remapJob_t;
+
+static void R_RemapRows( void *data, int job )
+{
+    const remapJob_t    *rj = data;
+    const byte  *table = rj->table;
+    byte        *p;
+    int         i, count;
+
+    i = job * rj->pixelsPerJob;
+    count = MIN( rj->pixelsPerJob, rj->numPixels - i );
+
+    for ( p = rj->data + i * 4 ; count > 0 ; count--, p += 4 ) {
+        p[0] = table[p[0]];
+        p[1] = table[p[1]];
+        p[2] = table[p[2]];
+    }
+}
+
+/*
+================
+R_RemapTextureRGB
+
+Runs the color channels of every pixel through table, alpha is left alone
+================
+*/
+void R_RemapTextureRGB( byte *data, int numPixels, const byte table[256] )
+{
+    remapJob_t  rj;
+    int         numJobs;
+
+    rj.data = data;
+    rj.numPixels = numPixels;
+    rj.table = table;
+
+    if ( numPixels < IMAGE_JOB_MIN || !GLimp_NumJobThreads() ) {
+        rj.pixelsPerJob = numPixels;
+        numJobs = 1;
+    } else {
+        rj.pixelsPerJob = IMAGE_JOB_PIXELS;
+        numJobs = ( numPixels + IMAGE_JOB_PIXELS - 1 ) / IMAGE_JOB_PIXELS;
+    }
+
+    GLimp_RunJobs( R_RemapRows, &rj, numJobs );
+}
@@ -0,0 +1,424 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// tr_image_retain.c -- textures kept on the GPU from one map to the next
+//
+// Images loaded from files are counted by the registrations that use
+// them.  When the renderer shuts down for a map change and keeps its
+// context, their textures are released here instead of deleted, and
+// the next map re-binds the ones it registers again without reading,
+// decoding or uploading anything.  Once the new map has registered,
+// textures it left unused are deleted least recently used first until
+// they fit in r_retainImages megabytes.
+//
+// The file a name resolves to is part of the key, so a texture is not
+// re-bound once the search path or pure list finds a different one.
+
+#include "tr_common.h"
+
+#define GLE(ret, name, ...) extern name##proc * qgl##name;
+QGL_1_1_PROCS;
+#undef GLE
+
+#define MAX_RETAINED_IMAGES     4096
+#define RETAINED_HASH_SIZE      1024
+
+typedef struct {
+    image_t     image;      // as it was last registered, texnum 0 marks a free slot
+    int         key;        // upload parameters it was processed with
+    int         refs;       // registrations using the texture
+    int         lastUsed;   // registration it was last used by
+    int         size;       // estimated bytes on the GPU
+    int         hashNext;
+} retainedImage_t;
+
+static retainedImage_t  retained[MAX_RETAINED_IMAGES];
+static int              retainedHash[RETAINED_HASH_SIZE];
+static int              numRetained;
+static int              retainSequence;
+
+/*
+================
+R_RetainedHashName
+================
+*/
+static int R_RetainedHashName( const char *name )
+{
+    unsigned    hash = 2166136261U;
+
+    while ( *name ) {
+        hash = ( hash ^ (byte)*name++ ) * 16777619U;
+    }
+
+    return hash & ( RETAINED_HASH_SIZE - 1 );
+}
+
+/*
+================
+R_RetainedImageKey
+
+Combines the upload parameters with the identity of the file the
+image name resolves to: its path, length and whether it is in a pak.
+path is NULL, and length negative, if there is no such file.
+================
+*/
+int R_RetainedImageKey( const char *params, const char *path, long length )
+{
+    unsigned    hash = 2166136261U;
+    int         i;
+
+    while ( *params ) {
+        hash = ( hash ^ (byte)*params++ ) * 16777619U;
+    }
+
+    if ( !path || length < 0 ) {
+        return (int)hash;
+    }
+
+    hash = ( hash ^ ( ri.FS_FileIsInPAK( path, NULL ) > 0 ) ) * 16777619U;
+
+    for ( i = 0; i < 4; i++ ) {
+        hash = ( hash ^ (byte)( length >> ( i * 8 ) ) ) * 16777619U;
+    }
+
+    while ( *path ) {
+        hash = ( hash ^ (byte)*path++ ) * 16777619U;
+    }
+
+    return (int)hash;
+}
+
+/*
+================
+R_RetainedImageSize
+
+Compressed formats without a block size of their own count as
+uncompressed, the budget errs on the side of deleting
+================
+*/
+static int R_RetainedImageSize( const image_t *image )
+{
+    int     size;
+
+    size = R_BlockImageSize( image->internalFormat, image->uploadWidth, image->uploadHeight );
+    if ( !size ) {
+        size = image->uploadWidth * image->uploadHeight * 4;
+    }
+
+    if ( image->flags & IMGFLAG_MIPMAP ) {
+        size += size / 3;
+    }
+
+    if ( image->flags & IMGFLAG_CUBEMAP ) {
+        size *= 6;
+    }
+
+    return size;
+}
+
+/*
+================
+R_ClearRetainedSlot
+
+Unlinks a slot, deleting its texture too when asked
+================
+*/
+static void R_ClearRetainedSlot( int index, qboolean deleteTexture )
+{
+    retainedImage_t *entry = &retained[index];
+    int             *link;
+
+    for ( link = &retainedHash[R_RetainedHashName( entry->image.imgName )]; *link >= 0; link = &retained[*link].hashNext ) {
+        if ( *link == index ) {
+            *link = entry->hashNext;
+            break;
+        }
+    }
+
+    if ( deleteTexture ) {
+        qglDeleteTextures( 1, &entry->image.texnum );
+    }
+
+    Com_Memset( entry, 0, sizeof( *entry ) );
+    numRetained--;
+}
+
+/*
+================
+R_OldestIdleImage
+================
+*/
+static int R_OldestIdleImage( void )
+{
+    int     oldest = -1;
+    int     i;
+
+    for ( i = 0; i < MAX_RETAINED_IMAGES; i++ ) {
+        if ( !retained[i].image.texnum || retained[i].refs ) {
+            continue;
+        }
+
+        if ( oldest < 0 || retained[i].lastUsed < retained[oldest].lastUsed ) {
+            oldest = i;
+        }
+    }
+
+    return oldest;
+}
+
+/*
+================
+R_FindRetainedImage
+================
+*/
+static int R_FindRetainedImage( const char *name, int key )
+{
+    int     i;
+
+    for ( i = retainedHash[R_RetainedHashName( name )]; i >= 0; i = retained[i].hashNext ) {
+        if ( retained[i].key == key && !strcmp( retained[i].image.imgName, name ) ) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*
+================
+R_HaveRetainedImage
+================
+*/
+qboolean R_HaveRetainedImage( const char *name, int key )
+{
+    if ( !numRetained ) {
+        return qfalse;
+    }
+
+    return R_FindRetainedImage( name, key ) >= 0;
+}
+
+/*
+================
+R_AcquireRetainedImage
+
+Returns the texture a previous map left for this image, if any.  The
+renderer builds its new image_t around it and owns a reference until
+R_ReleaseRetainedImage.
+================
+*/
+const image_t *R_AcquireRetainedImage( const char *name, int key )
+{
+    retainedImage_t *entry;
+    int             index;
+
+    if ( !numRetained ) {
+        return NULL;
+    }
+
+    index = R_FindRetainedImage( name, key );
+    if ( index < 0 ) {
+        return NULL;
+    }
+
+    entry = &retained[index];
+    entry->refs++;
+    entry->lastUsed = retainSequence;
+
+    return &entry->image;
+}
+
+/*
+================
+R_RetainImage
+
+Takes note of an image that was just loaded from a file, so its
+texture can outlive the registration
+================
+*/
+void R_RetainImage( const image_t *image, int key )
+{
+    retainedImage_t *entry;
+    int             hash;
+    int             index;
+
+    if ( r_retainImages->integer <= 0 ) {
+        return;
+    }
+
+    // an idle copy with the same parameters was not re-bound for some
+    // reason, the new upload replaces it
+    index = R_FindRetainedImage( image->imgName, key );
+    if ( index >= 0 && !retained[index].refs ) {
+        R_ClearRetainedSlot( index, qtrue );
+    }
+
+    if ( numRetained == MAX_RETAINED_IMAGES ) {
+        index = R_OldestIdleImage();
+        if ( index < 0 ) {
+            return;
+        }
+        R_ClearRetainedSlot( index, qtrue );
+    }
+
+    for ( index = 0; retained[index].image.texnum; index++ ) {
+    }
+
+    entry = &retained[index];
+    entry->image = *image;
+    entry->image.next = NULL;
+    entry->key = key;
+    entry->refs = 1;
+    entry->lastUsed = retainSequence;
+    entry->size = R_RetainedImageSize( image );
+
+    hash = R_RetainedHashName( image->imgName );
+    entry->hashNext = retainedHash[hash];
+    retainedHash[hash] = index;
+    numRetained++;
+}
+
+/*
+================
+R_ReleaseRetainedImage
+
+Returns qtrue if the texture now belongs to the pool and must not
+be deleted by the renderer
+================
+*/
+qboolean R_ReleaseRetainedImage( const image_t *image )
+{
+    int     i;
+
+    if ( !numRetained ) {
+        return qfalse;
+    }
+
+    for ( i = retainedHash[R_RetainedHashName( image->imgName )]; i >= 0; i = retained[i].hashNext ) {
+        if ( retained[i].image.texnum == image->texnum ) {
+            break;
+        }
+    }
+
+    if ( i < 0 ) {
+        return qfalse;
+    }
+
+    if ( retained[i].refs > 0 ) {
+        retained[i].refs--;
+    }
+
+    if ( r_retainImages->integer <= 0 ) {
+        R_ClearRetainedSlot( i, qfalse );
+        return qfalse;
+    }
+
+    return qtrue;
+}
+
+/*
+================
+R_BeginRetainedImages
+
+Called when a registration starts.  No image_t exists at this point,
+so references a drop kept from being released are dropped as well.
+================
+*/
+void R_BeginRetainedImages( void )
+{
+    int     i;
+
+    if ( !retainSequence ) {
+        for ( i = 0; i < RETAINED_HASH_SIZE; i++ ) {
+            retainedHash[i] = -1;
+        }
+    }
+
+    retainSequence++;
+
+    for ( i = 0; i < MAX_RETAINED_IMAGES; i++ ) {
+        retained[i].refs = 0;
+    }
+}
+
+/*
+================
+R_EvictRetainedImages
+
+Deletes the textures the current map did not register, oldest first,
+until the rest fit in the budget.  The context must be current.
+================
+*/
+void R_EvictRetainedImages( void )
+{
+    int     budget;
+    int     idle = 0, idleCount = 0;
+    int     inUse, evicted = 0;
+    int     index;
+    int     i;
+
+    if ( !numRetained ) {
+        return;
+    }
+
+    budget = r_retainImages->integer > 0 ? r_retainImages->integer : 0;
+
+    for ( i = 0; i < MAX_RETAINED_IMAGES; i++ ) {
+        if ( retained[i].image.texnum && !retained[i].refs ) {
+            idle += retained[i].size / 1024;
+            idleCount++;
+        }
+    }
+
+    inUse = numRetained - idleCount;
+
+    while ( idle > budget * 1024 ) {
+        index = R_OldestIdleImage();
+        if ( index < 0 ) {
+            break;
+        }
+
+        idle -= retained[index].size / 1024;
+        R_ClearRetainedSlot( index, qtrue );
+        evicted++;
+    }
+
+    ri.Printf( PRINT_DEVELOPER, "...%d retained images in use, %d idle kept (%d KB), %d evicted\n",
+                inUse, idleCount - evicted, idle, evicted );
+}
+
+/*
+================
+R_ShutdownRetainedImages
+
+Deletes every texture the pool holds, before the context goes away
+================
+*/
+void R_ShutdownRetainedImages( void )
+{
+    int     i;
+
+    for ( i = 0; i < MAX_RETAINED_IMAGES && numRetained; i++ ) {
+        if ( retained[i].image.texnum ) {
+            R_ClearRetainedSlot( i, qtrue );
+        }
+    }
+}
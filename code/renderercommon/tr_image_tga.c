@@ -63,14 +63,14 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
     //
     // load the file
     //
-    length = ri.FS_ReadFile ( ( char * ) name, &buffer.v);
+    length = R_ImageReadFile ( ( char * ) name, &buffer.v);
     if (!buffer.b || length < 0) {
         return;
     }
 
     if(length < 18)
     {
-        ri.Error( ERR_DROP, "LoadTGA: header too short (%s)", name );
+        R_ImageError( ERR_DROP, "LoadTGA: header too short (%s)", name );
     }
 
     buf_p = buffer.b;
@@ -103,17 +103,17 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
         && targa_header.image_type!=10
         && targa_header.image_type != 3 )
     {
-        ri.Error (ERR_DROP, "LoadTGA: Only type 2 (RGB), 3 (gray), and 10 (RGB) TGA images supported");
+        R_ImageError (ERR_DROP, "LoadTGA: Only type 2 (RGB), 3 (gray), and 10 (RGB) TGA images supported");
     }
 
     if ( targa_header.colormap_type != 0 )
     {
-        ri.Error( ERR_DROP, "LoadTGA: colormaps not supported" );
+        R_ImageError( ERR_DROP, "LoadTGA: colormaps not supported" );
     }
 
     if ( ( targa_header.pixel_size != 32 && targa_header.pixel_size != 24 ) && targa_header.image_type != 3 )
     {
-        ri.Error (ERR_DROP, "LoadTGA: Only 32 or 24 bit images supported (no colormaps)");
+        R_ImageError (ERR_DROP, "LoadTGA: Only 32 or 24 bit images supported (no colormaps)");
     }
 
     columns = targa_header.width;
@@ -122,16 +122,16 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 
     if(!columns || !rows || numPixels > 0x7FFFFFFF || numPixels / columns / 4 != rows)
     {
-        ri.Error (ERR_DROP, "LoadTGA: %s has an invalid image size", name);
+        R_ImageError (ERR_DROP, "LoadTGA: %s has an invalid image size", name);
     }
 
 
-    targa_rgba = ri.Malloc (numPixels);
+    targa_rgba = R_ImageMalloc (numPixels);
 
     if (targa_header.id_length != 0)
     {
         if (buf_p + targa_header.id_length > end)
-            ri.Error( ERR_DROP, "LoadTGA: header too short (%s)", name );
+            R_ImageError( ERR_DROP, "LoadTGA: header too short (%s)", name );
 
         buf_p += targa_header.id_length;  // skip TARGA image comment
     }
@@ -140,7 +140,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
     {
         if(buf_p + columns*rows*targa_header.pixel_size/8 > end)
         {
-            ri.Error (ERR_DROP, "LoadTGA: file truncated (%s)", name);
+            R_ImageError (ERR_DROP, "LoadTGA: file truncated (%s)", name);
         }
 
         // Uncompressed RGB or gray scale image
@@ -183,7 +183,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
                     *pixbuf++ = alphabyte;
                     break;
                 default:
-                    ri.Error( ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
+                    R_ImageError( ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
                     break;
                 }
             }
@@ -196,12 +196,12 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
             pixbuf = targa_rgba + row*columns*4;
             for(column=0; column<columns; ) {
                 if(buf_p + 1 > end)
-                    ri.Error (ERR_DROP, "LoadTGA: file truncated (%s)", name);
+                    R_ImageError (ERR_DROP, "LoadTGA: file truncated (%s)", name);
                 packetHeader= *buf_p++;
                 packetSize = 1 + (packetHeader & 0x7f);
                 if (packetHeader & 0x80) {        // run-length packet
                     if(buf_p + targa_header.pixel_size/8 > end)
-                        ri.Error (ERR_DROP, "LoadTGA: file truncated (%s)", name);
+                        R_ImageError (ERR_DROP, "LoadTGA: file truncated (%s)", name);
                     switch (targa_header.pixel_size) {
                         case 24:
                                 blue = *buf_p++;
@@ -216,7 +216,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
                                 alphabyte = *buf_p++;
                                 break;
                         default:
-                            ri.Error( ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
+                            R_ImageError( ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
                             break;
                     }
 
@@ -239,7 +239,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
                 else {                            // non run-length packet
 
                     if(buf_p + targa_header.pixel_size/8*packetSize > end)
-                        ri.Error (ERR_DROP, "LoadTGA: file truncated (%s)", name);
+                        R_ImageError (ERR_DROP, "LoadTGA: file truncated (%s)", name);
                     for(j=0;j<packetSize;j++) {
                         switch (targa_header.pixel_size) {
                             case 24:
@@ -262,7 +262,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
                                     *pixbuf++ = alphabyte;
                                     break;
                             default:
-                                ri.Error( ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
+                                R_ImageError( ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
                                 break;
                         }
                         column++;
@@ -301,7 +301,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 #endif
   // instead we just print a warning
   if (targa_header.attributes & 0x20) {
-    ri.Printf( PRINT_WARNING, "WARNING: '%s' TGA file header declares top-down image, ignoring\n", name);
+    R_ImagePrintf( PRINT_WARNING, "WARNING: '%s' TGA file header declares top-down image, ignoring\n", name);
   }
 
   if (width)
@@ -311,5 +311,5 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 
   *pic = targa_rgba;
 
-  ri.FS_FreeFile (buffer.v);
+  R_ImageFreeFile (buffer.v);
 }
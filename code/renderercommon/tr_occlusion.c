@@ -0,0 +1,572 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// tr_occlusion.c -- software hierarchical z occlusion culling
+//
+// The front end rasterizes large opaque world surfaces into a small depth
+// buffer, then tests surface and entity bounds against a min-depth pyramid
+// built from it.  Depth is stored as 1/z, so 0 is "nothing here" and larger
+// values are closer.  Nothing in here touches GL.
+#include "tr_common.h"
+
+#if idx64 || defined(__SSE2__)
+#define OCC_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#ifndef MIN
+#define MIN(a,b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a,b) ((a) > (b) ? (a) : (b))
+#endif
+
+#define OCC_LEVELS      6
+#define OCC_NEAR        4.0f
+
+static float occDepth[OCC_WIDTH * OCC_HEIGHT] QALIGN(16);
+static float occHiZ[OCC_WIDTH * OCC_HEIGHT / 3] QALIGN(16);
+static byte  occDebug[OCC_WIDTH * OCC_HEIGHT * 4];
+
+static struct
+{
+    qboolean    active;
+    qboolean    finished;
+    qboolean    debugValid;
+
+    vec3_t      origin;
+    vec3_t      axis[3];
+    float       scaleX, scaleY;
+
+    float       *levels[OCC_LEVELS];
+
+    int         numTris;
+    int         numTested;
+    int         numCulled;
+} occ;
+
+/*
+=================
+R_OcclusionBeginView
+
+Clears the depth buffer for a view looking from origin along axis[0]
+=================
+*/
+void R_OcclusionBeginView( const vec3_t origin, vec3_t axis[3], float fovX, float fovY )
+{
+    int     i, size;
+    float   *level;
+
+    VectorCopy( origin, occ.origin );
+    VectorCopy( axis[0], occ.axis[0] );
+    VectorCopy( axis[1], occ.axis[1] );
+    VectorCopy( axis[2], occ.axis[2] );
+
+    occ.scaleX = OCC_WIDTH * 0.5f / tan( fovX * M_PI / 360.0f );
+    occ.scaleY = OCC_HEIGHT * 0.5f / tan( fovY * M_PI / 360.0f );
+
+    occ.levels[0] = occDepth;
+    level = occHiZ;
+    for ( i = 1 ; i < OCC_LEVELS ; i++ ) {
+        size = ( OCC_WIDTH >> i ) * ( OCC_HEIGHT >> i );
+        occ.levels[i] = level;
+        level += size;
+    }
+
+    Com_Memset( occDepth, 0, sizeof( occDepth ) );
+
+    occ.active = qtrue;
+    occ.finished = qfalse;
+    occ.numTris = 0;
+    occ.numTested = 0;
+    occ.numCulled = 0;
+}
+
+/*
+=================
+R_OcclusionEndView
+=================
+*/
+void R_OcclusionEndView( void )
+{
+    occ.active = qfalse;
+    occ.finished = qfalse;
+}
+
+/*
+=================
+R_OcclusionActive
+=================
+*/
+qboolean R_OcclusionActive( void )
+{
+    return occ.active;
+}
+
+/*
+=================
+R_OcclusionTransform
+
+out[0] is depth along the view axis, out[1] left and out[2] up
+=================
+*/
+static void R_OcclusionTransform( const float *in, vec3_t out )
+{
+    vec3_t  delta;
+
+    VectorSubtract( in, occ.origin, delta );
+    out[0] = DotProduct( delta, occ.axis[0] );
+    out[1] = DotProduct( delta, occ.axis[1] );
+    out[2] = DotProduct( delta, occ.axis[2] );
+}
+
+/*
+=================
+R_OcclusionProject
+
+Returns pixel x, y and 1/z for a point in front of the near plane
+=================
+*/
+static void R_OcclusionProject( const vec3_t in, vec3_t out )
+{
+    float   iz = 1.0f / in[0];
+
+    out[0] = OCC_WIDTH * 0.5f - in[1] * occ.scaleX * iz;
+    out[1] = OCC_HEIGHT * 0.5f - in[2] * occ.scaleY * iz;
+    out[2] = iz;
+}
+
+/*
+=================
+R_OcclusionRasterTriangle
+
+Writes max( old, 1/z ) to every pixel whose center is inside the
+projected triangle, either winding
+=================
+*/
+static void R_OcclusionRasterTriangle( const float *a, const float *b, const float *c )
+{
+    float   area;
+    float   edgeA[3], edgeB[3], edgeC[3];
+    float   dzdx, dzdy, z0;
+    float   minX, maxX, minY, maxY;
+    int     x0, x1, y0, y1, x, y;
+    int     i;
+
+    area = ( b[0] - a[0] ) * ( c[1] - a[1] ) - ( b[1] - a[1] ) * ( c[0] - a[0] );
+    if ( area == 0.0f ) {
+        return;
+    }
+
+    if ( area < 0.0f ) {
+        const float *t = b;
+        b = c;
+        c = t;
+        area = -area;
+    }
+
+    minX = MIN( a[0], MIN( b[0], c[0] ) );
+    maxX = MAX( a[0], MAX( b[0], c[0] ) );
+    minY = MIN( a[1], MIN( b[1], c[1] ) );
+    maxY = MAX( a[1], MAX( b[1], c[1] ) );
+
+    // pixels whose centers may be inside
+    x0 = MAX( 0, (int)ceil( minX - 0.5f ) );
+    x1 = MIN( OCC_WIDTH - 1, (int)floor( maxX - 0.5f ) );
+    y0 = MAX( 0, (int)ceil( minY - 0.5f ) );
+    y1 = MIN( OCC_HEIGHT - 1, (int)floor( maxY - 0.5f ) );
+    if ( x0 > x1 || y0 > y1 ) {
+        return;
+    }
+
+    // edge functions, each positive on the inside, as A * x + B * y + C
+    {
+        const float *p0[3] = { b, c, a };
+        const float *p1[3] = { c, a, b };
+
+        for ( i = 0 ; i < 3 ; i++ ) {
+            edgeA[i] = p0[i][1] - p1[i][1];
+            edgeB[i] = p1[i][0] - p0[i][0];
+            edgeC[i] = -( edgeA[i] * p0[i][0] + edgeB[i] * p0[i][1] );
+        }
+    }
+
+    // edge i is the barycentric weight of the opposite vertex times area
+    dzdx = ( edgeA[0] * a[2] + edgeA[1] * b[2] + edgeA[2] * c[2] ) / area;
+    dzdy = ( edgeB[0] * a[2] + edgeB[1] * b[2] + edgeB[2] * c[2] ) / area;
+    z0   = ( edgeC[0] * a[2] + edgeC[1] * b[2] + edgeC[2] * c[2] ) / area;
+
+#ifdef OCC_SSE2
+    {
+        const __m128    zero = _mm_setzero_ps();
+        const __m128    ramp = _mm_setr_ps( 0.5f, 1.5f, 2.5f, 3.5f );
+        const __m128    first = _mm_set1_ps( x0 );
+        const __m128    last = _mm_set1_ps( x1 + 1 );
+        const __m128    ea0 = _mm_set1_ps( edgeA[0] );
+        const __m128    ea1 = _mm_set1_ps( edgeA[1] );
+        const __m128    ea2 = _mm_set1_ps( edgeA[2] );
+        const __m128    za = _mm_set1_ps( dzdx );
+
+        for ( y = y0 ; y <= y1 ; y++ ) {
+            float   py = y + 0.5f;
+            __m128  eb0 = _mm_set1_ps( edgeB[0] * py + edgeC[0] );
+            __m128  eb1 = _mm_set1_ps( edgeB[1] * py + edgeC[1] );
+            __m128  eb2 = _mm_set1_ps( edgeB[2] * py + edgeC[2] );
+            __m128  zb = _mm_set1_ps( dzdy * py + z0 );
+            float   *row = occDepth + y * OCC_WIDTH;
+
+            for ( x = x0 & ~3 ; x <= x1 ; x += 4 ) {
+                __m128  px = _mm_add_ps( _mm_set1_ps( x ), ramp );
+                __m128  inside, z, old;
+
+                // stay inside the bounding box, the row start is rounded down
+                inside = _mm_and_ps( _mm_cmpge_ps( px, first ), _mm_cmple_ps( px, last ) );
+                inside = _mm_and_ps( inside, _mm_cmpge_ps( _mm_add_ps( _mm_mul_ps( ea0, px ), eb0 ), zero ) );
+                inside = _mm_and_ps( inside, _mm_cmpge_ps( _mm_add_ps( _mm_mul_ps( ea1, px ), eb1 ), zero ) );
+                inside = _mm_and_ps( inside, _mm_cmpge_ps( _mm_add_ps( _mm_mul_ps( ea2, px ), eb2 ), zero ) );
+
+                z = _mm_add_ps( _mm_mul_ps( za, px ), zb );
+                old = _mm_load_ps( row + x );
+                z = _mm_max_ps( old, z );
+
+                _mm_store_ps( row + x, _mm_or_ps( _mm_and_ps( inside, z ), _mm_andnot_ps( inside, old ) ) );
+            }
+        }
+    }
+#else
+    for ( y = y0 ; y <= y1 ; y++ ) {
+        float   py = y + 0.5f;
+        float   *row = occDepth + y * OCC_WIDTH;
+
+        for ( x = x0 ; x <= x1 ; x++ ) {
+            float   px = x + 0.5f;
+            float   z;
+
+            if ( edgeA[0] * px + edgeB[0] * py + edgeC[0] < 0.0f
+                || edgeA[1] * px + edgeB[1] * py + edgeC[1] < 0.0f
+                || edgeA[2] * px + edgeB[2] * py + edgeC[2] < 0.0f ) {
+                continue;
+            }
+
+            z = dzdx * px + dzdy * py + z0;
+            if ( z > row[x] ) {
+                row[x] = z;
+            }
+        }
+    }
+#endif
+}
+
+/*
+=================
+R_OcclusionAddTriangles
+
+Adds an occluder given as indexed triangles.  xyz is the position of the
+first vertex and stride the byte distance between vertexes.
+=================
+*/
+void R_OcclusionAddTriangles( const float *xyz, int stride, const int *indexes, int numIndexes )
+{
+    int     i, j, k;
+
+    if ( !occ.active || occ.finished ) {
+        return;
+    }
+
+    for ( i = 0 ; i + 2 < numIndexes ; i += 3 ) {
+        vec3_t  view[3], clipped[4], screen[4];
+        int     numFront, numClipped;
+
+        numFront = 0;
+        for ( j = 0 ; j < 3 ; j++ ) {
+            R_OcclusionTransform( (const float *)( (const byte *)xyz + indexes[i + j] * stride ), view[j] );
+            if ( view[j][0] >= OCC_NEAR ) {
+                numFront++;
+            }
+        }
+
+        if ( !numFront ) {
+            continue;
+        }
+
+        // clip against the near plane, which gives at most a quad
+        numClipped = 0;
+        for ( j = 0 ; j < 3 ; j++ ) {
+            const float *p = view[j];
+            const float *q = view[( j + 1 ) % 3];
+
+            if ( p[0] >= OCC_NEAR ) {
+                VectorCopy( p, clipped[numClipped] );
+                numClipped++;
+            }
+
+            if ( ( p[0] >= OCC_NEAR ) != ( q[0] >= OCC_NEAR ) ) {
+                float frac = ( OCC_NEAR - p[0] ) / ( q[0] - p[0] );
+
+                for ( k = 0 ; k < 3 ; k++ ) {
+                    clipped[numClipped][k] = p[k] + frac * ( q[k] - p[k] );
+                }
+                clipped[numClipped][0] = OCC_NEAR;
+                numClipped++;
+            }
+        }
+
+        for ( j = 0 ; j < numClipped ; j++ ) {
+            R_OcclusionProject( clipped[j], screen[j] );
+        }
+
+        for ( j = 2 ; j < numClipped ; j++ ) {
+            R_OcclusionRasterTriangle( screen[0], screen[j - 1], screen[j] );
+        }
+
+        occ.numTris++;
+    }
+}
+
+/*
+=================
+R_OcclusionFinishOccluders
+
+Builds the pyramid where each texel holds the farthest depth of the
+four below it.  No occluders can be added after this until the next view.
+=================
+*/
+void R_OcclusionFinishOccluders( qboolean debug )
+{
+    int     i, x, y, w, h;
+
+    if ( !occ.active || occ.finished ) {
+        return;
+    }
+
+    for ( i = 1 ; i < OCC_LEVELS ; i++ ) {
+        const float *src = occ.levels[i - 1];
+        float       *dst = occ.levels[i];
+        int         srcWidth = OCC_WIDTH >> ( i - 1 );
+
+        w = OCC_WIDTH >> i;
+        h = OCC_HEIGHT >> i;
+
+        for ( y = 0 ; y < h ; y++ ) {
+            const float *row0 = src + ( y * 2 ) * srcWidth;
+            const float *row1 = row0 + srcWidth;
+
+            for ( x = 0 ; x < w ; x++ ) {
+                float a = MIN( row0[x * 2], row0[x * 2 + 1] );
+                float b = MIN( row1[x * 2], row1[x * 2 + 1] );
+
+                dst[y * w + x] = MIN( a, b );
+            }
+        }
+    }
+
+    occ.finished = qtrue;
+
+    if ( debug ) {
+        byte    *out = occDebug;
+
+        // brighter is closer, full white at the near plane
+        for ( i = 0 ; i < OCC_WIDTH * OCC_HEIGHT ; i++, out += 4 ) {
+            int     v = (int)( sqrt( occDepth[i] * OCC_NEAR ) * 255.0f );
+
+            out[0] = out[1] = out[2] = MIN( v, 255 );
+            out[3] = 255;
+        }
+
+        occ.debugValid = qtrue;
+    }
+}
+
+/*
+=================
+R_OcclusionCullBox
+
+Returns qtrue if the world space box is completely behind the occluders
+=================
+*/
+qboolean R_OcclusionCullBox( const vec3_t mins, const vec3_t maxs )
+{
+    float   minX, maxX, minY, maxY, minZ, maxIz;
+    int     x0, x1, y0, y1, x, y;
+    int     i, level, width;
+    const float *texels;
+
+    if ( !occ.active || !occ.finished ) {
+        return qfalse;
+    }
+
+    occ.numTested++;
+
+    minX = minY = minZ = 99999;
+    maxX = maxY = -99999;
+
+    for ( i = 0 ; i < 8 ; i++ ) {
+        vec3_t  corner, view, screen;
+
+        corner[0] = ( i & 1 ) ? maxs[0] : mins[0];
+        corner[1] = ( i & 2 ) ? maxs[1] : mins[1];
+        corner[2] = ( i & 4 ) ? maxs[2] : mins[2];
+
+        R_OcclusionTransform( corner, view );
+
+        // anything crossing the near plane is treated as visible
+        if ( view[0] < OCC_NEAR ) {
+            return qfalse;
+        }
+
+        R_OcclusionProject( view, screen );
+
+        minX = MIN( minX, screen[0] );
+        maxX = MAX( maxX, screen[0] );
+        minY = MIN( minY, screen[1] );
+        maxY = MAX( maxY, screen[1] );
+        minZ = MIN( minZ, view[0] );
+    }
+
+    // grow by a pixel so partially covered edge pixels can't hide anything
+    x0 = MAX( 0, (int)floor( minX ) - 1 );
+    x1 = MIN( OCC_WIDTH - 1, (int)floor( maxX ) + 1 );
+    y0 = MAX( 0, (int)floor( minY ) - 1 );
+    y1 = MIN( OCC_HEIGHT - 1, (int)floor( maxY ) + 1 );
+    if ( x0 > x1 || y0 > y1 ) {
+        return qfalse;
+    }
+
+    // nearest depth of the box, pulled in slightly against rounding
+    maxIz = 1.001f / minZ;
+
+    // test at most 4x4 texels
+    level = 0;
+    while ( level < OCC_LEVELS - 1 && ( ( x1 >> level ) - ( x0 >> level ) > 3 || ( y1 >> level ) - ( y0 >> level ) > 3 ) ) {
+        level++;
+    }
+
+    texels = occ.levels[level];
+    width = OCC_WIDTH >> level;
+
+    for ( y = y0 >> level ; y <= y1 >> level ; y++ ) {
+        for ( x = x0 >> level ; x <= x1 >> level ; x++ ) {
+            if ( texels[y * width + x] <= maxIz ) {
+                return qfalse;
+            }
+        }
+    }
+
+    occ.numCulled++;
+    return qtrue;
+}
+
+/*
+=================
+R_OcclusionCullLocalBox
+
+Tests a box given in the space of origin and axis, axis may be scaled
+=================
+*/
+qboolean R_OcclusionCullLocalBox( vec3_t bounds[2], const vec3_t origin, vec3_t axis[3] )
+{
+    vec3_t  center, extents, mins, maxs;
+    int     i, j;
+
+    if ( !occ.active || !occ.finished ) {
+        return qfalse;
+    }
+
+    for ( i = 0 ; i < 3 ; i++ ) {
+        center[i] = ( bounds[0][i] + bounds[1][i] ) * 0.5f;
+        extents[i] = ( bounds[1][i] - bounds[0][i] ) * 0.5f;
+    }
+
+    for ( j = 0 ; j < 3 ; j++ ) {
+        float c = origin[j];
+        float e = 0;
+
+        for ( i = 0 ; i < 3 ; i++ ) {
+            c += center[i] * axis[i][j];
+            e += fabs( extents[i] * axis[i][j] );
+        }
+
+        mins[j] = c - e;
+        maxs[j] = c + e;
+    }
+
+    return R_OcclusionCullBox( mins, maxs );
+}
+
+/*
+=================
+R_EntityOccluded
+
+Tests the bounds of a model entity's current frames against the
+occlusion buffer
+=================
+*/
+qboolean R_EntityOccluded( const refEntity_t *ent, const vec3_t origin, vec3_t axis[3] )
+{
+    vec3_t  bounds[2];
+
+    if ( !occ.active || !occ.finished ) {
+        return qfalse;
+    }
+
+    // view weapons and shadow casters must stay
+    if ( ent->renderfx & ( RF_DEPTHHACK | RF_FIRST_PERSON ) ) {
+        return qfalse;
+    }
+    if ( r_shadows->integer >= 2 && !( ent->renderfx & RF_NOSHADOW ) ) {
+        return qfalse;
+    }
+
+    if ( !R_ModelFrameBounds( ent->hModel, ent->frame, ent->oldframe, bounds ) ) {
+        return qfalse;
+    }
+
+    return R_OcclusionCullLocalBox( bounds, origin, axis );
+}
+
+/*
+=================
+R_OcclusionDebugPixels
+
+Returns the RGBA image of the last finished depth buffer once, or NULL
+=================
+*/
+const byte *R_OcclusionDebugPixels( void )
+{
+    if ( !occ.debugValid ) {
+        return NULL;
+    }
+
+    occ.debugValid = qfalse;
+    return occDebug;
+}
+
+/*
+=================
+R_OcclusionStats
+=================
+*/
+void R_OcclusionStats( int *numTris, int *numTested, int *numCulled )
+{
+    *numTris = occ.numTris;
+    *numTested = occ.numTested;
+    *numCulled = occ.numCulled;
+}
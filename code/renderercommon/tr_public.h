@@ -24,7 +24,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "tr_types.h"
 
-#define REF_API_VERSION     8
+#define REF_API_VERSION     10
 
 //
 // these are the functions exported by the refresh module
@@ -161,9 +161,11 @@ typedef struct {
     long        (*FS_ReadFile)( const char *name, void **buf );
     void    (*FS_FreeFile)( void *buf );
     char ** (*FS_ListFiles)( const char *name, const char *extension, int *numfilesfound );
+    char ** (*FS_ListFilteredFiles)( const char *path, const char *extension, char *filter, int *numfiles, qboolean allowNonPureFilesOnDisk );
     void    (*FS_FreeFileList)( char **filelist );
     void    (*FS_WriteFile)( const char *qpath, const void *buffer, int size );
     qboolean (*FS_FileExists)( const char *file );
+    const char *(*FS_FilePakName)( const char *name, int *pCheckSum );
 
     // cinematic stuff
     void    (*CIN_UploadCinematic)(int handle);
@@ -0,0 +1,668 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// tr_shader_db.c -- indexed database of shader script definitions
+//
+// Every .shader file is split into one compressed definition per shader
+// name, stored in a single block with an open hash over the names.  The
+// renderer looks definitions up when a shader is first registered and
+// only parses the ones it actually uses.  With r_shaderCache on, the
+// block is written to shadercache/ together with a key over the names,
+// sizes and locations of the script files, so later starts load it in
+// one read instead of scanning every script.  clearshadercache drops it.
+
+#include "tr_common.h"
+
+#define SHADERDB_IDENT          (('B'<<24)+('D'<<16)+('H'<<8)+'S')
+#define SHADERDB_VERSION        1
+#define SHADERDB_FILE           "shadercache/shaders.dat"
+
+#define MAX_SHADER_FILES        4096
+
+typedef struct {
+    int         ident;
+    int         version;
+    int         key[2];
+    int         numShaders;
+    int         hashSize;
+    int         textSize;
+} shaderDbHeader_t;
+
+typedef struct {
+    int         name;       // offset of the name in the text block
+    int         body;       // offset of the opening brace
+    int         next;       // next definition on the same hash chain, -1 ends it
+} shaderDbEntry_t;
+
+static int              *dbHash;
+static shaderDbEntry_t  *dbEntries;
+static char             *dbText;
+static int              dbNumShaders;
+static int              dbHashSize;
+static int              dbTextSize;
+
+/*
+================
+R_ShaderDbHashName
+================
+*/
+static unsigned R_ShaderDbHashName( const char *name )
+{
+    unsigned    hash = 2166136261U;
+
+    while ( *name ) {
+        hash = ( hash ^ (byte)tolower( *name++ ) ) * 16777619U;
+    }
+
+    return hash;
+}
+
+/*
+================
+R_ShaderDbHashBytes
+================
+*/
+static uint64_t R_ShaderDbHashBytes( uint64_t hash, const void *data, int length )
+{
+    const byte  *p = data;
+    int         i;
+
+    for ( i = 0; i < length; i++ ) {
+        hash = ( hash ^ p[i] ) * 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+/*
+================
+R_ShaderDbLookup
+================
+*/
+static shaderDbEntry_t *R_ShaderDbLookup( const char *name )
+{
+    int     i;
+
+    if ( !dbHashSize ) {
+        return NULL;
+    }
+
+    for ( i = dbHash[R_ShaderDbHashName( name ) & ( dbHashSize - 1 )]; i >= 0; i = dbEntries[i].next ) {
+        if ( !Q_stricmp( dbText + dbEntries[i].name, name ) ) {
+            return &dbEntries[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+================
+R_FindShaderText
+
+Returns the definition of the named shader, starting at its opening
+brace, or NULL if no script defines it
+================
+*/
+char *R_FindShaderText( const char *name )
+{
+    shaderDbEntry_t *entry;
+
+    entry = R_ShaderDbLookup( name );
+    if ( !entry ) {
+        return NULL;
+    }
+
+    return dbText + entry->body;
+}
+
+/*
+================
+R_GetShaderImageNames
+
+Lists the images the named shader will load without registering
+anything, for prefetching.  A shader without a definition in the
+shader text stands for an image of the same name.
+================
+*/
+int R_GetShaderImageNames( const char *name, char (*names)[MAX_QPATH], int maxNames )
+{
+    char        strippedName[MAX_QPATH];
+    char        *p, *token;
+    int         numNames, depth;
+
+    if ( !name[0] || maxNames <= 0 ) {
+        return 0;
+    }
+
+    COM_StripExtension( name, strippedName, sizeof( strippedName ) );
+
+    p = R_FindShaderText( strippedName );
+    if ( !p ) {
+        Q_strncpyz( names[0], name, MAX_QPATH );
+        return 1;
+    }
+
+    numNames = 0;
+    depth = 0;
+
+    while ( numNames < maxNames ) {
+        token = COM_ParseExt( &p, qtrue );
+        if ( !token[0] ) {
+            break;
+        }
+
+        if ( token[0] == '{' ) {
+            depth++;
+            continue;
+        }
+
+        if ( token[0] == '}' ) {
+            if ( --depth <= 0 ) {
+                break;
+            }
+            continue;
+        }
+
+        // only stages load images
+        if ( depth < 2 ) {
+            continue;
+        }
+
+        if ( !Q_stricmp( token, "map" ) || !Q_stricmp( token, "clampmap" ) ) {
+            token = COM_ParseExt( &p, qfalse );
+            if ( token[0] && token[0] != '$' ) {
+                Q_strncpyz( names[numNames++], token, MAX_QPATH );
+            }
+        } else if ( !Q_stricmp( token, "animMap" ) ) {
+            COM_ParseExt( &p, qfalse );     // frequency
+
+            while ( numNames < maxNames ) {
+                token = COM_ParseExt( &p, qfalse );
+                if ( !token[0] ) {
+                    break;
+                }
+                Q_strncpyz( names[numNames++], token, MAX_QPATH );
+            }
+        }
+    }
+
+    return numNames;
+}
+
+/*
+================
+R_ListShaderFiles
+
+Script files in load order, shaders/ before scripts/.  With altExt set a
+file of that extension next to a script replaces it.
+================
+*/
+static int R_ListShaderFiles( const char *dir, const char *altExt, char (*names)[MAX_QPATH], int numNames )
+{
+    char    **files;
+    char    *ext;
+    int     numFiles;
+    int     i;
+
+    files = ri.FS_ListFiles( dir, ".shader", &numFiles );
+
+    if ( !files || !numFiles ) {
+        return numNames;
+    }
+
+    for ( i = 0; i < numFiles && numNames < MAX_SHADER_FILES; i++ ) {
+        Com_sprintf( names[numNames], MAX_QPATH, "%s/%s", dir, files[i] );
+
+        if ( altExt && ( ext = strrchr( names[numNames], '.' ) ) ) {
+            Q_strncpyz( ext, altExt, MAX_QPATH - ( ext - names[numNames] ) );
+
+            if ( ri.FS_ReadFile( names[numNames], NULL ) <= 0 ) {
+                Com_sprintf( names[numNames], MAX_QPATH, "%s/%s", dir, files[i] );
+            }
+        }
+
+        numNames++;
+    }
+
+    ri.FS_FreeFileList( files );
+
+    return numNames;
+}
+
+/*
+================
+R_ShaderDbKey
+
+Files inside a pak are identified by name, size and the name and
+checksum of the pak, loose files that can be edited in place by their
+contents as well
+================
+*/
+static uint64_t R_ShaderDbKey( char (*names)[MAX_QPATH], int numNames )
+{
+    uint64_t    key = 0xcbf29ce484222325ULL;
+    const char  *pakName;
+    void        *buffer;
+    long        length;
+    int         checksum;
+    int         i;
+
+    for ( i = 0; i < numNames; i++ ) {
+        length = ri.FS_ReadFile( names[i], NULL );
+        pakName = ri.FS_FilePakName( names[i], &checksum );
+
+        key = R_ShaderDbHashBytes( key, names[i], strlen( names[i] ) + 1 );
+        key = R_ShaderDbHashBytes( key, &length, sizeof( length ) );
+
+        if ( pakName ) {
+            key = R_ShaderDbHashBytes( key, pakName, strlen( pakName ) + 1 );
+            key = R_ShaderDbHashBytes( key, &checksum, sizeof( checksum ) );
+        } else if ( length > 0 ) {
+            length = ri.FS_ReadFile( names[i], &buffer );
+            if ( buffer ) {
+                key = R_ShaderDbHashBytes( key, buffer, length );
+                ri.FS_FreeFile( buffer );
+            }
+        }
+    }
+
+    return key;
+}
+
+/*
+================
+R_LoadShaderDbCache
+================
+*/
+static qboolean R_LoadShaderDbCache( uint64_t key )
+{
+    shaderDbHeader_t    header;
+    shaderDbEntry_t     entry;
+    byte                *buffer;
+    int                 *ints;
+    long                length;
+    int                 numInts;
+    int                 i;
+    qboolean            valid;
+
+    length = ri.FS_ReadFile( SHADERDB_FILE, (void **)&buffer );
+    if ( !buffer ) {
+        return qfalse;
+    }
+
+    if ( length < sizeof( header ) ) {
+        ri.FS_FreeFile( buffer );
+        return qfalse;
+    }
+
+    Com_Memcpy( &header, buffer, sizeof( header ) );
+    for ( i = 0; i < sizeof( header ) / sizeof( int ); i++ ) {
+        ( (int *)&header )[i] = LittleLong( ( (int *)&header )[i] );
+    }
+
+    if ( header.ident != SHADERDB_IDENT || header.version != SHADERDB_VERSION
+        || header.key[0] != (int)key || header.key[1] != (int)( key >> 32 )
+        || header.numShaders < 0 || header.textSize <= 0
+        || header.hashSize <= 0 || ( header.hashSize & ( header.hashSize - 1 ) )
+        || length != sizeof( header ) + header.hashSize * sizeof( int )
+            + header.numShaders * sizeof( shaderDbEntry_t ) + header.textSize ) {
+        ri.FS_FreeFile( buffer );
+        return qfalse;
+    }
+
+    numInts = header.hashSize + header.numShaders * sizeof( shaderDbEntry_t ) / sizeof( int );
+    ints = (int *)( buffer + sizeof( header ) );
+
+    // a damaged file must not send lookups outside the block, check it
+    // before anything is taken from the hunk
+    valid = !( (char *)( ints + numInts ) )[header.textSize - 1];
+    for ( i = 0; valid && i < header.hashSize; i++ ) {
+        valid = LittleLong( ints[i] ) >= -1 && LittleLong( ints[i] ) < header.numShaders;
+    }
+    for ( i = 0; valid && i < header.numShaders; i++ ) {
+        Com_Memcpy( &entry, ints + header.hashSize + i * sizeof( entry ) / sizeof( int ), sizeof( entry ) );
+        entry.name = LittleLong( entry.name );
+        entry.body = LittleLong( entry.body );
+        entry.next = LittleLong( entry.next );
+
+        valid = entry.name >= 0 && entry.name < header.textSize
+            && entry.body >= 0 && entry.body < header.textSize
+            && entry.next >= -1 && entry.next < header.numShaders;
+    }
+    if ( !valid ) {
+        ri.Printf( PRINT_WARNING, "WARNING: %s is damaged, rebuilding\n", SHADERDB_FILE );
+        ri.FS_FreeFile( buffer );
+        return qfalse;
+    }
+
+    ints = ri.Hunk_Alloc( numInts * sizeof( int ) + header.textSize, h_low );
+    Com_Memcpy( ints, buffer + sizeof( header ), numInts * sizeof( int ) + header.textSize );
+    ri.FS_FreeFile( buffer );
+
+    for ( i = 0; i < numInts; i++ ) {
+        ints[i] = LittleLong( ints[i] );
+    }
+
+    dbHash = ints;
+    dbEntries = (shaderDbEntry_t *)( ints + header.hashSize );
+    dbText = (char *)( ints + numInts );
+    dbHashSize = header.hashSize;
+    dbNumShaders = header.numShaders;
+    dbTextSize = header.textSize;
+
+    return qtrue;
+}
+
+/*
+================
+R_SaveShaderDbCache
+================
+*/
+static void R_SaveShaderDbCache( uint64_t key )
+{
+    shaderDbHeader_t    *header;
+    int                 *ints;
+    int                 numInts;
+    int                 size;
+    int                 i;
+
+    numInts = dbHashSize + dbNumShaders * sizeof( shaderDbEntry_t ) / sizeof( int );
+    size = sizeof( *header ) + numInts * sizeof( int ) + dbTextSize;
+
+    header = ri.Hunk_AllocateTempMemory( size );
+    header->ident = LittleLong( SHADERDB_IDENT );
+    header->version = LittleLong( SHADERDB_VERSION );
+    header->key[0] = LittleLong( (int)key );
+    header->key[1] = LittleLong( (int)( key >> 32 ) );
+    header->numShaders = LittleLong( dbNumShaders );
+    header->hashSize = LittleLong( dbHashSize );
+    header->textSize = LittleLong( dbTextSize );
+
+    ints = (int *)( header + 1 );
+    for ( i = 0; i < dbHashSize; i++ ) {
+        *ints++ = LittleLong( dbHash[i] );
+    }
+    for ( i = 0; i < dbNumShaders; i++ ) {
+        *ints++ = LittleLong( dbEntries[i].name );
+        *ints++ = LittleLong( dbEntries[i].body );
+        *ints++ = LittleLong( dbEntries[i].next );
+    }
+    Com_Memcpy( ints, dbText, dbTextSize );
+
+    ri.FS_WriteFile( SHADERDB_FILE, header, size );
+    ri.Hunk_FreeTempMemory( header );
+}
+
+/*
+================
+R_ClearShaderCache_f
+
+Drops the cached database, the next start scans every script again
+================
+*/
+void R_ClearShaderCache_f( void )
+{
+    if ( ri.FS_ReadFile( SHADERDB_FILE, NULL ) <= 0 ) {
+        ri.Printf( PRINT_ALL, "No shader cache.\n" );
+        return;
+    }
+
+    // an empty file fails the header check like a missing one
+    ri.FS_WriteFile( SHADERDB_FILE, "", 0 );
+    ri.Printf( PRINT_ALL, "Shader cache cleared.\n" );
+}
+
+/*
+================
+R_CheckShaderFile
+
+Makes sure one bad shader file cannot break all other shaders, and
+counts what its definitions will need in the database at most.  Runs
+before COM_Compress so the line numbers in warnings are right.
+================
+*/
+static qboolean R_CheckShaderFile( const char *filename, char *text, int *numShaders, int *textSize )
+{
+    char    shaderName[MAX_QPATH];
+    char    *token, *body;
+    int     shaderLine;
+    int     count = 0, size = 0;
+
+    COM_BeginParseSession( filename );
+
+    while ( 1 ) {
+        token = COM_ParseExt( &text, qtrue );
+
+        if ( !*token ) {
+            break;
+        }
+
+        Q_strncpyz( shaderName, token, sizeof( shaderName ) );
+        shaderLine = COM_GetCurrentParseLine();
+
+        token = COM_ParseExt( &text, qtrue );
+        if ( token[0] != '{' || token[1] != '\0' ) {
+            ri.Printf( PRINT_WARNING, "WARNING: Ignoring shader file %s. Shader \"%s\" on line %d missing opening brace",
+                        filename, shaderName, shaderLine );
+            if ( token[0] ) {
+                ri.Printf( PRINT_WARNING, " (found \"%s\" on line %d)", token, COM_GetCurrentParseLine() );
+            }
+            ri.Printf( PRINT_WARNING, ".\n" );
+            return qfalse;
+        }
+
+        body = text - 1;
+
+        if ( !SkipBracedSection( &text, 1 ) ) {
+            ri.Printf( PRINT_WARNING, "WARNING: Ignoring shader file %s. Shader \"%s\" on line %d missing closing brace.\n",
+                        filename, shaderName, shaderLine );
+            return qfalse;
+        }
+
+        count++;
+        size += strlen( shaderName ) + 1 + ( text - body ) + 1;
+    }
+
+    *numShaders += count;
+    *textSize += size;
+
+    return qtrue;
+}
+
+/*
+================
+R_AddShaderFile
+
+Adds the definitions of a checked file.  A name that is already defined
+keeps its first definition.
+================
+*/
+static void R_AddShaderFile( char *text )
+{
+    shaderDbEntry_t *entry;
+    char            *token, *body;
+    int             hash, length;
+
+    while ( 1 ) {
+        token = COM_ParseExt( &text, qtrue );
+
+        if ( !*token ) {
+            break;
+        }
+
+        if ( R_ShaderDbLookup( token ) ) {
+            SkipBracedSection( &text, 0 );
+            continue;
+        }
+
+        entry = &dbEntries[dbNumShaders];
+        entry->name = dbTextSize;
+        length = strlen( token ) + 1;
+        Com_Memcpy( dbText + dbTextSize, token, length );
+        dbTextSize += length;
+
+        COM_ParseExt( &text, qtrue );
+        body = text - 1;
+        SkipBracedSection( &text, 1 );
+
+        entry->body = dbTextSize;
+        length = text - body;
+        Com_Memcpy( dbText + dbTextSize, body, length );
+        dbText[dbTextSize + length] = '\0';
+        dbTextSize += length + 1;
+
+        hash = R_ShaderDbHashName( dbText + entry->name ) & ( dbHashSize - 1 );
+        entry->next = dbHash[hash];
+        dbHash[hash] = dbNumShaders++;
+    }
+}
+
+/*
+================
+R_BuildShaderDb
+================
+*/
+static void R_BuildShaderDb( char (*names)[MAX_QPATH], int numNames )
+{
+    char    **buffers;
+    int     numShaders = 0, textSize = 0;
+    int     i;
+
+    buffers = ri.Hunk_AllocateTempMemory( numNames * sizeof( *buffers ) );
+
+    for ( i = 0; i < numNames; i++ ) {
+        ri.Printf( PRINT_DEVELOPER, "...loading '%s'\n", names[i] );
+        ri.FS_ReadFile( names[i], (void **)&buffers[i] );
+
+        if ( !buffers[i] ) {
+            ri.Error( ERR_DROP, "Couldn't load %s", names[i] );
+        }
+
+        if ( !R_CheckShaderFile( names[i], buffers[i], &numShaders, &textSize ) ) {
+            buffers[i][0] = '\0';
+        }
+
+        COM_Compress( buffers[i] );
+    }
+
+    dbHashSize = 64;
+    while ( dbHashSize < numShaders ) {
+        dbHashSize <<= 1;
+    }
+
+    dbHash = ri.Hunk_Alloc( dbHashSize * sizeof( *dbHash ) + numShaders * sizeof( *dbEntries ) + textSize + 1, h_low );
+    dbEntries = (shaderDbEntry_t *)( dbHash + dbHashSize );
+    dbText = (char *)( dbEntries + numShaders );
+    dbNumShaders = 0;
+    dbTextSize = 0;
+
+    for ( i = 0; i < dbHashSize; i++ ) {
+        dbHash[i] = -1;
+    }
+
+    // later files override earlier ones, free in reverse order so the
+    // temp files are all dumped
+    for ( i = numNames - 1; i >= 0; i-- ) {
+        R_AddShaderFile( buffers[i] );
+        ri.FS_FreeFile( buffers[i] );
+    }
+
+    // keep the block from ending in a bare name when nothing was found
+    if ( !dbTextSize ) {
+        dbTextSize = 1;
+    }
+
+    ri.Hunk_FreeTempMemory( buffers );
+}
+
+/*
+================
+R_LoadShaderDatabase
+
+Finds all .shader files and indexes their definitions by name.  The
+renderer passes the extension of its own script files that take the
+place of a .shader file of the same name, or NULL.
+================
+*/
+void R_LoadShaderDatabase( const char *altExt )
+{
+    char        (*names)[MAX_QPATH];
+    uint64_t    key = 0;
+    int         numNames;
+    int         startTime;
+
+    dbHash = NULL;
+    dbEntries = NULL;
+    dbText = NULL;
+    dbNumShaders = dbHashSize = dbTextSize = 0;
+
+    startTime = ri.Milliseconds();
+
+    names = ri.Hunk_AllocateTempMemory( MAX_SHADER_FILES * sizeof( *names ) );
+
+    numNames = R_ListShaderFiles( "shaders", altExt, names, 0 );
+    if ( !numNames ) {
+        ri.Printf( PRINT_WARNING, "WARNING: no shader files found\n" );
+    }
+
+#ifndef STANDALONE
+    // FIXME BOE
+    // Scan for original Quake III shader files too
+    // while still using Quake III base.
+    {
+        int     numQ3Names;
+
+        numQ3Names = R_ListShaderFiles( "scripts", altExt, names, numNames ) - numNames;
+        if ( !numQ3Names ) {
+            ri.Printf( PRINT_WARNING, "WARNING: no Quake III shader files found\n" );
+        }
+        numNames += numQ3Names;
+    }
+#endif
+
+    if ( !numNames ) {
+        ri.Hunk_FreeTempMemory( names );
+        return;
+    }
+
+    if ( r_shaderCache->integer ) {
+        key = R_ShaderDbKey( names, numNames );
+
+        if ( R_LoadShaderDbCache( key ) ) {
+            ri.Printf( PRINT_DEVELOPER, "...%d shaders from %s (%d msec)\n",
+                        dbNumShaders, SHADERDB_FILE, ri.Milliseconds() - startTime );
+            ri.Hunk_FreeTempMemory( names );
+            return;
+        }
+    }
+
+    R_BuildShaderDb( names, numNames );
+
+    if ( r_shaderCache->integer ) {
+        R_SaveShaderDbCache( key );
+    }
+
+    ri.Printf( PRINT_DEVELOPER, "...%d shaders from %d files (%d msec)\n",
+                dbNumShaders, numNames, ri.Milliseconds() - startTime );
+
+    ri.Hunk_FreeTempMemory( names );
+}
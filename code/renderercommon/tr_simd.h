@@ -0,0 +1,226 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// tr_simd.h -- four wide float and int vectors on SSE2 and NEON
+//
+// Only for the files built with SSE2 enabled on 32-bit x86, tr_simd.c and
+// tr_we_simd.c, which are only called when r_simd is set.
+
+#ifndef TR_SIMD_H
+#define TR_SIMD_H
+
+#if idx64 || id386
+
+#if id386 && !defined( __SSE2__ ) && !defined( _MSC_VER )
+#error "the SIMD files must be compiled with SSE2 enabled"
+#endif
+
+#include <emmintrin.h>
+#if id386
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+typedef __m128  vfloat;
+typedef __m128i vint;
+
+#define VF_Load( p )            _mm_loadu_ps( p )
+#define VF_Store( p, v )        _mm_storeu_ps( p, v )
+#define VF_Set( x )             _mm_set1_ps( x )
+#define VF_Add( a, b )          _mm_add_ps( a, b )
+#define VF_Sub( a, b )          _mm_sub_ps( a, b )
+#define VF_Mul( a, b )          _mm_mul_ps( a, b )
+#define VF_Div( a, b )          _mm_div_ps( a, b )
+#define VF_Min( a, b )          _mm_min_ps( a, b )
+#define VF_Abs( a )             _mm_and_ps( a, _mm_castsi128_ps( _mm_set1_epi32( 0x7fffffff ) ) )
+#define VF_CmpLT( a, b )        _mm_castps_si128( _mm_cmplt_ps( a, b ) )
+#define VF_CmpGT( a, b )        _mm_castps_si128( _mm_cmpgt_ps( a, b ) )
+#define VF_Select( m, a, b )    _mm_or_ps( _mm_and_ps( _mm_castsi128_ps( m ), a ), _mm_andnot_ps( _mm_castsi128_ps( m ), b ) )
+#define VF_ToInt( a )           _mm_cvttps_epi32( a )
+
+#define VI_Set( x )             _mm_set1_epi32( x )
+#define VI_Zero()               _mm_setzero_si128()
+#define VI_And( a, b )          _mm_and_si128( a, b )
+#define VI_Or( a, b )           _mm_or_si128( a, b )
+#define VI_Shl( a, n )          _mm_slli_epi32( a, n )
+#define VI_Select( m, a, b )    _mm_or_si128( _mm_and_si128( m, a ), _mm_andnot_si128( m, b ) )
+#define VI_Store( p, v )        _mm_storeu_si128( (__m128i *)(p), v )
+#define VI_Load( p )            _mm_loadu_si128( (const __m128i *)(p) )
+#define VI_Add( a, b )          _mm_add_epi32( a, b )
+#define VI_Sub( a, b )          _mm_sub_epi32( a, b )
+#define VI_Xor( a, b )          _mm_xor_si128( a, b )
+#define VI_ShrU( a, n )         _mm_srli_epi32( a, n )
+#define VI_CmpEq( a, b )        _mm_cmpeq_epi32( a, b )
+#define VI_ToFloat( a )         _mm_cvtepi32_ps( a )
+
+static ID_INLINE vfloat VF_RSqrt( vfloat x ) {
+    vfloat y = _mm_rsqrt_ps( x );
+
+    // one Newton-Raphson step takes the estimate to ~22 bits
+    return _mm_mul_ps( _mm_mul_ps( _mm_set1_ps( 0.5f ), y ),
+        _mm_sub_ps( _mm_set1_ps( 3.0f ), _mm_mul_ps( _mm_mul_ps( x, y ), y ) ) );
+}
+
+// four vec4_t in, one vector per component out
+static ID_INLINE void VF_LoadVec4x4( const float *p, vfloat *x, vfloat *y, vfloat *z ) {
+    vfloat r0 = _mm_loadu_ps( p );
+    vfloat r1 = _mm_loadu_ps( p + 4 );
+    vfloat r2 = _mm_loadu_ps( p + 8 );
+    vfloat r3 = _mm_loadu_ps( p + 12 );
+
+    _MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+    *x = r0;
+    *y = r1;
+    *z = r2;
+}
+
+static ID_INLINE void VF_StoreVec4x4( float *p, vfloat x, vfloat y, vfloat z ) {
+    vfloat w = _mm_setzero_ps();
+
+    _MM_TRANSPOSE4_PS( x, y, z, w );
+    _mm_storeu_ps( p, x );
+    _mm_storeu_ps( p + 4, y );
+    _mm_storeu_ps( p + 8, z );
+    _mm_storeu_ps( p + 12, w );
+}
+
+// four md3 xyz+normal short quads in, xyz as floats out
+static ID_INLINE void VS_LoadXyz4( const short *p, vfloat *x, vfloat *y, vfloat *z ) {
+    __m128i a = _mm_loadu_si128( (const __m128i *)p );
+    __m128i b = _mm_loadu_si128( (const __m128i *)( p + 8 ) );
+    vfloat  r0 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( a, a ), 16 ) );
+    vfloat  r1 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( a, a ), 16 ) );
+    vfloat  r2 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( b, b ), 16 ) );
+    vfloat  r3 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( b, b ), 16 ) );
+
+    _MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+    *x = r0;
+    *y = r1;
+    *z = r2;
+}
+
+// s0 t0 s1 t1 s2 t2 s3 t3
+static ID_INLINE void VF_StoreInterleaved2( float *p, vfloat s, vfloat t ) {
+    _mm_storeu_ps( p, _mm_unpacklo_ps( s, t ) );
+    _mm_storeu_ps( p + 4, _mm_unpackhi_ps( s, t ) );
+}
+
+#else // NEON
+
+#include <arm_neon.h>
+
+typedef float32x4_t vfloat;
+typedef int32x4_t   vint;
+
+#define VF_Load( p )            vld1q_f32( p )
+#define VF_Store( p, v )        vst1q_f32( p, v )
+#define VF_Set( x )             vdupq_n_f32( x )
+#define VF_Add( a, b )          vaddq_f32( a, b )
+#define VF_Sub( a, b )          vsubq_f32( a, b )
+#define VF_Mul( a, b )          vmulq_f32( a, b )
+#define VF_Min( a, b )          vminq_f32( a, b )
+#define VF_Abs( a )             vabsq_f32( a )
+#define VF_CmpLT( a, b )        vreinterpretq_s32_u32( vcltq_f32( a, b ) )
+#define VF_CmpGT( a, b )        vreinterpretq_s32_u32( vcgtq_f32( a, b ) )
+#define VF_Select( m, a, b )    vbslq_f32( vreinterpretq_u32_s32( m ), a, b )
+#define VF_ToInt( a )           vcvtq_s32_f32( a )
+
+#define VI_Set( x )             vdupq_n_s32( x )
+#define VI_Zero()               vdupq_n_s32( 0 )
+#define VI_And( a, b )          vandq_s32( a, b )
+#define VI_Or( a, b )           vorrq_s32( a, b )
+#define VI_Shl( a, n )          vshlq_n_s32( a, n )
+#define VI_Select( m, a, b )    vbslq_s32( vreinterpretq_u32_s32( m ), a, b )
+#define VI_Store( p, v )        vst1q_s32( (int32_t *)(p), v )
+#define VI_Load( p )            vld1q_s32( (const int32_t *)(p) )
+#define VI_Add( a, b )          vaddq_s32( a, b )
+#define VI_Sub( a, b )          vsubq_s32( a, b )
+#define VI_Xor( a, b )          veorq_s32( a, b )
+#define VI_ShrU( a, n )         vreinterpretq_s32_u32( vshrq_n_u32( vreinterpretq_u32_s32( a ), n ) )
+#define VI_CmpEq( a, b )        vreinterpretq_s32_u32( vceqq_s32( a, b ) )
+#define VI_ToFloat( a )         vcvtq_f32_s32( a )
+
+static ID_INLINE vfloat VF_Div( vfloat a, vfloat b ) {
+#ifdef __aarch64__
+    return vdivq_f32( a, b );
+#else
+    vfloat r = vrecpeq_f32( b );
+
+    r = vmulq_f32( vrecpsq_f32( b, r ), r );
+    r = vmulq_f32( vrecpsq_f32( b, r ), r );
+    return vmulq_f32( a, r );
+#endif
+}
+
+static ID_INLINE vfloat VF_RSqrt( vfloat x ) {
+    vfloat y = vrsqrteq_f32( x );
+
+    y = vmulq_f32( y, vrsqrtsq_f32( vmulq_f32( x, y ), y ) );
+    y = vmulq_f32( y, vrsqrtsq_f32( vmulq_f32( x, y ), y ) );
+    return y;
+}
+
+static ID_INLINE void VF_LoadVec4x4( const float *p, vfloat *x, vfloat *y, vfloat *z ) {
+    float32x4x4_t v = vld4q_f32( p );
+
+    *x = v.val[0];
+    *y = v.val[1];
+    *z = v.val[2];
+}
+
+static ID_INLINE void VF_StoreVec4x4( float *p, vfloat x, vfloat y, vfloat z ) {
+    float32x4x4_t v;
+
+    v.val[0] = x;
+    v.val[1] = y;
+    v.val[2] = z;
+    v.val[3] = vdupq_n_f32( 0.0f );
+    vst4q_f32( p, v );
+}
+
+static ID_INLINE void VS_LoadXyz4( const short *p, vfloat *x, vfloat *y, vfloat *z ) {
+    int16x4x4_t v = vld4_s16( p );
+
+    *x = vcvtq_f32_s32( vmovl_s16( v.val[0] ) );
+    *y = vcvtq_f32_s32( vmovl_s16( v.val[1] ) );
+    *z = vcvtq_f32_s32( vmovl_s16( v.val[2] ) );
+}
+
+static ID_INLINE void VF_StoreInterleaved2( float *p, vfloat s, vfloat t ) {
+    float32x4x2_t v;
+
+    v.val[0] = s;
+    v.val[1] = t;
+    vst2q_f32( p, v );
+}
+
+#endif
+
+#define VF_Zero()               VF_Set( 0.0f )
+#define VF_Madd( a, b, c )      VF_Add( VF_Mul( a, b ), c )
+
+// packs four 0..255 channel vectors into little endian RGBA dwords
+#define VI_PackRGBA( r, g, b )  VI_Or( VI_Or( r, VI_Shl( g, 8 ) ), VI_Or( VI_Shl( b, 16 ), VI_Shl( VI_Set( 255 ), 24 ) ) )
+
+#endif // TR_SIMD_H
@@ -215,7 +215,7 @@ typedef struct {
     // used CDS.
     qboolean                isFullscreen;
     qboolean                stereoEnabled;
-    qboolean                smpActive;      // UNUSED, present for compatibility
+    qboolean                smpActive;      // dual processor, set by renderergl1 with r_smp
 } glconfig_t;
 
 typedef enum {
@@ -46,16 +46,49 @@ typedef     struct      worldEffectSystem_s     worldEffectSystem_t;
 // World effect particle definitions.
 //
 
+// Particles are kept as one array per component so the backend can
+// update four of them at a time.  The arrays are padded to a multiple
+// of WE_PARTICLE_BATCH, the padding particles are updated but never
+// rendered.
+#define     WE_PARTICLE_BATCH               4
+#define     WE_PARTICLE_JOB                 2048    // particles handed to a worker thread at a time
+#define     WE_PADDED_PARTICLES(n)          (((n) + WE_PARTICLE_BATCH - 1) & ~(WE_PARTICLE_BATCH - 1))
+
 typedef struct {
-    vec3_t                  pos;
-    vec3_t                  velocity;
-    unsigned int            flags;
-} worldEffectParticle_t;
+    float                   *pos[3];
+    float                   *velocity[3];
+    unsigned int            *seed;              // per particle random state, see R_ParticleRandom
+    unsigned int            *flags;
+} worldEffectParticles_t;
 
 typedef enum {
     PARTICLE_FLAG_RENDER    = (1 << 0)
 } worldEffectParticleFlags_t;
 
+/*
+==================
+R_ParticleRandom
+
+Xorshift step on the particle's own state,
+returns 0 <= x < 1.  Unlike flrand this is
+safe to call from the worker threads and
+the SIMD kernels produce the same sequence.
+==================
+*/
+
+static ID_INLINE float R_ParticleRandom(unsigned int *seed)
+{
+    unsigned int    x;
+
+    x = *seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+
+    return (int)(x >> 8) * (1.0f / 16777216.0f);
+}
+
 //=============================================
 //
 // World effect structures.
@@ -131,7 +164,7 @@ struct worldEffectSystem_s {
 
     worldEffect_t           *worldEffectList;
 
-    worldEffectParticle_t   *particleList;
+    worldEffectParticles_t  particles;
     int                     numParticles;
 
     qboolean                isRendering;
@@ -181,10 +214,42 @@ typedef struct {
     float                   velocityStabilize;
 } snowSystem_t;
 
+//=============================================
+//
+// Particle update jobs, one per WE_PARTICLE_JOB particles.
+//
+
+typedef struct {
+    worldEffectParticles_t  *particles;
+    int                     numParticles;       // padded
+    float                   elapsedTime;
+
+    float                   minHeight;
+    vec3_t                  spread;
+    vec3_t                  minVelocity, velocityRange;
+} weRainJob_t;
+
+typedef struct {
+    worldEffectParticles_t  *particles;
+    int                     numParticles;       // padded
+    float                   elapsedTime;
+
+    snowSystem_t            *snowSystem;
+    vec3_t                  mins, maxs;
+} weSnowJob_t;
+
+typedef struct {
+    worldEffectParticles_t  *particles;
+    int                     numParticles;       // padded
+    float                   elapsedTime;
+
+    windEffect_t            *windEffect;
+} weWindJob_t;
+
 //=============================================
 
 //
-// tr_we backend.c
+// tr_we_backend.c
 //
 
 qboolean            RB_LoadMistyFogImage                ( mistyFogImage_t *fogImage, char *fileName );
@@ -192,15 +257,31 @@ void                RB_CreateMistyFogTextureCoords      ( mistyFogImage_t *fogIm
 void                RB_MistyFogEffectUpdate             ( worldEffectSystem_t *weSystem, worldEffect_t *effect, float elapsedTime );
 void                RB_MistyFogEffectRender             ( worldEffectSystem_t *weSystem, worldEffect_t *effect );
 
-void                RB_WindEffectUpdate                 ( worldEffectSystem_t *weSystem, worldEffect_t *effect, float elapsedTime );
-
 void                RB_LoadRainImage                    ( rainSystem_t *rainSystem, const char *fileName );
-void                RB_RainSystemUpdate                 ( worldEffectSystem_t *weSystem, float elapsedTime );
 void                RB_RainSystemRender                 ( worldEffectSystem_t *weSystem );
 
-void                RB_SnowSystemUpdate                 ( worldEffectSystem_t *weSystem, float elapsedTime );
 void                RB_SnowSystemRender                 ( worldEffectSystem_t *weSystem );
 
+//
+// tr_we_particles.c
+//
+
+extern vec3_t       weViewOrigin;
+
+void                RB_WindEffectUpdate                 ( worldEffectSystem_t *weSystem, worldEffect_t *effect, float elapsedTime );
+void                RB_RainSystemUpdate                 ( worldEffectSystem_t *weSystem, float elapsedTime );
+void                RB_SnowSystemUpdate                 ( worldEffectSystem_t *weSystem, float elapsedTime );
+
+//
+// tr_we_simd.c
+//
+
+#if idsimd
+void                RB_WindParticles_simd               ( weWindJob_t *job, int first, int count );
+void                RB_RainParticles_simd               ( weRainJob_t *job, int first, int count );
+void                RB_SnowParticles_simd               ( weSnowJob_t *job, int first, int count );
+#endif
+
 //
 // tr_we_main.c
 //
@@ -217,14 +298,20 @@ qboolean            R_WorldEffectCommand                ( worldEffectSystem_t *w
 
 void                R_AddWorldEffectSystem              ( worldEffectSystem_t *weSystem );
 void                R_RemoveWorldEffectSystem           ( worldEffectSystem_t *weSystem );
-void                R_RenderWorldEffectSystems          ( float elapsedTime );
+void                R_RenderWorldEffectSystems          ( float elapsedTime, const vec3_t viewOrigin );
 qboolean            R_IsAnyWorldEffectSystemRendering   ( void );
 
 void                R_WorldEffect_f                     ( void );
 
+void                R_AllocWorldEffectParticles         ( worldEffectSystem_t *weSystem, int numParticles );
+
 qboolean            R_GetRainWindSpeed                  ( float *windSpeed );
 qboolean            R_GetWindDirection                  ( vec3_t windDirection );
 
+void                R_InitWorldEffectContents           ( const char *mapName, vec3_t mins, vec3_t maxs );
+void                R_ClearWorldEffectContents          ( void );
+int                 R_WorldEffectPointContents          ( const vec3_t point );
+
 //
 // tr_we_mistyfog.c
 //
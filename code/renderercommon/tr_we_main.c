@@ -27,6 +27,45 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 // A linked list containing all world effect system instances.
 static  worldEffectSystem_t     *worldEffectSystemList  = NULL;
 
+// Map-wide contents grid sampled by the world effect systems
+// instead of querying the collision map.  It is built when the
+// first world effect system of a map is created.
+#define     WECONTENTS_IDENT        (('D'<<24)+('I'<<16)+('R'<<8)+'G')
+#define     WECONTENTS_VERSION      1
+#define     WECONTENTS_MAX_CELLS    (1 << 22)
+#define     WECONTENTS_MIN_CELL     16
+
+#define     WECELL_SOLID            (1 << 0)
+#define     WECELL_WATER            (1 << 1)
+#define     WECELL_OUTSIDE          (1 << 2)
+
+typedef struct {
+    int                     ident;
+    int                     version;
+    int                     checksum;
+    int                     cellSize;
+    int                     origin[3];
+    int                     bounds[3];
+} weContentsHeader_t;
+
+typedef struct {
+    byte                    *cells;
+    vec3_t                  origin;
+    float                   invCellSize;
+    int                     cellSize;
+    int                     bounds[3];
+
+    // Map the grid is built for on first use.
+    qboolean                pending;
+    char                    mapName[MAX_QPATH];
+    vec3_t                  mins;
+    vec3_t                  maxs;
+} weContentsGrid_t;
+
+static  weContentsGrid_t        weContents;
+
+static void R_BuildWorldEffectContents(void);
+
 //==============================================
 
 /*
@@ -349,6 +388,10 @@ void R_AddWorldEffectSystem(worldEffectSystem_t *weSystem)
 {
     worldEffectSystem_t *lastSystem;
 
+    if(weContents.pending){
+        R_BuildWorldEffectContents();
+    }
+
     // If there is no world effect system initialized yet,
     // use this sytem as list base.
     if(!worldEffectSystemList){
@@ -415,10 +458,52 @@ void R_RemoveWorldEffectSystem(worldEffectSystem_t *weSystem)
         R_RemoveWorldEffect(weSystem, weSystem->worldEffectList);
     }
 
-    ri.Free(weSystem->particleList);
+    ri.Free(weSystem->particles.pos[0]);
     ri.Free(weSystem);
 }
 
+/*
+==================
+R_AllocWorldEffectParticles
+
+Allocates the particle arrays of a new
+world effect system as a single block
+and clears them.  Every particle gets
+its own non-zero random seed.
+==================
+*/
+
+void R_AllocWorldEffectParticles(worldEffectSystem_t *weSystem, int numParticles)
+{
+    worldEffectParticles_t  *particles;
+    float                   *data;
+    unsigned int            seed;
+    int                     numPadded;
+    int                     i;
+
+    particles   = &weSystem->particles;
+    numPadded   = WE_PADDED_PARTICLES(numParticles);
+
+    data = ri.Malloc(numPadded * 8 * sizeof(float));
+    Com_Memset(data, 0, numPadded * 8 * sizeof(float));
+
+    for(i = 0; i < 3; i++){
+        particles->pos[i]       = data + numPadded * i;
+        particles->velocity[i]  = data + numPadded * (i + 3);
+    }
+
+    particles->seed     = (unsigned int *)(data + numPadded * 6);
+    particles->flags    = (unsigned int *)(data + numPadded * 7);
+
+    seed = ri.Milliseconds();
+    for(i = 0; i < numPadded; i++){
+        seed = seed * 1664525u + 1013904223u;
+        particles->seed[i] = seed ? seed : 1;
+    }
+
+    weSystem->numParticles = numParticles;
+}
+
 /*
 ==================
 R_RenderWorldEffectSystems
@@ -430,10 +515,12 @@ set for given system.
 ==================
 */
 
-void R_RenderWorldEffectSystems(float elapsedTime)
+void R_RenderWorldEffectSystems(float elapsedTime, const vec3_t viewOrigin)
 {
     worldEffectSystem_t *weSystem;
 
+    VectorCopy(viewOrigin, weViewOrigin);
+
     weSystem = worldEffectSystemList;
     while(weSystem != NULL){
         if(weSystem->Update != NULL){
@@ -586,3 +673,334 @@ qboolean R_GetWindDirection(vec3_t windDirection)
 
     return qfalse;
 }
+
+/*
+=============================================
+----------------------------
+World effect contents grid
+----------------------------
+=============================================
+*/
+
+/*
+==================
+R_WorldEffectChecksum
+
+FNV-1a hash of the BSP file, used to
+tell whether a cached contents grid
+still matches the map.
+==================
+*/
+
+static int R_WorldEffectChecksum(const byte *data, int length)
+{
+    unsigned int    hash;
+    int             i;
+
+    hash = 2166136261u;
+    for(i = 0; i < length; i++){
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+
+    return (int)hash;
+}
+
+/*
+==================
+R_WorldEffectContentsJob
+
+Fills one Z slice of the contents
+grid from the collision map, the
+layout is taken from weContents.
+==================
+*/
+
+static void R_WorldEffectContentsJob(void *data, int z)
+{
+    weContentsGrid_t    *grid;
+    byte                *out;
+    vec3_t              pos;
+    int                 contents;
+    int                 x, y;
+
+    grid    = &weContents;
+    out     = (byte *)data + z * grid->bounds[0] * grid->bounds[1];
+    pos[2]  = grid->origin[2] + (z + 0.5f) * grid->cellSize;
+
+    for(y = 0; y < grid->bounds[1]; y++){
+        pos[1] = grid->origin[1] + (y + 0.5f) * grid->cellSize;
+
+        for(x = 0; x < grid->bounds[0]; x++){
+            pos[0]      = grid->origin[0] + (x + 0.5f) * grid->cellSize;
+            // The query only writes the c_pointcontents
+            // statistic, racing on it just loses counts.
+            contents    = ri.CM_PointContents(pos, 0);
+
+            *out++ = ((contents & CONTENTS_SOLID) ? WECELL_SOLID : 0) |
+                     ((contents & CONTENTS_WATER) ? WECELL_WATER : 0) |
+                     ((contents & CONTENTS_OUTSIDE) ? WECELL_OUTSIDE : 0);
+        }
+    }
+}
+
+/*
+==================
+R_LoadWorldEffectContents
+
+Tries to load a previously built
+contents grid matching the current
+grid layout and BSP checksum.
+==================
+*/
+
+static qboolean R_LoadWorldEffectContents(const char *fileName, weContentsHeader_t *header, byte *cells, int numCells)
+{
+    union {
+        byte                *b;
+        weContentsHeader_t  *h;
+        void                *v;
+    } buffer;
+    int     length;
+    int     i;
+
+    length = ri.FS_ReadFile(fileName, &buffer.v);
+    if(!buffer.v){
+        return qfalse;
+    }
+
+    if(length != sizeof(*header) + numCells
+        || LittleLong(buffer.h->ident) != header->ident
+        || LittleLong(buffer.h->version) != header->version
+        || LittleLong(buffer.h->checksum) != header->checksum
+        || LittleLong(buffer.h->cellSize) != header->cellSize
+    ){
+        ri.FS_FreeFile(buffer.v);
+        return qfalse;
+    }
+
+    for(i = 0; i < 3; i++){
+        if(LittleLong(buffer.h->origin[i]) != header->origin[i]
+            || LittleLong(buffer.h->bounds[i]) != header->bounds[i]
+        ){
+            ri.FS_FreeFile(buffer.v);
+            return qfalse;
+        }
+    }
+
+    Com_Memcpy(cells, buffer.b + sizeof(*header), numCells);
+    ri.FS_FreeFile(buffer.v);
+
+    return qtrue;
+}
+
+/*
+==================
+R_SaveWorldEffectContents
+
+Writes the contents grid to disk so
+following loads of the same map can
+skip building it.
+==================
+*/
+
+static void R_SaveWorldEffectContents(const char *fileName, const weContentsHeader_t *header, const byte *cells, int numCells)
+{
+    weContentsHeader_t  *out;
+    int                 i;
+
+    out = ri.Hunk_AllocateTempMemory(sizeof(*header) + numCells);
+
+    out->ident      = LittleLong(header->ident);
+    out->version    = LittleLong(header->version);
+    out->checksum   = LittleLong(header->checksum);
+    out->cellSize   = LittleLong(header->cellSize);
+
+    for(i = 0; i < 3; i++){
+        out->origin[i] = LittleLong(header->origin[i]);
+        out->bounds[i] = LittleLong(header->bounds[i]);
+    }
+
+    Com_Memcpy(out + 1, cells, numCells);
+    ri.FS_WriteFile(fileName, out, sizeof(*header) + numCells);
+
+    ri.Hunk_FreeTempMemory(out);
+}
+
+/*
+==================
+R_InitWorldEffectContents
+
+Called at world load, notes the map
+the contents grid is built for once
+a world effect system is created.
+==================
+*/
+
+void R_InitWorldEffectContents(const char *mapName, vec3_t mins, vec3_t maxs)
+{
+    R_ClearWorldEffectContents();
+
+    if(!r_weatherGrid->integer){
+        return;
+    }
+
+    Q_strncpyz(weContents.mapName, mapName, sizeof(weContents.mapName));
+    VectorCopy(mins, weContents.mins);
+    VectorCopy(maxs, weContents.maxs);
+    weContents.pending = qtrue;
+}
+
+/*
+==================
+R_BuildWorldEffectContents
+
+Builds the map-wide outside/solid/water
+grid sampled by the world effect systems,
+or loads it from the on-disk cache.
+==================
+*/
+
+static void R_BuildWorldEffectContents(void)
+{
+    weContentsHeader_t  header;
+    char                fileName[MAX_QPATH];
+    char                baseName[MAX_QPATH];
+    void                *bspData;
+    int                 bspLength;
+    byte                *cells;
+    int                 numCells;
+    int                 startTime;
+    int                 i;
+    qboolean            useCache;
+
+    weContents.pending = qfalse;
+
+    startTime = ri.Milliseconds();
+
+    // Grow the cells until the grid fits in the budget,
+    // some maps have huge skybox bounds.
+    // Smaller cells only multiply the point queries.
+    header.cellSize = r_weatherGrid->integer;
+    if(header.cellSize < WECONTENTS_MIN_CELL){
+        header.cellSize = WECONTENTS_MIN_CELL;
+    }
+
+    for(;;){
+        for(i = 0; i < 3; i++){
+            header.origin[i] = (int)floor(weContents.mins[i] / header.cellSize) * header.cellSize;
+            header.bounds[i] = (int)ceil((weContents.maxs[i] - header.origin[i]) / header.cellSize);
+            if(header.bounds[i] < 1){
+                header.bounds[i] = 1;
+            }
+        }
+
+        // Checked axis by axis so the product can't overflow.
+        if(header.bounds[0] <= WECONTENTS_MAX_CELLS / header.bounds[1] &&
+           header.bounds[0] * header.bounds[1] <= WECONTENTS_MAX_CELLS / header.bounds[2]){
+            numCells = header.bounds[0] * header.bounds[1] * header.bounds[2];
+            break;
+        }
+
+        header.cellSize *= 2;
+    }
+
+    header.ident        = WECONTENTS_IDENT;
+    header.version      = WECONTENTS_VERSION;
+    header.checksum     = 0;
+
+    // The cells are only published once they are filled.
+    cells                   = ri.Hunk_Alloc(numCells, h_low);
+    weContents.cellSize     = header.cellSize;
+    weContents.invCellSize  = 1.0f / header.cellSize;
+
+    for(i = 0; i < 3; i++){
+        weContents.origin[i] = header.origin[i];
+        weContents.bounds[i] = header.bounds[i];
+    }
+
+    // Stored as .dat, pure servers refuse other loose files.
+    COM_StripExtension(COM_SkipPath(weContents.mapName), baseName, sizeof(baseName));
+    Com_sprintf(fileName, sizeof(fileName), "weathercache/%s.dat", baseName);
+
+    useCache = qfalse;
+    if(r_weatherGridCache->integer){
+        bspLength = ri.FS_ReadFile(weContents.mapName, &bspData);
+        if(bspData){
+            header.checksum = R_WorldEffectChecksum(bspData, bspLength);
+            ri.FS_FreeFile(bspData);
+            useCache = qtrue;
+        }
+    }
+
+    if(useCache && R_LoadWorldEffectContents(fileName, &header, cells, numCells)){
+        weContents.cells = cells;
+        ri.Printf(PRINT_DEVELOPER, "Loaded %ix%ix%i world effect contents grid from %s\n",
+            header.bounds[0], header.bounds[1], header.bounds[2], fileName);
+        return;
+    }
+
+    GLimp_RunJobs(R_WorldEffectContentsJob, cells, header.bounds[2]);
+    weContents.cells = cells;
+
+    ri.Printf(PRINT_DEVELOPER, "Built %ix%ix%i world effect contents grid of %i units in %i msec\n",
+        header.bounds[0], header.bounds[1], header.bounds[2], header.cellSize, ri.Milliseconds() - startTime);
+
+    if(useCache){
+        R_SaveWorldEffectContents(fileName, &header, cells, numCells);
+    }
+}
+
+/*
+==================
+R_ClearWorldEffectContents
+
+Forgets the contents grid, its memory
+goes away with the hunk.
+==================
+*/
+
+void R_ClearWorldEffectContents(void)
+{
+    Com_Memset(&weContents, 0, sizeof(weContents));
+}
+
+/*
+==================
+R_WorldEffectPointContents
+
+Returns the CONTENTS_SOLID, CONTENTS_WATER
+and CONTENTS_OUTSIDE bits at the given
+point, taken from the contents grid.
+
+Points outside of the world are solid.
+Without a grid the collision map is
+queried instead.
+==================
+*/
+
+int R_WorldEffectPointContents(const vec3_t point)
+{
+    int     x, y, z;
+    int     cell;
+
+    if(!weContents.cells){
+        return ri.CM_PointContents(point, 0);
+    }
+
+    x = (int)floor((point[0] - weContents.origin[0]) * weContents.invCellSize);
+    y = (int)floor((point[1] - weContents.origin[1]) * weContents.invCellSize);
+    z = (int)floor((point[2] - weContents.origin[2]) * weContents.invCellSize);
+
+    if(x < 0 || x >= weContents.bounds[0] ||
+       y < 0 || y >= weContents.bounds[1] ||
+       z < 0 || z >= weContents.bounds[2]
+    ){
+        return CONTENTS_SOLID;
+    }
+
+    cell = weContents.cells[(z * weContents.bounds[1] + y) * weContents.bounds[0] + x];
+
+    return ((cell & WECELL_SOLID) ? CONTENTS_SOLID : 0) |
+           ((cell & WECELL_WATER) ? CONTENTS_WATER : 0) |
+           ((cell & WECELL_OUTSIDE) ? CONTENTS_OUTSIDE : 0);
+}
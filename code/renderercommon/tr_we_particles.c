@@ -0,0 +1,631 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// tr_we_particles.c - Particle simulation of the world effect systems,
+// the backends only draw the particles.
+
+#include "tr_common.h"
+#include "tr_we.h"
+
+// Origin of the view being rendered, set by R_RenderWorldEffectSystems.
+vec3_t  weViewOrigin;
+
+/*
+==================
+RB_RunParticleJobs
+
+Runs a particle update job over every
+WE_PARTICLE_JOB particles, spread over
+the worker threads if allowed.
+==================
+*/
+
+static void RB_RunParticleJobs(void (*function)(void *data, int index), void *data, int numParticles)
+{
+    int     numJobs;
+    int     i;
+
+    numJobs = (numParticles + WE_PARTICLE_JOB - 1) / WE_PARTICLE_JOB;
+
+    if(r_weatherThreads->integer){
+        GLimp_RunJobs(function, data, numJobs);
+        return;
+    }
+
+    for(i = 0; i < numJobs; i++){
+        function(data, i);
+    }
+}
+
+/*
+==================
+RB_ParticleJobRange
+
+Returns the first particle and the
+particle count of a job.
+==================
+*/
+
+static int RB_ParticleJobRange(int numParticles, int index, int *count)
+{
+    int     first;
+
+    first   = index * WE_PARTICLE_JOB;
+    *count  = numParticles - first;
+
+    if(*count > WE_PARTICLE_JOB){
+        *count = WE_PARTICLE_JOB;
+    }
+
+    return first;
+}
+
+/*
+=============================================
+-----------
+Wind effect
+-----------
+=============================================
+*/
+
+/*
+==================
+RB_WindParticles
+
+Applies the wind to the particles that
+are inside of the wind effect volume
+and not still drifting from an earlier
+gust.
+==================
+*/
+
+static void RB_WindParticles(weWindJob_t *job, int first, int count)
+{
+    windEffect_t            *windEffect;
+    worldEffectParticles_t  *particles;
+    float                   dist, calcDist;
+    float                   scaleLength;
+    int                     i, j;
+
+    windEffect  = job->windEffect;
+    particles   = job->particles;
+
+    for(i = first; i < first + count; i++){
+        if(windEffect->affectedParticles[i]){
+            windEffect->affectedParticles[i]--;
+            continue;
+        }
+
+        calcDist = 0.0f;
+        if(!windEffect->isGlobal){
+            for(j = 0; j < windEffect->numPlanes; j++){
+                dist = particles->pos[0][i] * windEffect->planes[j][0]
+                     + particles->pos[1][i] * windEffect->planes[j][1]
+                     + particles->pos[2][i] * windEffect->planes[j][2]
+                     - windEffect->planes[j][3];
+
+                if(dist < 0.01f || dist > windEffect->maxDistance[j]){
+                    break;
+                }else if(j == 0){
+                    calcDist = dist;
+                }
+            }
+
+            if(j != windEffect->numPlanes){
+                continue;
+            }
+        }
+
+        scaleLength = 1.0f - (calcDist / windEffect->maxDistance[0]);
+
+        windEffect->affectedParticles[i] = windEffect->affectedDuration * scaleLength;
+        for(j = 0; j < 3; j++){
+            particles->velocity[j][i] += job->elapsedTime * windEffect->velocity[j];
+        }
+    }
+}
+
+/*
+==================
+RB_WindParticlesJob
+==================
+*/
+
+static void RB_WindParticlesJob(void *data, int index)
+{
+    weWindJob_t     *job;
+    int             first, count;
+
+    job     = (weWindJob_t *)data;
+    first   = RB_ParticleJobRange(job->numParticles, index, &count);
+
+#if idsimd
+    if(r_simd->integer){
+        RB_WindParticles_simd(job, first, count);
+        return;
+    }
+#endif
+
+    RB_WindParticles(job, first, count);
+}
+
+/*
+==================
+RB_WindEffectUpdate
+
+Updates any particles of the parent
+world effect system that are affected
+by this wind effect.
+==================
+*/
+
+void RB_WindEffectUpdate(worldEffectSystem_t *weSystem, worldEffect_t *effect, float elapsedTime)
+{
+    windEffect_t            *windEffect;
+    weWindJob_t             job;
+    vec3_t                  difference;
+
+    windEffect = (windEffect_t *)effect;
+
+    // Only update if this effect is currently enabled in the parent world effect system.
+    if(!windEffect->isEnabled){
+        return;
+    }
+
+    // Calculate total distance between the wind effect origin
+    // and the current player position.
+    VectorSubtract(weViewOrigin, windEffect->point, difference);
+    if(VectorLength(difference) > 300.0f){
+        // This effect instance is too far away to impact any
+        // of the particles that are currently rendering.
+        return;
+    }
+
+    job.particles       = &weSystem->particles;
+    job.numParticles    = WE_PADDED_PARTICLES(weSystem->numParticles);
+    job.elapsedTime     = elapsedTime;
+    job.windEffect      = windEffect;
+
+    RB_RunParticleJobs(RB_WindParticlesJob, &job, job.numParticles);
+}
+
+/*
+=============================================
+-----------
+Rain system
+-----------
+=============================================
+*/
+
+/*
+==================
+RB_RainParticles
+
+Moves the raindrops and respawns the
+ones that fell out of the spread.
+==================
+*/
+
+static void RB_RainParticles(weRainJob_t *job, int first, int count)
+{
+    worldEffectParticles_t  *particles;
+    int                     i, j;
+
+    particles = job->particles;
+
+    for(i = first; i < first + count; i++){
+        for(j = 0; j < 3; j++){
+            particles->pos[j][i] += job->elapsedTime * particles->velocity[j][i];
+        }
+
+        if(particles->pos[2][i] < job->minHeight){
+            particles->pos[0][i] = R_ParticleRandom(&particles->seed[i]) * job->spread[0];
+            particles->pos[1][i] = R_ParticleRandom(&particles->seed[i]) * job->spread[1];
+            particles->pos[2][i] = 40.0f;
+
+            for(j = 0; j < 3; j++){
+                particles->velocity[j][i] = job->minVelocity[j] + R_ParticleRandom(&particles->seed[i]) * job->velocityRange[j];
+            }
+        }
+    }
+}
+
+/*
+==================
+RB_RainParticlesJob
+==================
+*/
+
+static void RB_RainParticlesJob(void *data, int index)
+{
+    weRainJob_t     *job;
+    int             first, count;
+
+    job     = (weRainJob_t *)data;
+    first   = RB_ParticleJobRange(job->numParticles, index, &count);
+
+#if idsimd
+    if(r_simd->integer){
+        RB_RainParticles_simd(job, first, count);
+        return;
+    }
+#endif
+
+    RB_RainParticles(job, first, count);
+}
+
+/*
+==================
+RB_RainSystemUpdate
+
+Checks the current player position and
+updates the rain effect system and all
+of its particles accordingly, also
+taking wind in account.
+==================
+*/
+
+void RB_RainSystemUpdate(worldEffectSystem_t *weSystem, float elapsedTime)
+{
+    rainSystem_t            *rainSystem;
+    weRainJob_t             job;
+    vec3_t                  windDifference;
+    int                     originContents;
+
+    rainSystem      = (rainSystem_t *)weSystem;
+    originContents  = R_WorldEffectPointContents(weViewOrigin);
+
+    rainSystem->windChange--;
+    if(rainSystem->windChange < 0){
+        rainSystem->windNewDirection[0] = flrand(-1.0f, 1.0f);
+        rainSystem->windNewDirection[1] = flrand(-1.0f, 1.0f);
+        rainSystem->windNewDirection[2] = 0.0f;
+
+        VectorNormalize(rainSystem->windNewDirection);
+
+        rainSystem->windChange = irand(200, 450);
+
+        // Update wind direction for all misty fog effect images.
+        R_UpdateMistyFogWindDirection(weSystem, rainSystem->windDirection);
+    }
+
+    // Set wind direction.
+    VectorSubtract(rainSystem->windNewDirection, rainSystem->windDirection, windDifference);
+    VectorMA(rainSystem->windDirection, elapsedTime, windDifference, rainSystem->windDirection);
+
+    // Update all effects if we are rendering.
+    if(weSystem->isRendering){
+        R_UpdateWorldEffects(weSystem, elapsedTime);
+    }
+
+    if(originContents & CONTENTS_OUTSIDE && !(originContents & CONTENTS_WATER)){
+        rainSystem->base.isRendering = qtrue;
+
+        if(rainSystem->fadeAlpha < 1.0f){
+            // Player just went outside, fade in rain.
+            rainSystem->fadeAlpha += elapsedTime / 2.0f;
+        }else if(rainSystem->fadeAlpha > 1.0f){
+            rainSystem->fadeAlpha = 1.0f;
+        }
+    }else{
+        if(rainSystem->fadeAlpha > 0.0f){
+            // Player just went inside, fade out rain.
+            rainSystem->fadeAlpha -= elapsedTime / 2.0f;
+        }else if(rainSystem->fadeAlpha <= 0.0f){
+            // No need to continue here as the player is (still) inside
+            // and the rain is already fully faded out.
+            rainSystem->base.isRendering = qfalse;
+            return;
+        }
+    }
+
+    //
+    // Re-determine particile positions.
+    //
+    job.particles       = &weSystem->particles;
+    job.numParticles    = WE_PADDED_PARTICLES(weSystem->numParticles);
+    job.elapsedTime     = elapsedTime;
+    job.minHeight       = -rainSystem->spread[2];
+
+    VectorCopy(rainSystem->spread, job.spread);
+    VectorCopy(rainSystem->minVelocity, job.minVelocity);
+    VectorSubtract(rainSystem->maxVelocity, rainSystem->minVelocity, job.velocityRange);
+
+    RB_RunParticleJobs(RB_RainParticlesJob, &job, job.numParticles);
+}
+
+/*
+=============================================
+-----------
+Snow system
+-----------
+=============================================
+*/
+
+/*
+==================
+RB_SnowParticles
+
+Drifts the snowflakes, respawns the ones
+that left the contents box and marks the
+ones that are outside for rendering.
+==================
+*/
+
+static void RB_SnowParticles(weSnowJob_t *job, int first, int count)
+{
+    snowSystem_t            *snowSystem;
+    worldEffectParticles_t  *particles;
+    float                   stabilize;
+    int                     i, j;
+    int                     x, y, z;
+
+    snowSystem  = job->snowSystem;
+    particles   = job->particles;
+    stabilize   = snowSystem->velocityStabilize * job->elapsedTime;
+
+    for(i = first; i < first + count; i++){
+        for(j = 0; j < 2; j++){
+            if(particles->velocity[j][i] < snowSystem->minVelocity[j]){
+                particles->velocity[j][i] += stabilize;
+            }else if(particles->velocity[j][i] > snowSystem->maxVelocity[j]){
+                particles->velocity[j][i] -= stabilize;
+            }else{
+                particles->velocity[j][i] += -1.4f + R_ParticleRandom(&particles->seed[i]) * 2.8f;
+            }
+        }
+
+        if(particles->velocity[2][i] > snowSystem->minVelocity[2]){
+            particles->velocity[2][i] -= snowSystem->velocityStabilize * 2.0f;
+        }
+
+        for(j = 0; j < 3; j++){
+            particles->pos[j][i] += job->elapsedTime * particles->velocity[j][i];
+        }
+
+        // Check if we should render this snowflake.
+        x = (particles->pos[0][i] - snowSystem->contentsStart[0]) / snowSystem->contentsSize[0];
+        y = (particles->pos[1][i] - snowSystem->contentsStart[1]) / snowSystem->contentsSize[1];
+        z = (particles->pos[2][i] - snowSystem->contentsStart[2]) / snowSystem->contentsSize[2];
+
+        if(x < 0 || x >= SNOWCONTENTS_X_SIZE ||
+           y < 0 || y >= SNOWCONTENTS_Y_SIZE ||
+           z < 0 || z >= SNOWCONTENTS_Z_SIZE
+        ){
+            particles->pos[0][i] = job->mins[0] + R_ParticleRandom(&particles->seed[i]) * (job->maxs[0] - job->mins[0]);
+            particles->pos[1][i] = job->mins[1] + R_ParticleRandom(&particles->seed[i]) * (job->maxs[1] - job->mins[1]);
+            particles->pos[2][i] = job->maxs[2] - (job->mins[2] - particles->pos[2][i]);
+            if(particles->pos[2][i] < job->mins[2] || particles->pos[2][i] > job->maxs[2]){
+                // Way out of range.
+                particles->pos[2][i] = job->mins[2] + R_ParticleRandom(&particles->seed[i]) * (job->maxs[2] - job->mins[2]);
+            }
+
+            particles->velocity[0][i] = 0.0f;
+            particles->velocity[1][i] = 0.0f;
+            particles->velocity[2][i] = snowSystem->maxVelocity[2] + R_ParticleRandom(&particles->seed[i]) * (snowSystem->minVelocity[2] - snowSystem->maxVelocity[2]);
+            particles->flags[i] &= ~PARTICLE_FLAG_RENDER;
+        }else if(snowSystem->contents[z][y][x] & CONTENTS_OUTSIDE){
+            particles->flags[i] |= PARTICLE_FLAG_RENDER;
+        }else{
+            particles->flags[i] &= ~PARTICLE_FLAG_RENDER;
+        }
+    }
+}
+
+/*
+==================
+RB_SnowParticlesJob
+==================
+*/
+
+static void RB_SnowParticlesJob(void *data, int index)
+{
+    weSnowJob_t     *job;
+    int             first, count;
+
+    job     = (weSnowJob_t *)data;
+    first   = RB_ParticleJobRange(job->numParticles, index, &count);
+
+#if idsimd
+    if(r_simd->integer){
+        RB_SnowParticles_simd(job, first, count);
+        return;
+    }
+#endif
+
+    RB_SnowParticles(job, first, count);
+}
+
+/*
+==================
+RB_SnowSystemUpdate
+
+Checks player surroundings and updates
+particles accordingly.
+
+This can result in new particles being
+rendered, particles already rendering
+being updated to new positions or even
+particles not being rendered anymore
+(e.g. out of area or particles no
+longer outside).
+==================
+*/
+
+void RB_SnowSystemUpdate(worldEffectSystem_t *weSystem, float elapsedTime)
+{
+    snowSystem_t            *snowSystem;
+    windEffect_t            *windGust;
+    worldEffectParticles_t  *particles;
+    weSnowJob_t             job;
+    vec3_t                  origin, difference;
+    vec3_t                  newMins, newMaxs;
+    vec3_t                  start;
+    qboolean                changePos;
+    int                     i;
+    int                     x, y, z;
+
+    snowSystem  = (snowSystem_t *)weSystem;
+    windGust    = (windEffect_t *)R_GetWorldEffect(weSystem, "wind");
+    particles   = &weSystem->particles;
+
+    snowSystem->windChange--;
+    if(snowSystem->windChange < 0){
+        snowSystem->windDirection[0] = flrand(-1.0f, 1.0f);
+        snowSystem->windDirection[1] = flrand(-1.0f, 1.0f);
+        snowSystem->windDirection[2] = 0.0f;
+
+        VectorNormalize(snowSystem->windDirection);
+
+        snowSystem->windChange = irand(200, 450);
+
+        // Update wind direction for all misty fog effect images.
+        R_UpdateMistyFogWindDirection(weSystem, snowSystem->windDirection);
+    }
+
+    // Update all effects if we are rendering.
+    if(weSystem->isRendering){
+        R_UpdateWorldEffects(weSystem, elapsedTime);
+    }
+
+    VectorCopy(weViewOrigin, origin);
+
+    // Check when the next wind gust should occur.
+    snowSystem->nextWindGust -= elapsedTime;
+    if(snowSystem->nextWindGust < 0){
+        // There is currently no wind, disable the effect temporarily.
+        windGust->isEnabled = qfalse;
+    }
+
+    if(snowSystem->nextWindGust < snowSystem->windLowSize){
+        vec3_t  windDirection;
+        vec3_t  windPos;
+
+        windDirection[0] = flrand(-1.0f, 1.0f);
+        windDirection[1] = flrand(-1.0f, 1.0f);
+        windDirection[2] = 0.0f;
+
+        VectorNormalize(windDirection);
+        VectorScale(windDirection, flrand(snowSystem->windMin, snowSystem->windMax), windDirection);
+
+        VectorCopy(origin, windPos);
+
+        // Update the global wind effect with the new parameters.
+        windGust->isEnabled = qtrue;
+        R_UpdateWindParams(windGust, windPos, windDirection, snowSystem->windSize);
+
+        snowSystem->nextWindGust = flrand(snowSystem->windDuration, snowSystem->windDuration * 2.0f);
+        snowSystem->windLowSize = -flrand(snowSystem->windLow, snowSystem->windLow * 3.0f);
+    }
+
+    VectorAdd(snowSystem->minSpread, origin, newMins);
+    VectorAdd(snowSystem->maxSpread, origin, newMaxs);
+
+    changePos = qfalse;
+    for(i = 0; i < 3; i++){
+        difference[i] = newMaxs[i] - snowSystem->maxs[i];
+
+        if(difference[i] >= 0.0f){
+            if(difference[i] > newMaxs[i] - newMins[i]){
+                difference[i] = newMaxs[i] - newMins[i];
+            }
+
+            start[i] = newMaxs[i] - difference[i];
+        }else{
+            if(difference[i] < newMins[i] - newMaxs[i]){
+                difference[i] = newMins[i] - newMaxs[i];
+            }
+
+            start[i] = newMins[i] - difference[i];
+        }
+
+        if(!changePos && fabs(difference[i]) > 25.0f){
+            changePos = qtrue;
+        }
+    }
+
+    //
+    // Re-determine particile positions.
+    //
+    if(changePos){
+        int         *store;
+        int         contentsPos, contents;
+        vec3_t      pos;
+        qboolean    resetFlake;
+
+        for(i = 0; i < 3; i++){
+            contentsPos = (origin[i] + snowSystem->minSpread[i]) / snowSystem->contentsSize[i];
+            snowSystem->contentsStart[i] = contentsPos * snowSystem->contentsSize[i];
+        }
+
+        snowSystem->overallContents = 0;
+        store = (int *)snowSystem->contents;
+
+        for(z = 0, pos[2] = snowSystem->contentsStart[2]; z < SNOWCONTENTS_Z_SIZE; z++, pos[2] += snowSystem->contentsSize[2]){
+            for(y = 0, pos[1] = snowSystem->contentsStart[1]; y < SNOWCONTENTS_Y_SIZE; y++, pos[1] += snowSystem->contentsSize[1]){
+                for(x = 0, pos[0] = snowSystem->contentsStart[0]; x < SNOWCONTENTS_X_SIZE; x++, pos[0] += snowSystem->contentsSize[0]){
+                    contents = R_WorldEffectPointContents(pos);
+                    snowSystem->overallContents |= contents;
+                    *store++ = contents;
+                }
+            }
+        }
+
+        for(i = 0; i < WE_PADDED_PARTICLES(weSystem->numParticles); i++){
+            resetFlake = qfalse;
+
+            for(x = 0; x < 3; x++){
+                if(particles->pos[x][i] < newMins[x] || particles->pos[x][i] > newMaxs[x]){
+                    particles->pos[x][i] = R_ParticleRandom(&particles->seed[i]) * difference[x] + start[x];
+                    resetFlake = qtrue;
+                }
+            }
+
+            if(resetFlake){
+                particles->velocity[0][i] = 0.0f;
+                particles->velocity[1][i] = 0.0f;
+                particles->velocity[2][i] = snowSystem->maxVelocity[2] + R_ParticleRandom(&particles->seed[i]) * (snowSystem->minVelocity[2] - snowSystem->maxVelocity[2]);
+            }
+        }
+
+        VectorCopy(newMins, snowSystem->mins);
+        VectorCopy(newMaxs, snowSystem->maxs);
+    }
+
+    // No need to render or update any particle as none of
+    // the particles are outside.
+    if(!(snowSystem->overallContents & CONTENTS_OUTSIDE)){
+        weSystem->isRendering = qfalse;
+        return;
+    }
+
+    weSystem->isRendering = qtrue;
+
+    job.particles       = particles;
+    job.numParticles    = WE_PADDED_PARTICLES(weSystem->numParticles);
+    job.elapsedTime     = elapsedTime;
+    job.snowSystem      = snowSystem;
+
+    VectorCopy(newMins, job.mins);
+    VectorCopy(newMaxs, job.maxs);
+
+    RB_RunParticleJobs(RB_SnowParticlesJob, &job, job.numParticles);
+}
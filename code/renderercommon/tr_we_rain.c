@@ -36,7 +36,7 @@ the rain world effect system.
 static worldEffectSystem_t *R_RainSystemInitialize(int maxRaindrops)
 {
     rainSystem_t            *rainSystem;
-    worldEffectParticle_t   *item;
+    worldEffectParticles_t  *particles;
     int                     i, j;
 
     //
@@ -50,8 +50,7 @@ static worldEffectSystem_t *R_RainSystemInitialize(int maxRaindrops)
     //
     rainSystem->base.name           = "rain";
 
-    rainSystem->base.particleList   = ri.Malloc(sizeof(worldEffectParticle_t) * maxRaindrops);
-    rainSystem->base.numParticles   = maxRaindrops;
+    R_AllocWorldEffectParticles(&rainSystem->base, maxRaindrops);
 
     rainSystem->base.Update         = RB_RainSystemUpdate;
     rainSystem->base.Render         = RB_RainSystemRender;
@@ -73,17 +72,15 @@ static worldEffectSystem_t *R_RainSystemInitialize(int maxRaindrops)
     //
     // Set raindrop particle defaults.
     //
-    Com_Memset(rainSystem->base.particleList, 0, sizeof(worldEffectParticle_t) * maxRaindrops);
+    particles = &rainSystem->base.particles;
 
-    for(i = 0; i < maxRaindrops; i++){
-        item = &rainSystem->base.particleList[i];
-
-        item->pos[0] = flrand(0.0f, rainSystem->spread[0]);
-        item->pos[1] = flrand(0.0f, rainSystem->spread[1]);
-        item->pos[2] = flrand(-rainSystem->spread[2], 40.0f);
+    for(i = 0; i < WE_PADDED_PARTICLES(maxRaindrops); i++){
+        particles->pos[0][i] = flrand(0.0f, rainSystem->spread[0]);
+        particles->pos[1][i] = flrand(0.0f, rainSystem->spread[1]);
+        particles->pos[2][i] = flrand(-rainSystem->spread[2], 40.0f);
 
         for(j = 0; j < 3; j++){
-            item->velocity[j] = flrand(rainSystem->minVelocity[j], rainSystem->maxVelocity[j]);
+            particles->velocity[j][i] = flrand(rainSystem->minVelocity[j], rainSystem->maxVelocity[j]);
         }
     }
 
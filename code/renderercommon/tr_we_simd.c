@@ -0,0 +1,264 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// tr_we_simd.c -- SSE2 and NEON versions of the world effect particle updates
+//
+// Built with SSE2 enabled on 32-bit x86 like tr_simd.c, so this is also
+// where both renderers find RB_SIMDSupported.  The scalar updates in
+// tr_we_particles.c remain the reference implementations.
+
+#include "tr_common.h"
+#include "tr_we.h"
+
+#if idsimd
+
+#include "tr_simd.h"
+
+
+/*
+=================
+RB_SIMDSupported
+
+Checked by R_Register before r_simd is allowed to stay on
+=================
+*/
+qboolean RB_SIMDSupported( void ) {
+#if id386
+#ifdef _MSC_VER
+    int regs[4];
+
+    __cpuid( regs, 1 );
+    return ( regs[3] >> 26 ) & 1;
+#else
+    unsigned int eax, ebx, ecx, edx;
+
+    if ( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) ) {
+        return qfalse;
+    }
+    return ( edx >> 26 ) & 1;
+#endif
+#else
+    // SSE2 is part of x86_64 and NEON was required to build this file
+    return qtrue;
+#endif
+}
+
+
+/*
+====================================================================
+
+WORLD EFFECT PARTICLES
+
+====================================================================
+*/
+
+/*
+** VF_ParticleRandom
+**
+** Vector form of R_ParticleRandom.  Only the lanes set in mask keep
+** the advanced seed, so every particle draws the same sequence as on
+** the scalar path.
+*/
+static ID_INLINE vfloat VF_ParticleRandom( vint *seed, vint mask ) {
+    vint    x = *seed;
+
+    x = VI_Xor( x, VI_Shl( x, 13 ) );
+    x = VI_Xor( x, VI_ShrU( x, 17 ) );
+    x = VI_Xor( x, VI_Shl( x, 5 ) );
+    *seed = VI_Select( mask, x, *seed );
+
+    return VF_Mul( VI_ToFloat( VI_ShrU( x, 8 ) ), VF_Set( 1.0f / 16777216.0f ) );
+}
+
+void RB_WindParticles_simd( weWindJob_t *job, int first, int count ) {
+    windEffect_t            *windEffect = job->windEffect;
+    worldEffectParticles_t  *particles = job->particles;
+    vfloat  planes[3][4], maxDistance[3];
+    vfloat  velocity[3], duration, minDistance;
+    vfloat  px, py, pz, dist, calcDist;
+    vint    affected, idle, apply, allBits;
+    int     i, j;
+
+    for ( j = 0 ; j < windEffect->numPlanes ; j++ ) {
+        planes[j][0] = VF_Set( windEffect->planes[j][0] );
+        planes[j][1] = VF_Set( windEffect->planes[j][1] );
+        planes[j][2] = VF_Set( windEffect->planes[j][2] );
+        planes[j][3] = VF_Set( windEffect->planes[j][3] );
+        maxDistance[j] = VF_Set( windEffect->maxDistance[j] );
+    }
+
+    for ( j = 0 ; j < 3 ; j++ ) {
+        velocity[j] = VF_Set( job->elapsedTime * windEffect->velocity[j] );
+    }
+
+    duration = VF_Set( windEffect->affectedDuration );
+    minDistance = VF_Set( 0.01f );
+    allBits = VI_Set( -1 );
+
+    for ( i = first ; i < first + count ; i += 4 ) {
+        affected = VI_Load( windEffect->affectedParticles + i );
+        idle = VI_CmpEq( affected, VI_Zero() );
+        apply = idle;
+        calcDist = VF_Zero();
+
+        if ( !windEffect->isGlobal ) {
+            px = VF_Load( particles->pos[0] + i );
+            py = VF_Load( particles->pos[1] + i );
+            pz = VF_Load( particles->pos[2] + i );
+
+            for ( j = 0 ; j < windEffect->numPlanes ; j++ ) {
+                dist = VF_Sub( VF_Add( VF_Add( VF_Mul( px, planes[j][0] ), VF_Mul( py, planes[j][1] ) ),
+                    VF_Mul( pz, planes[j][2] ) ), planes[j][3] );
+
+                apply = VI_And( apply, VI_Xor( VI_Or( VF_CmpLT( dist, minDistance ),
+                    VF_CmpGT( dist, maxDistance[j] ) ), allBits ) );
+                if ( j == 0 ) {
+                    calcDist = dist;
+                }
+            }
+        }
+
+        // particles still drifting from an earlier gust count down,
+        // the ones inside the volume start drifting now
+        affected = VI_Select( idle, affected, VI_Sub( affected, VI_Set( 1 ) ) );
+        affected = VI_Select( apply, VF_ToInt( VF_Mul( duration,
+            VF_Sub( VF_Set( 1.0f ), VF_Div( calcDist, VF_Set( windEffect->maxDistance[0] ) ) ) ) ), affected );
+        VI_Store( windEffect->affectedParticles + i, affected );
+
+        for ( j = 0 ; j < 3 ; j++ ) {
+            VF_Store( particles->velocity[j] + i, VF_Add( VF_Load( particles->velocity[j] + i ),
+                VF_Select( apply, velocity[j], VF_Zero() ) ) );
+        }
+    }
+}
+
+void RB_RainParticles_simd( weRainJob_t *job, int first, int count ) {
+    worldEffectParticles_t  *particles = job->particles;
+    vfloat  elapsedTime = VF_Set( job->elapsedTime );
+    vfloat  minHeight = VF_Set( job->minHeight );
+    vfloat  pos[3], velocity[3];
+    vint    seed, reset;
+    int     i, j;
+
+    for ( i = first ; i < first + count ; i += 4 ) {
+        for ( j = 0 ; j < 3 ; j++ ) {
+            velocity[j] = VF_Load( particles->velocity[j] + i );
+            pos[j] = VF_Add( VF_Load( particles->pos[j] + i ), VF_Mul( elapsedTime, velocity[j] ) );
+        }
+
+        reset = VF_CmpLT( pos[2], minHeight );
+        seed = VI_Load( particles->seed + i );
+
+        pos[0] = VF_Select( reset, VF_Mul( VF_ParticleRandom( &seed, reset ), VF_Set( job->spread[0] ) ), pos[0] );
+        pos[1] = VF_Select( reset, VF_Mul( VF_ParticleRandom( &seed, reset ), VF_Set( job->spread[1] ) ), pos[1] );
+        pos[2] = VF_Select( reset, VF_Set( 40.0f ), pos[2] );
+
+        for ( j = 0 ; j < 3 ; j++ ) {
+            velocity[j] = VF_Select( reset, VF_Add( VF_Set( job->minVelocity[j] ),
+                VF_Mul( VF_ParticleRandom( &seed, reset ), VF_Set( job->velocityRange[j] ) ) ), velocity[j] );
+
+            VF_Store( particles->pos[j] + i, pos[j] );
+            VF_Store( particles->velocity[j] + i, velocity[j] );
+        }
+
+        VI_Store( particles->seed + i, seed );
+    }
+}
+
+void RB_SnowParticles_simd( weSnowJob_t *job, int first, int count ) {
+    snowSystem_t            *snowSystem = job->snowSystem;
+    worldEffectParticles_t  *particles = job->particles;
+    vfloat  elapsedTime = VF_Set( job->elapsedTime );
+    vfloat  stabilize = VF_Set( snowSystem->velocityStabilize * job->elapsedTime );
+    vfloat  pos[3], velocity[3];
+    vint    seed, below, above, reset, wayOut, render, flags;
+    int     cell[3][4], resetInts[4], renderInts[4];
+    int     i, j, k;
+
+    for ( i = first ; i < first + count ; i += 4 ) {
+        seed = VI_Load( particles->seed + i );
+
+        for ( j = 0 ; j < 2 ; j++ ) {
+            velocity[j] = VF_Load( particles->velocity[j] + i );
+            below = VF_CmpLT( velocity[j], VF_Set( snowSystem->minVelocity[j] ) );
+            above = VF_CmpGT( velocity[j], VF_Set( snowSystem->maxVelocity[j] ) );
+
+            velocity[j] = VF_Select( below, VF_Add( velocity[j], stabilize ),
+                VF_Select( above, VF_Sub( velocity[j], stabilize ),
+                VF_Add( velocity[j], VF_Add( VF_Set( -1.4f ),
+                VF_Mul( VF_ParticleRandom( &seed, VI_Xor( VI_Or( below, above ), VI_Set( -1 ) ) ), VF_Set( 2.8f ) ) ) ) ) );
+        }
+
+        velocity[2] = VF_Load( particles->velocity[2] + i );
+        velocity[2] = VF_Select( VF_CmpGT( velocity[2], VF_Set( snowSystem->minVelocity[2] ) ),
+            VF_Sub( velocity[2], VF_Set( snowSystem->velocityStabilize * 2.0f ) ), velocity[2] );
+
+        for ( j = 0 ; j < 3 ; j++ ) {
+            pos[j] = VF_Add( VF_Load( particles->pos[j] + i ), VF_Mul( elapsedTime, velocity[j] ) );
+            VI_Store( cell[j], VF_ToInt( VF_Div( VF_Sub( pos[j], VF_Set( snowSystem->contentsStart[j] ) ),
+                VF_Set( snowSystem->contentsSize[j] ) ) ) );
+        }
+
+        // the contents lookup is a gather, do it per lane
+        for ( k = 0 ; k < 4 ; k++ ) {
+            if ( cell[0][k] < 0 || cell[0][k] >= SNOWCONTENTS_X_SIZE ||
+                 cell[1][k] < 0 || cell[1][k] >= SNOWCONTENTS_Y_SIZE ||
+                 cell[2][k] < 0 || cell[2][k] >= SNOWCONTENTS_Z_SIZE ) {
+                resetInts[k] = -1;
+                renderInts[k] = 0;
+            } else {
+                resetInts[k] = 0;
+                renderInts[k] = ( snowSystem->contents[cell[2][k]][cell[1][k]][cell[0][k]] & CONTENTS_OUTSIDE ) ? -1 : 0;
+            }
+        }
+
+        reset = VI_Load( resetInts );
+        render = VI_Load( renderInts );
+
+        for ( j = 0 ; j < 2 ; j++ ) {
+            pos[j] = VF_Select( reset, VF_Add( VF_Set( job->mins[j] ),
+                VF_Mul( VF_ParticleRandom( &seed, reset ), VF_Set( job->maxs[j] - job->mins[j] ) ) ), pos[j] );
+            velocity[j] = VF_Select( reset, VF_Zero(), velocity[j] );
+        }
+
+        pos[2] = VF_Select( reset, VF_Sub( VF_Set( job->maxs[2] ), VF_Sub( VF_Set( job->mins[2] ), pos[2] ) ), pos[2] );
+        wayOut = VI_And( reset, VI_Or( VF_CmpLT( pos[2], VF_Set( job->mins[2] ) ), VF_CmpGT( pos[2], VF_Set( job->maxs[2] ) ) ) );
+        pos[2] = VF_Select( wayOut, VF_Add( VF_Set( job->mins[2] ),
+            VF_Mul( VF_ParticleRandom( &seed, wayOut ), VF_Set( job->maxs[2] - job->mins[2] ) ) ), pos[2] );
+
+        velocity[2] = VF_Select( reset, VF_Add( VF_Set( snowSystem->maxVelocity[2] ),
+            VF_Mul( VF_ParticleRandom( &seed, reset ), VF_Set( snowSystem->minVelocity[2] - snowSystem->maxVelocity[2] ) ) ), velocity[2] );
+
+        flags = VI_Load( particles->flags + i );
+        flags = VI_Select( render, VI_Or( flags, VI_Set( PARTICLE_FLAG_RENDER ) ),
+            VI_And( flags, VI_Set( ~PARTICLE_FLAG_RENDER ) ) );
+
+        for ( j = 0 ; j < 3 ; j++ ) {
+            VF_Store( particles->pos[j] + i, pos[j] );
+            VF_Store( particles->velocity[j] + i, velocity[j] );
+        }
+
+        VI_Store( particles->seed + i, seed );
+        VI_Store( particles->flags + i, flags );
+    }
+}
+
+#endif // idsimd
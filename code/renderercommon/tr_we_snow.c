@@ -37,7 +37,7 @@ static worldEffectSystem_t *R_SnowSystemInitialize(int maxSnowflakes)
 {
     snowSystem_t            *snowSystem;
     worldEffectSystem_t     *weSystem;
-    worldEffectParticle_t   *item;
+    worldEffectParticles_t  *particles;
     int                     i;
 
     //
@@ -51,8 +51,7 @@ static worldEffectSystem_t *R_SnowSystemInitialize(int maxSnowflakes)
     //
     snowSystem->base.name           = "snow";
 
-    snowSystem->base.particleList   = ri.Malloc(sizeof(worldEffectParticle_t) * maxSnowflakes);
-    snowSystem->base.numParticles   = maxSnowflakes;
+    R_AllocWorldEffectParticles(&snowSystem->base, maxSnowflakes);
 
     snowSystem->base.Update         = RB_SnowSystemUpdate;
     snowSystem->base.Render         = RB_SnowSystemRender;
@@ -85,12 +84,12 @@ static worldEffectSystem_t *R_SnowSystemInitialize(int maxSnowflakes)
     //
     // Set snowflake particle defaults.
     //
-    Com_Memset(snowSystem->base.particleList, 0, sizeof(worldEffectParticle_t) * maxSnowflakes);
+    particles = &snowSystem->base.particles;
 
-    for(i = 0; i < maxSnowflakes; i++){
-        item = &snowSystem->base.particleList[i];
-
-        VectorSet(item->pos, 99999, 99999, 99999);
+    for(i = 0; i < WE_PADDED_PARTICLES(maxSnowflakes); i++){
+        particles->pos[0][i] = 99999;
+        particles->pos[1][i] = 99999;
+        particles->pos[2][i] = 99999;
     }
 
     //
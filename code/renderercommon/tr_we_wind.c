@@ -108,8 +108,8 @@ windEffect_t *R_AddWindEffect(worldEffectSystem_t *weSystem, qboolean isGlobalEf
     //
     windEffect->isGlobal = isGlobalEffect;
 
-    windEffect->affectedParticles = ri.Malloc(weSystem->numParticles * sizeof(int));
-    Com_Memset(windEffect->affectedParticles, 0, weSystem->numParticles * sizeof(int));
+    windEffect->affectedParticles = ri.Malloc(WE_PADDED_PARTICLES(weSystem->numParticles) * sizeof(int));
+    Com_Memset(windEffect->affectedParticles, 0, WE_PADDED_PARTICLES(weSystem->numParticles) * sizeof(int));
 
     //
     // Add the new instance to the world effect list
@@ -21,7 +21,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 #include "tr_local.h"
 
-backEndData_t   *backEndData;
+backEndData_t   *backEndData[SMP_FRAMES];
 backEndState_t  backEnd;
 
 
@@ -552,6 +552,8 @@ void RB_RenderDrawSurfList( drawSurf_t *drawSurfs, int numDrawSurfs ) {
             if (oldShader != NULL) {
                 RB_EndSurface();
             }
+            // surface sprites batched from earlier surfaces may have to go first
+            RB_FlushQuickSpritesForShader( shader );
             RB_BeginSurface( shader, fogNum );
             oldShader = shader;
             oldFogNum = fogNum;
@@ -562,6 +564,9 @@ void RB_RenderDrawSurfList( drawSurf_t *drawSurfs, int numDrawSurfs ) {
         // change the modelview matrix if needed
         //
         if ( entityNum != oldEntityNum ) {
+            // batched surface sprites are in the old entity's space
+            RB_FlushQuickSprites();
+
             depthRange = isCrosshair = qfalse;
 
             if ( entityNum != REFENTITYNUM_WORLD ) {
@@ -666,6 +671,7 @@ void RB_RenderDrawSurfList( drawSurf_t *drawSurfs, int numDrawSurfs ) {
     if (oldShader != NULL) {
         RB_EndSurface();
     }
+    RB_FlushQuickSprites();
 
     // go back to the world modelview matrix
     qglLoadMatrixf( backEnd.viewParms.world.modelMatrix );
@@ -789,6 +795,8 @@ void RE_StretchRaw (int x, int y, int w, int h, int cols, int rows, const byte *
 
 void RE_UploadCinematic (int w, int h, int cols, int rows, const byte *data, int client, qboolean dirty) {
 
+    R_SyncRenderThread();
+
     GL_Bind( tr.scratchImage[client] );
 
     // if the scratchImage isn't in the format we want, specify it as a new texture
@@ -829,31 +837,88 @@ const void  *RB_SetColor( const void *data ) {
     return (const void *)(cmd + 1);
 }
 
+/*
+============================================================================
+
+2D BATCHING
+
+Stretch pics are collected until a command other than a color change
+or another pic comes along.  A pic joins the most recent batch with the
+same shader unless it overlaps a pic of a batch in between, so the
+screen looks the same as if the pics were drawn in order.
+
+============================================================================
+*/
+
+#define MAX_2D_PICS             4096
+#define MAX_2D_BATCHES          512
+#define MAX_2D_MERGE_DEPTH      16      // batches a pic can be moved in front of
+#define MAX_2D_OVERLAP_TESTS    64      // larger batches are only tested by their bounds
+
+typedef struct {
+    float       x, y, w, h;
+    float       s1, t1, s2, t2;
+    float       mins[2], maxs[2];
+    byte        color[4];
+    int         next;                   // next pic of the batch, -1 if last
+} pic2D_t;
+
+typedef struct {
+    shader_t    *shader;
+    float       mins[2], maxs[2];
+    int         firstPic, lastPic;
+    int         numPics;
+} batch2D_t;
+
+static pic2D_t      r2DPics[MAX_2D_PICS];
+static batch2D_t    r2DBatches[MAX_2D_BATCHES];
+static int          r2DNumPics;
+static int          r2DNumBatches;
+
 /*
 =============
-RB_StretchPic
+RB_2DBoundsOverlap
 =============
 */
-const void *RB_StretchPic ( const void *data ) {
-    const stretchPicCommand_t   *cmd;
-    shader_t *shader;
-    int     numVerts, numIndexes;
+static qboolean RB_2DBoundsOverlap( const float *mins1, const float *maxs1, const float *mins2, const float *maxs2 ) {
+    // pics that only share an edge, like the glyphs of a word, don't overlap
+    return mins1[0] < maxs2[0] && maxs1[0] > mins2[0] && mins1[1] < maxs2[1] && maxs1[1] > mins2[1];
+}
 
-    cmd = (const stretchPicCommand_t *)data;
+/*
+=============
+RB_2DBatchOverlaps
+=============
+*/
+static qboolean RB_2DBatchOverlaps( const batch2D_t *batch, const pic2D_t *pic ) {
+    const pic2D_t   *other;
+    int             i;
 
-    if ( !backEnd.projection2D ) {
-        RB_SetGL2D();
+    if ( !RB_2DBoundsOverlap( batch->mins, batch->maxs, pic->mins, pic->maxs ) ) {
+        return qfalse;
+    }
+    if ( batch->numPics > MAX_2D_OVERLAP_TESTS ) {
+        return qtrue;
     }
 
-    shader = cmd->shader;
-    if ( shader != tess.shader ) {
-        if ( tess.numIndexes ) {
-            RB_EndSurface();
+    for ( i = batch->firstPic; i != -1; i = other->next ) {
+        other = &r2DPics[i];
+        if ( RB_2DBoundsOverlap( other->mins, other->maxs, pic->mins, pic->maxs ) ) {
+            return qtrue;
         }
-        backEnd.currentEntity = &backEnd.entity2D;
-        RB_BeginSurface( shader, 0 );
     }
 
+    return qfalse;
+}
+
+/*
+=============
+RB_Tess2DPic
+=============
+*/
+static void RB_Tess2DPic( const pic2D_t *pic ) {
+    int     numVerts, numIndexes;
+
     RB_CHECKOVERFLOW( 4, 6 );
     numVerts = tess.numVertexes;
     numIndexes = tess.numIndexes;
@@ -871,35 +936,139 @@ const void *RB_StretchPic ( const void *data ) {
     *(int *)tess.vertexColors[ numVerts ] =
         *(int *)tess.vertexColors[ numVerts + 1 ] =
         *(int *)tess.vertexColors[ numVerts + 2 ] =
-        *(int *)tess.vertexColors[ numVerts + 3 ] = *(int *)backEnd.color2D;
+        *(int *)tess.vertexColors[ numVerts + 3 ] = *(int *)pic->color;
 
-    tess.xyz[ numVerts ][0] = cmd->x;
-    tess.xyz[ numVerts ][1] = cmd->y;
+    tess.xyz[ numVerts ][0] = pic->x;
+    tess.xyz[ numVerts ][1] = pic->y;
     tess.xyz[ numVerts ][2] = 0;
 
-    tess.texCoords[ numVerts ][0][0] = cmd->s1;
-    tess.texCoords[ numVerts ][0][1] = cmd->t1;
+    tess.texCoords[ numVerts ][0][0] = pic->s1;
+    tess.texCoords[ numVerts ][0][1] = pic->t1;
 
-    tess.xyz[ numVerts + 1 ][0] = cmd->x + cmd->w;
-    tess.xyz[ numVerts + 1 ][1] = cmd->y;
+    tess.xyz[ numVerts + 1 ][0] = pic->x + pic->w;
+    tess.xyz[ numVerts + 1 ][1] = pic->y;
     tess.xyz[ numVerts + 1 ][2] = 0;
 
-    tess.texCoords[ numVerts + 1 ][0][0] = cmd->s2;
-    tess.texCoords[ numVerts + 1 ][0][1] = cmd->t1;
+    tess.texCoords[ numVerts + 1 ][0][0] = pic->s2;
+    tess.texCoords[ numVerts + 1 ][0][1] = pic->t1;
 
-    tess.xyz[ numVerts + 2 ][0] = cmd->x + cmd->w;
-    tess.xyz[ numVerts + 2 ][1] = cmd->y + cmd->h;
+    tess.xyz[ numVerts + 2 ][0] = pic->x + pic->w;
+    tess.xyz[ numVerts + 2 ][1] = pic->y + pic->h;
     tess.xyz[ numVerts + 2 ][2] = 0;
 
-    tess.texCoords[ numVerts + 2 ][0][0] = cmd->s2;
-    tess.texCoords[ numVerts + 2 ][0][1] = cmd->t2;
+    tess.texCoords[ numVerts + 2 ][0][0] = pic->s2;
+    tess.texCoords[ numVerts + 2 ][0][1] = pic->t2;
 
-    tess.xyz[ numVerts + 3 ][0] = cmd->x;
-    tess.xyz[ numVerts + 3 ][1] = cmd->y + cmd->h;
+    tess.xyz[ numVerts + 3 ][0] = pic->x;
+    tess.xyz[ numVerts + 3 ][1] = pic->y + pic->h;
     tess.xyz[ numVerts + 3 ][2] = 0;
 
-    tess.texCoords[ numVerts + 3 ][0][0] = cmd->s1;
-    tess.texCoords[ numVerts + 3 ][0][1] = cmd->t2;
+    tess.texCoords[ numVerts + 3 ][0][0] = pic->s1;
+    tess.texCoords[ numVerts + 3 ][0][1] = pic->t2;
+}
+
+/*
+=============
+RB_Flush2DPics
+
+Draws the collected stretch pics, one surface per batch
+=============
+*/
+static void RB_Flush2DPics( void ) {
+    const batch2D_t *batch;
+    int             i, j;
+
+    if ( !r2DNumBatches ) {
+        return;
+    }
+
+    if ( !backEnd.projection2D ) {
+        RB_SetGL2D();
+    }
+
+    backEnd.currentEntity = &backEnd.entity2D;
+
+    for ( i = 0, batch = r2DBatches; i < r2DNumBatches; i++, batch++ ) {
+        RB_BeginSurface( batch->shader, 0 );
+
+        for ( j = batch->firstPic; j != -1; j = r2DPics[j].next ) {
+            RB_Tess2DPic( &r2DPics[j] );
+        }
+
+        RB_EndSurface();
+    }
+
+    r2DNumPics = 0;
+    r2DNumBatches = 0;
+}
+
+/*
+=============
+RB_StretchPic
+=============
+*/
+const void *RB_StretchPic ( const void *data ) {
+    const stretchPicCommand_t   *cmd;
+    pic2D_t     *pic;
+    batch2D_t   *batch;
+    int         i;
+
+    cmd = (const stretchPicCommand_t *)data;
+
+    if ( r2DNumPics == MAX_2D_PICS || r2DNumBatches == MAX_2D_BATCHES ) {
+        RB_Flush2DPics();
+    }
+
+    pic = &r2DPics[ r2DNumPics ];
+    pic->x = cmd->x;
+    pic->y = cmd->y;
+    pic->w = cmd->w;
+    pic->h = cmd->h;
+    pic->s1 = cmd->s1;
+    pic->t1 = cmd->t1;
+    pic->s2 = cmd->s2;
+    pic->t2 = cmd->t2;
+    pic->mins[0] = cmd->w < 0 ? cmd->x + cmd->w : cmd->x;
+    pic->mins[1] = cmd->h < 0 ? cmd->y + cmd->h : cmd->y;
+    pic->maxs[0] = pic->mins[0] + fabs( cmd->w );
+    pic->maxs[1] = pic->mins[1] + fabs( cmd->h );
+    *(int *)pic->color = *(int *)backEnd.color2D;
+    pic->next = -1;
+
+    // look for a batch of this shader the pic can join
+    batch = NULL;
+    for ( i = r2DNumBatches - 1; i >= 0 && r2DNumBatches - i <= MAX_2D_MERGE_DEPTH; i-- ) {
+        if ( r2DBatches[i].shader == cmd->shader ) {
+            batch = &r2DBatches[i];
+            break;
+        }
+        if ( RB_2DBatchOverlaps( &r2DBatches[i], pic ) ) {
+            break;
+        }
+    }
+
+    if ( batch ) {
+        r2DPics[ batch->lastPic ].next = r2DNumPics;
+        for ( i = 0; i < 2; i++ ) {
+            if ( pic->mins[i] < batch->mins[i] ) {
+                batch->mins[i] = pic->mins[i];
+            }
+            if ( pic->maxs[i] > batch->maxs[i] ) {
+                batch->maxs[i] = pic->maxs[i];
+            }
+        }
+        batch->numPics++;
+    } else {
+        batch = &r2DBatches[ r2DNumBatches++ ];
+        batch->shader = cmd->shader;
+        batch->firstPic = r2DNumPics;
+        batch->mins[0] = pic->mins[0];
+        batch->mins[1] = pic->mins[1];
+        batch->maxs[0] = pic->maxs[0];
+        batch->maxs[1] = pic->maxs[1];
+        batch->numPics = 1;
+    }
+    batch->lastPic = r2DNumPics++;
 
     return (const void *)(cmd + 1);
 }
@@ -1115,9 +1284,20 @@ void RB_ExecuteRenderCommands( const void *data ) {
 
     t1 = ri.Milliseconds ();
 
+    if ( !glConfig.smpActive || data == backEndData[0]->commands.cmds ) {
+        backEnd.smpFrame = 0;
+    } else {
+        backEnd.smpFrame = 1;
+    }
+
     while ( 1 ) {
         data = PADP(data, sizeof(void *));
 
+        // stretch pics are batched until something else is drawn
+        if ( *(const int *)data != RC_SET_COLOR && *(const int *)data != RC_STRETCH_PIC ) {
+            RB_Flush2DPics();
+        }
+
         switch ( *(const int *)data ) {
         case RC_SET_COLOR:
             data = RB_SetColor( data );
@@ -1156,3 +1336,25 @@ void RB_ExecuteRenderCommands( const void *data ) {
     }
 
 }
+
+
+/*
+================
+RB_RenderThread
+================
+*/
+void RB_RenderThread( void ) {
+    const void  *data;
+
+    // wait for either a rendering command or a quit command
+    while ( 1 ) {
+        // sleep until we have work to do
+        data = GLimp_RendererSleep();
+
+        if ( !data ) {
+            return; // all done, renderer is shutting down
+        }
+
+        RB_ExecuteRenderCommands( data );
+    }
+}
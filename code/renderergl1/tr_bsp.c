@@ -35,6 +35,7 @@ void RE_LoadWorldMap( const char *name );
 
 static  world_t     s_worldData;
 static  byte        *fileBase;
+static  byte        *s_shadersPrefetched;   // world shaders whose images went to R_PrefetchImages
 
 int         c_subdivisions;
 int         c_gridVerts;
@@ -275,6 +276,44 @@ static  void R_LoadVisibility( lump_t *l ) {
 //===============================================================================
 
 
+/*
+===============
+R_PrefetchWorldShaders
+
+Decodes the images of the world shaders from firstShader on,
+skipping the ones already handed over, in one go on the worker
+threads.  Surfaces register their shaders in no particular order,
+so this runs again for the first shader left out.
+===============
+*/
+static void R_PrefetchWorldShaders( int firstShader ) {
+    char        names[MAX_PREFETCH_IMAGES][MAX_QPATH];
+    const char  *namePtrs[MAX_PREFETCH_IMAGES];
+    int         numNames;
+    int         i;
+
+    numNames = 0;
+    for ( i = firstShader; i < s_worldData.numShaders; i++ ) {
+        if ( s_shadersPrefetched[i] ) {
+            continue;
+        }
+
+        // leave room for a shader with several stages
+        if ( numNames > MAX_PREFETCH_IMAGES - 16 ) {
+            break;
+        }
+
+        numNames += R_GetShaderImageNames( s_worldData.shaders[i].shader, names + numNames, MAX_PREFETCH_IMAGES - numNames );
+        s_shadersPrefetched[i] = qtrue;
+    }
+
+    for ( i = 0; i < numNames; i++ ) {
+        namePtrs[i] = names[i];
+    }
+
+    R_PrefetchImages( namePtrs, numNames );
+}
+
 /*
 ===============
 ShaderForShaderNum
@@ -293,6 +332,10 @@ static shader_t *ShaderForShaderNum( int shaderNum, const int *lightmapNum, cons
     }
     dsh = &s_worldData.shaders[ _shaderNum ];
 
+    if ( r_imagePrefetch->integer && !s_shadersPrefetched[ _shaderNum ] ) {
+        R_PrefetchWorldShaders( _shaderNum );
+    }
+
     if(lightmapNum[0] == LIGHTMAP_BY_VERTEX){
         styles = vertexStyles;
     }
@@ -1489,6 +1532,8 @@ static  void R_LoadShaders( lump_t *l ) {
     s_worldData.shaders = out;
     s_worldData.numShaders = count;
 
+    s_shadersPrefetched = ri.Hunk_Alloc( count, h_low );
+
     Com_Memcpy( out, in, count*sizeof(*out) );
 
     for ( i=0 ; i<count ; i++ ) {
@@ -1841,6 +1886,127 @@ qboolean R_GetEntityToken( char *buffer, int size ) {
     }
 }
 
+/*
+=================
+R_SetupClusterTables
+
+Groups the leafs by cluster and computes the bounds of every
+surface, so R_MarkLeaves can gather the surfaces in the pvs
+without walking the nodes
+=================
+*/
+static void R_SetupClusterTables( void ) {
+    int         numLeafs, maxCount;
+    int         *cursor;
+    byte        *fromLeafs;
+    mnode_t     *leaf;
+    msurface_t  *surf, **mark;
+    visList_t   *vl;
+    float       *bounds;
+    vec3_t      *mins, *maxs;
+    int         i, j;
+
+    numLeafs = s_worldData.numnodes - s_worldData.numDecisionNodes;
+
+    // counting sort of the leafs by cluster
+    s_worldData.clusterFirstLeaf = ri.Hunk_Alloc( ( s_worldData.numClusters + 1 ) * sizeof( int ), h_low );
+    s_worldData.clusterLeafs = ri.Hunk_Alloc( numLeafs * sizeof( int ), h_low );
+
+    for ( i = 0, leaf = s_worldData.nodes + s_worldData.numDecisionNodes; i < numLeafs; i++, leaf++ ) {
+        if ( leaf->cluster >= 0 && leaf->cluster < s_worldData.numClusters ) {
+            s_worldData.clusterFirstLeaf[leaf->cluster + 1]++;
+        }
+    }
+    for ( i = 0; i < s_worldData.numClusters; i++ ) {
+        s_worldData.clusterFirstLeaf[i + 1] += s_worldData.clusterFirstLeaf[i];
+    }
+
+    cursor = ri.Hunk_AllocateTempMemory( s_worldData.numClusters * sizeof( int ) );
+    Com_Memcpy( cursor, s_worldData.clusterFirstLeaf, s_worldData.numClusters * sizeof( int ) );
+    for ( i = 0, leaf = s_worldData.nodes + s_worldData.numDecisionNodes; i < numLeafs; i++, leaf++ ) {
+        if ( leaf->cluster >= 0 && leaf->cluster < s_worldData.numClusters ) {
+            s_worldData.clusterLeafs[cursor[leaf->cluster]++] = s_worldData.numDecisionNodes + i;
+        }
+    }
+    ri.Hunk_FreeTempMemory( cursor );
+
+    // surface bounds from their geometry where it is known, deformed
+    // surfaces are drawn outside of it and keep the leaf bounds the
+    // node walk culled them by
+    s_worldData.surfaceBounds = ri.Hunk_Alloc( s_worldData.numsurfaces * 2 * sizeof( vec3_t ), h_low );
+    fromLeafs = ri.Hunk_AllocateTempMemory( s_worldData.numsurfaces );
+
+    for ( i = 0, surf = s_worldData.surfaces; i < s_worldData.numsurfaces; i++, surf++ ) {
+        mins = &s_worldData.surfaceBounds[i * 2 + 0];
+        maxs = &s_worldData.surfaceBounds[i * 2 + 1];
+
+        ClearBounds( *mins, *maxs );
+        fromLeafs[i] = qfalse;
+
+        if ( surf->shader->numDeforms ) {
+            fromLeafs[i] = qtrue;
+            continue;
+        }
+
+        switch ( *surf->data ) {
+        case SF_FACE:
+            {
+                srfSurfaceFace_t *face = (srfSurfaceFace_t *)surf->data;
+
+                for ( j = 0; j < face->numPoints; j++ ) {
+                    AddPointToBounds( face->points[j], *mins, *maxs );
+                }
+            }
+            break;
+        case SF_GRID:
+            VectorCopy( ((srfGridMesh_t *)surf->data)->meshBounds[0], *mins );
+            VectorCopy( ((srfGridMesh_t *)surf->data)->meshBounds[1], *maxs );
+            break;
+        case SF_TRIANGLES:
+            VectorCopy( ((srfTriangles_t *)surf->data)->bounds[0], *mins );
+            VectorCopy( ((srfTriangles_t *)surf->data)->bounds[1], *maxs );
+            break;
+        case SF_FLARE:
+            AddPointToBounds( ((srfFlare_t *)surf->data)->origin, *mins, *maxs );
+            break;
+        default:
+            fromLeafs[i] = qtrue;
+            break;
+        }
+    }
+
+    // anything else is bounded by the leafs that reference it
+    for ( i = 0, leaf = s_worldData.nodes + s_worldData.numDecisionNodes; i < numLeafs; i++, leaf++ ) {
+        for ( j = 0, mark = leaf->firstmarksurface; j < leaf->nummarksurfaces; j++, mark++ ) {
+            int     surfNum = *mark - s_worldData.surfaces;
+
+            if ( fromLeafs[surfNum] ) {
+                AddPointToBounds( leaf->mins, s_worldData.surfaceBounds[surfNum * 2 + 0], s_worldData.surfaceBounds[surfNum * 2 + 1] );
+                AddPointToBounds( leaf->maxs, s_worldData.surfaceBounds[surfNum * 2 + 0], s_worldData.surfaceBounds[surfNum * 2 + 1] );
+            }
+        }
+    }
+    ri.Hunk_FreeTempMemory( fromLeafs );
+
+    // room for everything being visible at once
+    vl = &s_worldData.visList;
+    maxCount = numLeafs > s_worldData.numsurfaces ? numLeafs : s_worldData.numsurfaces;
+
+    vl->leafs = ri.Hunk_Alloc( numLeafs * sizeof( *vl->leafs ), h_low );
+    bounds = ri.Hunk_Alloc( numLeafs * 6 * sizeof( float ), h_low );
+    for ( i = 0; i < 6; i++ ) {
+        vl->leafBounds[i] = bounds + i * numLeafs;
+    }
+
+    vl->surfaces = ri.Hunk_Alloc( s_worldData.numsurfaces * sizeof( *vl->surfaces ), h_low );
+    bounds = ri.Hunk_Alloc( s_worldData.numsurfaces * 6 * sizeof( float ), h_low );
+    for ( i = 0; i < 6; i++ ) {
+        vl->surfaceBounds[i] = bounds + i * s_worldData.numsurfaces;
+    }
+
+    vl->visible = ri.Hunk_Alloc( maxCount, h_low );
+}
+
 /*
 =================
 RE_LoadWorldMap
@@ -1881,6 +2047,9 @@ void RE_LoadWorldMap( const char *name ) {
     // try will not look at the partially loaded version
     tr.world = NULL;
 
+    // left over from a load that was dropped
+    R_ClearPrefetchedImages();
+
     Com_Memset( &s_worldData, 0, sizeof( s_worldData ) );
     Q_strncpyz( s_worldData.name, name, sizeof( s_worldData.name ) );
 
@@ -1910,10 +2079,12 @@ void RE_LoadWorldMap( const char *name ) {
     R_LoadPlanes (&header->lumps[LUMP_PLANES]);
     R_LoadFogs( &header->lumps[LUMP_FOGS], &header->lumps[LUMP_BRUSHES], &header->lumps[LUMP_BRUSHSIDES] );
     R_LoadSurfaces( &header->lumps[LUMP_SURFACES], &header->lumps[LUMP_DRAWVERTS], &header->lumps[LUMP_DRAWINDEXES] );
+    R_ClearPrefetchedImages();
     R_LoadMarksurfaces (&header->lumps[LUMP_LEAFSURFACES]);
     R_LoadNodesAndLeafs (&header->lumps[LUMP_NODES], &header->lumps[LUMP_LEAFS]);
     R_LoadSubmodels (&header->lumps[LUMP_MODELS]);
     R_LoadVisibility( &header->lumps[LUMP_VISIBILITY] );
+    R_SetupClusterTables();
     R_LoadEntities( &header->lumps[LUMP_ENTITIES] );
     R_LoadLightGrid( &header->lumps[LUMP_LIGHTGRID] );
     R_LoadLightArray( &header->lumps[LUMP_LIGHTARRAY] );
@@ -1923,6 +2094,10 @@ void RE_LoadWorldMap( const char *name ) {
     // only set tr.world now that we know the entire level has loaded properly
     tr.world = &s_worldData;
 
+    R_CreateWorldVBO();
+
+    R_InitWorldEffectContents( s_worldData.name, s_worldData.bmodels[0].bounds[0], s_worldData.bmodels[0].bounds[1] );
+
     ri.FS_FreeFile( buffer.v );
 }
 
@@ -46,6 +46,8 @@ void R_PerformanceCounters( void ) {
         ri.Printf (PRINT_ALL, "(md3) %i sin %i sclip  %i sout %i bin %i bclip %i bout\n",
             tr.pc.c_sphere_cull_md3_in, tr.pc.c_sphere_cull_md3_clip, tr.pc.c_sphere_cull_md3_out,
             tr.pc.c_box_cull_md3_in, tr.pc.c_box_cull_md3_clip, tr.pc.c_box_cull_md3_out );
+        ri.Printf (PRINT_ALL, "(occlusion) %i surfs %i ents\n",
+            tr.pc.c_occluded, tr.pc.c_occludedEntities );
     } else if (r_speeds->integer == 3) {
         ri.Printf (PRINT_ALL, "viewcluster: %i\n", tr.viewCluster );
     } else if (r_speeds->integer == 4) {
@@ -70,6 +72,37 @@ void R_PerformanceCounters( void ) {
 }
 
 
+/*
+====================
+R_InitCommandBuffers
+====================
+*/
+void R_InitCommandBuffers( void ) {
+    glConfig.smpActive = qfalse;
+    if ( r_smp->integer && backEndData[1] ) {
+        ri.Printf( PRINT_ALL, "Trying SMP acceleration...\n" );
+        if ( GLimp_SpawnRenderThread( RB_RenderThread ) ) {
+            ri.Printf( PRINT_ALL, "...succeeded.\n" );
+            glConfig.smpActive = qtrue;
+        } else {
+            ri.Printf( PRINT_ALL, "...failed.\n" );
+        }
+    }
+}
+
+/*
+====================
+R_ShutdownCommandBuffers
+====================
+*/
+void R_ShutdownCommandBuffers( void ) {
+    // kill the rendering thread
+    if ( glConfig.smpActive ) {
+        GLimp_ShutdownRenderThread();
+        glConfig.smpActive = qfalse;
+    }
+}
+
 /*
 ====================
 R_IssueRenderCommands
@@ -77,15 +110,30 @@ R_IssueRenderCommands
 */
 void R_IssueRenderCommands( qboolean runPerformanceCounters ) {
     renderCommandList_t *cmdList;
+    qboolean            synchronous;
 
-    cmdList = &backEndData->commands;
+    cmdList = &backEndData[tr.smpFrame]->commands;
     assert(cmdList);
     // add an end-of-list command
     *(int *)(cmdList->cmds + cmdList->used) = RC_END_OF_LIST;
 
     // clear it out, in case this is a sync and not a buffer flip
     cmdList->used = 0;
+    synchronous = cmdList->synchronous;
+    cmdList->synchronous = qfalse;
+
+    if ( glConfig.smpActive ) {
+        // if the render thread is not idle, wait for it
+        if ( r_showSmp->integer ) {
+            ri.Printf( PRINT_ALL, GLimp_RendererActive() ? "R" : "." );
+        }
+
+        // sleep until the renderer has completed
+        GLimp_FrontEndSleep();
+    }
 
+    // at this point, the back end thread is idle, so it is ok
+    // to look at its performance counters
     if ( runPerformanceCounters ) {
         R_PerformanceCounters();
     }
@@ -93,7 +141,17 @@ void R_IssueRenderCommands( qboolean runPerformanceCounters ) {
     // actually start the commands going
     if ( !r_skipBackEnd->integer ) {
         // let it start on the new batch
-        RB_ExecuteRenderCommands( cmdList->cmds );
+        if ( !glConfig.smpActive ) {
+            RB_ExecuteRenderCommands( cmdList->cmds );
+        } else {
+            GLimp_WakeRenderer( cmdList->cmds );
+
+            // screenshots and video frames call back into the
+            // client, they can't overlap with the front end
+            if ( synchronous ) {
+                GLimp_FrontEndSleep();
+            }
+        }
     }
 }
 
@@ -103,13 +161,41 @@ void R_IssueRenderCommands( qboolean runPerformanceCounters ) {
 R_IssuePendingRenderCommands
 
 Issue any pending commands and wait for them to complete.
+With a render thread this also hands the GL context back
+to the front end, so it is safe to call GL afterwards.
 ====================
 */
 void R_IssuePendingRenderCommands( void ) {
     if ( !tr.registered ) {
         return;
     }
+
+    if ( glConfig.smpActive && !backEndData[tr.smpFrame]->commands.used ) {
+        GLimp_FrontEndAcquireContext();
+        return;
+    }
+
     R_IssueRenderCommands( qfalse );
+
+    if ( glConfig.smpActive ) {
+        GLimp_FrontEndAcquireContext();
+    }
+}
+
+/*
+====================
+R_SyncRenderThread
+
+Waits for the render thread and takes the context back without
+issuing the commands queued so far, for GL work that doesn't
+depend on them, like texture uploads.
+====================
+*/
+void R_SyncRenderThread( void ) {
+    if ( !glConfig.smpActive ) {
+        return;
+    }
+    GLimp_FrontEndAcquireContext();
 }
 
 /*
@@ -122,7 +208,7 @@ make sure there is enough command space
 void *R_GetCommandBufferReserved( int bytes, int reservedBytes ) {
     renderCommandList_t *cmdList;
 
-    cmdList = &backEndData->commands;
+    cmdList = &backEndData[tr.smpFrame]->commands;
     bytes = PAD(bytes, sizeof(void *));
 
     // always leave room for the end of list command
@@ -385,6 +471,7 @@ void RE_BeginFrame( stereoFrame_t stereoFrame ) {
             if(r_anaglyphMode->modified)
             {
                 // clear both, front and backbuffer.
+                R_IssuePendingRenderCommands();
                 qglColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
                 qglClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
@@ -437,6 +524,7 @@ void RE_BeginFrame( stereoFrame_t stereoFrame ) {
 
             if(r_anaglyphMode->modified)
             {
+                R_IssuePendingRenderCommands();
                 qglColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
                 r_anaglyphMode->modified = qfalse;
             }
@@ -505,6 +593,7 @@ void RE_TakeVideoFrame( int width, int height,
     }
 
     cmd->commandId = RC_VIDEOFRAME;
+    backEndData[tr.smpFrame]->commands.synchronous = qtrue;
 
     cmd->width = width;
     cmd->height = height;
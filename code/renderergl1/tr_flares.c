@@ -36,9 +36,11 @@ projected area of the light source.
 A surface that has been flagged as having a light flare will calculate the depth
 buffer value that its midpoint should have when the surface is added.
 
-After all opaque surfaces have been rendered, the depth buffer is read back for
-each flare in view.  If the point has not been obscured by a closer surface, the
-flare should be drawn.
+After all opaque surfaces have been rendered, an occlusion query is issued for
+each flare in view.  Its result is read back a frame or more later, when the GPU
+has finished with it, and if the point has not been obscured by a closer surface,
+the flare should be drawn.  Without occlusion queries the depth buffer is read
+back for each flare instead, which stalls until everything before it is drawn.
 
 Surfaces that have a repeated texture should never be flagged as flaring, because
 there will only be a single flare added at the midpoint of the polygon.
@@ -72,6 +74,9 @@ typedef struct flare_s {
     qboolean    visible;            // state of last test
     float       drawIntensity;      // may be non 0 even if !visible due to fading
 
+    qboolean    queryPending;       // occlusion query issued, result not read yet
+    qboolean    queryVisible;       // result of the last finished query
+
     int         windowX, windowY;
     float       eyeZ;
 
@@ -84,6 +89,10 @@ typedef struct flare_s {
 flare_t     r_flareStructs[MAX_FLARES];
 flare_t     *r_activeFlares, *r_inactiveFlares;
 
+// one occlusion query for each of r_flareStructs
+static GLuint   r_flareQueries[MAX_FLARES];
+static qboolean r_flareQueriesActive;
+
 int flareCoeff;
 
 /*
@@ -119,6 +128,36 @@ void R_ClearFlares( void ) {
     R_SetFlareCoeff();
 }
 
+/*
+==================
+R_InitFlareQueries
+==================
+*/
+void R_InitFlareQueries( void ) {
+    r_flareQueriesActive = qfalse;
+
+    if ( !qglGenQueries ) {
+        return;
+    }
+
+    qglGenQueries( MAX_FLARES, r_flareQueries );
+    r_flareQueriesActive = qtrue;
+}
+
+/*
+==================
+R_ShutdownFlareQueries
+==================
+*/
+void R_ShutdownFlareQueries( void ) {
+    if ( !r_flareQueriesActive ) {
+        return;
+    }
+
+    qglDeleteQueries( MAX_FLARES, r_flareQueries );
+    r_flareQueriesActive = qfalse;
+}
+
 
 /*
 ==================
@@ -189,6 +228,10 @@ void RB_AddFlare( void *surface, int fogNum, vec3_t point, vec3_t color, vec3_t
         f->frameSceneNum = backEnd.viewParms.frameSceneNum;
         f->inPortal = backEnd.viewParms.isPortal;
         f->addedFrame = -1;
+
+        // a query still pending belongs to the previous owner
+        f->queryPending = qfalse;
+        f->queryVisible = qfalse;
     }
 
     if ( f->addedFrame != backEnd.viewParms.frameCount - 1 ) {
@@ -267,6 +310,32 @@ FLARE BACK END
 ===============================================================================
 */
 
+/*
+==================
+RB_TestFlareQuery
+
+Picks up the result of the query issued for this flare in an
+earlier frame if the GPU is done with it, it never waits
+==================
+*/
+static qboolean RB_TestFlareQuery( flare_t *f ) {
+    GLuint  query;
+    GLuint  available, samples;
+
+    if ( f->queryPending ) {
+        query = r_flareQueries[f - r_flareStructs];
+
+        qglGetQueryObjectuiv( query, GL_QUERY_RESULT_AVAILABLE, &available );
+        if ( available ) {
+            qglGetQueryObjectuiv( query, GL_QUERY_RESULT, &samples );
+            f->queryVisible = ( samples != 0 );
+            f->queryPending = qfalse;
+        }
+    }
+
+    return f->queryVisible;
+}
+
 /*
 ==================
 RB_TestFlare
@@ -280,17 +349,21 @@ void RB_TestFlare( flare_t *f ) {
 
     backEnd.pc.c_flareTests++;
 
-    // doing a readpixels is as good as doing a glFinish(), so
-    // don't bother with another sync
-    glState.finishCalled = qfalse;
+    if ( r_flareQueriesActive ) {
+        visible = RB_TestFlareQuery( f );
+    } else {
+        // doing a readpixels is as good as doing a glFinish(), so
+        // don't bother with another sync
+        glState.finishCalled = qfalse;
 
-    // read back the z buffer contents
-    qglReadPixels( f->windowX, f->windowY, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &depth );
+        // read back the z buffer contents
+        qglReadPixels( f->windowX, f->windowY, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &depth );
 
-    screenZ = backEnd.viewParms.projectionMatrix[14] /
-        ( ( 2*depth - 1 ) * backEnd.viewParms.projectionMatrix[11] - backEnd.viewParms.projectionMatrix[10] );
+        screenZ = backEnd.viewParms.projectionMatrix[14] /
+            ( ( 2*depth - 1 ) * backEnd.viewParms.projectionMatrix[11] - backEnd.viewParms.projectionMatrix[10] );
 
-    visible = ( -f->eyeZ - -screenZ ) < 24;
+        visible = ( -f->eyeZ - -screenZ ) < 24;
+    }
 
     if ( visible ) {
         if ( !f->visible ) {
@@ -317,6 +390,69 @@ void RB_TestFlare( flare_t *f ) {
 }
 
 
+/*
+==================
+RB_IssueFlareQueries
+
+Draws a point for every flare in this view that has no query in
+flight.  The point is pulled 24 units towards the eye, the same
+tolerance the depth readback uses, and counts as visible if any
+sample of it passes the depth test.
+==================
+*/
+static void RB_IssueFlareQueries( void ) {
+    flare_t     *f;
+    float       *projection;
+    float       eyeZ, depth;
+
+    projection = backEnd.viewParms.projectionMatrix;
+
+    qglMatrixMode( GL_PROJECTION );
+    qglPushMatrix();
+    qglLoadIdentity();
+    // window z is the depth buffer value
+    qglOrtho( backEnd.viewParms.viewportX, backEnd.viewParms.viewportX + backEnd.viewParms.viewportWidth,
+              backEnd.viewParms.viewportY, backEnd.viewParms.viewportY + backEnd.viewParms.viewportHeight,
+              0, -1 );
+    qglMatrixMode( GL_MODELVIEW );
+
+    GL_Bind( tr.whiteImage );
+    GL_Cull( CT_TWO_SIDED );
+    // depth tested, but leaves the color and depth buffers alone
+    GL_State( GLS_SRCBLEND_ZERO | GLS_DSTBLEND_ONE );
+
+    for ( f = r_activeFlares ; f ; f = f->next ) {
+        if ( f->frameSceneNum != backEnd.viewParms.frameSceneNum
+            || f->inPortal != backEnd.viewParms.isPortal || f->queryPending ) {
+            continue;
+        }
+
+        eyeZ = f->eyeZ + 24;
+        if ( eyeZ > -r_znear->value ) {
+            depth = 0;
+        } else {
+            depth = 0.5f * ( projection[10] * eyeZ + projection[14] ) / ( projection[11] * eyeZ ) + 0.5f;
+            if ( depth < 0 ) {
+                depth = 0;
+            } else if ( depth > 1 ) {
+                depth = 1;
+            }
+        }
+
+        qglBeginQuery( GL_SAMPLES_PASSED, r_flareQueries[f - r_flareStructs] );
+        qglBegin( GL_POINTS );
+        qglVertex3f( f->windowX + 0.5f, f->windowY + 0.5f, depth );
+        qglEnd();
+        qglEndQuery( GL_SAMPLES_PASSED );
+
+        f->queryPending = qtrue;
+    }
+
+    qglMatrixMode( GL_PROJECTION );
+    qglPopMatrix();
+    qglMatrixMode( GL_MODELVIEW );
+}
+
 /*
 ==================
 RB_RenderFlare
@@ -476,7 +612,8 @@ void RB_RenderFlares (void) {
 
 //  RB_AddDlightFlares();
 
-    // perform z buffer readback on each flare in this view
+    // perform z buffer readback or collect the query results
+    // on each flare in this view
     draw = qfalse;
     prev = &r_activeFlares;
     while ( ( f = *prev ) != NULL ) {
@@ -495,7 +632,7 @@ void RB_RenderFlares (void) {
             RB_TestFlare( f );
             if ( f->drawIntensity ) {
                 draw = qtrue;
-            } else {
+            } else if ( !r_flareQueriesActive ) {
                 // this flare has completely faded out, so remove it from the chain
                 *prev = f->next;
                 f->next = r_inactiveFlares;
@@ -507,7 +644,9 @@ void RB_RenderFlares (void) {
         prev = &f->next;
     }
 
-    if ( !draw ) {
+    // with queries the occluded flares stay in the chain,
+    // they have to be tested again
+    if ( !draw && !r_flareQueriesActive ) {
         return;     // none visible
     }
 
@@ -517,6 +656,16 @@ void RB_RenderFlares (void) {
 
     qglPushMatrix();
     qglLoadIdentity();
+
+    if ( r_flareQueriesActive ) {
+        RB_IssueFlareQueries();
+
+        if ( !draw ) {
+            qglPopMatrix();
+            return;     // none visible
+        }
+    }
+
     qglMatrixMode( GL_PROJECTION );
     qglPushMatrix();
     qglLoadIdentity();
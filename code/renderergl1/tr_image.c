@@ -148,8 +148,9 @@ R_ImageList_f
 void R_ImageList_f( void ) {
     int i;
     int estTotalSize = 0;
+    int readTotal = 0, decodeTotal = 0, uploadTotal = 0;
 
-    ri.Printf(PRINT_ALL, "\n      -w-- -h-- type  -size- --name-------\n");
+    ri.Printf(PRINT_ALL, "\n      -w-- -h-- type  -size- -read -dec- -upl- --name-------\n");
 
     for ( i = 0 ; i < tr.numImages ; i++ )
     {
@@ -273,70 +274,22 @@ void R_ImageList_f( void ) {
             sizeSuffix = "Gb";
         }
 
-        ri.Printf(PRINT_ALL, "%4i: %4ix%4i %s %4i%s %s\n", i, image->uploadWidth, image->uploadHeight, format, displaySize, sizeSuffix, image->imgName);
+        ri.Printf(PRINT_ALL, "%4i: %4ix%4i %s %4i%s %5i %5i %5i %s\n", i, image->uploadWidth, image->uploadHeight, format, displaySize, sizeSuffix,
+                image->readMsec, image->decodeMsec, image->uploadMsec, image->imgName);
         estTotalSize += estSize;
+        readTotal += image->readMsec;
+        decodeTotal += image->decodeMsec;
+        uploadTotal += image->uploadMsec;
     }
 
     ri.Printf (PRINT_ALL, " ---------\n");
     ri.Printf (PRINT_ALL, " approx %i bytes\n", estTotalSize);
+    ri.Printf (PRINT_ALL, " %i msec read, %i msec decode, %i msec upload\n", readTotal, decodeTotal, uploadTotal);
     ri.Printf (PRINT_ALL, " %i total images\n\n", tr.numImages );
 }
 
 //=======================================================================
 
-/*
-================
-ResampleTexture
-
-Used to resample images in a more general than quartering fashion.
-
-This will only be filtered properly if the resampled size
-is greater than half the original size.
-
-If a larger shrinking is needed, use the mipmap function
-before or after.
-================
-*/
-static void ResampleTexture( unsigned *in, int inwidth, int inheight, unsigned *out,
-                            int outwidth, int outheight ) {
-    int     i, j;
-    unsigned    *inrow, *inrow2;
-    unsigned    frac, fracstep;
-    unsigned    p1[2048], p2[2048];
-    byte        *pix1, *pix2, *pix3, *pix4;
-
-    if (outwidth>2048)
-        ri.Error(ERR_DROP, "ResampleTexture: max width");
-
-    fracstep = inwidth*0x10000/outwidth;
-
-    frac = fracstep>>2;
-    for ( i=0 ; i<outwidth ; i++ ) {
-        p1[i] = 4*(frac>>16);
-        frac += fracstep;
-    }
-    frac = 3*(fracstep>>2);
-    for ( i=0 ; i<outwidth ; i++ ) {
-        p2[i] = 4*(frac>>16);
-        frac += fracstep;
-    }
-
-    for (i=0 ; i<outheight ; i++, out += outwidth) {
-        inrow = in + inwidth*(int)((i+0.25)*inheight/outheight);
-        inrow2 = in + inwidth*(int)((i+0.75)*inheight/outheight);
-        for (j=0 ; j<outwidth ; j++) {
-            pix1 = (byte *)inrow + p1[j];
-            pix2 = (byte *)inrow + p2[j];
-            pix3 = (byte *)inrow2 + p1[j];
-            pix4 = (byte *)inrow2 + p2[j];
-            ((byte *)(out+j))[0] = (pix1[0] + pix2[0] + pix3[0] + pix4[0])>>2;
-            ((byte *)(out+j))[1] = (pix1[1] + pix2[1] + pix3[1] + pix4[1])>>2;
-            ((byte *)(out+j))[2] = (pix1[2] + pix2[2] + pix3[2] + pix4[2])>>2;
-            ((byte *)(out+j))[3] = (pix1[3] + pix2[3] + pix3[3] + pix4[3])>>2;
-        }
-    }
-}
-
 /*
 ================
 R_LightScaleTexture
@@ -347,52 +300,28 @@ lighting range
 */
 void R_LightScaleTexture (unsigned *in, int inwidth, int inheight, qboolean only_gamma )
 {
+    byte    table[256];
+    int     i;
+
     if ( only_gamma )
     {
-        if ( !glConfig.deviceSupportsGamma )
-        {
-            int     i, c;
-            byte    *p;
-
-            p = (byte *)in;
+        if ( glConfig.deviceSupportsGamma )
+            return;
 
-            c = inwidth*inheight;
-            for (i=0 ; i<c ; i++, p+=4)
-            {
-                p[0] = s_gammatable[p[0]];
-                p[1] = s_gammatable[p[1]];
-                p[2] = s_gammatable[p[2]];
-            }
-        }
+        Com_Memcpy( table, s_gammatable, sizeof( table ) );
+    }
+    else if ( glConfig.deviceSupportsGamma )
+    {
+        Com_Memcpy( table, s_intensitytable, sizeof( table ) );
     }
     else
     {
-        int     i, c;
-        byte    *p;
-
-        p = (byte *)in;
-
-        c = inwidth*inheight;
-
-        if ( glConfig.deviceSupportsGamma )
-        {
-            for (i=0 ; i<c ; i++, p+=4)
-            {
-                p[0] = s_intensitytable[p[0]];
-                p[1] = s_intensitytable[p[1]];
-                p[2] = s_intensitytable[p[2]];
-            }
-        }
-        else
-        {
-            for (i=0 ; i<c ; i++, p+=4)
-            {
-                p[0] = s_gammatable[s_intensitytable[p[0]]];
-                p[1] = s_gammatable[s_intensitytable[p[1]]];
-                p[2] = s_gammatable[s_intensitytable[p[2]]];
-            }
-        }
+        // fold both lookups into one pass
+        for ( i = 0 ; i < 256 ; i++ )
+            table[i] = s_gammatable[s_intensitytable[i]];
     }
+
+    R_RemapTextureRGB( (byte *)in, inwidth*inheight, table );
 }
 
 
@@ -460,43 +389,12 @@ Operates in place, quartering the size of the texture
 ================
 */
 static void R_MipMap (byte *in, int width, int height) {
-    int     i, j;
-    byte    *out;
-    int     row;
-
     if ( !r_simpleMipMaps->integer ) {
         R_MipMap2( (unsigned *)in, width, height );
         return;
     }
 
-    if ( width == 1 && height == 1 ) {
-        return;
-    }
-
-    row = width * 4;
-    out = in;
-    width >>= 1;
-    height >>= 1;
-
-    if ( width == 0 || height == 0 ) {
-        width += height;    // get largest
-        for (i=0 ; i<width ; i++, out+=4, in+=8 ) {
-            out[0] = ( in[0] + in[4] )>>1;
-            out[1] = ( in[1] + in[5] )>>1;
-            out[2] = ( in[2] + in[6] )>>1;
-            out[3] = ( in[3] + in[7] )>>1;
-        }
-        return;
-    }
-
-    for (i=0 ; i<height ; i++, in+=row) {
-        for (j=0 ; j<width ; j++, out+=4, in+=8) {
-            out[0] = (in[0] + in[4] + in[row+0] + in[row+4])>>2;
-            out[1] = (in[1] + in[5] + in[row+1] + in[row+5])>>2;
-            out[2] = (in[2] + in[6] + in[row+2] + in[row+6])>>2;
-            out[3] = (in[3] + in[7] + in[row+3] + in[row+7])>>2;
-        }
-    }
+    R_MipMapBoxRGBA( in, width, height );
 }
 
 
@@ -544,6 +442,33 @@ byte    mipBlendColors[16][4] = {
 };
 
 
+/*
+===============
+Upload_SetFilter
+===============
+*/
+static void Upload_SetFilter( qboolean mipmap )
+{
+    if (mipmap)
+    {
+        if ( textureFilterAnisotropic )
+            qglTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT,
+                    (GLint)Com_Clamp( 1, maxAnisotropy, r_ext_max_anisotropy->integer ) );
+
+        qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, gl_filter_min);
+        qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, gl_filter_max);
+    }
+    else
+    {
+        if ( textureFilterAnisotropic )
+            qglTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 1 );
+
+        qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+        qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+    }
+}
+
+
 /*
 ===============
 Upload32
@@ -582,7 +507,7 @@ static void Upload32( unsigned *data,
 
     if ( scaled_width != width || scaled_height != height ) {
         resampledBuffer = ri.Hunk_AllocateTempMemory( scaled_width * scaled_height * 4 );
-        ResampleTexture (data, width, height, resampledBuffer, scaled_width, scaled_height);
+        R_ResampleTextureRGBA( (byte *)data, width, height, (byte *)resampledBuffer, scaled_width, scaled_height );
         data = resampledBuffer;
         width = scaled_width;
         height = scaled_height;
@@ -802,23 +727,7 @@ static void Upload32( unsigned *data,
     }
 done:
 
-    if (mipmap)
-    {
-        if ( textureFilterAnisotropic )
-            qglTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT,
-                    (GLint)Com_Clamp( 1, maxAnisotropy, r_ext_max_anisotropy->integer ) );
-
-        qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, gl_filter_min);
-        qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, gl_filter_max);
-    }
-    else
-    {
-        if ( textureFilterAnisotropic )
-            qglTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 1 );
-
-        qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-        qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-    }
+    Upload_SetFilter( mipmap );
 
     GL_CheckErrors();
 
@@ -829,6 +738,51 @@ done:
 }
 
 
+/*
+===============
+UploadCached
+
+Uploads the levels of an image cache file as they are
+===============
+*/
+static void UploadCached( const cachedImage_t *cached, qboolean mipmap, int *format,
+                          int *pUploadWidth, int *pUploadHeight )
+{
+    int     width, height;
+    int     i;
+
+    width = cached->uploadWidth;
+    height = cached->uploadHeight;
+
+    for ( i = 0; i < cached->numLevels; i++ )
+    {
+        if ( cached->compressed )
+            qglCompressedTexImage2D( GL_TEXTURE_2D, i, cached->internalFormat, width, height, 0, cached->levelSize[i], cached->levels[i] );
+        else
+            qglTexImage2D( GL_TEXTURE_2D, i, cached->internalFormat, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, cached->levels[i] );
+
+        width = width > 1 ? width >> 1 : 1;
+        height = height > 1 ? height >> 1 : 1;
+    }
+
+    *pUploadWidth = cached->uploadWidth;
+    *pUploadHeight = cached->uploadHeight;
+    *format = cached->internalFormat;
+
+    Upload_SetFilter( mipmap );
+
+    GL_CheckErrors();
+}
+
+
+// set by R_FindImageFile to have R_CreateImage upload a cache file
+// instead of processing the picture
+static const cachedImage_t  *uploadCache;
+
+// set by R_FindImageFile to have R_CreateImage re-bind a texture
+// a previous map left in the pool
+static const image_t        *uploadRetained;
+
 /*
 ================
 R_CreateImage
@@ -842,6 +796,7 @@ image_t *R_CreateImage( const char *name, byte *pic, int width, int height,
     qboolean    isLightmap = qfalse;
     long        hash;
     int         glWrapClampMode;
+    int         start;
 
     if (strlen(name) >= MAX_QPATH ) {
         ri.Error (ERR_DROP, "R_CreateImage: \"%s\" is too long", name);
@@ -854,8 +809,15 @@ image_t *R_CreateImage( const char *name, byte *pic, int width, int height,
         ri.Error( ERR_DROP, "R_CreateImage: MAX_DRAWIMAGES hit");
     }
 
+    // the upload needs the context
+    R_SyncRenderThread();
+
     image = tr.images[tr.numImages] = ri.Hunk_Alloc( sizeof( image_t ), h_low );
-    qglGenTextures(1, &image->texnum);
+    if ( uploadRetained ) {
+        image->texnum = uploadRetained->texnum;
+    } else {
+        qglGenTextures(1, &image->texnum);
+    }
     tr.numImages++;
 
     image->type = type;
@@ -883,7 +845,21 @@ image_t *R_CreateImage( const char *name, byte *pic, int width, int height,
 
     GL_Bind(image);
 
-    Upload32( (unsigned *)pic, image->width, image->height,
+    start = ri.Milliseconds();
+
+    if ( uploadRetained ) {
+        // the levels are there already, only the filter may have changed
+        image->internalFormat = uploadRetained->internalFormat;
+        image->uploadWidth = uploadRetained->uploadWidth;
+        image->uploadHeight = uploadRetained->uploadHeight;
+        Upload_SetFilter( image->flags & IMGFLAG_MIPMAP );
+    } else if ( uploadCache ) {
+        UploadCached( uploadCache, image->flags & IMGFLAG_MIPMAP,
+                                &image->internalFormat,
+                                &image->uploadWidth,
+                                &image->uploadHeight );
+    } else {
+        Upload32( (unsigned *)pic, image->width, image->height,
                                 image->flags & IMGFLAG_MIPMAP,
                                 image->flags & IMGFLAG_PICMIP,
                                 isLightmap,
@@ -891,6 +867,9 @@ image_t *R_CreateImage( const char *name, byte *pic, int width, int height,
                                 &image->internalFormat,
                                 &image->uploadWidth,
                                 &image->uploadHeight );
+    }
+
+    image->uploadMsec = ri.Milliseconds() - start;
 
     qglTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, glWrapClampMode );
     qglTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, glWrapClampMode );
@@ -911,12 +890,6 @@ image_t *R_CreateImage( const char *name, byte *pic, int width, int height,
 
 //===================================================================
 
-typedef struct
-{
-    char *ext;
-    void (*ImageLoader)( const char *, unsigned char **, int *, int * );
-} imageExtToLoaderMap_t;
-
 // Note that the ordering indicates the order of preference used
 // when there are multiple images of different formats available
 static imageExtToLoaderMap_t imageLoaders[ ] =
@@ -931,15 +904,15 @@ static imageExtToLoaderMap_t imageLoaders[ ] =
 
 static int numImageLoaders = ARRAY_LEN( imageLoaders );
 
+// timings of the last R_LoadImage, for R_FindImageFile
+static int loadReadMsec, loadDecodeMsec;
+
 /*
 =================
-R_LoadImage
-
-Loads any of the supported image types into a canonical
-32 bit format.
+R_LoadImageFile
 =================
 */
-void R_LoadImage( const char *name, byte **pic, int *width, int *height )
+static void R_LoadImageFile( const char *name, byte **pic, int *width, int *height )
 {
     qboolean orgNameFailed = qfalse;
     int orgLoader = -1;
@@ -1013,6 +986,69 @@ void R_LoadImage( const char *name, byte **pic, int *width, int *height )
     }
 }
 
+/*
+=================
+R_LoadImage
+
+Loads any of the supported image types into a canonical
+32 bit format.
+=================
+*/
+void R_LoadImage( const char *name, byte **pic, int *width, int *height )
+{
+    int     start;
+
+    if ( R_TakePrefetchedImage( name, pic, width, height, &loadReadMsec, &loadDecodeMsec ) ) {
+        return;
+    }
+
+    R_ImageReadTime();
+    start = ri.Milliseconds();
+
+    R_LoadImageFile( name, pic, width, height );
+
+    loadReadMsec = R_ImageReadTime();
+    loadDecodeMsec = ri.Milliseconds() - start - loadReadMsec;
+}
+
+/*
+=================
+R_PrefetchImages
+
+Decodes the named images on the worker threads ahead of
+their registration
+=================
+*/
+void R_PrefetchImages( const char **names, int numNames )
+{
+    const char  *unloaded[MAX_PREFETCH_IMAGES];
+    image_t     *image;
+    int         numUnloaded;
+    int         i;
+
+    if ( !r_imagePrefetch->integer ) {
+        return;
+    }
+
+    numUnloaded = 0;
+    for ( i = 0; i < numNames && numUnloaded < MAX_PREFETCH_IMAGES; i++ ) {
+        for ( image = hashTable[generateHashValue( names[i] )]; image; image = image->next ) {
+            if ( !strcmp( names[i], image->imgName ) ) {
+                break;
+            }
+        }
+
+        if ( !image ) {
+            unloaded[numUnloaded++] = names[i];
+        }
+    }
+
+    // the workers may be busy with the back end
+    R_SyncRenderThread();
+
+    R_PrefetchImageFiles( unloaded, numUnloaded, imageLoaders, numImageLoaders );
+}
+
 /*
 =================
 R_LoadDataImage
@@ -1039,6 +1075,53 @@ void R_LoadDataImage(const char *name, byte **pic, int *width, int *height)
     R_LoadPNGDataFile(localName, pic, width, height);
 }
 
+/*
+===============
+R_ImageCacheParams
+
+Everything besides the picture that goes into an upload
+===============
+*/
+static void R_ImageCacheParams( imgType_t type, imgFlags_t flags, char *params, int size )
+{
+    Com_sprintf( params, size, "gl1 %i %i %i %i %i %i %i %g %g %g %i %i %i %i",
+            type, flags, r_picmip->integer, r_roundImagesDown->integer, r_texturebits->integer,
+            r_simpleMipMaps->integer, r_colorMipLevels->integer, r_intensity->value, r_greyscale->value,
+            glConfig.deviceSupportsGamma ? 0.0f : r_gamma->value, tr.overbrightBits,
+            glConfig.maxTextureSize, glConfig.textureCompression, r_imageCacheCompress->integer );
+}
+
+/*
+===============
+R_ImageCacheEncodeFormat
+
+Upload32 never compresses images with alpha, the cache can
+===============
+*/
+static GLenum R_ImageCacheEncodeFormat( const image_t *image )
+{
+    if ( !r_imageCacheCompress->integer || glConfig.textureCompression != TC_S3TC_ARB ) {
+        return 0;
+    }
+
+    if ( image->flags & IMGFLAG_NO_COMPRESSION ) {
+        return 0;
+    }
+
+    switch ( image->internalFormat ) {
+        case GL_RGBA:
+        case GL_RGBA4:
+        case GL_RGBA8:
+            return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case GL_RGB:
+        case GL_RGB5:
+        case GL_RGB8:
+            return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        default:
+            return 0;
+    }
+}
+
 /*
 ===============
 R_FindImageFile
@@ -1053,6 +1136,15 @@ image_t *R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags )
     int     width, height;
     byte    *pic;
     long    hash;
+    imageCacheKey_t cacheKey;
+    cachedImage_t   cached;
+    const image_t   *retained;
+    int     retainKey;
+    char    params[MAX_STRING_CHARS];
+    char    source[MAX_QPATH];
+    long    sourceLength;
+    qboolean    renamed;
+    int     loader;
 
     if (!name) {
         return NULL;
@@ -1075,6 +1167,37 @@ image_t *R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags )
         }
     }
 
+    R_ImageCacheParams( type, flags, params, sizeof( params ) );
+
+    //
+    // re-bind the texture a previous map left behind
+    //
+    sourceLength = R_ReadImageSource( name, imageLoaders, numImageLoaders, source, sizeof( source ), &loader, &renamed, NULL );
+    retainKey = R_RetainedImageKey( params, source, sourceLength );
+    retained = R_AcquireRetainedImage( name, retainKey );
+    if ( retained ) {
+        uploadRetained = retained;
+        image = R_CreateImage( ( char * ) name, NULL, retained->width, retained->height, type, flags, 0 );
+        uploadRetained = NULL;
+        return image;
+    }
+
+    //
+    // upload a processed copy from the image cache
+    //
+    cacheKey.path[0] = '\0';
+    if ( r_imageCache->integer ) {
+        if ( R_FindCachedImage( name, params, imageLoaders, numImageLoaders, &cacheKey, &cached ) ) {
+            uploadCache = &cached;
+            image = R_CreateImage( ( char * ) name, NULL, cached.width, cached.height, type, flags, 0 );
+            uploadCache = NULL;
+            image->readMsec = cached.readMsec;
+            R_FreeCachedImage( &cached );
+            R_RetainImage( image, retainKey );
+            return image;
+        }
+    }
+
     //
     // load the pic from disk
     //
@@ -1084,7 +1207,17 @@ image_t *R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags )
     }
 
     image = R_CreateImage( ( char * ) name, pic, width, height, type, flags, 0 );
+    image->readMsec = loadReadMsec;
+    image->decodeMsec = loadDecodeMsec;
     ri.Free( pic );
+
+    if ( cacheKey.path[0] ) {
+        GL_Bind( image );
+        R_SaveCachedImage( &cacheKey, image, R_ImageCacheEncodeFormat( image ) );
+    }
+
+    R_RetainImage( image, retainKey );
+
     return image;
 }
 
@@ -1367,6 +1500,9 @@ R_InitImages
 */
 void    R_InitImages( void ) {
     Com_Memset(hashTable, 0, sizeof(hashTable));
+    uploadCache = NULL;     // in case a drop interrupted a cached upload
+    uploadRetained = NULL;
+    R_BeginRetainedImages();
     // build brightness translation tables
     R_SetColorMappings();
 
@@ -1383,7 +1519,10 @@ void R_DeleteTextures( void ) {
     int     i;
 
     for ( i=0; i<tr.numImages ; i++ ) {
-        qglDeleteTextures( 1, &tr.images[i]->texnum );
+        // textures of images from files can be kept for the next map
+        if ( !R_ReleaseRetainedImage( tr.images[i] ) ) {
+            qglDeleteTextures( 1, &tr.images[i]->texnum );
+        }
     }
     Com_Memset( tr.images, 0, sizeof( tr.images ) );
 
@@ -70,6 +70,8 @@ cvar_t  *r_fastsky;
 cvar_t  *r_drawSun;
 cvar_t  *r_dynamiclight;
 cvar_t  *r_dlightBacks;
+cvar_t  *r_simd;
+cvar_t  *r_weatherThreads;
 
 cvar_t  *r_lodbias;
 cvar_t  *r_lodscale;
@@ -81,12 +83,25 @@ cvar_t  *r_speeds;
 cvar_t  *r_fullbright;
 cvar_t  *r_novis;
 cvar_t  *r_nocull;
+cvar_t  *r_occlusion;
+cvar_t  *r_occlusionDebug;
+
+cvar_t  *r_imageThreads;
+cvar_t  *r_imagePrefetch;
+cvar_t  *r_imageCache;
+cvar_t  *r_imageCacheCompress;
+cvar_t  *r_shaderCache;
+cvar_t  *r_retainImages;
+
+cvar_t  *r_weatherGrid;
+cvar_t  *r_weatherGridCache;
 cvar_t  *r_facePlaneCull;
 cvar_t  *r_showcluster;
 cvar_t  *r_nocurves;
 
 cvar_t  *r_surfaceSprites;
 cvar_t  *r_ssCheap;
+cvar_t  *r_surfaceSpriteBudget;
 cvar_t  *r_surfaceWeather;
 
 cvar_t  *r_windSpeed;
@@ -113,6 +128,10 @@ cvar_t  *r_stencilbits;
 cvar_t  *r_depthbits;
 cvar_t  *r_colorbits;
 cvar_t  *r_primitives;
+cvar_t  *r_worldVBO;
+cvar_t  *r_worldVisLists;
+cvar_t  *r_smp;
+cvar_t  *r_showSmp;
 cvar_t  *r_texturebits;
 cvar_t  *r_ext_multisample;
 
@@ -216,6 +235,9 @@ static void InitOpenGL( void )
         }
     }
 
+    // init command buffers and SMP
+    R_InitCommandBuffers();
+
     // set default state
     GL_SetDefaultState();
 }
@@ -510,6 +532,7 @@ void R_TakeScreenshot( int x, int y, int width, int height, char *name, qboolean
         return;
     }
     cmd->commandId = RC_SCREENSHOT;
+    backEndData[tr.smpFrame]->commands.synchronous = qtrue;
 
     cmd->x = x;
     cmd->y = y;
@@ -992,6 +1015,7 @@ void GfxInfo_f( void )
     ri.Printf( PRINT_ALL, "texture bits: %d\n", r_texturebits->integer );
     ri.Printf( PRINT_ALL, "multitexture: %s\n", enablestrings[qglActiveTextureARB != 0] );
     ri.Printf( PRINT_ALL, "compiled vertex arrays: %s\n", enablestrings[qglLockArraysEXT != 0 ] );
+    ri.Printf( PRINT_ALL, "world vertex buffers: %s\n", enablestrings[qglGenBuffers != 0 && r_worldVBO->integer] );
     ri.Printf( PRINT_ALL, "texenv add: %s\n", enablestrings[glConfig.textureEnvAddAvailable != 0] );
     ri.Printf( PRINT_ALL, "compressed textures: %s\n", enablestrings[glConfig.textureCompression!=TC_NONE] );
     if ( r_vertexLight->integer || glConfig.hardwareType == GLHW_PERMEDIA2 )
@@ -1009,6 +1033,22 @@ void GfxInfo_f( void )
     if ( r_finish->integer ) {
         ri.Printf( PRINT_ALL, "Forcing glFinish\n" );
     }
+    if ( glConfig.smpActive ) {
+        ri.Printf( PRINT_ALL, "Using dual processor acceleration\n" );
+    }
+}
+
+/*
+===============
+R_WorldEffectSync_f
+
+The world effect systems are updated by the back end,
+don't change them under the render thread.
+===============
+*/
+static void R_WorldEffectSync_f( void ) {
+    R_IssuePendingRenderCommands();
+    R_WorldEffect_f();
 }
 
 /*
@@ -1056,12 +1096,29 @@ void R_Register( void )
     r_customheight = ri.Cvar_Get( "r_customheight", "1024", CVAR_ARCHIVE | CVAR_LATCH );
     r_customPixelAspect = ri.Cvar_Get( "r_customPixelAspect", "1", CVAR_ARCHIVE | CVAR_LATCH );
     r_simpleMipMaps = ri.Cvar_Get( "r_simpleMipMaps", "1", CVAR_ARCHIVE | CVAR_LATCH );
+    r_imageThreads = ri.Cvar_Get( "r_imageThreads", "-1", CVAR_ARCHIVE | CVAR_LATCH );
+    ri.Cvar_CheckRange( r_imageThreads, -1, 8, qtrue );
+    r_imagePrefetch = ri.Cvar_Get( "r_imagePrefetch", "1", CVAR_ARCHIVE );
+    r_imageCache = ri.Cvar_Get( "r_imageCache", "0", CVAR_ARCHIVE );
+    r_imageCacheCompress = ri.Cvar_Get( "r_imageCacheCompress", "1", CVAR_ARCHIVE );
+    r_shaderCache = ri.Cvar_Get( "r_shaderCache", "1", CVAR_ARCHIVE );
+    r_retainImages = ri.Cvar_Get( "r_retainImages", "256", CVAR_ARCHIVE );
+    r_weatherGrid = ri.Cvar_Get( "r_weatherGrid", "64", CVAR_ARCHIVE | CVAR_LATCH );
+    ri.Cvar_CheckRange( r_weatherGrid, 0, 512, qtrue );
+    r_weatherGridCache = ri.Cvar_Get( "r_weatherGridCache", "1", CVAR_ARCHIVE );
     r_vertexLight = ri.Cvar_Get( "r_vertexLight", "0", CVAR_ARCHIVE | CVAR_LATCH );
     r_uiFullScreen = ri.Cvar_Get( "r_uifullscreen", "0", 0);
     r_subdivisions = ri.Cvar_Get ("r_subdivisions", "4", CVAR_ARCHIVE | CVAR_LATCH);
     r_stereoEnabled = ri.Cvar_Get( "r_stereoEnabled", "0", CVAR_ARCHIVE | CVAR_LATCH);
     r_greyscale = ri.Cvar_Get("r_greyscale", "0", CVAR_ARCHIVE | CVAR_LATCH);
     ri.Cvar_CheckRange(r_greyscale, 0, 1, qfalse);
+    r_simd = ri.Cvar_Get( "r_simd", "1", CVAR_ARCHIVE | CVAR_LATCH );
+#if idsimd
+    if ( r_simd->integer && !RB_SIMDSupported() ) {
+        ri.Cvar_Set( "r_simd", "0" );   // we don't have it! Disable support!
+    }
+#endif
+    r_weatherThreads = ri.Cvar_Get( "r_weatherThreads", "1", CVAR_ARCHIVE );
 
     //
     // temporary latched variables that can only change over a restart
@@ -1102,6 +1159,11 @@ void R_Register( void )
     r_railSegmentLength = ri.Cvar_Get( "r_railSegmentLength", "32", CVAR_ARCHIVE );
 
     r_primitives = ri.Cvar_Get( "r_primitives", "0", CVAR_ARCHIVE );
+    r_worldVBO = ri.Cvar_Get( "r_worldVBO", "1", CVAR_ARCHIVE );
+    r_worldVisLists = ri.Cvar_Get( "r_worldVisLists", "1", CVAR_ARCHIVE );
+
+    r_smp = ri.Cvar_Get( "r_smp", "0", CVAR_ARCHIVE | CVAR_LATCH );
+    r_showSmp = ri.Cvar_Get( "r_showSmp", "0", CVAR_CHEAT );
 
     r_ambientScale = ri.Cvar_Get( "r_ambientScale", "0.6", CVAR_CHEAT );
     r_directedScale = ri.Cvar_Get( "r_directedScale", "1", CVAR_CHEAT );
@@ -1122,6 +1184,8 @@ void R_Register( void )
     ri.Cvar_CheckRange( r_surfaceSprites, 1, 2, qtrue );
     r_ssCheap = ri.Cvar_Get( "r_ssCheap", "0", CVAR_ARCHIVE );
     ri.Cvar_CheckRange( r_ssCheap, 0.0f, 0.4f, qfalse );
+    r_surfaceSpriteBudget = ri.Cvar_Get( "r_surfaceSpriteBudget", "20000", CVAR_ARCHIVE );
+    ri.Cvar_CheckRange( r_surfaceSpriteBudget, 0, 1000000, qtrue );
     r_surfaceWeather = ri.Cvar_Get( "r_surfaceWeather", "0", 0 );
 
     r_windSpeed = ri.Cvar_Get( "r_windSpeed", "0", 0 );
@@ -1149,6 +1213,8 @@ void R_Register( void )
     r_drawentities = ri.Cvar_Get ("r_drawentities", "1", CVAR_CHEAT );
     r_ignore = ri.Cvar_Get( "r_ignore", "1", CVAR_CHEAT );
     r_nocull = ri.Cvar_Get ("r_nocull", "0", CVAR_CHEAT);
+    r_occlusion = ri.Cvar_Get ("r_occlusion", "1", CVAR_ARCHIVE);
+    r_occlusionDebug = ri.Cvar_Get ("r_occlusionDebug", "0", CVAR_CHEAT);
     r_novis = ri.Cvar_Get ("r_novis", "0", CVAR_CHEAT);
     r_showcluster = ri.Cvar_Get ("r_showcluster", "0", CVAR_CHEAT);
     r_speeds = ri.Cvar_Get ("r_speeds", "0", CVAR_CHEAT);
@@ -1179,6 +1245,7 @@ void R_Register( void )
     // removed in R_Shutdown
     ri.Cmd_AddCommand( "imagelist", R_ImageList_f );
     ri.Cmd_AddCommand( "shaderlist", R_ShaderList_f );
+    ri.Cmd_AddCommand( "clearshadercache", R_ClearShaderCache_f );
     ri.Cmd_AddCommand( "skinlist", R_SkinList_f );
     ri.Cmd_AddCommand( "modellist", R_Modellist_f );
     ri.Cmd_AddCommand( "modelist", R_ModeList_f );
@@ -1186,7 +1253,7 @@ void R_Register( void )
     ri.Cmd_AddCommand( "screenshotJPEG", R_ScreenShotJPEG_f );
     ri.Cmd_AddCommand( "gfxinfo", GfxInfo_f );
     ri.Cmd_AddCommand( "minimize", GLimp_Minimize );
-    ri.Cmd_AddCommand( "r_we", R_WorldEffect_f );
+    ri.Cmd_AddCommand( "r_we", R_WorldEffectSync_f );
 }
 
 /*
@@ -1257,14 +1324,22 @@ void R_Init( void ) {
     if (max_polyverts < MAX_POLYVERTS)
         max_polyverts = MAX_POLYVERTS;
 
-    ptr = ri.Hunk_Alloc( sizeof( *backEndData ) + sizeof(srfPoly_t) * max_polys + sizeof(polyVert_t) * max_polyverts, h_low);
-    backEndData = (backEndData_t *) ptr;
-    backEndData->polys = (srfPoly_t *) ((char *) ptr + sizeof( *backEndData ));
-    backEndData->polyVerts = (polyVert_t *) ((char *) ptr + sizeof( *backEndData ) + sizeof(srfPoly_t) * max_polys);
+    // the second set is only needed by the render thread
+    for ( i = 0; i < ( r_smp->integer ? SMP_FRAMES : 1 ); i++ ) {
+        ptr = ri.Hunk_Alloc( sizeof( *backEndData[i] ) + sizeof(srfPoly_t) * max_polys + sizeof(polyVert_t) * max_polyverts, h_low);
+        backEndData[i] = (backEndData_t *) ptr;
+        backEndData[i]->polys = (srfPoly_t *) ((char *) ptr + sizeof( *backEndData[i] ));
+        backEndData[i]->polyVerts = (polyVert_t *) ((char *) ptr + sizeof( *backEndData[i] ) + sizeof(srfPoly_t) * max_polys);
+    }
+    for ( ; i < SMP_FRAMES; i++ ) {
+        backEndData[i] = NULL;
+    }
     R_InitNextFrame();
 
     InitOpenGL();
 
+    GLimp_SpawnJobThreads( r_imageThreads->integer );
+
     R_InitImages();
 
     R_InitShaders();
@@ -1277,6 +1352,8 @@ void R_Init( void ) {
 
     R_InitQuickSpriteSystem();
 
+    R_InitFlareQueries();
+
     err = qglGetError();
     if ( err != GL_NO_ERROR )
         ri.Printf (PRINT_ALL, "glGetError() = 0x%x\n", err);
@@ -1297,6 +1374,7 @@ void RE_Shutdown( qboolean destroyWindow ) {
 
     ri.Cmd_RemoveCommand( "imagelist" );
     ri.Cmd_RemoveCommand( "shaderlist" );
+    ri.Cmd_RemoveCommand( "clearshadercache" );
     ri.Cmd_RemoveCommand( "skinlist" );
     ri.Cmd_RemoveCommand( "modellist" );
     ri.Cmd_RemoveCommand( "modelist" );
@@ -1309,13 +1387,33 @@ void RE_Shutdown( qboolean destroyWindow ) {
 
     if ( tr.registered ) {
         R_IssuePendingRenderCommands();
+    }
+
+    // the render thread has to let go of the context first
+    R_ShutdownCommandBuffers();
+
+    R_ShutdownFlareQueries();
+
+    R_ShutdownQuickSpriteSystem();
+
+    if ( tr.registered ) {
+        R_DeleteWorldVBO();
         R_DeleteTextures();
     }
 
     R_DoneFreeType();
 
+    R_ClearPrefetchedImages();
+    R_ShutdownImageCache();
+    GLimp_ShutdownJobThreads();
+
+    R_ClearWorldEffectContents();
+
+    R_ShutdownSurfaceSprites();
+
     // shut down platform specific OpenGL stuff
     if ( destroyWindow ) {
+        R_ShutdownRetainedImages();
         GLimp_Shutdown();
 
         Com_Memset( &glConfig, 0, sizeof( glConfig ) );
@@ -1334,11 +1432,13 @@ void RE_Shutdown( qboolean destroyWindow ) {
 =============
 RE_EndRegistration
 
-Touch all images to make sure they are resident
+Touch all images to make sure they are resident, and let go of
+the textures earlier maps left that this one did not use
 =============
 */
 void RE_EndRegistration( void ) {
     R_IssuePendingRenderCommands();
+    R_EvictRetainedImages();
     if (!ri.Sys_LowPhysicalMemory()) {
         RB_ShowImages();
     }
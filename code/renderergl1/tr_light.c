@@ -95,11 +95,11 @@ void R_DlightBmodel( bmodel_t *bmodel ) {
         surf = bmodel->firstSurface + i;
 
         if ( *surf->data == SF_FACE ) {
-            ((srfSurfaceFace_t *)surf->data)->dlightBits = mask;
+            ((srfSurfaceFace_t *)surf->data)->dlightBits[tr.smpFrame] = mask;
         } else if ( *surf->data == SF_GRID ) {
-            ((srfGridMesh_t *)surf->data)->dlightBits = mask;
+            ((srfGridMesh_t *)surf->data)->dlightBits[tr.smpFrame] = mask;
         } else if ( *surf->data == SF_TRIANGLES ) {
-            ((srfTriangles_t *)surf->data)->dlightBits = mask;
+            ((srfTriangles_t *)surf->data)->dlightBits[tr.smpFrame] = mask;
         }
     }
 }
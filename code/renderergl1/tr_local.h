@@ -38,18 +38,26 @@ QGL_1_1_PROCS;
 QGL_1_1_FIXED_FUNCTION_PROCS;
 QGL_DESKTOP_1_1_PROCS;
 QGL_DESKTOP_1_1_FIXED_FUNCTION_PROCS;
+QGL_1_3_PROCS;
+QGL_1_5_PROCS;
 QGL_3_0_PROCS;
+QGL_ARB_occlusion_query_PROCS;
 #undef GLE
 
 #define GL_INDEX_TYPE       GL_UNSIGNED_INT
 typedef unsigned int glIndex_t;
 
+#define BUFFER_OFFSET(i) ((char *)NULL + (i))
+
 // 14 bits
 // can't be increased without changing bit packing for drawsurfs
 // see QSORT_SHADERNUM_SHIFT
 #define SHADERNUM_BITS  14
 #define MAX_SHADERS     (1<<SHADERNUM_BITS)
 
+// the front end fills one set of backEndData and surface
+// dlight bits while the render thread draws the other
+#define SMP_FRAMES      2
 
 
 typedef struct dlight_s {
@@ -369,6 +377,13 @@ typedef struct {
 
 struct shaderCommands_s;
 
+// how a shader can use the static world vertex buffer
+enum {
+    WVBO_NONE,          // needs per-vertex work on the CPU
+    WVBO_ALWAYS,
+    WVBO_OPAQUE_ALPHA   // only for surfaces whose vertex alpha is all 255
+};
+
 typedef enum {
     CT_FRONT_SIDED,
     CT_BACK_SIDED,
@@ -447,6 +462,8 @@ typedef struct shader_s {
 
     void        (*optimalStageIteratorFunc)( void );
 
+    int         worldVBO;               // WVBO_*, can static world surfaces be drawn from tr.worldVBO
+
   double clampTime;                                  // time this shader is clamped to
   double timeOffset;                                 // current time offset for this shader
 
@@ -581,6 +598,16 @@ typedef struct drawSurf_s {
 
 #define MAX_FACE_POINTS     64
 
+// where a static world surface lives in tr.worldVBO, firstIndex is -1 if
+// it was not uploaded and always goes through the tess arrays
+typedef struct {
+    int             firstIndex;
+    int             numIndexes;
+    int             firstVertex;
+    int             numVertexes;
+    qboolean        opaqueAlpha;    // every vertex alpha is 255
+} surfaceVBO_t;
+
 #define MAX_PATCH_SIZE      32          // max dimensions of a patch mesh in map file
 #define MAX_GRID_SIZE       65          // max dimensions of a grid mesh in memory
 
@@ -606,7 +633,7 @@ typedef struct srfGridMesh_s {
     surfaceType_t   surfaceType;
 
     // dynamic lighting information
-    int             dlightBits;
+    int             dlightBits[SMP_FRAMES];
 
     // culling information
     vec3_t          meshBounds[2];
@@ -622,6 +649,9 @@ typedef struct srfGridMesh_s {
     int             lodStitched;
 
     // vertexes
+    // static buffer copy, always at full detail
+    surfaceVBO_t    vbo;
+
     int             width, height;
     float           *widthLodError;
     float           *heightLodError;
@@ -639,7 +669,9 @@ typedef struct {
     cplane_t    plane;
 
     // dynamic lighting information
-    int         dlightBits;
+    int         dlightBits[SMP_FRAMES];
+
+    surfaceVBO_t    vbo;
 
     // triangle definitions (no normals at points)
     int         numPoints;
@@ -655,13 +687,15 @@ typedef struct {
     surfaceType_t   surfaceType;
 
     // dynamic lighting information
-    int             dlightBits;
+    int             dlightBits[SMP_FRAMES];
 
     // culling information (FIXME: use this!)
     vec3_t          bounds[2];
     vec3_t          localOrigin;
     float           radius;
 
+    surfaceVBO_t    vbo;
+
     // triangle definitions
     int             numIndexes;
     int             *indexes;
@@ -742,6 +776,7 @@ BRUSH MODELS
 
 typedef struct msurface_s {
     int                 viewCount;      // if == tr.viewCount, already added
+    int                 visCount;       // if == tr.visCount, already in the visible list
     struct shader_s     *shader;
     int                 fogIndex;
 
@@ -776,6 +811,22 @@ typedef struct {
     int         numSurfaces;
 } bmodel_t;
 
+// flat lists of the leafs and surfaces in the current pvs, rebuilt
+// by R_MarkLeaves so the views can frustum cull them without
+// walking the nodes. bounds are split into mins xyz and maxs xyz
+// arrays so the box tests run over contiguous floats
+typedef struct {
+    int         numLeafs;
+    mnode_t     **leafs;
+    float       *leafBounds[6];
+
+    int         numSurfaces;
+    msurface_t  **surfaces;
+    float       *surfaceBounds[6];
+
+    byte        *visible;       // frustum test results
+} visList_t;
+
 typedef struct {
     byte        ambientLight[MAXLIGHTMAPS][3];
     byte        directLight[MAXLIGHTMAPS][3];
@@ -825,6 +876,12 @@ typedef struct {
 
     byte        *novis;         // clusterBytes of 0xff
 
+    int         *clusterLeafs;      // leaf numbers grouped by cluster
+    int         *clusterFirstLeaf;  // numClusters + 1 offsets into clusterLeafs
+    vec3_t      *surfaceBounds;     // mins and maxs of every surface
+
+    visList_t   visList;
+
     char        *entityString;
     char        *entityParsePoint;
 } world_t;
@@ -910,6 +967,7 @@ typedef struct {
     int     c_box_cull_md3_in, c_box_cull_md3_clip, c_box_cull_md3_out;
 
     int     c_leafs;
+    int     c_occluded, c_occludedEntities;
     int     c_dlightSurfaces;
     int     c_dlightSurfacesCulled;
 } frontEndCounters_t;
@@ -951,6 +1009,7 @@ typedef struct {
     viewParms_t viewParms;
     orientationr_t  or;
     backEndCounters_t   pc;
+    int         smpFrame;
     qboolean    isHyperspace;
     trRefEntity_t   *currentEntity;
     qboolean    skyRenderedThisView;    // flag for drawing sun
@@ -980,6 +1039,8 @@ typedef struct {
 
     int                     frameSceneNum;  // zeroed at RE_BeginFrame
 
+    int                     smpFrame;       // backEndData being filled by the front end
+
     qboolean                worldMapLoaded;
     world_t                 *world;
 
@@ -1055,6 +1116,11 @@ typedef struct {
     float                   fogTable[FOG_TABLE_SIZE];
 
     visual_t                visualOverlay;      // Visual overlay support for nightvision and thermal goggles.
+
+    // static world geometry, built by RE_LoadWorldMap
+    GLuint                  worldVBO;
+    GLuint                  worldIBO;
+    int                     worldVBOStyleColor;     // styleColors[0] baked into vertex lit soups
 } trGlobals_t;
 
 extern backEndState_t   backEnd;
@@ -1091,6 +1157,12 @@ extern cvar_t   *r_primitives;          // "0" = based on compiled vertex array
                                         // "2" = glDrawElements triangles
                                         // "-1" = no drawing
 
+extern cvar_t   *r_worldVBO;            // draw static world surfaces from vertex buffers
+extern cvar_t   *r_worldVisLists;       // cull the pvs surfaces from flat lists instead of walking the nodes
+
+extern cvar_t   *r_smp;                 // run the back end in its own thread
+extern cvar_t   *r_showSmp;             // print which thread had to wait each frame
+
 extern cvar_t   *r_inGameVideo;             // controls whether in game video should be draw
 extern cvar_t   *r_fastsky;             // controls whether sky should be cleared or drawn
 extern cvar_t   *r_drawSun;             // controls drawing of sun quad
@@ -1110,6 +1182,7 @@ extern  cvar_t  *r_showcluster;
 
 extern  cvar_t  *r_surfaceSprites;
 extern  cvar_t  *r_ssCheap;
+extern  cvar_t  *r_surfaceSpriteBudget; // most surface sprites drawn per frame, 0 = no limit
 extern  cvar_t  *r_surfaceWeather;
 
 extern  cvar_t  *r_windSpeed;
@@ -1144,7 +1217,6 @@ extern  cvar_t  *r_showsky;                     // forces sky in front of all su
 extern  cvar_t  *r_shownormals;                 // draws wireframe normals
 extern  cvar_t  *r_clear;                       // force screen clear every frame
 
-extern  cvar_t  *r_shadows;                     // controls shadows: 0 = none, 1 = blur, 2 = stencil, 3 = black planar projection
 extern  cvar_t  *r_flares;                      // light flares
 
 extern  cvar_t  *r_intensity;
@@ -1330,6 +1402,13 @@ typedef struct stageVars
 } stageVars_t;
 
 
+#define SHADER_MAX_VBO_RANGES   1024
+
+typedef struct {
+    int         firstIndex;
+    int         numIndexes;
+} vboRange_t;
+
 typedef struct shaderCommands_s
 {
     glIndex_t   indexes[SHADER_MAX_INDEXES] QALIGN(16);
@@ -1353,6 +1432,11 @@ typedef struct shaderCommands_s
     int         numIndexes;
     int         numVertexes;
 
+    // static world surfaces taken from tr.worldIBO instead of being copied
+    qboolean    useWorldVBO;
+    int         numVBORanges;
+    vboRange_t  vboRanges[SHADER_MAX_VBO_RANGES];
+
     // info extracted from current shader
     int         numPasses;
     void        (*currentStageIteratorFunc)( void );
@@ -1374,6 +1458,23 @@ void RB_CheckOverflow       ( int verts, int indexes );
 void RB_StageIteratorGeneric( void );
 void RB_StageIteratorSky( void );
 
+/*
+============================================================
+
+WORLD VERTEX BUFFER, tr_vbo.c
+
+============================================================
+*/
+
+int         R_ShaderWorldVBOMode( const shader_t *shader );
+void        R_CreateWorldVBO( void );
+void        R_DeleteWorldVBO( void );
+void        R_CheckWorldVBOStyle( void );
+
+qboolean    RB_WorldVBOUsable( const shader_t *shader, int fogNum );
+qboolean    RB_AddWorldVBOSurface( const surfaceVBO_t *vbo, int dlightBits );
+void        RB_StageIteratorWorldVBO( void );
+
 void RB_AddQuadStamp( vec3_t origin, vec3_t left, vec3_t up, byte *color );
 void RB_AddQuadStampExt( vec3_t origin, vec3_t left, vec3_t up, byte *color, float s1, float t1, float s2, float t2 );
 
@@ -1402,6 +1503,8 @@ FLARES
 */
 
 void R_ClearFlares( void );
+void R_InitFlareQueries( void );
+void R_ShutdownFlareQueries( void );
 
 void RB_AddFlare( void *surface, int fogNum, vec3_t point, vec3_t color, vec3_t normal );
 void RB_AddDlightFlares( void );
@@ -1571,6 +1674,7 @@ RENDERER BACK END COMMAND QUEUE
 typedef struct {
     byte    cmds[MAX_RENDER_COMMANDS];
     int     used;
+    qboolean    synchronous;    // calls back into the engine, the front end must wait for it
 } renderCommandList_t;
 
 typedef struct {
@@ -1682,16 +1786,22 @@ typedef struct {
 extern  int     max_polys;
 extern  int     max_polyverts;
 
-extern  backEndData_t   *backEndData;   // the second one may not be allocated
+extern  backEndData_t   *backEndData[SMP_FRAMES];   // the second one may not be allocated
 
 
 void *R_GetCommandBuffer( int bytes );
 void RB_ExecuteRenderCommands( const void *data );
 
+void R_InitCommandBuffers( void );
+void R_ShutdownCommandBuffers( void );
+
+void RB_RenderThread( void );
+
 void SetViewportAndScissor          ( void );
 void RB_RenderWorldEffectSystems    ( void );
 
 void R_IssuePendingRenderCommands( void );
+void R_SyncRenderThread( void );
 
 void R_AddDrawSurfCmd( drawSurf_t *drawSurfs, int numDrawSurfs );
 
@@ -1716,6 +1826,16 @@ void ProjectDlightTexture_altivec( void );
 void RB_CalcDiffuseColor_altivec( unsigned char *colors );
 #endif
 
+// SSE2 and NEON versions of the per-vertex loops, see tr_simd.c
+#if idsimd
+void LerpMeshVertexes_simd( md3Surface_t *surf, float backlerp );
+void ProjectDlightTexture_simd( void );
+void RB_CalcDiffuseColor_simd( unsigned char *colors );
+void RB_CalcFogTexCoords_simd( float *st, const vec4_t fogDistanceVector, const vec4_t fogDepthVector,
+                               float eyeT, qboolean eyeOutside );
+void RB_CalcDeformVertexes_simd( const deformStage_t *ds, const float *table, float scale );
+#endif
+
 /*
 ============================================================
 
@@ -1731,13 +1851,17 @@ SURFACE SPRITE SYSTEM
 void            RB_AddQuickSprite               ( float *pointData, color4ub_t color );
 void            RB_StartQuickSpriteRendering    ( textureBundle_t *bundle, uint32_t stateBits, uint32_t fogColor );
 void            RB_EndQuickSpriteRendering      ( void );
+void            RB_FlushQuickSprites            ( void );
+void            RB_FlushQuickSpritesForShader   ( const shader_t *shader );
 
 void            R_InitQuickSpriteSystem         ( void );
+void            R_ShutdownQuickSpriteSystem     ( void );
 
 //
 // tr_ss_main.c
 //
 
 void            R_RenderSurfaceSprites          ( shaderStage_t *stage, shaderCommands_t *input );
+void            R_ShutdownSurfaceSprites        ( void );
 
 #endif //TR_LOCAL_H
@@ -1243,6 +1243,11 @@ void R_AddEntitySurfaces (void) {
             R_RotateForEntity( ent, &tr.viewParms, &tr.or );
 
             tr.currentModel = R_GetModelByHandle( ent->e.hModel );
+            if ( tr.currentModel && R_EntityOccluded( &ent->e, tr.or.origin, tr.or.axis ) ) {
+                tr.pc.c_occludedEntities++;
+                break;
+            }
+
             if (!tr.currentModel) {
                 R_AddDrawSurf( &entitySurface, tr.defaultShader, 0, 0 );
             } else {
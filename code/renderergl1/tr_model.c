@@ -1120,3 +1120,78 @@ void R_ModelBounds( qhandle_t handle, vec3_t mins, vec3_t maxs ) {
     VectorClear( mins );
     VectorClear( maxs );
 }
+
+/*
+====================
+R_ModelFrameBounds
+
+Bounds spanning two frames of a model, qfalse for models without
+bounds for each frame or frames out of range
+====================
+*/
+qboolean R_ModelFrameBounds( qhandle_t handle, int frame, int oldframe, vec3_t bounds[2] ) {
+    model_t     *model;
+    const float *newBounds, *oldBounds;     // mins followed by maxs
+    int         numFrames;
+    int         i;
+
+    model = R_GetModelByHandle( handle );
+
+    switch ( model->type ) {
+    case MOD_BRUSH:
+        VectorCopy( model->bmodel->bounds[0], bounds[0] );
+        VectorCopy( model->bmodel->bounds[1], bounds[1] );
+        return qtrue;
+    case MOD_MESH:
+        {
+            md3Header_t *header = model->md3[0];
+            md3Frame_t  *frames = (md3Frame_t *)( (byte *)header + header->ofsFrames );
+
+            numFrames = header->numFrames;
+            if ( frame < 0 || frame >= numFrames || oldframe < 0 || oldframe >= numFrames ) {
+                return qfalse;
+            }
+
+            newBounds = frames[frame].bounds[0];
+            oldBounds = frames[oldframe].bounds[0];
+        }
+        break;
+    case MOD_MDR:
+        {
+            mdrHeader_t *header = (mdrHeader_t *)model->modelData;
+            int         frameSize = (size_t)( &((mdrFrame_t *)0)->bones[ header->numBones ] );
+            byte        *frames = (byte *)header + header->ofsFrames;
+
+            numFrames = header->numFrames;
+            if ( frame < 0 || frame >= numFrames || oldframe < 0 || oldframe >= numFrames ) {
+                return qfalse;
+            }
+
+            newBounds = ( (mdrFrame_t *)( frames + frameSize * frame ) )->bounds[0];
+            oldBounds = ( (mdrFrame_t *)( frames + frameSize * oldframe ) )->bounds[0];
+        }
+        break;
+    case MOD_IQM:
+        {
+            iqmData_t   *data = model->modelData;
+
+            numFrames = data->num_frames;
+            if ( !data->bounds || frame < 0 || frame >= numFrames || oldframe < 0 || oldframe >= numFrames ) {
+                return qfalse;
+            }
+
+            newBounds = data->bounds + 6 * frame;
+            oldBounds = data->bounds + 6 * oldframe;
+        }
+        break;
+    default:
+        return qfalse;
+    }
+
+    for ( i = 0 ; i < 3 ; i++ ) {
+        bounds[0][i] = oldBounds[i] < newBounds[i] ? oldBounds[i] : newBounds[i];
+        bounds[1][i] = oldBounds[i + 3] > newBounds[i + 3] ? oldBounds[i + 3] : newBounds[i + 3];
+    }
+
+    return qtrue;
+}
@@ -23,18 +23,27 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "tr_local.h"
 
+#define     QUICKSPRITE_MAX_VERTS   (4 * 4096)
+
+typedef struct {
+    vec3_t          xyz;
+    vec2_t          st;
+    uint32_t        color;
+} quickSpriteVert_t;
+
+// The batch currently being filled.
 static textureBundle_t  *texBundle;
 static uint32_t         glStateBits;
+static float            batchSort;
 
-static uint32_t         fogColor;
+static uint32_t         spriteFogColor;
 static qboolean         useFog;
 
-static vec4_t           verts[SHADER_MAX_VERTEXES];
-static vec2_t           textureCoords[SHADER_MAX_VERTEXES];
-static uint32_t         colors[SHADER_MAX_VERTEXES];
-
+static quickSpriteVert_t verts[QUICKSPRITE_MAX_VERTS];
 static int              nextVert;
-static qboolean         turnCullBackOn;
+
+// Streaming vertex buffer, 0 to draw from client memory.
+static GLuint           spriteVBO;
 
 //==============================================
 
@@ -51,6 +60,7 @@ Also flushes all buffers.
 
 static void RB_RenderQuickSprites(void)
 {
+    char            *base;
     //fog_t *fog;
 
     if(nextVert == 0){
@@ -62,6 +72,7 @@ static void RB_RenderQuickSprites(void)
     //
     R_BindAnimatedImage(texBundle);
     GL_State(glStateBits);
+    GL_Cull(CT_TWO_SIDED);
 
     //
     // Render the fog pass.
@@ -80,22 +91,33 @@ static void RB_RenderQuickSprites(void)
     }
 
     //
-    // Set arrays and lock.
+    // Upload the batch and set the arrays.
     //
-    qglTexCoordPointer(2, GL_FLOAT, 0, textureCoords);
+    if(spriteVBO){
+        // Orphan the previous contents so the driver
+        // doesn't wait for the last batch to finish.
+        qglBindBuffer(GL_ARRAY_BUFFER, spriteVBO);
+        qglBufferData(GL_ARRAY_BUFFER, sizeof(verts), NULL, GL_STREAM_DRAW);
+        qglBufferSubData(GL_ARRAY_BUFFER, 0, nextVert * sizeof(quickSpriteVert_t), verts);
+        base = BUFFER_OFFSET(0);
+    }else{
+        base = (char *)verts;
+    }
+
+    qglTexCoordPointer(2, GL_FLOAT, sizeof(quickSpriteVert_t), base + offsetof(quickSpriteVert_t, st));
     qglEnableClientState(GL_TEXTURE_COORD_ARRAY);
 
-    qglColorPointer(4, GL_UNSIGNED_BYTE, 0, colors);
+    qglColorPointer(4, GL_UNSIGNED_BYTE, sizeof(quickSpriteVert_t), base + offsetof(quickSpriteVert_t, color));
     qglEnableClientState(GL_COLOR_ARRAY);
 
-    qglVertexPointer(3, GL_FLOAT, 16, verts);
+    qglVertexPointer(3, GL_FLOAT, sizeof(quickSpriteVert_t), base + offsetof(quickSpriteVert_t, xyz));
 
-    if(qglLockArraysEXT){
-        qglLockArraysEXT(0, nextVert);
-        GLimp_LogComment("glLockArraysEXT\n");
-    }
     qglDrawArrays(GL_QUADS, 0, nextVert);
 
+    if(spriteVBO){
+        qglBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
     //
     // Update backend counters.
     //
@@ -110,13 +132,7 @@ static void RB_RenderQuickSprites(void)
         qglDisable(GL_FOG);
     }
 
-    //
-    // Unlock arrays.
-    //
-    if(qglUnlockArraysEXT){
-        qglUnlockArraysEXT();
-        GLimp_LogComment("glUnlockArraysEXT\n");
-    }
+    qglColor4ub(255, 255, 255, 255);
 
     nextVert = 0;
 }
@@ -134,66 +150,80 @@ of the quick sprite system.
 
 void RB_AddQuickSprite(float *pointData, color4ub_t color)
 {
-    uint32_t        *currColor;
-    float           *currCoord;
-    int             i;
+    quickSpriteVert_t   *vert;
+    int                 i;
 
     // Render all sprites in this quick sprite and flush
     // the buffers right away if there is no room left.
-    if(nextVert > (SHADER_MAX_VERTEXES - 4)){
+    if(nextVert > (QUICKSPRITE_MAX_VERTS - 4)){
         RB_RenderQuickSprites();
     }
 
-    // Store point data.
-    currCoord = verts[nextVert];
-    Com_Memcpy(currCoord, pointData, sizeof(vec4_t) * 4);
-
-    // Setup the color.
-    currColor = &colors[nextVert];
-    for(i = 0; i < 4; i++){
-        *currColor++ = *(uint32_t *)color;
+    // Store point data and color, the texture
+    // coordinates never change.
+    vert = &verts[nextVert];
+    for(i = 0; i < 4; i++, vert++, pointData += 4){
+        VectorCopy(pointData, vert->xyz);
+        vert->color = *(uint32_t *)color;
     }
 
     nextVert += 4;
 }
 
+/*
+==================
+RB_QuickSpriteBatchMatches
+
+Checks if sprites drawn with these
+parameters can be added to the sprites
+that are still waiting to be drawn.
+==================
+*/
+
+static qboolean RB_QuickSpriteBatchMatches(textureBundle_t *bundle, uint32_t stateBits, uint32_t fogColor)
+{
+    if(stateBits != glStateBits || fogColor != spriteFogColor){
+        return qfalse;
+    }
+
+    if(bundle == texBundle){
+        return qtrue;
+    }
+
+    // Separate stages drawing the same image.
+    return bundle->numImageAnimations <= 1 && texBundle->numImageAnimations <= 1
+        && !bundle->isVideoMap && !texBundle->isVideoMap
+        && bundle->image[0] == texBundle->image[0];
+}
+
 /*
 ==================
 RB_StartQuickSpriteRendering
 
 Signal the quick sprite system to
 start rendering sprites.
+
+Sprites are kept across surfaces and
+stages until the texture, state or fog
+changes, or RB_FlushQuickSprites is
+called.
 ==================
 */
 
 void RB_StartQuickSpriteRendering(textureBundle_t *bundle, uint32_t stateBits, uint32_t fogColor)
 {
-    int cullingOn;
+    if(nextVert && (tess.shader->sort != batchSort || !RB_QuickSpriteBatchMatches(bundle, stateBits, fogColor))){
+        RB_RenderQuickSprites();
+    }
 
     // Store common information.
-    texBundle = bundle;
-    glStateBits = stateBits;
-    nextVert = 0;
+    texBundle       = bundle;
+    glStateBits     = stateBits;
+    batchSort       = tess.shader->sort;
 
     // Check if we use fog.
-    if(fogColor){
-        fogColor = fogColor; // FIXME BOE: This doesn't appear to be used anywhere.
-        useFog = qtrue;
-    }else{
-        useFog = qfalse;
-    }
-
-    // Check if we have to turn culling back on after
-    // finishing up rendering the sprites.
-    qglGetIntegerv(GL_CULL_FACE, &cullingOn);
-
-    if(cullingOn){
-        turnCullBackOn = qtrue;
-    }else{
-        turnCullBackOn = qfalse;
-    }
-
-    qglDisable(GL_CULL_FACE);
+    spriteFogColor  = fogColor;
+    useFog          = fogColor ? qtrue : qfalse;
 }
 
 /*
@@ -207,13 +237,50 @@ finish and stop rendering sprites.
 
 void RB_EndQuickSpriteRendering(void)
 {
-    // Render all sprites.
+    // Animated images are picked by the shader time
+    // of the current surface, they can't wait.
+    if(texBundle && (texBundle->numImageAnimations > 1 || texBundle->isVideoMap)){
+        RB_RenderQuickSprites();
+    }
+}
+
+/*
+==================
+RB_FlushQuickSprites
+
+Renders any sprites still waiting
+to be drawn.  Needs to be called
+before the transformation changes.
+==================
+*/
+
+void RB_FlushQuickSprites(void)
+{
     RB_RenderQuickSprites();
+}
 
-    // Finish this render pass.
-    qglColor4ub(255, 255, 255, 255);
-    if(turnCullBackOn){
-        qglEnable(GL_CULL_FACE);
+/*
+==================
+RB_FlushQuickSpritesForShader
+
+Renders the waiting sprites before
+a surface of this shader is drawn,
+unless they can safely be drawn after
+it.  Opaque surfaces are depth tested
+against the sprites either way,
+anything blended needs to keep the
+draw order.
+==================
+*/
+
+void RB_FlushQuickSpritesForShader(const shader_t *shader)
+{
+    if(shader->remappedShader){
+        shader = shader->remappedShader;
+    }
+
+    if(nextVert && (shader->sort != batchSort || batchSort > SS_OPAQUE)){
+        RB_RenderQuickSprites();
     }
 }
 
@@ -230,21 +297,47 @@ void R_InitQuickSpriteSystem(void)
     int             i;
 
     // Set initial texture coordinates.
-    for(i = 0; i < SHADER_MAX_VERTEXES; i += 4){
+    for(i = 0; i < QUICKSPRITE_MAX_VERTS; i += 4){
         // Bottom right.
-        textureCoords[i + 0][0] = 1.0f;
-        textureCoords[i + 0][1] = 1.0f;
+        verts[i + 0].st[0] = 1.0f;
+        verts[i + 0].st[1] = 1.0f;
 
         // Top right.
-        textureCoords[i + 1][0] = 1.0f;
-        textureCoords[i + 1][1] = 0.0f;
+        verts[i + 1].st[0] = 1.0f;
+        verts[i + 1].st[1] = 0.0f;
 
         // Top left.
-        textureCoords[i + 2][0] = 0.0f;
-        textureCoords[i + 2][1] = 0.0f;
+        verts[i + 2].st[0] = 0.0f;
+        verts[i + 2].st[1] = 0.0f;
 
         // Bottom left.
-        textureCoords[i + 3][0] = 0.0f;
-        textureCoords[i + 3][1] = 1.0f;
+        verts[i + 3].st[0] = 0.0f;
+        verts[i + 3].st[1] = 1.0f;
+    }
+
+    nextVert    = 0;
+    texBundle   = NULL;
+
+    spriteVBO   = 0;
+    if(qglGenBuffers){
+        qglGenBuffers(1, &spriteVBO);
     }
 }
+
+/*
+==================
+R_ShutdownQuickSpriteSystem
+
+Frees the streaming vertex buffer.
+==================
+*/
+
+void R_ShutdownQuickSpriteSystem(void)
+{
+    if(spriteVBO){
+        qglDeleteBuffers(1, &spriteVBO);
+        spriteVBO = 0;
+    }
+
+    nextVert = 0;
+}
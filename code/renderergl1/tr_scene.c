@@ -42,10 +42,19 @@ int         r_lastFrameTime;
 ====================
 R_InitNextFrame
 
+With a render thread the other set of buffers is
+used next frame, it may still be drawing this one.
 ====================
 */
 void R_InitNextFrame( void ) {
-    backEndData->commands.used = 0;
+    if ( glConfig.smpActive ) {
+        tr.smpFrame ^= 1;
+    } else {
+        tr.smpFrame = 0;
+    }
+
+    backEndData[tr.smpFrame]->commands.used = 0;
+    backEndData[tr.smpFrame]->commands.synchronous = qfalse;
 
     r_firstSceneDrawSurf = 0;
 
@@ -139,11 +148,11 @@ void RE_AddPolyToScene( qhandle_t hShader, int numVerts, const polyVert_t *verts
             return;
         }
 
-        poly = &backEndData->polys[r_numpolys];
+        poly = &backEndData[tr.smpFrame]->polys[r_numpolys];
         poly->surfaceType = SF_POLY;
         poly->hShader = hShader;
         poly->numVerts = numVerts;
-        poly->verts = &backEndData->polyVerts[r_numpolyverts];
+        poly->verts = &backEndData[tr.smpFrame]->polyVerts[r_numpolyverts];
 
         Com_Memcpy( poly->verts, &verts[numVerts*j], numVerts * sizeof( *verts ) );
 
@@ -220,8 +229,8 @@ void RE_AddRefEntityToScene( const refEntity_t *ent ) {
         ri.Error( ERR_DROP, "RE_AddRefEntityToScene: bad reType %i", ent->reType );
     }
 
-    backEndData->entities[r_numentities].e = *ent;
-    backEndData->entities[r_numentities].lightingCalculated = qfalse;
+    backEndData[tr.smpFrame]->entities[r_numentities].e = *ent;
+    backEndData[tr.smpFrame]->entities[r_numentities].lightingCalculated = qfalse;
 
     r_numentities++;
 }
@@ -249,7 +258,7 @@ void RE_AddDynamicLightToScene( const vec3_t org, float intensity, float r, floa
     if ( glConfig.hardwareType == GLHW_RIVA128 || glConfig.hardwareType == GLHW_PERMEDIA2 ) {
         return;
     }
-    dl = &backEndData->dlights[r_numdlights++];
+    dl = &backEndData[tr.smpFrame]->dlights[r_numdlights++];
     VectorCopy (org, dl->origin);
     dl->radius = intensity;
     dl->color[0] = r;
@@ -278,6 +287,31 @@ void RE_AddAdditiveLightToScene( const vec3_t org, float intensity, float r, flo
     RE_AddDynamicLightToScene( org, intensity, r, g, b, qtrue );
 }
 
+/*
+=====================
+R_DrawOcclusionDebug
+
+Shows the occlusion buffer of the last view that filled one
+=====================
+*/
+static void R_DrawOcclusionDebug( void ) {
+    const byte  *pixels;
+
+    pixels = R_OcclusionDebugPixels();
+    if ( !pixels ) {
+        return;
+    }
+
+    RE_StretchRaw( 0, 0, OCC_WIDTH * 2, OCC_HEIGHT * 2, OCC_WIDTH, OCC_HEIGHT, pixels, 0, qtrue );
+
+    if ( r_occlusionDebug->integer > 1 ) {
+        int     numTris, numTested, numCulled;
+
+        R_OcclusionStats( &numTris, &numTested, &numCulled );
+        ri.Printf( PRINT_ALL, "occlusion: %i occluder tris, %i tested, %i culled\n", numTris, numTested, numCulled );
+    }
+}
+
 /*
 @@@@@@@@@@@@@@@@@@@@@
 RE_RenderScene
@@ -344,6 +378,8 @@ void RE_RenderScene( const refdef_t *fd ) {
             // a door just opened or something
             tr.refdef.areamaskModified = qtrue;
         }
+
+        R_CheckWorldVBOStyle();
     }
 
 
@@ -352,16 +388,16 @@ void RE_RenderScene( const refdef_t *fd ) {
     tr.refdef.floatTime = tr.refdef.time * 0.001;
 
     tr.refdef.numDrawSurfs = r_firstSceneDrawSurf;
-    tr.refdef.drawSurfs = backEndData->drawSurfs;
+    tr.refdef.drawSurfs = backEndData[tr.smpFrame]->drawSurfs;
 
     tr.refdef.num_entities = r_numentities - r_firstSceneEntity;
-    tr.refdef.entities = &backEndData->entities[r_firstSceneEntity];
+    tr.refdef.entities = &backEndData[tr.smpFrame]->entities[r_firstSceneEntity];
 
     tr.refdef.num_dlights = r_numdlights - r_firstSceneDlight;
-    tr.refdef.dlights = &backEndData->dlights[r_firstSceneDlight];
+    tr.refdef.dlights = &backEndData[tr.smpFrame]->dlights[r_firstSceneDlight];
 
     tr.refdef.numPolys = r_numpolys - r_firstScenePoly;
-    tr.refdef.polys = &backEndData->polys[r_firstScenePoly];
+    tr.refdef.polys = &backEndData[tr.smpFrame]->polys[r_firstScenePoly];
 
     // turn off dynamic lighting globally by clearing all the
     // dlights if it needs to be disabled or if vertex lighting is enabled
@@ -413,4 +449,8 @@ void RE_RenderScene( const refdef_t *fd ) {
     r_firstScenePoly = r_numpolys;
 
     tr.frontEndMsec += ri.Milliseconds() - startTime;
+
+    if ( r_occlusionDebug->integer ) {
+        R_DrawOcclusionDebug();
+    }
 }
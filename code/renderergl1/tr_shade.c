@@ -359,6 +359,8 @@ void RB_BeginSurface( shader_t *shader, int fogNum ) {
     tess.shader = state;
     tess.fogNum = fogNum;
     tess.dlightBits = 0;        // will be OR'd in by surface functions
+    tess.numVBORanges = 0;
+    tess.useWorldVBO = RB_WorldVBOUsable( shader, fogNum );
     tess.xstages = state->stages;
     tess.numPasses = state->numUnfoggedPasses;
     tess.currentStageIteratorFunc = state->optimalStageIteratorFunc;
@@ -597,6 +599,12 @@ static void ProjectDlightTexture( void ) {
         ProjectDlightTexture_altivec();
         return;
     }
+#endif
+#if idsimd
+    if (r_simd->integer) {
+        ProjectDlightTexture_simd();
+        return;
+    }
 #endif
     ProjectDlightTexture_scalar();
 }
@@ -1051,6 +1059,12 @@ static void RB_IterateStagesGeneric( shaderCommands_t *input )
             break;
         }
 
+        // surface sprites are generated after the other stages
+        if ( pStage->ss && pStage->ss->surfaceSpriteType )
+        {
+            continue;
+        }
+
         ComputeColors( pStage );
         ComputeTexCoords( pStage );
 
@@ -1102,6 +1116,7 @@ void RB_StageIteratorGeneric( void )
 {
     shaderCommands_t *input;
     shader_t        *shader;
+    int             stage;
 
     input = &tess;
     shader = input->shader;
@@ -1208,6 +1223,20 @@ void RB_StageIteratorGeneric( void )
     {
         qglDisable( GL_POLYGON_OFFSET_FILL );
     }
+
+    //
+    // grow any surface sprites from the final geometry
+    //
+    if ( r_surfaceSprites->integer )
+    {
+        for ( stage = 0; stage < MAX_SHADER_STAGES && tess.xstages[stage]; stage++ )
+        {
+            if ( tess.xstages[stage]->ss && tess.xstages[stage]->ss->surfaceSpriteType )
+            {
+                R_RenderSurfaceSprites( tess.xstages[stage], input );
+            }
+        }
+    }
 }
 
 /*
@@ -1218,7 +1247,7 @@ void RB_EndSurface( void ) {
 
     input = &tess;
 
-    if (input->numIndexes == 0) {
+    if (input->numIndexes == 0 && input->numVBORanges == 0) {
         return;
     }
 
@@ -1243,26 +1272,37 @@ void RB_EndSurface( void ) {
     // update performance counters
     //
     backEnd.pc.c_shaders++;
-    backEnd.pc.c_vertexes += tess.numVertexes;
-    backEnd.pc.c_indexes += tess.numIndexes;
-    backEnd.pc.c_totalIndexes += tess.numIndexes * tess.numPasses;
 
     //
-    // call off to shader specific tess end function
-    //
-    tess.currentStageIteratorFunc();
-
+    // static world surfaces queued from the vertex buffer
     //
-    // draw debugging stuff
-    //
-    if ( r_showtris->integer ) {
-        DrawTris (input);
+    if ( input->numVBORanges ) {
+        RB_StageIteratorWorldVBO();
     }
-    if ( r_shownormals->integer ) {
-        DrawNormals (input);
+
+    if ( input->numIndexes ) {
+        backEnd.pc.c_vertexes += tess.numVertexes;
+        backEnd.pc.c_indexes += tess.numIndexes;
+        backEnd.pc.c_totalIndexes += tess.numIndexes * tess.numPasses;
+
+        //
+        // call off to shader specific tess end function
+        //
+        tess.currentStageIteratorFunc();
+
+        //
+        // draw debugging stuff
+        //
+        if ( r_showtris->integer ) {
+            DrawTris (input);
+        }
+        if ( r_shownormals->integer ) {
+            DrawNormals (input);
+        }
     }
     // clear shader so we can tell we don't have any unclosed surfaces
     tess.numIndexes = 0;
+    tess.numVBORanges = 0;
 
     GLimp_LogComment( "----------\n" );
 }
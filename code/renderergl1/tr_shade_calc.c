@@ -128,6 +128,13 @@ void RB_CalcDeformVertexes( deformStage_t *ds )
     {
         scale = EvalWaveForm( &ds->deformationWave );
 
+#if idsimd
+        if ( r_simd->integer ) {
+            RB_CalcDeformVertexes_simd( ds, NULL, scale );
+            return;
+        }
+#endif
+
         for ( i = 0; i < tess.numVertexes; i++, xyz += 4, normal += 4 )
         {
             VectorScale( normal, scale, offset );
@@ -141,6 +148,13 @@ void RB_CalcDeformVertexes( deformStage_t *ds )
     {
         table = TableForFunc( ds->deformationWave.func );
 
+#if idsimd
+        if ( r_simd->integer ) {
+            RB_CalcDeformVertexes_simd( ds, table, 0 );
+            return;
+        }
+#endif
+
         for ( i = 0; i < tess.numVertexes; i++, xyz += 4, normal += 4 )
         {
             float off = ( xyz[0] + xyz[1] + xyz[2] ) * ds->deformationSpread;
@@ -853,6 +867,13 @@ void RB_CalcFogTexCoords( float *st ) {
 
     fogDistanceVector[3] += 1.0/512;
 
+#if idsimd
+    if ( r_simd->integer ) {
+        RB_CalcFogTexCoords_simd( st, fogDistanceVector, fogDepthVector, eyeT, eyeOutside );
+        return;
+    }
+#endif
+
     // calculate density for each point
     for (i = 0, v = tess.xyz[0] ; i < tess.numVertexes ; i++, v += 4) {
         // calculate the length in fog
@@ -1136,6 +1157,12 @@ void RB_CalcDiffuseColor( unsigned char *colors )
         RB_CalcDiffuseColor_altivec( colors );
         return;
     }
+#endif
+#if idsimd
+    if (r_simd->integer) {
+        RB_CalcDiffuseColor_simd( colors );
+        return;
+    }
 #endif
     RB_CalcDiffuseColor_scalar( colors );
 }
@@ -0,0 +1,556 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+/* SSE2 and NEON versions of the per-vertex backend loops; the x86 and ARM
+   counterparts of tr_altivec.c.  Like that file this is kept in its own
+   translation unit so 32-bit x86 builds can compile just this file with
+   -msse2, and r_simd is cleared at startup when the CPU lacks the unit.
+   The scalar versions in tr_shade.c, tr_shade_calc.c and tr_surface.c
+   remain the reference implementations.
+
+   Every kernel works on four vertexes at a time in structure-of-arrays
+   form; the few vertexes left over at the end of a batch are copied into
+   padded scratch arrays so nothing reads or writes past tess. */
+
+#include "tr_local.h"
+
+#if idsimd
+
+#include "../renderercommon/tr_simd.h"
+
+
+/*
+====================================================================
+
+DYNAMIC LIGHTS
+
+====================================================================
+*/
+
+typedef struct {
+    vfloat  origin[3];
+    vfloat  color[3];
+    vfloat  scale;
+    vfloat  radius;
+    qboolean    backs;
+} dlightSIMD_t;
+
+/*
+** ProjectDlightVertexes4
+**
+** Back facing vertexes get no light at all rather than the scalar
+** loop's leftover modulate from the previous vertex.
+*/
+static ID_INLINE void ProjectDlightVertexes4( const dlightSIMD_t *dl, const float *xyz, const float *normal,
+                                              float *texCoords, byte *colors, byte *clipBits ) {
+    vfloat  x, y, z, nx, ny, nz;
+    vfloat  dx, dy, dz, adz, s, t;
+    vfloat  zero = VF_Zero(), one = VF_Set( 1.0f ), modulate;
+    vint    clip, above, below, back;
+    int     clipInts[4];
+
+    VF_LoadVec4x4( xyz, &x, &y, &z );
+    dx = VF_Sub( dl->origin[0], x );
+    dy = VF_Sub( dl->origin[1], y );
+    dz = VF_Sub( dl->origin[2], z );
+
+    s = VF_Madd( dx, dl->scale, VF_Set( 0.5f ) );
+    t = VF_Madd( dy, dl->scale, VF_Set( 0.5f ) );
+    VF_StoreInterleaved2( texCoords, s, t );
+
+    clip = VI_And( VF_CmpLT( s, zero ), VI_Set( 1 ) );
+    clip = VI_Or( clip, VI_And( VF_CmpGT( s, one ), VI_Set( 2 ) ) );
+    clip = VI_Or( clip, VI_And( VF_CmpLT( t, zero ), VI_Set( 4 ) ) );
+    clip = VI_Or( clip, VI_And( VF_CmpGT( t, one ), VI_Set( 8 ) ) );
+    // modulate the strength based on the height and color
+    above = VF_CmpGT( dz, dl->radius );
+    below = VF_CmpLT( dz, VF_Sub( zero, dl->radius ) );
+    clip = VI_Or( clip, VI_And( above, VI_Set( 16 ) ) );
+    clip = VI_Or( clip, VI_And( below, VI_Set( 32 ) ) );
+
+    adz = VF_Abs( dz );
+    modulate = VF_Select( VF_CmpLT( adz, VF_Mul( dl->radius, VF_Set( 0.5f ) ) ),
+        one, VF_Mul( VF_Mul( VF_Set( 2.0f ), VF_Sub( dl->radius, adz ) ), dl->scale ) );
+    modulate = VF_Select( VI_Or( above, below ), zero, modulate );
+
+    if ( !dl->backs ) {
+        VF_LoadVec4x4( normal, &nx, &ny, &nz );
+        back = VF_CmpLT( VF_Madd( dx, nx, VF_Madd( dy, ny, VF_Mul( dz, nz ) ) ), zero );
+        clip = VI_Select( back, VI_Set( 63 ), clip );
+        modulate = VF_Select( back, zero, modulate );
+    }
+
+    VI_Store( colors, VI_PackRGBA(
+        VF_ToInt( VF_Min( VF_Mul( dl->color[0], modulate ), VF_Set( 255.0f ) ) ),
+        VF_ToInt( VF_Min( VF_Mul( dl->color[1], modulate ), VF_Set( 255.0f ) ) ),
+        VF_ToInt( VF_Min( VF_Mul( dl->color[2], modulate ), VF_Set( 255.0f ) ) ) ) );
+
+    VI_Store( clipInts, clip );
+    clipBits[0] = clipInts[0];
+    clipBits[1] = clipInts[1];
+    clipBits[2] = clipInts[2];
+    clipBits[3] = clipInts[3];
+}
+
+void ProjectDlightTexture_simd( void ) {
+    int     i, l;
+    byte    clipBits[SHADER_MAX_VERTEXES];
+    float   texCoordsArray[SHADER_MAX_VERTEXES][2];
+    byte    colorArray[SHADER_MAX_VERTEXES][4];
+    glIndex_t   hitIndexes[SHADER_MAX_INDEXES];
+    int     numIndexes;
+    int     numVertexes, numQuads;
+    vec3_t  floatColor;
+    dlightSIMD_t    dls;
+
+    if ( !backEnd.refdef.num_dlights ) {
+        return;
+    }
+
+    numVertexes = tess.numVertexes;
+    numQuads = numVertexes & ~3;
+    dls.backs = r_dlightBacks->integer ? qtrue : qfalse;
+
+    for ( l = 0 ; l < backEnd.refdef.num_dlights ; l++ ) {
+        dlight_t    *dl;
+
+        if ( !( tess.dlightBits & ( 1 << l ) ) ) {
+            continue;   // this surface definitely doesn't have any of this light
+        }
+
+        dl = &backEnd.refdef.dlights[l];
+
+        if(r_greyscale->integer)
+        {
+            float luminance;
+
+            luminance = LUMA(dl->color[0], dl->color[1], dl->color[2]) * 255.0f;
+            floatColor[0] = floatColor[1] = floatColor[2] = luminance;
+        }
+        else if(r_greyscale->value)
+        {
+            float luminance;
+
+            luminance = LUMA(dl->color[0], dl->color[1], dl->color[2]) * 255.0f;
+            floatColor[0] = LERP(dl->color[0] * 255.0f, luminance, r_greyscale->value);
+            floatColor[1] = LERP(dl->color[1] * 255.0f, luminance, r_greyscale->value);
+            floatColor[2] = LERP(dl->color[2] * 255.0f, luminance, r_greyscale->value);
+        }
+        else
+        {
+            floatColor[0] = dl->color[0] * 255.0f;
+            floatColor[1] = dl->color[1] * 255.0f;
+            floatColor[2] = dl->color[2] * 255.0f;
+        }
+
+        dls.origin[0] = VF_Set( dl->transformed[0] );
+        dls.origin[1] = VF_Set( dl->transformed[1] );
+        dls.origin[2] = VF_Set( dl->transformed[2] );
+        dls.color[0] = VF_Set( floatColor[0] );
+        dls.color[1] = VF_Set( floatColor[1] );
+        dls.color[2] = VF_Set( floatColor[2] );
+        dls.radius = VF_Set( dl->radius );
+        dls.scale = VF_Set( 1.0f / dl->radius );
+
+        for ( i = 0 ; i < numQuads ; i += 4 ) {
+            ProjectDlightVertexes4( &dls, tess.xyz[i], tess.normal[i],
+                texCoordsArray[i], colorArray[i], &clipBits[i] );
+        }
+
+        if ( i < numVertexes ) {
+            vec4_t  xyz[4], normal[4];
+            float   texCoords[4][2];
+            byte    colors[4][4];
+            byte    clip[4];
+            int     rem = numVertexes - i;
+
+            Com_Memset( xyz, 0, sizeof( xyz ) );
+            Com_Memset( normal, 0, sizeof( normal ) );
+            Com_Memcpy( xyz, tess.xyz[i], rem * sizeof( vec4_t ) );
+            Com_Memcpy( normal, tess.normal[i], rem * sizeof( vec4_t ) );
+            ProjectDlightVertexes4( &dls, xyz[0], normal[0], texCoords[0], colors[0], clip );
+            Com_Memcpy( texCoordsArray[i], texCoords, rem * sizeof( texCoords[0] ) );
+            Com_Memcpy( colorArray[i], colors, rem * sizeof( colors[0] ) );
+            Com_Memcpy( &clipBits[i], clip, rem );
+        }
+
+        backEnd.pc.c_dlightVertexes += numVertexes;
+
+        // build a list of triangles that need light
+        numIndexes = 0;
+        for ( i = 0 ; i < tess.numIndexes ; i += 3 ) {
+            int     a, b, c;
+
+            a = tess.indexes[i];
+            b = tess.indexes[i+1];
+            c = tess.indexes[i+2];
+            if ( clipBits[a] & clipBits[b] & clipBits[c] ) {
+                continue;   // not lighted
+            }
+            hitIndexes[numIndexes] = a;
+            hitIndexes[numIndexes+1] = b;
+            hitIndexes[numIndexes+2] = c;
+            numIndexes += 3;
+        }
+
+        if ( !numIndexes ) {
+            continue;
+        }
+
+        qglEnableClientState( GL_TEXTURE_COORD_ARRAY );
+        qglTexCoordPointer( 2, GL_FLOAT, 0, texCoordsArray[0] );
+
+        qglEnableClientState( GL_COLOR_ARRAY );
+        qglColorPointer( 4, GL_UNSIGNED_BYTE, 0, colorArray );
+
+        GL_Bind( tr.dlightImage );
+        // include GLS_DEPTHFUNC_EQUAL so alpha tested surfaces don't add light
+        // where they aren't rendered
+        if ( dl->additive ) {
+            GL_State( GLS_SRCBLEND_ONE | GLS_DSTBLEND_ONE | GLS_DEPTHFUNC_EQUAL );
+        }
+        else {
+            GL_State( GLS_SRCBLEND_DST_COLOR | GLS_DSTBLEND_ONE | GLS_DEPTHFUNC_EQUAL );
+        }
+        R_DrawElements( numIndexes, hitIndexes );
+        backEnd.pc.c_totalIndexes += numIndexes;
+        backEnd.pc.c_dlightIndexes += numIndexes;
+    }
+}
+
+
+/*
+====================================================================
+
+VERTEX COLORS AND TEXCOORDS
+
+====================================================================
+*/
+
+typedef struct {
+    vfloat  lightDir[3];
+    vfloat  ambientLight[3];
+    vfloat  directedLight[3];
+    vint    ambientLightInt;
+} diffuseSIMD_t;
+
+static ID_INLINE void CalcDiffuseColor4( const diffuseSIMD_t *dc, const float *normal, unsigned char *colors ) {
+    vfloat  nx, ny, nz, incoming, max = VF_Set( 255.0f );
+    vint    rgba;
+
+    VF_LoadVec4x4( normal, &nx, &ny, &nz );
+    incoming = VF_Madd( nx, dc->lightDir[0], VF_Madd( ny, dc->lightDir[1], VF_Mul( nz, dc->lightDir[2] ) ) );
+
+    rgba = VI_PackRGBA(
+        VF_ToInt( VF_Min( VF_Madd( incoming, dc->directedLight[0], dc->ambientLight[0] ), max ) ),
+        VF_ToInt( VF_Min( VF_Madd( incoming, dc->directedLight[1], dc->ambientLight[1] ), max ) ),
+        VF_ToInt( VF_Min( VF_Madd( incoming, dc->directedLight[2], dc->ambientLight[2] ), max ) ) );
+
+    VI_Store( colors, VI_Select( VF_CmpGT( incoming, VF_Zero() ), rgba, dc->ambientLightInt ) );
+}
+
+void RB_CalcDiffuseColor_simd( unsigned char *colors )
+{
+    int             i, numVertexes;
+    trRefEntity_t   *ent;
+    diffuseSIMD_t   dc;
+
+    ent = backEnd.currentEntity;
+    for ( i = 0 ; i < 3 ; i++ ) {
+        dc.lightDir[i] = VF_Set( ent->lightDir[i] );
+        dc.ambientLight[i] = VF_Set( ent->ambientLight[i] );
+        dc.directedLight[i] = VF_Set( ent->directedLight[i] );
+    }
+    dc.ambientLightInt = VI_Set( ent->ambientLightInt );
+
+    numVertexes = tess.numVertexes;
+    for ( i = 0 ; i + 4 <= numVertexes ; i += 4 ) {
+        CalcDiffuseColor4( &dc, tess.normal[i], &colors[i*4] );
+    }
+
+    if ( i < numVertexes ) {
+        vec4_t          normal[4];
+        unsigned char   out[4][4];
+        int             rem = numVertexes - i;
+
+        Com_Memset( normal, 0, sizeof( normal ) );
+        Com_Memcpy( normal, tess.normal[i], rem * sizeof( vec4_t ) );
+        CalcDiffuseColor4( &dc, normal[0], out[0] );
+        Com_Memcpy( &colors[i*4], out, rem * 4 );
+    }
+}
+
+typedef struct {
+    vfloat  distance[4];
+    vfloat  depth[4];
+    vfloat  eyeT;
+    qboolean    eyeOutside;
+} fogSIMD_t;
+
+static ID_INLINE void CalcFogTexCoords4( const fogSIMD_t *fs, const float *xyz, float *st ) {
+    vfloat  x, y, z, s, t;
+
+    VF_LoadVec4x4( xyz, &x, &y, &z );
+
+    // calculate the length in fog
+    s = VF_Madd( x, fs->distance[0], VF_Madd( y, fs->distance[1], VF_Madd( z, fs->distance[2], fs->distance[3] ) ) );
+    t = VF_Madd( x, fs->depth[0], VF_Madd( y, fs->depth[1], VF_Madd( z, fs->depth[2], fs->depth[3] ) ) );
+
+    // partially clipped fogs use the T axis
+    if ( fs->eyeOutside ) {
+        vfloat cut = VF_Madd( VF_Set( 30.0f / 32 ), VF_Div( t, VF_Sub( t, fs->eyeT ) ), VF_Set( 1.0f / 32 ) );
+
+        t = VF_Select( VF_CmpLT( t, VF_Set( 1.0f ) ), VF_Set( 1.0f / 32 ), cut );
+    } else {
+        t = VF_Select( VF_CmpLT( t, VF_Zero() ), VF_Set( 1.0f / 32 ), VF_Set( 31.0f / 32 ) );
+    }
+
+    VF_StoreInterleaved2( st, s, t );
+}
+
+void RB_CalcFogTexCoords_simd( float *st, const vec4_t fogDistanceVector, const vec4_t fogDepthVector,
+                               float eyeT, qboolean eyeOutside )
+{
+    int         i, numVertexes;
+    fogSIMD_t   fs;
+
+    for ( i = 0 ; i < 4 ; i++ ) {
+        fs.distance[i] = VF_Set( fogDistanceVector[i] );
+        fs.depth[i] = VF_Set( fogDepthVector[i] );
+    }
+    fs.eyeT = VF_Set( eyeT );
+    fs.eyeOutside = eyeOutside;
+
+    numVertexes = tess.numVertexes;
+    for ( i = 0 ; i + 4 <= numVertexes ; i += 4, st += 8 ) {
+        CalcFogTexCoords4( &fs, tess.xyz[i], st );
+    }
+
+    if ( i < numVertexes ) {
+        vec4_t  xyz[4];
+        float   out[4][2];
+        int     rem = numVertexes - i;
+
+        Com_Memset( xyz, 0, sizeof( xyz ) );
+        Com_Memcpy( xyz, tess.xyz[i], rem * sizeof( vec4_t ) );
+        CalcFogTexCoords4( &fs, xyz[0], out[0] );
+        Com_Memcpy( st, out, rem * sizeof( out[0] ) );
+    }
+}
+
+
+/*
+====================================================================
+
+DEFORMS
+
+====================================================================
+*/
+
+/*
+** RB_CalcDeformVertexes_simd
+**
+** With no table every vertex moves by scale along its normal, otherwise
+** the wave is sampled per vertex.  The shader time is folded into one
+** period up front so the per vertex phase fits comfortably in a float.
+*/
+void RB_CalcDeformVertexes_simd( const deformStage_t *ds, const float *table, float scale )
+{
+    int     i, j, numVertexes;
+    float   *xyz = ( float * ) tess.xyz;
+    float   *normal = ( float * ) tess.normal;
+
+    numVertexes = tess.numVertexes;
+
+    if ( !table ) {
+        vfloat  s = VF_Set( scale );
+
+        for ( i = 0 ; i < numVertexes ; i++, xyz += 4, normal += 4 ) {
+            VF_Store( xyz, VF_Madd( VF_Load( normal ), s, VF_Load( xyz ) ) );
+        }
+    } else {
+        double  timePhase = tess.shaderTime * ds->deformationWave.frequency;
+        vfloat  phase, spread, size;
+        vint    mask;
+
+        timePhase -= floor( timePhase );
+        phase = VF_Set( ds->deformationWave.phase + timePhase );
+        spread = VF_Set( ds->deformationSpread );
+        size = VF_Set( FUNCTABLE_SIZE );
+        mask = VI_Set( FUNCTABLE_MASK );
+
+        for ( i = 0 ; i < numVertexes ; i += 4 ) {
+            vec4_t  pad[4];
+            vfloat  x, y, z, off;
+            int     index[4];
+            int     count = numVertexes - i < 4 ? numVertexes - i : 4;
+            float   *in = tess.xyz[i];
+
+            if ( count < 4 ) {
+                Com_Memset( pad, 0, sizeof( pad ) );
+                Com_Memcpy( pad, tess.xyz[i], count * sizeof( vec4_t ) );
+                in = pad[0];
+            }
+
+            VF_LoadVec4x4( in, &x, &y, &z );
+            off = VF_Mul( VF_Add( VF_Add( x, y ), z ), spread );
+            VI_Store( index, VI_And( VF_ToInt( VF_Mul( VF_Add( phase, off ), size ) ), mask ) );
+
+            for ( j = 0 ; j < count ; j++, xyz += 4, normal += 4 ) {
+                vfloat s = VF_Set( ds->deformationWave.base + table[index[j]] * ds->deformationWave.amplitude );
+
+                VF_Store( xyz, VF_Madd( VF_Load( normal ), s, VF_Load( xyz ) ) );
+            }
+        }
+    }
+}
+
+
+/*
+====================================================================
+
+MD3 VERTEX LERPING
+
+====================================================================
+*/
+
+// decode X as cos( lat ) * sin( long )
+// decode Y as sin( lat ) * sin( long )
+// decode Z as cos( long )
+static ID_INLINE void DecodeMd3Normals4( const short *xyzNormals, float *nx, float *ny, float *nz ) {
+    int         i;
+    unsigned    lat, lng;
+
+    for ( i = 0 ; i < 4 ; i++, xyzNormals += 4 ) {
+        lat = ( xyzNormals[3] >> 8 ) & 0xff;
+        lng = ( xyzNormals[3] & 0xff );
+        lat *= (FUNCTABLE_SIZE/256);
+        lng *= (FUNCTABLE_SIZE/256);
+
+        nx[i] = tr.sinTable[(lat+(FUNCTABLE_SIZE/4))&FUNCTABLE_MASK] * tr.sinTable[lng];
+        ny[i] = tr.sinTable[lat] * tr.sinTable[lng];
+        nz[i] = tr.sinTable[(lng+(FUNCTABLE_SIZE/4))&FUNCTABLE_MASK];
+    }
+}
+
+typedef struct {
+    vfloat  newXyzScale;
+    vfloat  oldXyzScale;
+    vfloat  newNormalScale;
+    vfloat  oldNormalScale;
+} lerpSIMD_t;
+
+static ID_INLINE void LerpMeshVertexes4( const lerpSIMD_t *ls, const short *newXyz, const short *oldXyz,
+                                         float *outXyz, float *outNormal ) {
+    float   nx[4], ny[4], nz[4];
+    vfloat  x, y, z, ox, oy, oz;
+    vfloat  normX, normY, normZ;
+
+    VS_LoadXyz4( newXyz, &x, &y, &z );
+    DecodeMd3Normals4( newXyz, nx, ny, nz );
+    normX = VF_Load( nx );
+    normY = VF_Load( ny );
+    normZ = VF_Load( nz );
+
+    if ( !oldXyz ) {
+        VF_StoreVec4x4( outXyz, VF_Mul( x, ls->newXyzScale ), VF_Mul( y, ls->newXyzScale ), VF_Mul( z, ls->newXyzScale ) );
+        VF_StoreVec4x4( outNormal, normX, normY, normZ );
+        return;
+    }
+
+    // interpolate the xyz
+    VS_LoadXyz4( oldXyz, &ox, &oy, &oz );
+    VF_StoreVec4x4( outXyz,
+        VF_Madd( ox, ls->oldXyzScale, VF_Mul( x, ls->newXyzScale ) ),
+        VF_Madd( oy, ls->oldXyzScale, VF_Mul( y, ls->newXyzScale ) ),
+        VF_Madd( oz, ls->oldXyzScale, VF_Mul( z, ls->newXyzScale ) ) );
+
+    // FIXME: interpolate lat/long instead?
+    DecodeMd3Normals4( oldXyz, nx, ny, nz );
+    normX = VF_Madd( VF_Load( nx ), ls->oldNormalScale, VF_Mul( normX, ls->newNormalScale ) );
+    normY = VF_Madd( VF_Load( ny ), ls->oldNormalScale, VF_Mul( normY, ls->newNormalScale ) );
+    normZ = VF_Madd( VF_Load( nz ), ls->oldNormalScale, VF_Mul( normZ, ls->newNormalScale ) );
+
+    // same job as VectorArrayNormalize on the scalar path
+    {
+        vfloat invLen = VF_RSqrt( VF_Madd( normX, normX, VF_Madd( normY, normY, VF_Mul( normZ, normZ ) ) ) );
+
+        VF_StoreVec4x4( outNormal, VF_Mul( normX, invLen ), VF_Mul( normY, invLen ), VF_Mul( normZ, invLen ) );
+    }
+}
+
+void LerpMeshVertexes_simd( md3Surface_t *surf, float backlerp )
+{
+    short       *oldXyz, *newXyz;
+    float       *outXyz, *outNormal;
+    int         vertNum, numVerts;
+    lerpSIMD_t  ls;
+
+    outXyz = tess.xyz[tess.numVertexes];
+    outNormal = tess.normal[tess.numVertexes];
+
+    newXyz = (short *)((byte *)surf + surf->ofsXyzNormals)
+        + (backEnd.currentEntity->e.frame * surf->numVerts * 4);
+
+    if ( backlerp == 0 ) {
+        oldXyz = NULL;
+    } else {
+        oldXyz = (short *)((byte *)surf + surf->ofsXyzNormals)
+            + (backEnd.currentEntity->e.oldframe * surf->numVerts * 4);
+    }
+
+    ls.newXyzScale = VF_Set( MD3_XYZ_SCALE * (1.0 - backlerp) );
+    ls.newNormalScale = VF_Set( 1.0 - backlerp );
+    ls.oldXyzScale = VF_Set( MD3_XYZ_SCALE * backlerp );
+    ls.oldNormalScale = VF_Set( backlerp );
+
+    numVerts = surf->numVerts;
+
+    for ( vertNum = 0 ; vertNum + 4 <= numVerts ; vertNum += 4 ) {
+        LerpMeshVertexes4( &ls, newXyz, oldXyz, outXyz, outNormal );
+        newXyz += 16;
+        if ( oldXyz ) {
+            oldXyz += 16;
+        }
+        outXyz += 16;
+        outNormal += 16;
+    }
+
+    if ( vertNum < numVerts ) {
+        short   newPad[16], oldPad[16];
+        vec4_t  xyz[4], normal[4];
+        int     rem = numVerts - vertNum;
+
+        Com_Memset( newPad, 0, sizeof( newPad ) );
+        Com_Memset( oldPad, 0, sizeof( oldPad ) );
+        Com_Memcpy( newPad, newXyz, rem * 4 * sizeof( short ) );
+        if ( oldXyz ) {
+            Com_Memcpy( oldPad, oldXyz, rem * 4 * sizeof( short ) );
+        }
+        LerpMeshVertexes4( &ls, newPad, oldXyz ? oldPad : NULL, xyz[0], normal[0] );
+        Com_Memcpy( outXyz, xyz, rem * sizeof( vec4_t ) );
+        Com_Memcpy( outNormal, normal, rem * sizeof( vec4_t ) );
+    }
+}
+
+
+#endif // idsimd
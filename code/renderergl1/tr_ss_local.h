@@ -36,11 +36,40 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define     WINDPOINT_RADIUS        750.0f
 #define     FADE_RANGE              250.0f
 
+#define     SS_CACHE_SPRITES        (1 << 16)   // sprite placements kept between frames
+#define     SS_CACHE_TRIANGLES      (1 << 13)   // triangles those placements belong to
+#define     SS_CACHE_HASH_SIZE      4096
+#define     SS_MAX_TRIANGLE_SPRITES 2048        // placements generated for a single triangle
+
 //=============================================
 //
 // Surface sprite system structures.
 //
 
+// A sprite placed on a surface, generated once per triangle.
+typedef struct {
+    vec3_t      origin;
+    float       width;              // includes variance, negative to mirror the sprite
+    float       height;
+    vec2_t      skew;
+    float       fadeStart;          // 0 <= x < 1, where in the fade range this sprite fades out
+    float       phase;              // 0 <= x < 1, offset into the effect life
+    byte        light;
+    byte        rightVector;        // index into ssSystem.rightVectors
+    byte        weatherRank;        // weather sprites show while curWeatherAmount is above this
+} ssSprite_t;
+
+// The cached placements of a single triangle.
+typedef struct ssTriangle_s {
+    const surfaceSprite_t   *ss;
+    vec3_t                  verts[3];
+
+    int                     firstSprite;
+    int                     numSprites;
+
+    struct ssTriangle_s     *hashNext;
+} ssTriangle_t;
+
 typedef struct {
     float       curWindSpeed;
     float       curWeatherAmount;
@@ -63,6 +92,7 @@ typedef struct {
     qboolean    usingFog;
 
     int         numSurfaceSprites;
+    int         numCacheFlushes;
 } surfaceSpriteSystem_t;
 
 #endif // __TR_SS_LOCAL_H
@@ -46,6 +46,30 @@ static vec3_t           *forwardCoords;
 
 static int              numSurfaces;
 
+// Sprite placements, generated once per world triangle.
+typedef struct {
+    ssTriangle_t    *triangles;
+    ssSprite_t      *sprites;
+    ssTriangle_t    *hashTable[SS_CACHE_HASH_SIZE];
+
+    int             numTriangles;
+    int             numSprites;
+} ssCache_t;
+
+static ssCache_t        ssCache;
+static ssSprite_t       ssScratch[SS_MAX_TRIANGLE_SPRITES];
+
+// Per stage values used while drawing the sprites.
+typedef struct {
+    float           cutDistSq;
+    float           fadeDistSq;
+    float           invFadeDiff;
+    float           fadeRange;
+    float           cheapCut;
+    int             weatherCut;
+    int             budget;
+} ssDrawParms_t;
+
 //==============================================
 
 /*
@@ -311,7 +335,8 @@ static void R_SurfaceSpriteFrameUpdate(void)
     }
 
     if(r_surfaceSprites->integer == 2){
-        ri.Printf(PRINT_ALL, "Surfacesprites drawn: %d on %d surfaces.\n", ssSystem.numSurfaceSprites, numSurfaces);
+        ri.Printf(PRINT_ALL, "Surfacesprites drawn: %d on %d surfaces, %d/%d placements cached, %d cache flushes.\n",
+            ssSystem.numSurfaceSprites, numSurfaces, ssCache.numSprites, SS_CACHE_SPRITES, ssSystem.numCacheFlushes);
     }
 
     lastUpdateTime              = backEnd.refdef.time;
@@ -319,6 +344,553 @@ static void R_SurfaceSpriteFrameUpdate(void)
     ssSystem.numSurfaceSprites  = 0;
 }
 
+/*
+==================
+R_SurfaceSpriteHash
+
+Hashes the position of a triangle.
+Also seeds the placement of its sprites,
+so they land in the same spot every time
+the triangle is generated.
+==================
+*/
+
+static unsigned int R_SurfaceSpriteHash(const float *v1, const float *v2, const float *v3)
+{
+    const float     *verts[3];
+    unsigned int    hash, bits;
+    int             i, j;
+
+    verts[0] = v1;
+    verts[1] = v2;
+    verts[2] = v3;
+
+    hash = 2166136261u;
+    for(i = 0; i < 3; i++){
+        for(j = 0; j < 3; j++){
+            Com_Memcpy(&bits, &verts[i][j], sizeof(bits));
+            hash = (hash ^ bits) * 16777619u;
+        }
+    }
+
+    return hash;
+}
+
+/*
+==================
+R_SurfaceSpriteFacing
+
+Checks if a vertex normal faces the
+way the surface sprite wants to grow.
+==================
+*/
+
+static qboolean R_SurfaceSpriteFacing(const surfaceSprite_t *ss, const float *normal)
+{
+    switch(ss->facing){
+        case SURFSPRITE_FACING_DOWN:
+            return normal[2] <= -0.5f;
+        case SURFSPRITE_FACING_UP:
+            return normal[2] >= 0.5f;
+        case SURFSPRITE_FACING_ANY:
+            return qtrue;
+        default:
+            // Effects go on any surface, everything
+            // else only grows on floors.
+            if(ss->surfaceSpriteType == SURFSPRITE_EFFECT || ss->surfaceSpriteType == SURFSPRITE_WEATHERFX){
+                return qtrue;
+            }
+
+            return normal[2] >= 0.5f;
+    }
+}
+
+/*
+==================
+R_GenerateSurfaceSprites
+
+Places the sprites of a triangle on a
+jittered grid in barycentric space,
+roughly one per density square.
+Returns the number of sprites placed.
+==================
+*/
+
+static int R_GenerateSurfaceSprites(const surfaceSprite_t *ss, const float *v1, const float *v2, const float *v3,
+                                    const byte *c1, const byte *c2, const byte *c3, ssSprite_t *sprites)
+{
+    vec3_t          edge1, edge2, cross;
+    float           area, step, posi, posj;
+    float           fa, fb, fc, var;
+    float           l1, l2, l3;
+    unsigned int    seed;
+    int             numSprites, rightVector;
+    int             gridSize;
+    ssSprite_t      *sprite;
+
+    VectorSubtract(v2, v1, edge1);
+    VectorSubtract(v3, v1, edge2);
+    CrossProduct(edge1, edge2, cross);
+
+    area = VectorLength(cross);
+    if(area <= 1.0f){
+        return 0;
+    }
+
+    seed = R_SurfaceSpriteHash(v1, v2, v3);
+    if(!seed){
+        seed = 1;
+    }
+
+    step = ss->density / sqrt(area);
+
+    // Large triangles get a coarser grid instead of running out
+    // of sprites along the first edge, a grid of n cells a side
+    // has n * (n + 1) / 2 cells.
+    gridSize = (int)((sqrt(8.0f * SS_MAX_TRIANGLE_SPRITES + 1.0f) - 1.0f) * 0.5f);
+    if(step < 1.0f / gridSize){
+        step = 1.0f / gridSize;
+    }
+
+    l1 = (c1[0] + c1[1] + c1[2]) * (1.0f / 3.0f);
+    l2 = (c2[0] + c2[1] + c2[2]) * (1.0f / 3.0f);
+    l3 = (c3[0] + c3[1] + c3[2]) * (1.0f / 3.0f);
+
+    numSprites  = 0;
+    rightVector = 0;
+
+    for(posi = 0.0f; posi < 1.0f; posi += step){
+        for(posj = 0.0f; posj < 1.0f - posi; posj += step){
+            fa = posi + R_ParticleRandom(&seed) * step;
+            fb = posj + R_ParticleRandom(&seed) * step;
+            rightVector = (rightVector + 1) & 3;
+
+            if(fa > 1.0f || fb > 1.0f - fa){
+                continue;
+            }
+            if(numSprites == SS_MAX_TRIANGLE_SPRITES){
+                // a safety net, the steps could round to an extra row
+                return numSprites;
+            }
+
+            fc = 1.0f - fa - fb;
+            sprite = &sprites[numSprites++];
+
+            sprite->origin[0]   = v1[0] * fa + v2[0] * fb + v3[0] * fc;
+            sprite->origin[1]   = v1[1] * fa + v2[1] * fb + v3[1] * fc;
+            sprite->origin[2]   = v1[2] * fa + v2[2] * fb + v3[2] * fc;
+            sprite->light       = (byte)(l1 * fa + l2 * fb + l3 * fc);
+            sprite->rightVector = rightVector;
+
+            sprite->fadeStart   = R_ParticleRandom(&seed);
+
+            var = R_ParticleRandom(&seed);
+            sprite->width       = ss->width * (1.0f + ss->variance[0] * var);
+            sprite->height      = ss->height * (1.0f + ss->variance[1] * var);
+            if(R_ParticleRandom(&seed) > 0.5f){
+                sprite->width = -sprite->width;
+            }
+
+            if(ss->vertSkew != 0.0f){
+                sprite->skew[0] = sprite->height * ss->vertSkew * (R_ParticleRandom(&seed) * 2.0f - 1.0f);
+                sprite->skew[1] = sprite->height * ss->vertSkew * (R_ParticleRandom(&seed) * 2.0f - 1.0f);
+            }else{
+                sprite->skew[0] = sprite->skew[1] = 0.0f;
+            }
+
+            sprite->phase       = R_ParticleRandom(&seed);
+            sprite->weatherRank = (byte)(R_ParticleRandom(&seed) * 256.0f);
+        }
+    }
+
+    return numSprites;
+}
+
+/*
+==================
+R_FlushSurfaceSpriteCache
+
+Drops all cached sprite placements.
+==================
+*/
+
+static void R_FlushSurfaceSpriteCache(void)
+{
+    Com_Memset(ssCache.hashTable, 0, sizeof(ssCache.hashTable));
+    ssCache.numTriangles    = 0;
+    ssCache.numSprites      = 0;
+}
+
+/*
+==================
+R_CacheSurfaceSpriteTriangle
+
+Returns the cached sprite placements of
+a triangle, generating them first if
+this triangle wasn't seen before.
+==================
+*/
+
+static ssTriangle_t *R_CacheSurfaceSpriteTriangle(const surfaceSprite_t *ss, shaderCommands_t *input, int i1, int i2, int i3)
+{
+    float           *v1, *v2, *v3;
+    ssTriangle_t    *tri;
+    unsigned int    hash;
+    int             numSprites;
+
+    v1 = input->xyz[i1];
+    v2 = input->xyz[i2];
+    v3 = input->xyz[i3];
+
+    hash = R_SurfaceSpriteHash(v1, v2, v3) ^ (unsigned int)((intptr_t)ss >> 4);
+    hash &= SS_CACHE_HASH_SIZE - 1;
+
+    for(tri = ssCache.hashTable[hash]; tri; tri = tri->hashNext){
+        if(tri->ss == ss && VectorCompare(tri->verts[0], v1)
+            && VectorCompare(tri->verts[1], v2) && VectorCompare(tri->verts[2], v3))
+        {
+            return tri;
+        }
+    }
+
+    //
+    // Not placed yet, generate the sprites.
+    //
+    if(!ssCache.triangles){
+        ssCache.triangles   = ri.Malloc(SS_CACHE_TRIANGLES * sizeof(ssTriangle_t));
+        ssCache.sprites     = ri.Malloc(SS_CACHE_SPRITES * sizeof(ssSprite_t));
+    }
+
+    numSprites = R_GenerateSurfaceSprites(ss, v1, v2, v3,
+        input->vertexColors[i1], input->vertexColors[i2], input->vertexColors[i3], ssScratch);
+
+    if(ssCache.numTriangles == SS_CACHE_TRIANGLES || ssCache.numSprites + numSprites > SS_CACHE_SPRITES){
+        // Out of room, start over with
+        // whatever is in view now.
+        R_FlushSurfaceSpriteCache();
+        ssSystem.numCacheFlushes++;
+    }
+
+    tri = &ssCache.triangles[ssCache.numTriangles++];
+    tri->ss = ss;
+    VectorCopy(v1, tri->verts[0]);
+    VectorCopy(v2, tri->verts[1]);
+    VectorCopy(v3, tri->verts[2]);
+
+    tri->firstSprite    = ssCache.numSprites;
+    tri->numSprites     = numSprites;
+    Com_Memcpy(ssCache.sprites + tri->firstSprite, ssScratch, numSprites * sizeof(ssSprite_t));
+    ssCache.numSprites += numSprites;
+
+    tri->hashNext = ssCache.hashTable[hash];
+    ssCache.hashTable[hash] = tri;
+
+    return tri;
+}
+
+/*
+==================
+R_ShutdownSurfaceSprites
+
+Frees the sprite placement cache.
+The surface sprite parameters it is
+keyed on don't survive a renderer
+restart.
+==================
+*/
+
+void R_ShutdownSurfaceSprites(void)
+{
+    if(ssCache.triangles){
+        ri.Free(ssCache.triangles);
+        ri.Free(ssCache.sprites);
+    }
+
+    Com_Memset(&ssCache, 0, sizeof(ssCache));
+    ssSystem.numCacheFlushes = 0;
+}
+
+//==============================================
+
+/*
+==================
+RB_SurfaceSpriteQuad
+
+Adds a sprite running from bottom to
+top, right being half its width.
+==================
+*/
+
+static void RB_SurfaceSpriteQuad(const vec3_t bottom, const vec3_t top, const vec3_t right, byte light, float alpha)
+{
+    vec4_t          points[4];
+    color4ub_t      color;
+
+    if(ssSystem.additiveTransparency){
+        // Additive sprites fade by getting darker.
+        color[0] = color[1] = color[2] = (byte)(light * alpha);
+        color[3] = 255;
+    }else{
+        color[0] = color[1] = color[2] = light;
+        color[3] = (byte)(alpha * 255.0f);
+    }
+
+    VectorAdd(bottom, right, points[0]);
+    VectorAdd(top, right, points[1]);
+    VectorSubtract(top, right, points[2]);
+    VectorSubtract(bottom, right, points[3]);
+    points[0][3] = points[1][3] = points[2][3] = points[3][3] = 0.0f;
+
+    RB_AddQuickSprite(points[0], color);
+    ssSystem.numSurfaceSprites++;
+}
+
+/*
+==================
+RB_FlatSurfaceSprite
+
+Adds a sprite lying flat on the ground,
+turned by its random phase.
+==================
+*/
+
+static void RB_FlatSurfaceSprite(const vec3_t origin, const ssSprite_t *sprite, float width, float height, float alpha)
+{
+    vec3_t          right, forward, bottom, top;
+    float           angle;
+
+    angle = sprite->phase * 2.0f * M_PI;
+    VectorSet(right, cos(angle) * width * 0.5f, sin(angle) * width * 0.5f, 0.0f);
+    VectorSet(forward, -right[1] * height / width, right[0] * height / width, 0.0f);
+
+    // Keep clear of the surface itself.
+    VectorSubtract(origin, forward, bottom);
+    VectorAdd(origin, forward, top);
+    bottom[2] += 1.0f;
+    top[2] += 1.0f;
+
+    RB_SurfaceSpriteQuad(bottom, top, right, sprite->light, alpha);
+}
+
+/*
+==================
+RB_VerticalSurfaceSprite
+
+Adds a sprite standing up from (or hanging
+down off) the surface, swaying in the wind.
+==================
+*/
+
+static void RB_VerticalSurfaceSprite(const surfaceSprite_t *ss, const ssSprite_t *sprite, float width, float height, float alpha)
+{
+    vec3_t          right, top, diff;
+    float           angle, windsway, dist, force;
+
+    VectorScale(ssSystem.rightVectors[sprite->rightVector], width * 0.5f, right);
+
+    top[0] = sprite->origin[0] + sprite->skew[0];
+    top[1] = sprite->origin[1] + sprite->skew[1];
+    top[2] = sprite->origin[2];
+
+    // Sway a little even without wind, offset by
+    // position so neighbours don't move in step.
+    angle = (sprite->origin[0] + sprite->origin[1]) * 0.02f + backEnd.refdef.time * 0.0015f;
+    if(ss->windIdle > 0.0f){
+        windsway = height * ss->windIdle * 0.075f;
+        top[0] += cos(angle) * windsway;
+        top[1] += sin(angle) * windsway;
+    }
+
+    if(ss->facing == SURFSPRITE_FACING_DOWN){
+        top[2] -= height;
+    }else{
+        top[2] += height;
+    }
+
+    if(ss->wind > 0.0f){
+        // Bend with the general wind.
+        if(ssSystem.curWindSpeed > 0.001f){
+            VectorMA(top, height * ss->wind, ssSystem.curWindGrassDir, top);
+            top[2] += sin(angle * 2.5f) * height * ss->wind * 0.075f;
+        }
+
+        // Get pushed away from the wind point.
+        if(ssSystem.curWindPointActive){
+            VectorSubtract(sprite->origin, ssSystem.curWindPoint, diff);
+            diff[2] = 0.0f;
+            dist = VectorNormalize(diff);
+
+            if(dist < WINDPOINT_RADIUS){
+                force = ssSystem.curWindPointForce * ss->wind * (1.0f - dist * (1.0f / WINDPOINT_RADIUS));
+                if(force > 1.0f){
+                    force = 1.0f;
+                }
+
+                VectorMA(top, height * force, diff, top);
+                top[2] -= height * force * 0.5f;
+            }
+        }
+    }
+
+    if(ss->facing == SURFSPRITE_FACING_DOWN){
+        // Keep the top of the texture at the ceiling.
+        RB_SurfaceSpriteQuad(top, sprite->origin, right, sprite->light, alpha);
+    }else{
+        RB_SurfaceSpriteQuad(sprite->origin, top, right, sprite->light, alpha);
+    }
+}
+
+/*
+==================
+RB_OrientedSurfaceSprite
+
+Adds a sprite facing the viewer, or
+lying flat on the ground.
+==================
+*/
+
+static void RB_OrientedSurfaceSprite(const surfaceSprite_t *ss, const vec3_t origin, const ssSprite_t *sprite,
+                                     float width, float height, qboolean flat, float alpha)
+{
+    vec3_t          right, bottom, top;
+
+    if(flat){
+        RB_FlatSurfaceSprite(origin, sprite, width, height, alpha);
+        return;
+    }
+
+    VectorScale(viewRight, width * 0.5f, right);
+
+    if(ss->facing == SURFSPRITE_FACING_DOWN){
+        VectorCopy(origin, top);
+        VectorMA(top, -height, viewUp, bottom);
+    }else{
+        if(ss->noOffset){
+            // Centered on the surface.
+            VectorMA(origin, -height * 0.5f, viewUp, bottom);
+        }else{
+            // Standing on the surface.
+            VectorCopy(origin, bottom);
+        }
+
+        VectorMA(bottom, height, viewUp, top);
+    }
+
+    RB_SurfaceSpriteQuad(bottom, top, right, sprite->light, alpha);
+}
+
+/*
+==================
+RB_EffectSurfaceSprite
+
+Adds a sprite that loops through its
+effect life, growing and fading as
+it goes.
+==================
+*/
+
+static void RB_EffectSurfaceSprite(const surfaceSprite_t *ss, const ssSprite_t *sprite, float width, float height, float alpha)
+{
+    vec3_t          origin;
+    float           life, pos;
+
+    life = (backEnd.refdef.time + 10000.0f * sprite->phase) / ss->fxDuration;
+    pos = life - floor(life);
+
+    width   *= 1.0f + ss->fxGrow[0] * pos;
+    height  *= 1.0f + ss->fxGrow[1] * pos;
+
+    alpha *= ss->fxAlphaStart + (ss->fxAlphaEnd - ss->fxAlphaStart) * pos;
+    if(alpha <= 0.0f){
+        return;
+    }else if(alpha > 1.0f){
+        alpha = 1.0f;
+    }
+
+    VectorCopy(sprite->origin, origin);
+    if(ss->facing == SURFSPRITE_FACING_SPURT || ss->facing == SURFSPRITE_FACING_SPURTFLAT){
+        // Shoot up over its life.
+        origin[2] += sprite->height * pos;
+    }
+
+    RB_OrientedSurfaceSprite(ss, origin, sprite, width, height,
+        ss->facing == SURFSPRITE_FACING_FLAT || ss->facing == SURFSPRITE_FACING_SPURTFLAT, alpha);
+}
+
+/*
+==================
+RB_DrawSurfaceSprites
+
+Fades the placed sprites by distance and
+adds the visible ones.  Returns qfalse
+once the sprite budget is used up.
+==================
+*/
+
+static qboolean RB_DrawSurfaceSprites(const surfaceSprite_t *ss, const ssSprite_t *sprites, int numSprites, const ssDrawParms_t *parms)
+{
+    const ssSprite_t    *sprite;
+    vec3_t              delta;
+    float               distSq, alphaPos, fadeStart, alpha;
+    float               width, height;
+    int                 i;
+
+    for(i = 0, sprite = sprites; i < numSprites; i++, sprite++){
+        if(sprite->fadeStart < parms->cheapCut){
+            continue;
+        }
+        if(sprite->weatherRank >= parms->weatherCut){
+            continue;
+        }
+
+        VectorSubtract(sprite->origin, viewOrigin, delta);
+        distSq = DotProduct(delta, delta);
+        if(distSq >= parms->cutDistSq){
+            continue;
+        }
+
+        // Each sprite starts fading at its own
+        // point within the last FADE_RANGE units.
+        alphaPos    = 1.0f - (distSq - parms->fadeDistSq) * parms->invFadeDiff;
+        fadeStart   = parms->fadeRange + (1.0f - parms->fadeRange) * sprite->fadeStart;
+        alpha       = 1.0f - (fadeStart - alphaPos) / parms->fadeRange;
+        if(alpha <= 0.0f){
+            continue;
+        }else if(alpha > 1.0f){
+            alpha = 1.0f;
+        }
+
+        if(parms->budget && ssSystem.numSurfaceSprites >= parms->budget){
+            return qfalse;
+        }
+
+        width   = sprite->width;
+        height  = sprite->height;
+        if(ss->fadeScale != 0.0f && alphaPos < 1.0f){
+            width   *= 1.0f + ss->fadeScale * (1.0f - alphaPos);
+            height  *= 1.0f + ss->fadeScale * (1.0f - alphaPos);
+        }
+
+        switch(ss->surfaceSpriteType){
+            case SURFSPRITE_VERTICAL:
+                RB_VerticalSurfaceSprite(ss, sprite, width, height, alpha);
+                break;
+            case SURFSPRITE_ORIENTED:
+                RB_OrientedSurfaceSprite(ss, sprite->origin, sprite, width, height,
+                    ss->facing == SURFSPRITE_FACING_UP || ss->facing == SURFSPRITE_FACING_FLAT, alpha);
+                break;
+            case SURFSPRITE_EFFECT:
+            case SURFSPRITE_WEATHERFX:
+                RB_EffectSurfaceSprite(ss, sprite, width, height, alpha);
+                break;
+            default:
+                break;
+        }
+    }
+
+    return qtrue;
+}
+
 /*
 ==================
 R_RenderSurfaceSprites
@@ -333,6 +905,16 @@ void R_RenderSurfaceSprites(shaderStage_t *stage, shaderCommands_t *input)
 {
     unsigned long   glBits;
     fog_t           *fog;
+    surfaceSprite_t *ss;
+    ssDrawParms_t   parms;
+    ssTriangle_t    *tri;
+    ssSprite_t      *sprites;
+    vec3_t          center;
+    float           cutDist, fadeDist, radius, dist;
+    qboolean        cacheable;
+    int             i, i1, i2, i3, numSprites;
+
+    ss = stage->ss;
 
     //
     // Update with the current frame.
@@ -386,9 +968,77 @@ void R_RenderSurfaceSprites(shaderStage_t *stage, shaderCommands_t *input)
         lastEntityDrawn = backEnd.currentEntity;
     }
 
-    switch(stage->ss->surfaceSpriteType){
-        default:
+    //
+    // Draw the sprites of every triangle in range.
+    //
+    cutDist     = ss->fadeMax * ssSystem.rangeScaleFactor;
+    fadeDist    = ss->fadeDist * ssSystem.rangeScaleFactor;
+
+    parms.cutDistSq     = cutDist * cutDist;
+    parms.fadeDistSq    = fadeDist * fadeDist;
+    parms.invFadeDiff   = 1.0f / (parms.cutDistSq - parms.fadeDistSq);
+    parms.fadeRange     = FADE_RANGE / (cutDist - fadeDist);
+    if(parms.fadeRange > 1.0f){
+        parms.fadeRange = 1.0f;
+    }
+
+    parms.cheapCut      = r_ssCheap->value;
+    parms.budget        = r_surfaceSpriteBudget->integer;
+
+    if(ss->surfaceSpriteType == SURFSPRITE_WEATHERFX){
+        parms.weatherCut = (int)(ssSystem.curWeatherAmount * 256.0f);
+    }else{
+        parms.weatherCut = 256;
+    }
+
+    // Placements are only cached for static world geometry,
+    // anything else is regenerated on every draw.
+    cacheable = backEnd.currentEntity == &tr.worldEntity && !tess.shader->numDeforms;
+
+    for(i = 0; i + 2 < input->numIndexes && parms.weatherCut > 0; i += 3){
+        i1 = input->indexes[i];
+        i2 = input->indexes[i + 1];
+        i3 = input->indexes[i + 2];
+
+        if(!R_SurfaceSpriteFacing(ss, input->normal[i1]) || !R_SurfaceSpriteFacing(ss, input->normal[i2])
+            || !R_SurfaceSpriteFacing(ss, input->normal[i3]))
+        {
+            continue;
+        }
+
+        // Skip triangles entirely out of range.
+        VectorAdd(input->xyz[i1], input->xyz[i2], center);
+        VectorAdd(center, input->xyz[i3], center);
+        VectorScale(center, 1.0f / 3.0f, center);
+
+        radius = Distance(center, input->xyz[i1]);
+        dist = Distance(center, input->xyz[i2]);
+        if(dist > radius){
+            radius = dist;
+        }
+        dist = Distance(center, input->xyz[i3]);
+        if(dist > radius){
+            radius = dist;
+        }
+        radius += ss->width * (1.0f + ss->variance[0]) + ss->height * (1.0f + ss->variance[1]);
+
+        if(Distance(center, viewOrigin) - radius >= cutDist){
+            continue;
+        }
+
+        if(cacheable){
+            tri = R_CacheSurfaceSpriteTriangle(ss, input, i1, i2, i3);
+            sprites = ssCache.sprites + tri->firstSprite;
+            numSprites = tri->numSprites;
+        }else{
+            sprites = ssScratch;
+            numSprites = R_GenerateSurfaceSprites(ss, input->xyz[i1], input->xyz[i2], input->xyz[i3],
+                input->vertexColors[i1], input->vertexColors[i2], input->vertexColors[i3], ssScratch);
+        }
+
+        if(!RB_DrawSurfaceSprites(ss, sprites, numSprites, &parms)){
             break;
+        }
     }
 
     RB_EndQuickSpriteRendering();
@@ -291,7 +291,11 @@ static void RB_SurfaceTriangles( srfTriangles_t *srf ) {
     int         dlightBits;
     qboolean    needsNormal;
 
-    dlightBits = srf->dlightBits;
+    if ( RB_AddWorldVBOSurface( &srf->vbo, srf->dlightBits[backEnd.smpFrame] ) ) {
+        return;
+    }
+
+    dlightBits = srf->dlightBits[backEnd.smpFrame];
     tess.dlightBits |= dlightBits;
 
     RB_CHECKOVERFLOW( srf->numVerts, srf->numIndexes );
@@ -786,6 +790,12 @@ static void LerpMeshVertexes(md3Surface_t *surf, float backlerp)
         return;
     }
 #endif // idppc_altivec
+#if idsimd
+    if (r_simd->integer) {
+        LerpMeshVertexes_simd( surf, backlerp );
+        return;
+    }
+#endif
     LerpMeshVertexes_scalar( surf, backlerp );
 }
 
@@ -853,9 +863,13 @@ static void RB_SurfaceFace( srfSurfaceFace_t *surf ) {
     int         numPoints;
     int         dlightBits;
 
+    if ( RB_AddWorldVBOSurface( &surf->vbo, surf->dlightBits[backEnd.smpFrame] ) ) {
+        return;
+    }
+
     RB_CHECKOVERFLOW( surf->numPoints, surf->numIndices );
 
-    dlightBits = surf->dlightBits;
+    dlightBits = surf->dlightBits[backEnd.smpFrame];
     tess.dlightBits |= dlightBits;
 
     indices = ( unsigned * ) ( ( ( char  * ) surf ) + surf->ofsIndices );
@@ -953,7 +967,12 @@ static void RB_SurfaceGrid( srfGridMesh_t *cv ) {
     int     *vDlightBits;
     qboolean    needsNormal;
 
-    dlightBits = cv->dlightBits;
+    // the buffered copy is drawn at full detail
+    if ( RB_AddWorldVBOSurface( &cv->vbo, cv->dlightBits[backEnd.smpFrame] ) ) {
+        return;
+    }
+
+    dlightBits = cv->dlightBits[backEnd.smpFrame];
     tess.dlightBits |= dlightBits;
 
     // determine the allowable discrepance
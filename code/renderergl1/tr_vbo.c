@@ -0,0 +1,951 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// tr_vbo.c
+
+#include "tr_local.h"
+
+/*
+=============================================================================
+
+STATIC WORLD VERTEX BUFFER
+
+Faces, patch grids and triangle soups never move, so they are uploaded once
+when the map loads and drawn straight from buffer objects.  Only shaders
+whose stages can be expressed with fixed function state take this path,
+everything else keeps copying into tess.
+
+=============================================================================
+*/
+
+typedef struct {
+    vec3_t      xyz;
+    vec2_t      st[NUM_TEX_COORDS];
+    byte        color[4];           // what RB_ComputeFinalVertexColor produces
+    byte        colorScaled[4];     // color * tr.identityLight for rgbGen vertex
+} worldVBOVert_t;
+
+static int      s_numStyleSurfaces;     // vertex lit soups that depend on styleColors[0]
+
+/*
+=================
+R_ShaderWorldVBOMode
+
+Classifies a shader by whether every stage can be drawn from
+static vertex data with constant colors or vertex color arrays.
+=================
+*/
+int R_ShaderWorldVBOMode( const shader_t *shader ) {
+    shaderStage_t   *pStage;
+    qboolean        vertexLit, rgbConst;
+    int             mode;
+    int             i, b;
+
+    if ( shader->isSky || shader->numDeforms || shader->entityMergable ) {
+        return WVBO_NONE;
+    }
+    if ( shader->optimalStageIteratorFunc != RB_StageIteratorGeneric ) {
+        return WVBO_NONE;
+    }
+
+    // vertex colors are only baked for a single static light style
+    vertexLit = ( shader->lightmapIndex[0] == LIGHTMAP_BY_VERTEX );
+    if ( vertexLit ) {
+        if ( MAXLIGHTMAPS > 1 && shader->styles[1] < LS_UNUSED ) {
+            return WVBO_NONE;
+        }
+        if ( shader->styles[0] != 0 && shader->styles[0] < LS_UNUSED ) {
+            return WVBO_NONE;
+        }
+    }
+
+    mode = WVBO_ALWAYS;
+
+    for ( i = 0; i < MAX_SHADER_STAGES; i++ ) {
+        pStage = shader->stages[i];
+        if ( !pStage || !pStage->active ) {
+            break;
+        }
+
+        if ( pStage->ss ) {
+            return WVBO_NONE;
+        }
+
+        for ( b = 0; b < NUM_TEXTURE_BUNDLES; b++ ) {
+            if ( b > 0 && !pStage->bundle[b].image[0] ) {
+                continue;
+            }
+            if ( pStage->bundle[b].numTexMods ) {
+                return WVBO_NONE;
+            }
+            switch ( pStage->bundle[b].tcGen ) {
+            case TCGEN_TEXTURE:
+            case TCGEN_LIGHTMAP:
+            case TCGEN_LIGHTMAP1:
+            case TCGEN_LIGHTMAP2:
+            case TCGEN_LIGHTMAP3:
+                break;
+            default:
+                return WVBO_NONE;
+            }
+        }
+
+        switch ( pStage->rgbGen ) {
+        case CGEN_IDENTITY:
+        case CGEN_IDENTITY_LIGHTING:
+        case CGEN_CONST:
+        case CGEN_LIGHTMAP0:
+        case CGEN_LIGHTMAP1:
+        case CGEN_LIGHTMAP2:
+        case CGEN_LIGHTMAP3:
+            rgbConst = qtrue;
+            break;
+        case CGEN_EXACT_VERTEX:
+        case CGEN_VERTEX:
+            rgbConst = qfalse;
+            break;
+        default:
+            return WVBO_NONE;
+        }
+
+        switch ( pStage->alphaGen ) {
+        case AGEN_SKIP:
+            break;
+        case AGEN_IDENTITY:
+            // a forced 255 over vertex colors only matches opaque vertexes
+            if ( !rgbConst ) {
+                mode = WVBO_OPAQUE_ALPHA;
+            }
+            break;
+        case AGEN_CONST:
+            if ( !rgbConst ) {
+                if ( pStage->constantColor[3] != 255 ) {
+                    return WVBO_NONE;
+                }
+                mode = WVBO_OPAQUE_ALPHA;
+            }
+            break;
+        case AGEN_VERTEX:
+            // vertex alpha under a constant color needs white vertex rgb
+            if ( rgbConst ) {
+                if ( vertexLit || ( pStage->rgbGen != CGEN_IDENTITY && pStage->rgbGen != CGEN_LIGHTMAP0 ) ) {
+                    return WVBO_NONE;
+                }
+            }
+            break;
+        default:
+            return WVBO_NONE;
+        }
+    }
+
+    return mode;
+}
+
+/*
+=================
+R_SurfaceVBO
+=================
+*/
+static surfaceVBO_t *R_SurfaceVBO( surfaceType_t *data ) {
+    switch ( *data ) {
+    case SF_FACE:
+        return &( (srfSurfaceFace_t *)data )->vbo;
+    case SF_GRID:
+        return &( (srfGridMesh_t *)data )->vbo;
+    case SF_TRIANGLES:
+        return &( (srfTriangles_t *)data )->vbo;
+    default:
+        return NULL;
+    }
+}
+
+/*
+=================
+R_SurfaceVBOCounts
+
+Returns qfalse if the surface can't be put in the buffer.
+=================
+*/
+static qboolean R_SurfaceVBOCounts( surfaceType_t *data, int *numVerts, int *numIndexes ) {
+    srfSurfaceFace_t    *face;
+    srfGridMesh_t       *grid;
+    srfTriangles_t      *tri;
+    int                 *indices;
+    int                 i;
+
+    switch ( *data ) {
+    case SF_FACE:
+        face = (srfSurfaceFace_t *)data;
+        indices = (int *)( (byte *)face + face->ofsIndices );
+        // faces clamped to MAX_FACE_POINTS may still reference dropped points
+        for ( i = 0; i < face->numIndices; i++ ) {
+            if ( indices[i] < 0 || indices[i] >= face->numPoints ) {
+                return qfalse;
+            }
+        }
+        *numVerts = face->numPoints;
+        *numIndexes = face->numIndices;
+        break;
+    case SF_GRID:
+        grid = (srfGridMesh_t *)data;
+        *numVerts = grid->width * grid->height;
+        *numIndexes = ( grid->width - 1 ) * ( grid->height - 1 ) * 6;
+        break;
+    case SF_TRIANGLES:
+        tri = (srfTriangles_t *)data;
+        *numVerts = tri->numVerts;
+        *numIndexes = tri->numIndexes;
+        break;
+    default:
+        return qfalse;
+    }
+
+    return ( *numVerts > 0 && *numIndexes > 0 );
+}
+
+/*
+=================
+R_WorldVBOColor
+
+Same result as RB_ComputeFinalVertexColor for the light styles
+R_ShaderWorldVBOMode accepts.
+=================
+*/
+static void R_WorldVBOColor( const shader_t *shader, const byte *in, qboolean isFace, worldVBOVert_t *out ) {
+    const byte  *styleColor;
+    int         i;
+
+    if ( shader->lightmapIndex[0] != LIGHTMAP_BY_VERTEX ) {
+        out->color[0] = out->color[1] = out->color[2] = 255;
+        out->color[3] = in[3];
+    } else if ( isFace ) {
+        out->color[0] = in[0];
+        out->color[1] = in[1];
+        out->color[2] = in[2];
+        out->color[3] = in[3];
+    } else if ( shader->styles[0] < LS_UNUSED ) {
+        styleColor = styleColors[shader->styles[0]];
+        for ( i = 0; i < 3; i++ ) {
+            out->color[i] = Com_Clamp( 0, 255, ( in[i] * styleColor[i] ) >> 8 );
+        }
+        // alpha comes from the color after the last style summed,
+        // the second one with a single style
+        out->color[3] = in[4 + 3];
+    } else {
+        out->color[0] = out->color[1] = out->color[2] = 0;
+        out->color[3] = in[3];
+    }
+
+    for ( i = 0; i < 3; i++ ) {
+        out->colorScaled[i] = out->color[i] * tr.identityLight;
+    }
+    out->colorScaled[3] = out->color[3];
+}
+
+/*
+=================
+R_FillSurfaceVBOVerts
+
+Returns qtrue if every vertex alpha is 255.
+=================
+*/
+static qboolean R_FillSurfaceVBOVerts( msurface_t *surf, worldVBOVert_t *out ) {
+    srfSurfaceFace_t    *face;
+    srfGridMesh_t       *grid;
+    srfTriangles_t      *tri;
+    drawVert_t          *dv;
+    float               *v;
+    int                 numVerts;
+    int                 i, k;
+    qboolean            opaque;
+
+    opaque = qtrue;
+
+    if ( *surf->data == SF_FACE ) {
+        face = (srfSurfaceFace_t *)surf->data;
+        for ( i = 0, v = face->points[0]; i < face->numPoints; i++, v += VERTEXSIZE, out++ ) {
+            VectorCopy( v, out->xyz );
+            out->st[0][0] = v[3];
+            out->st[0][1] = v[4];
+            for ( k = 0; k < MAXLIGHTMAPS; k++ ) {
+                out->st[k + 1][0] = v[VERTEX_LM + ( k * 2 )];
+                out->st[k + 1][1] = v[VERTEX_LM + ( k * 2 ) + 1];
+            }
+            R_WorldVBOColor( surf->shader, (byte *)&v[VERTEX_COLOR], qtrue, out );
+            if ( out->color[3] != 255 ) {
+                opaque = qfalse;
+            }
+        }
+        return opaque;
+    }
+
+    if ( *surf->data == SF_GRID ) {
+        grid = (srfGridMesh_t *)surf->data;
+        dv = grid->verts;
+        numVerts = grid->width * grid->height;
+    } else {
+        tri = (srfTriangles_t *)surf->data;
+        dv = tri->verts;
+        numVerts = tri->numVerts;
+    }
+
+    for ( i = 0; i < numVerts; i++, dv++, out++ ) {
+        VectorCopy( dv->xyz, out->xyz );
+        out->st[0][0] = dv->st[0];
+        out->st[0][1] = dv->st[1];
+        for ( k = 0; k < MAXLIGHTMAPS; k++ ) {
+            out->st[k + 1][0] = dv->lightmap[k][0];
+            out->st[k + 1][1] = dv->lightmap[k][1];
+        }
+        R_WorldVBOColor( surf->shader, (byte *)dv->color, qfalse, out );
+        if ( out->color[3] != 255 ) {
+            opaque = qfalse;
+        }
+    }
+
+    return opaque;
+}
+
+/*
+=================
+R_FillSurfaceVBOIndexes
+=================
+*/
+static void R_FillSurfaceVBOIndexes( surfaceType_t *data, int firstVertex, glIndex_t *out ) {
+    srfSurfaceFace_t    *face;
+    srfGridMesh_t       *grid;
+    srfTriangles_t      *tri;
+    int                 *indices;
+    int                 i, j;
+    int                 v1, v2, v3, v4;
+
+    switch ( *data ) {
+    case SF_FACE:
+        face = (srfSurfaceFace_t *)data;
+        indices = (int *)( (byte *)face + face->ofsIndices );
+        for ( i = 0; i < face->numIndices; i++ ) {
+            *out++ = firstVertex + indices[i];
+        }
+        break;
+    case SF_GRID:
+        // same triangulation as RB_SurfaceGrid with every row and column
+        grid = (srfGridMesh_t *)data;
+        for ( i = 0; i < grid->height - 1; i++ ) {
+            for ( j = 0; j < grid->width - 1; j++ ) {
+                v1 = firstVertex + i * grid->width + j + 1;
+                v2 = v1 - 1;
+                v3 = v2 + grid->width;
+                v4 = v3 + 1;
+
+                *out++ = v2;
+                *out++ = v3;
+                *out++ = v1;
+
+                *out++ = v1;
+                *out++ = v3;
+                *out++ = v4;
+            }
+        }
+        break;
+    case SF_TRIANGLES:
+        tri = (srfTriangles_t *)data;
+        for ( i = 0; i < tri->numIndexes; i++ ) {
+            *out++ = firstVertex + tri->indexes[i];
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+=================
+R_StyleDependentSurface
+=================
+*/
+static qboolean R_StyleDependentSurface( const msurface_t *surf ) {
+    return *surf->data != SF_FACE && surf->shader->lightmapIndex[0] == LIGHTMAP_BY_VERTEX
+        && surf->shader->styles[0] == 0;
+}
+
+/*
+=================
+R_CompareVBOSurfaces
+
+Keeps surfaces that batch together next to each other in the
+buffer so their index ranges can be merged into one draw.
+=================
+*/
+static int R_CompareVBOSurfaces( const void *a, const void *b ) {
+    const msurface_t    *sa = *(const msurface_t **)a;
+    const msurface_t    *sb = *(const msurface_t **)b;
+
+    if ( sa->shader->index != sb->shader->index ) {
+        return sa->shader->index - sb->shader->index;
+    }
+    if ( sa->fogIndex != sb->fogIndex ) {
+        return sa->fogIndex - sb->fogIndex;
+    }
+    return sa - sb;
+}
+
+/*
+=================
+R_CreateWorldVBO
+
+Called at the end of RE_LoadWorldMap, after patches have been stitched.
+=================
+*/
+void R_CreateWorldVBO( void ) {
+    world_t         *w;
+    msurface_t      *surf;
+    msurface_t      **list;
+    surfaceVBO_t    *vbo;
+    worldVBOVert_t  *verts;
+    glIndex_t       *indexes;
+    int             numSurfs, numVerts, numIndexes;
+    int             surfVerts, surfIndexes;
+    int             i;
+
+    R_DeleteWorldVBO();
+    s_numStyleSurfaces = 0;
+
+    w = tr.world;
+    if ( !w ) {
+        return;
+    }
+
+    // the hunk is zero filled, so mark everything as not buffered first
+    for ( i = 0, surf = w->surfaces; i < w->numsurfaces; i++, surf++ ) {
+        vbo = R_SurfaceVBO( surf->data );
+        if ( vbo ) {
+            vbo->firstIndex = -1;
+        }
+    }
+
+    if ( !r_worldVBO->integer || !qglGenBuffers ) {
+        return;
+    }
+
+    list = ri.Hunk_AllocateTempMemory( w->numsurfaces * sizeof( *list ) );
+
+    numSurfs = numVerts = numIndexes = 0;
+    for ( i = 0, surf = w->surfaces; i < w->numsurfaces; i++, surf++ ) {
+        if ( !R_SurfaceVBO( surf->data ) || !surf->shader || surf->shader->worldVBO == WVBO_NONE ) {
+            continue;
+        }
+        if ( !R_SurfaceVBOCounts( surf->data, &surfVerts, &surfIndexes ) ) {
+            continue;
+        }
+        list[numSurfs++] = surf;
+        numVerts += surfVerts;
+        numIndexes += surfIndexes;
+    }
+
+    if ( !numSurfs ) {
+        ri.Hunk_FreeTempMemory( list );
+        return;
+    }
+
+    qsort( list, numSurfs, sizeof( *list ), R_CompareVBOSurfaces );
+
+    verts = ri.Hunk_AllocateTempMemory( numVerts * sizeof( *verts ) );
+    indexes = ri.Hunk_AllocateTempMemory( numIndexes * sizeof( *indexes ) );
+
+    numVerts = numIndexes = 0;
+    for ( i = 0; i < numSurfs; i++ ) {
+        surf = list[i];
+        vbo = R_SurfaceVBO( surf->data );
+        R_SurfaceVBOCounts( surf->data, &surfVerts, &surfIndexes );
+
+        vbo->firstVertex = numVerts;
+        vbo->numVertexes = surfVerts;
+        vbo->firstIndex = numIndexes;
+        vbo->numIndexes = surfIndexes;
+        vbo->opaqueAlpha = R_FillSurfaceVBOVerts( surf, verts + numVerts );
+        R_FillSurfaceVBOIndexes( surf->data, numVerts, indexes + numIndexes );
+
+        if ( R_StyleDependentSurface( surf ) ) {
+            s_numStyleSurfaces++;
+        }
+
+        numVerts += surfVerts;
+        numIndexes += surfIndexes;
+    }
+
+    tr.worldVBOStyleColor = *(int *)styleColors[0];
+
+    qglGenBuffers( 1, &tr.worldVBO );
+    qglBindBuffer( GL_ARRAY_BUFFER, tr.worldVBO );
+    qglBufferData( GL_ARRAY_BUFFER, numVerts * sizeof( *verts ), verts, GL_STATIC_DRAW );
+    qglBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+    qglGenBuffers( 1, &tr.worldIBO );
+    qglBindBuffer( GL_ELEMENT_ARRAY_BUFFER, tr.worldIBO );
+    qglBufferData( GL_ELEMENT_ARRAY_BUFFER, numIndexes * sizeof( *indexes ), indexes, GL_STATIC_DRAW );
+    qglBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+
+    ri.Hunk_FreeTempMemory( indexes );
+    ri.Hunk_FreeTempMemory( verts );
+    ri.Hunk_FreeTempMemory( list );
+
+    ri.Printf( PRINT_ALL, "...world VBO: %i surfaces, %i verts, %i indexes, %i KB\n", numSurfs, numVerts, numIndexes,
+        (int)( ( numVerts * sizeof( worldVBOVert_t ) + numIndexes * sizeof( glIndex_t ) ) / 1024 ) );
+}
+
+/*
+=================
+R_DeleteWorldVBO
+=================
+*/
+void R_DeleteWorldVBO( void ) {
+    if ( tr.worldVBO ) {
+        qglDeleteBuffers( 1, &tr.worldVBO );
+        tr.worldVBO = 0;
+    }
+    if ( tr.worldIBO ) {
+        qglDeleteBuffers( 1, &tr.worldIBO );
+        tr.worldIBO = 0;
+    }
+}
+
+/*
+=================
+R_UpdateWorldVBOStyle
+
+Vertex lit soups and grids scale their colors by light style 0,
+rebake them when the game changes it.
+=================
+*/
+static void R_UpdateWorldVBOStyle( void ) {
+    msurface_t      *surf;
+    surfaceVBO_t    *vbo;
+    worldVBOVert_t  *verts;
+    int             maxVerts;
+    int             i;
+
+    tr.worldVBOStyleColor = *(int *)styleColors[0];
+
+    if ( !s_numStyleSurfaces ) {
+        return;
+    }
+
+    maxVerts = 0;
+    for ( i = 0, surf = tr.world->surfaces; i < tr.world->numsurfaces; i++, surf++ ) {
+        vbo = R_SurfaceVBO( surf->data );
+        if ( vbo && vbo->firstIndex >= 0 && R_StyleDependentSurface( surf ) && vbo->numVertexes > maxVerts ) {
+            maxVerts = vbo->numVertexes;
+        }
+    }
+
+    verts = ri.Hunk_AllocateTempMemory( maxVerts * sizeof( *verts ) );
+
+    qglBindBuffer( GL_ARRAY_BUFFER, tr.worldVBO );
+    for ( i = 0, surf = tr.world->surfaces; i < tr.world->numsurfaces; i++, surf++ ) {
+        vbo = R_SurfaceVBO( surf->data );
+        if ( !vbo || vbo->firstIndex < 0 || !R_StyleDependentSurface( surf ) ) {
+            continue;
+        }
+        R_FillSurfaceVBOVerts( surf, verts );
+        qglBufferSubData( GL_ARRAY_BUFFER, vbo->firstVertex * sizeof( *verts ),
+            vbo->numVertexes * sizeof( *verts ), verts );
+    }
+    qglBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+    ri.Hunk_FreeTempMemory( verts );
+}
+
+/*
+=================
+R_CheckWorldVBOStyle
+
+Called by the front end for every scene with the world in it,
+the rebake allocates temp memory so it can't run on the render thread.
+=================
+*/
+void R_CheckWorldVBOStyle( void ) {
+    if ( !tr.worldVBO || *(int *)styleColors[0] == tr.worldVBOStyleColor ) {
+        return;
+    }
+
+    R_SyncRenderThread();
+    R_UpdateWorldVBOStyle();
+}
+
+/*
+=================
+RB_WorldVBOUsable
+
+Called by RB_BeginSurface to decide if surfaces of this batch
+may be taken from the world buffer.
+=================
+*/
+qboolean RB_WorldVBOUsable( const shader_t *shader, int fogNum ) {
+    if ( !tr.worldVBO || !r_worldVBO->integer || !tr.world ) {
+        return qfalse;
+    }
+
+    // surface colors were baked for the shader the map asked for
+    if ( shader->remappedShader || shader->worldVBO == WVBO_NONE ) {
+        return qfalse;
+    }
+
+    // fog and these color modes are all computed per vertex
+    if ( fogNum || r_greyscale->value || tr.visualOverlay == VO_NIGHTVISION ) {
+        return qfalse;
+    }
+
+    // the debugging primitive modes need client side arrays
+    if ( r_primitives->integer != 0 && r_primitives->integer != 2 ) {
+        return qfalse;
+    }
+
+    if ( backEnd.projection2D ) {
+        return qfalse;
+    }
+
+    // changed after this scene was set up, the buffer is stale
+    if ( *(int *)styleColors[0] != tr.worldVBOStyleColor ) {
+        return qfalse;
+    }
+
+    return qtrue;
+}
+
+/*
+=================
+RB_AddWorldVBOSurface
+
+Queues the index range of a static surface instead of copying it
+into tess.  Returns qfalse if the caller has to tesselate it.
+=================
+*/
+qboolean RB_AddWorldVBOSurface( const surfaceVBO_t *vbo, int dlightBits ) {
+    vboRange_t  *range;
+
+    if ( !tess.useWorldVBO || vbo->firstIndex < 0 ) {
+        return qfalse;
+    }
+
+    // dynamic lights are projected from the tess vertexes
+    if ( dlightBits && tess.shader->sort <= SS_OPAQUE
+        && !( tess.shader->surfaceFlags & ( SURF_NODLIGHT | SURF_SKY ) ) ) {
+        return qfalse;
+    }
+
+    if ( tess.shader->worldVBO == WVBO_OPAQUE_ALPHA && !vbo->opaqueAlpha ) {
+        return qfalse;
+    }
+
+    if ( tess.numVBORanges ) {
+        range = &tess.vboRanges[tess.numVBORanges - 1];
+        if ( range->firstIndex + range->numIndexes == vbo->firstIndex ) {
+            range->numIndexes += vbo->numIndexes;
+            return qtrue;
+        }
+    }
+
+    if ( tess.numVBORanges == SHADER_MAX_VBO_RANGES ) {
+        RB_EndSurface();
+        RB_BeginSurface( tess.shader, tess.fogNum );
+    }
+
+    range = &tess.vboRanges[tess.numVBORanges++];
+    range->firstIndex = vbo->firstIndex;
+    range->numIndexes = vbo->numIndexes;
+
+    return qtrue;
+}
+
+/*
+=================
+RB_CompareVBORanges
+=================
+*/
+static int RB_CompareVBORanges( const void *a, const void *b ) {
+    return ( (const vboRange_t *)a )->firstIndex - ( (const vboRange_t *)b )->firstIndex;
+}
+
+/*
+=================
+RB_MergeVBORanges
+
+Surfaces arrive in BSP order, sorting them by buffer position
+lets neighbours from the same shader group collapse into one draw.
+=================
+*/
+static int RB_MergeVBORanges( void ) {
+    vboRange_t  *in, *out;
+    int         numIndexes;
+    int         i;
+
+    if ( tess.numVBORanges > 1 ) {
+        qsort( tess.vboRanges, tess.numVBORanges, sizeof( tess.vboRanges[0] ), RB_CompareVBORanges );
+    }
+
+    out = tess.vboRanges;
+    numIndexes = out->numIndexes;
+    for ( i = 1, in = tess.vboRanges + 1; i < tess.numVBORanges; i++, in++ ) {
+        numIndexes += in->numIndexes;
+        if ( out->firstIndex + out->numIndexes == in->firstIndex ) {
+            out->numIndexes += in->numIndexes;
+        } else {
+            *++out = *in;
+        }
+    }
+    tess.numVBORanges = out - tess.vboRanges + 1;
+
+    return numIndexes;
+}
+
+/*
+=================
+RB_DrawWorldVBORanges
+=================
+*/
+static void RB_DrawWorldVBORanges( void ) {
+    vboRange_t  *range;
+    int         i;
+
+    for ( i = 0, range = tess.vboRanges; i < tess.numVBORanges; i++, range++ ) {
+        qglDrawElements( GL_TRIANGLES, range->numIndexes, GL_INDEX_TYPE,
+            BUFFER_OFFSET( range->firstIndex * sizeof( glIndex_t ) ) );
+    }
+}
+
+/*
+=================
+RB_WorldVBOTexCoords
+=================
+*/
+static void RB_WorldVBOTexCoords( textureBundle_t *bundle ) {
+    int     st;
+
+    switch ( bundle->tcGen ) {
+    case TCGEN_LIGHTMAP:
+        st = 1;
+        break;
+    case TCGEN_LIGHTMAP1:
+        st = 2;
+        break;
+    case TCGEN_LIGHTMAP2:
+        st = 3;
+        break;
+    case TCGEN_LIGHTMAP3:
+        st = 4;
+        break;
+    default:
+        st = 0;
+        break;
+    }
+
+    qglTexCoordPointer( 2, GL_FLOAT, sizeof( worldVBOVert_t ),
+        BUFFER_OFFSET( offsetof( worldVBOVert_t, st ) + st * sizeof( vec2_t ) ) );
+}
+
+/*
+=================
+RB_WorldVBOColors
+
+The fixed function counterpart of ComputeColors for the
+rgbGen / alphaGen pairs R_ShaderWorldVBOMode accepts.
+=================
+*/
+static void RB_WorldVBOColors( shaderStage_t *pStage ) {
+    byte    color[4];
+    int     offset;
+
+    offset = -1;
+
+    switch ( pStage->rgbGen ) {
+    case CGEN_IDENTITY_LIGHTING:
+        color[0] = color[1] = color[2] = color[3] = tr.identityLightByte;
+        break;
+    case CGEN_CONST:
+        *(int *)color = *(int *)pStage->constantColor;
+        break;
+    case CGEN_LIGHTMAP1:
+    case CGEN_LIGHTMAP2:
+    case CGEN_LIGHTMAP3:
+        *(int *)color = *(int *)styleColors[pStage->lightmapStyle];
+        break;
+    case CGEN_EXACT_VERTEX:
+        offset = offsetof( worldVBOVert_t, color );
+        break;
+    case CGEN_VERTEX:
+        if ( tr.identityLight == 1 ) {
+            offset = offsetof( worldVBOVert_t, color );
+        } else {
+            offset = offsetof( worldVBOVert_t, colorScaled );
+        }
+        break;
+    default:
+        color[0] = color[1] = color[2] = color[3] = 255;
+        break;
+    }
+
+    switch ( pStage->alphaGen ) {
+    case AGEN_IDENTITY:
+        color[3] = 255;
+        break;
+    case AGEN_CONST:
+        color[3] = pStage->constantColor[3];
+        break;
+    case AGEN_VERTEX:
+        if ( offset < 0 ) {
+            offset = offsetof( worldVBOVert_t, color );
+        }
+        break;
+    default:
+        break;
+    }
+
+    if ( offset >= 0 ) {
+        qglEnableClientState( GL_COLOR_ARRAY );
+        qglColorPointer( 4, GL_UNSIGNED_BYTE, sizeof( worldVBOVert_t ), BUFFER_OFFSET( offset ) );
+    } else {
+        qglDisableClientState( GL_COLOR_ARRAY );
+        qglColor4ubv( color );
+    }
+}
+
+/*
+=================
+RB_StageIteratorWorldVBO
+
+RB_StageIteratorGeneric for the queued world buffer ranges.
+=================
+*/
+void RB_StageIteratorWorldVBO( void ) {
+    shader_t        *shader;
+    shaderStage_t   *pStage;
+    qboolean        multitextured;
+    int             numIndexes;
+    int             stage;
+
+    shader = tess.shader;
+
+    numIndexes = RB_MergeVBORanges();
+    backEnd.pc.c_indexes += numIndexes;
+    backEnd.pc.c_totalIndexes += numIndexes * tess.numPasses;
+
+    if ( r_logFile->integer ) {
+        GLimp_LogComment( va("--- RB_StageIteratorWorldVBO( %s ) ---\n", shader->name) );
+    }
+
+    GL_Cull( shader->cullType );
+
+    if ( shader->polygonOffset ) {
+        qglEnable( GL_POLYGON_OFFSET_FILL );
+        qglPolygonOffset( r_offsetFactor->value, r_offsetUnits->value );
+    }
+
+    qglBindBuffer( GL_ARRAY_BUFFER, tr.worldVBO );
+    qglBindBuffer( GL_ELEMENT_ARRAY_BUFFER, tr.worldIBO );
+
+    qglVertexPointer( 3, GL_FLOAT, sizeof( worldVBOVert_t ), BUFFER_OFFSET( offsetof( worldVBOVert_t, xyz ) ) );
+    qglEnableClientState( GL_TEXTURE_COORD_ARRAY );
+
+    multitextured = qfalse;
+
+    for ( stage = 0; stage < MAX_SHADER_STAGES; stage++ ) {
+        pStage = tess.xstages[stage];
+        if ( !pStage ) {
+            break;
+        }
+
+        RB_WorldVBOColors( pStage );
+
+        if ( pStage->bundle[1].image[0] != 0 ) {
+            // same as DrawMultitextured
+            GL_State( pStage->stateBits );
+
+            if ( backEnd.viewParms.isPortal ) {
+                qglPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
+            }
+
+            GL_SelectTexture( 0 );
+            RB_WorldVBOTexCoords( &pStage->bundle[0] );
+            R_BindAnimatedImage( &pStage->bundle[0] );
+
+            GL_SelectTexture( 1 );
+            qglEnable( GL_TEXTURE_2D );
+            qglEnableClientState( GL_TEXTURE_COORD_ARRAY );
+
+            if ( r_lightmap->integer ) {
+                GL_TexEnv( GL_REPLACE );
+            } else {
+                GL_TexEnv( shader->multitextureEnv );
+            }
+
+            RB_WorldVBOTexCoords( &pStage->bundle[1] );
+            R_BindAnimatedImage( &pStage->bundle[1] );
+
+            RB_DrawWorldVBORanges();
+
+            qglDisable( GL_TEXTURE_2D );
+            GL_SelectTexture( 0 );
+
+            multitextured = qtrue;
+        } else {
+            RB_WorldVBOTexCoords( &pStage->bundle[0] );
+            R_BindAnimatedImage( &pStage->bundle[0] );
+            GL_State( pStage->stateBits );
+
+            RB_DrawWorldVBORanges();
+        }
+
+        // allow skipping out to show just lightmaps during development
+        if ( r_lightmap->integer && ( pStage->bundle[0].isLightmap || pStage->bundle[1].isLightmap ) ) {
+            break;
+        }
+    }
+
+    if ( r_showtris->integer ) {
+        GL_Bind( tr.whiteImage );
+        qglColor3f( 1, 1, 1 );
+        GL_State( GLS_POLYMODE_LINE | GLS_DEPTHMASK_TRUE );
+        qglDepthRange( 0, 0 );
+        qglDisableClientState( GL_COLOR_ARRAY );
+        qglDisableClientState( GL_TEXTURE_COORD_ARRAY );
+
+        RB_DrawWorldVBORanges();
+
+        qglDepthRange( 0, 1 );
+    }
+
+    qglBindBuffer( GL_ARRAY_BUFFER, 0 );
+    qglBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+
+    // the rest of the back end expects client side array pointers
+    qglVertexPointer( 3, GL_FLOAT, 16, tess.xyz );
+    qglColorPointer( 4, GL_UNSIGNED_BYTE, 0, tess.svars.colors );
+    if ( multitextured ) {
+        GL_SelectTexture( 1 );
+        qglTexCoordPointer( 2, GL_FLOAT, 0, tess.svars.texcoords[1] );
+        GL_SelectTexture( 0 );
+    }
+    qglTexCoordPointer( 2, GL_FLOAT, 0, tess.svars.texcoords[0] );
+
+    if ( shader->polygonOffset ) {
+        qglDisable( GL_POLYGON_OFFSET_FILL );
+    }
+}
@@ -107,7 +107,7 @@ void RB_MistyFogEffectUpdate(worldEffectSystem_t *weSystem, worldEffect_t *effec
     int                 x, y;
 
     mistyFogEffect = (mistyFogEffect_t *)effect;
-    originContents = ri.CM_PointContents(backEnd.viewParms.or.origin, 0);
+    originContents = R_WorldEffectPointContents(backEnd.viewParms.or.origin);
 
     if(originContents & CONTENTS_OUTSIDE && !(originContents & CONTENTS_WATER)){
         if(mistyFogEffect->fadeAlpha < 1.0f){
@@ -274,80 +274,6 @@ void RB_MistyFogEffectRender(worldEffectSystem_t *weSystem, worldEffect_t *effec
     qglEnable(GL_TEXTURE_2D);
 }
 
-/*
-=============================================
------------
-Wind effect
------------
-=============================================
-*/
-
-/*
-==================
-RB_WindEffectUpdate
-
-Updates any particles of the parent
-world effect system that are affected
-by this wind effect.
-==================
-*/
-
-void RB_WindEffectUpdate(worldEffectSystem_t *weSystem, worldEffect_t *effect, float elapsedTime)
-{
-    windEffect_t            *windEffect;
-    worldEffectParticle_t   *item;
-    vec3_t                  difference;
-    float                   dist, calcDist;
-    float                   scaleLength;
-    int                     i, j;
-
-    windEffect = (windEffect_t *)effect;
-
-    // Only update if this effect is currently enabled in the parent world effect system.
-    if(!windEffect->isEnabled){
-        return;
-    }
-
-    // Calculate total distance between the wind effect origin
-    // and the current player position.
-    VectorSubtract(backEnd.viewParms.or.origin, windEffect->point, difference);
-    if(VectorLength(difference) > 300.0f){
-        // This effect instance is too far away to impact any
-        // of the particles that are currently rendering.
-        return;
-    }
-
-    calcDist = 0.0f;
-    for(i = 0; i < weSystem->numParticles; i++){
-        item = &weSystem->particleList[i];
-
-        if(windEffect->affectedParticles[i]){
-            windEffect->affectedParticles[i]--;
-        }else{
-            if(!windEffect->isGlobal){
-                for(j = 0; j < windEffect->numPlanes; j++){
-                    dist = DotProduct(item->pos, windEffect->planes[j]) - windEffect->planes[j][3];
-
-                    if(dist < 0.01f || dist > windEffect->maxDistance[j]){
-                        break;
-                    }else if(j == 0){
-                        calcDist = dist;
-                    }
-                }
-
-                if(j != windEffect->numPlanes){
-                    continue;
-                }
-            }
-
-            scaleLength = 1.0f - (calcDist / windEffect->maxDistance[0]);
-
-            windEffect->affectedParticles[i] = windEffect->affectedDuration * scaleLength;
-            VectorMA(item->velocity, elapsedTime, windEffect->velocity, item->velocity);
-        }
-    }
-}
-
 /*
 =============================================
 -----------
@@ -373,91 +299,6 @@ void RB_LoadRainImage(rainSystem_t *rainSystem, const char *fileName)
     qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 }
 
-/*
-==================
-RB_RainSystemUpdate
-
-Checks the current player position and
-updates the rain effect system and all
-of its particles accordingly, also
-taking wind in account.
-==================
-*/
-
-void RB_RainSystemUpdate(worldEffectSystem_t *weSystem, float elapsedTime)
-{
-    rainSystem_t            *rainSystem;
-    worldEffectParticle_t   *item;
-    vec3_t                  windDifference;
-    int                     originContents;
-    int                     i, j;
-
-    rainSystem      = (rainSystem_t *)weSystem;
-    originContents  = ri.CM_PointContents(backEnd.viewParms.or.origin, 0);
-
-    rainSystem->windChange--;
-    if(rainSystem->windChange < 0){
-        rainSystem->windNewDirection[0] = flrand(-1.0f, 1.0f);
-        rainSystem->windNewDirection[1] = flrand(-1.0f, 1.0f);
-        rainSystem->windNewDirection[2] = 0.0f;
-
-        VectorNormalize(rainSystem->windNewDirection);
-
-        rainSystem->windChange = irand(200, 450);
-
-        // Update wind direction for all misty fog effect images.
-        R_UpdateMistyFogWindDirection(weSystem, rainSystem->windDirection);
-    }
-
-    // Set wind direction.
-    VectorSubtract(rainSystem->windNewDirection, rainSystem->windDirection, windDifference);
-    VectorMA(rainSystem->windDirection, elapsedTime, windDifference, rainSystem->windDirection);
-
-    // Update all effects if we are rendering.
-    if(weSystem->isRendering){
-        R_UpdateWorldEffects(weSystem, elapsedTime);
-    }
-
-    if(originContents & CONTENTS_OUTSIDE && !(originContents & CONTENTS_WATER)){
-        rainSystem->base.isRendering = qtrue;
-
-        if(rainSystem->fadeAlpha < 1.0f){
-            // Player just went outside, fade in rain.
-            rainSystem->fadeAlpha += elapsedTime / 2.0f;
-        }else if(rainSystem->fadeAlpha > 1.0f){
-            rainSystem->fadeAlpha = 1.0f;
-        }
-    }else{
-        if(rainSystem->fadeAlpha > 0.0f){
-            // Player just went inside, fade out rain.
-            rainSystem->fadeAlpha -= elapsedTime / 2.0f;
-        }else if(rainSystem->fadeAlpha <= 0.0f){
-            // No need to continue here as the player is (still) inside
-            // and the rain is already fully faded out.
-            rainSystem->base.isRendering = qfalse;
-            return;
-        }
-    }
-
-    //
-    // Re-determine particile positions.
-    //
-    for(i = 0; i < weSystem->numParticles; i++){
-        item = &weSystem->particleList[i];
-
-        VectorMA(item->pos, elapsedTime, item->velocity, item->pos);
-        if(item->pos[2] < -rainSystem->spread[2]){
-            item->pos[0] = flrand(0.0f, rainSystem->spread[0]);
-            item->pos[1] = flrand(0.0f, rainSystem->spread[1]);
-            item->pos[2] = 40.0f;
-
-            for(j = 0; j < 3; j++){
-                item->velocity[j] = flrand(rainSystem->minVelocity[j], rainSystem->maxVelocity[j]);
-            }
-        }
-    }
-}
-
 /*
 ==================
 RB_RainSystemRender
@@ -469,11 +310,12 @@ Renders all rain particles.
 void RB_RainSystemRender(worldEffectSystem_t *weSystem)
 {
     rainSystem_t            *rainSystem;
-    worldEffectParticle_t   *item;
+    worldEffectParticles_t  *particles;
     vec4_t                  left, down;
     int                     i;
 
-    rainSystem = (rainSystem_t *)weSystem;
+    rainSystem  = (rainSystem_t *)weSystem;
+    particles   = &weSystem->particles;
 
     // Only render the player is currently outside
     // or if the effect is currently fading out.
@@ -502,11 +344,10 @@ void RB_RainSystemRender(worldEffectSystem_t *weSystem)
         float   radius, alpha;
         vec3_t  pos;
 
-        item    = &weSystem->particleList[i];
-        radius  = item->pos[1];
+        radius  = particles->pos[1][i];
 
-        if(item->pos[2] < 0.0f){
-            alpha = rainSystem->alpha * (item->pos[1] / -item->pos[2]);
+        if(particles->pos[2][i] < 0.0f){
+            alpha = rainSystem->alpha * (particles->pos[1][i] / -particles->pos[2][i]);
 
             if(alpha > rainSystem->alpha){
                 alpha = rainSystem->alpha;
@@ -517,9 +358,9 @@ void RB_RainSystemRender(worldEffectSystem_t *weSystem)
             qglColor4f(1.0f, 1.0f, 1.0f, rainSystem->alpha * rainSystem->fadeAlpha);
         }
 
-        pos[0] = sin(item->pos[0]) * radius + (item->pos[2] * rainSystem->windDirection[0] * rainSystem->windAngle);
-        pos[1] = cos(item->pos[0]) * radius + (item->pos[2] * rainSystem->windDirection[1] * rainSystem->windAngle);
-        pos[2] = item->pos[2];
+        pos[0] = sin(particles->pos[0][i]) * radius + (particles->pos[2][i] * rainSystem->windDirection[0] * rainSystem->windAngle);
+        pos[1] = cos(particles->pos[0][i]) * radius + (particles->pos[2][i] * rainSystem->windDirection[1] * rainSystem->windAngle);
+        pos[2] = particles->pos[2][i];
 
         qglTexCoord2f(1.0f, 0.0f);
         qglVertex3f(pos[0],
@@ -550,218 +391,6 @@ Snow system
 =============================================
 */
 
-/*
-==================
-RB_SnowSystemUpdate
-
-Checks player surroundings and updates
-particles accordingly.
-
-This can result in new particles being
-rendered, particles already rendering
-being updated to new positions or even
-particles not being rendered anymore
-(e.g. out of area or particles no
-longer outside).
-==================
-*/
-
-void RB_SnowSystemUpdate(worldEffectSystem_t *weSystem, float elapsedTime)
-{
-    snowSystem_t            *snowSystem;
-    windEffect_t            *windGust;
-    worldEffectParticle_t   *item;
-    vec3_t                  origin, difference;
-    vec3_t                  newMins, newMaxs;
-    vec3_t                  start;
-    qboolean                changePos;
-    int                     i;
-    int                     x, y, z;
-
-    snowSystem  = (snowSystem_t *)weSystem;
-    windGust    = (windEffect_t *)R_GetWorldEffect(weSystem, "wind");
-
-    snowSystem->windChange--;
-    if(snowSystem->windChange < 0){
-        snowSystem->windDirection[0] = flrand(-1.0f, 1.0f);
-        snowSystem->windDirection[1] = flrand(-1.0f, 1.0f);
-        snowSystem->windDirection[2] = 0.0f;
-
-        VectorNormalize(snowSystem->windDirection);
-
-        snowSystem->windChange = irand(200, 450);
-
-        // Update wind direction for all misty fog effect images.
-        R_UpdateMistyFogWindDirection(weSystem, snowSystem->windDirection);
-    }
-
-    // Update all effects if we are rendering.
-    if(weSystem->isRendering){
-        R_UpdateWorldEffects(weSystem, elapsedTime);
-    }
-
-    VectorCopy(backEnd.viewParms.or.origin, origin);
-
-    // Check when the next wind gust should occur.
-    snowSystem->nextWindGust -= elapsedTime;
-    if(snowSystem->nextWindGust < 0){
-        // There is currently no wind, disable the effect temporarily.
-        windGust->isEnabled = qfalse;
-    }
-
-    if(snowSystem->nextWindGust < snowSystem->windLowSize){
-        vec3_t  windDirection;
-        vec3_t  windPos;
-
-        windDirection[0] = flrand(-1.0f, 1.0f);
-        windDirection[1] = flrand(-1.0f, 1.0f);
-        windDirection[2] = 0.0f;
-
-        VectorNormalize(windDirection);
-        VectorScale(windDirection, flrand(snowSystem->windMin, snowSystem->windMax), windDirection);
-
-        VectorCopy(origin, windPos);
-
-        // Update the global wind effect with the new parameters.
-        windGust->isEnabled = qtrue;
-        R_UpdateWindParams(windGust, windPos, windDirection, snowSystem->windSize);
-
-        snowSystem->nextWindGust = flrand(snowSystem->windDuration, snowSystem->windDuration * 2.0f);
-        snowSystem->windLowSize = -flrand(snowSystem->windLow, snowSystem->windLow * 3.0f);
-    }
-
-    VectorAdd(snowSystem->minSpread, origin, newMins);
-    VectorAdd(snowSystem->maxSpread, origin, newMaxs);
-
-    changePos = qfalse;
-    for(i = 0; i < 3; i++){
-        difference[i] = newMaxs[i] - snowSystem->maxs[i];
-
-        if(difference[i] >= 0.0f){
-            if(difference[i] > newMaxs[i] - newMins[i]){
-                difference[i] = newMaxs[i] - newMins[i];
-            }
-
-            start[i] = newMaxs[i] - difference[i];
-        }else{
-            if(difference[i] < newMins[i] - newMaxs[i]){
-                difference[i] = newMins[i] - newMaxs[i];
-            }
-
-            start[i] = newMins[i] - difference[i];
-        }
-
-        if(!changePos && fabs(difference[i]) > 25.0f){
-            changePos = qtrue;
-        }
-    }
-
-    //
-    // Re-determine particile positions.
-    //
-    if(changePos){
-        int         *store;
-        int         contentsPos, contents;
-        vec3_t      pos;
-        qboolean    resetFlake;
-
-        for(i = 0; i < 3; i++){
-            contentsPos = (origin[i] + snowSystem->minSpread[i]) / snowSystem->contentsSize[i];
-            snowSystem->contentsStart[i] = contentsPos * snowSystem->contentsSize[i];
-        }
-
-        snowSystem->overallContents = 0;
-        store = (int *)snowSystem->contents;
-
-        for(z = 0, pos[2] = snowSystem->contentsStart[2]; z < SNOWCONTENTS_Z_SIZE; z++, pos[2] += snowSystem->contentsSize[2]){
-            for(y = 0, pos[1] = snowSystem->contentsStart[1]; y < SNOWCONTENTS_Y_SIZE; y++, pos[1] += snowSystem->contentsSize[1]){
-                for(x = 0, pos[0] = snowSystem->contentsStart[0]; x < SNOWCONTENTS_X_SIZE; x++, pos[0] += snowSystem->contentsSize[0]){
-                    contents = ri.CM_PointContents(pos, 0);
-                    snowSystem->overallContents |= contents;
-                    *store++ = contents;
-                }
-            }
-        }
-
-        for(i = 0; i < weSystem->numParticles; i++){
-            item        = &weSystem->particleList[i];
-            resetFlake  = qfalse;
-
-            for(x = 0; x < 3; x++){
-                if(item->pos[x] < newMins[x] || item->pos[x] > newMaxs[x]){
-                    item->pos[x] = flrand(0.0f, difference[x]) + start[x];
-                    resetFlake = qtrue;
-                }
-            }
-
-            if(resetFlake){
-                item->velocity[0] = 0.0f;
-                item->velocity[1] = 0.0f;
-                item->velocity[2] = flrand(snowSystem->maxVelocity[2], snowSystem->minVelocity[2]);
-            }
-        }
-
-        VectorCopy(newMins, snowSystem->mins);
-        VectorCopy(newMaxs, snowSystem->maxs);
-    }
-
-    // No need to render or update any particle as none of
-    // the particles are outside.
-    if(!(snowSystem->overallContents & CONTENTS_OUTSIDE)){
-        weSystem->isRendering = qfalse;
-        return;
-    }
-
-    weSystem->isRendering = qtrue;
-
-    for(i = 0; i < weSystem->numParticles; i++){
-        item = &weSystem->particleList[i];
-
-        for(x = 0; x < 2; x++){
-            if(item->velocity[x] < snowSystem->minVelocity[x]){
-                item->velocity[x] += snowSystem->velocityStabilize * elapsedTime;
-            }else if(item->velocity[x] > snowSystem->maxVelocity[x]){
-                item->velocity[x] -= snowSystem->velocityStabilize * elapsedTime;
-            }else{
-                item->velocity[x] += flrand(-1.4f, 1.4f);
-            }
-        }
-
-        if(item->velocity[2] > snowSystem->minVelocity[2]){
-            item->velocity[2] -= snowSystem->velocityStabilize * 2.0f;
-        }
-
-        VectorMA(item->pos, elapsedTime, item->velocity, item->pos);
-
-        // Check if we should render this snowflake.
-        x = (item->pos[0] - snowSystem->contentsStart[0]) / snowSystem->contentsSize[0];
-        y = (item->pos[1] - snowSystem->contentsStart[1]) / snowSystem->contentsSize[1];
-        z = (item->pos[2] - snowSystem->contentsStart[2]) / snowSystem->contentsSize[2];
-
-        if(x < 0 || x >= SNOWCONTENTS_X_SIZE ||
-           y < 0 || y >= SNOWCONTENTS_Y_SIZE ||
-           z < 0 || z >= SNOWCONTENTS_Z_SIZE
-        ){
-            item->pos[0] = flrand(newMins[0], newMaxs[0]);
-            item->pos[1] = flrand(newMins[1], newMaxs[1]);
-            item->pos[2] = newMaxs[2] - (newMins[2] - item->pos[2]);
-            if(item->pos[2] < newMins[2] || item->pos[2] > newMaxs[2]){
-                // Way out of range.
-                item->pos[2] = flrand(newMins[2], newMaxs[2]);
-            }
-
-            item->velocity[0] = 0.0f;
-            item->velocity[1] = 0.0f;
-            item->velocity[2] = flrand(snowSystem->maxVelocity[2], snowSystem->minVelocity[2]);
-            item->flags &= ~PARTICLE_FLAG_RENDER;
-        }else if(snowSystem->contents[z][y][x] & CONTENTS_OUTSIDE){
-            item->flags |= PARTICLE_FLAG_RENDER;
-        }else{
-            item->flags &= ~PARTICLE_FLAG_RENDER;
-        }
-    }
-}
-
 /*
 ==================
 RB_SnowSystemRender
@@ -775,13 +404,14 @@ rendered.
 void RB_SnowSystemRender(worldEffectSystem_t *weSystem)
 {
     snowSystem_t            *snowSystem;
-    worldEffectParticle_t   *item;
+    worldEffectParticles_t  *particles;
     int                     i;
     static float            snowAttenuation[3] = {
         1.0f, 0.0f, 0.0004f
     };
 
-    snowSystem = (snowSystem_t *)weSystem;
+    snowSystem  = (snowSystem_t *)weSystem;
+    particles   = &weSystem->particles;
 
     // Only render if any particle is currently outside.
     if(!weSystem->isRendering){
@@ -807,10 +437,8 @@ void RB_SnowSystemRender(worldEffectSystem_t *weSystem)
     qglBegin(GL_POINTS);
 
     for(i = 0; i < weSystem->numParticles; i++){
-        item = &weSystem->particleList[i];
-
-        if(item->flags & PARTICLE_FLAG_RENDER){
-            qglVertex3fv(item->pos);
+        if(particles->flags[i] & PARTICLE_FLAG_RENDER){
+            qglVertex3f(particles->pos[0][i], particles->pos[1][i], particles->pos[2][i]);
         }
     }
 
@@ -845,5 +473,5 @@ void RB_RenderWorldEffectSystems(void)
 
     // Let the world effect system handler update
     // and render all systems initialized.
-    R_RenderWorldEffectSystems(tr.refdef.frameTime * 0.001);
+    R_RenderWorldEffectSystems(tr.refdef.frameTime * 0.001, backEnd.viewParms.or.origin);
 }
@@ -180,7 +180,7 @@ static int R_DlightFace( srfSurfaceFace_t *face, int dlightBits ) {
         tr.pc.c_dlightSurfacesCulled++;
     }
 
-    face->dlightBits = dlightBits;
+    face->dlightBits[tr.smpFrame] = dlightBits;
     return dlightBits;
 }
 
@@ -208,14 +208,14 @@ static int R_DlightGrid( srfGridMesh_t *grid, int dlightBits ) {
         tr.pc.c_dlightSurfacesCulled++;
     }
 
-    grid->dlightBits = dlightBits;
+    grid->dlightBits[tr.smpFrame] = dlightBits;
     return dlightBits;
 }
 
 
 static int R_DlightTrisurf( srfTriangles_t *surf, int dlightBits ) {
     // FIXME: more dlight culling to trisurfs...
-    surf->dlightBits = dlightBits;
+    surf->dlightBits[tr.smpFrame] = dlightBits;
     return dlightBits;
 #if 0
     int         i;
@@ -241,7 +241,7 @@ static int R_DlightTrisurf( srfTriangles_t *surf, int dlightBits ) {
         tr.pc.c_dlightSurfacesCulled++;
     }
 
-    grid->dlightBits = dlightBits;
+    grid->dlightBits[tr.smpFrame] = dlightBits;
     return dlightBits;
 #endif
 }
@@ -493,6 +493,192 @@ static void R_RecursiveWorldNode( mnode_t *node, unsigned int planeBits, unsigne
 }
 
 
+/*
+================
+R_CullBoxes
+
+Frustum tests count boxes stored as separate mins and maxs arrays,
+setting visible[i] for the ones that aren't completely outside.
+There are no early outs so the compiler can vectorize the loop.
+================
+*/
+static void R_CullBoxes( float * const bounds[6], int count, byte *visible ) {
+    const float *px[4], *py[4], *pz[4];
+    vec3_t      normal[4];
+    float       dist[4];
+    int         i, p;
+
+    if ( r_nocull->integer ) {
+        Com_Memset( visible, 1, count );
+        return;
+    }
+
+    // test the corner of each box that is furthest along the plane normal
+    for ( p = 0 ; p < 4 ; p++ ) {
+        cplane_t    *frust = &tr.viewParms.frustum[p];
+
+        VectorCopy( frust->normal, normal[p] );
+        dist[p] = frust->dist;
+
+        px[p] = frust->normal[0] >= 0 ? bounds[3] : bounds[0];
+        py[p] = frust->normal[1] >= 0 ? bounds[4] : bounds[1];
+        pz[p] = frust->normal[2] >= 0 ? bounds[5] : bounds[2];
+    }
+
+    for ( i = 0 ; i < count ; i++ ) {
+        float   d0, d1, d2, d3;
+
+        d0 = normal[0][0] * px[0][i] + normal[0][1] * py[0][i] + normal[0][2] * pz[0][i] - dist[0];
+        d1 = normal[1][0] * px[1][i] + normal[1][1] * py[1][i] + normal[1][2] * pz[1][i] - dist[1];
+        d2 = normal[2][0] * px[2][i] + normal[2][1] * py[2][i] + normal[2][2] * pz[2][i] - dist[2];
+        d3 = normal[3][0] * px[3][i] + normal[3][1] * py[3][i] + normal[3][2] * pz[3][i] - dist[3];
+
+        visible[i] = ( d0 >= 0 ) & ( d1 >= 0 ) & ( d2 >= 0 ) & ( d3 >= 0 );
+    }
+}
+
+/*
+================
+R_AddSurfaceOccluder
+
+Rasterizes large faces and triangle soups from the vis list into the
+occlusion buffer, faces only when they face the view
+================
+*/
+static void R_AddSurfaceOccluder( visList_t *vl, int index ) {
+    msurface_t  *surf = vl->surfaces[index];
+    int         i;
+
+    for ( i = 0 ; i < 3 ; i++ ) {
+        if ( vl->surfaceBounds[i + 3][index] - vl->surfaceBounds[i][index] >= OCC_OCCLUDER_SIZE ) {
+            break;
+        }
+    }
+    if ( i == 3 ) {
+        return;
+    }
+
+    if ( !R_ShaderIsOccluder( surf->shader ) ) {
+        return;
+    }
+
+    switch ( *surf->data ) {
+    case SF_FACE:
+        {
+            srfSurfaceFace_t *face = (srfSurfaceFace_t *)surf->data;
+            float d = DotProduct( tr.viewParms.or.origin, face->plane.normal ) - face->plane.dist;
+
+            if ( surf->shader->cullType == CT_FRONT_SIDED && d < 0 ) {
+                return;
+            }
+            if ( surf->shader->cullType == CT_BACK_SIDED && d > 0 ) {
+                return;
+            }
+
+            R_OcclusionAddTriangles( face->points[0], sizeof( face->points[0] ),
+                (int *)( (byte *)face + face->ofsIndices ), face->numIndices );
+        }
+        break;
+    case SF_TRIANGLES:
+        {
+            srfTriangles_t *tris = (srfTriangles_t *)surf->data;
+
+            R_OcclusionAddTriangles( tris->verts[0].xyz, sizeof( tris->verts[0] ), tris->indexes, tris->numIndexes );
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+================
+R_AddVisListSurfaces
+
+Adds the surfaces of the current pvs from the flat list built by
+R_MarkLeaves, dlights are tested against each surface's bounds
+instead of being split down the nodes
+================
+*/
+static void R_AddVisListSurfaces( void ) {
+    visList_t   *vl;
+    int         i, j;
+
+    vl = &tr.world->visList;
+
+    // the leafs only matter for the z buffer bounds now
+    R_CullBoxes( vl->leafBounds, vl->numLeafs, vl->visible );
+    for ( i = 0 ; i < vl->numLeafs ; i++ ) {
+        if ( !vl->visible[i] ) {
+            continue;
+        }
+
+        tr.pc.c_leafs++;
+        AddPointToBounds( vl->leafs[i]->mins, tr.viewParms.visBounds[0], tr.viewParms.visBounds[1] );
+        AddPointToBounds( vl->leafs[i]->maxs, tr.viewParms.visBounds[0], tr.viewParms.visBounds[1] );
+    }
+
+    R_CullBoxes( vl->surfaceBounds, vl->numSurfaces, vl->visible );
+
+    // draw the occluders in the frustum before testing anything against them
+    if ( R_OcclusionActive() ) {
+        for ( i = 0 ; i < vl->numSurfaces ; i++ ) {
+            if ( vl->visible[i] ) {
+                R_AddSurfaceOccluder( vl, i );
+            }
+        }
+
+        R_OcclusionFinishOccluders( r_occlusionDebug->integer != 0 );
+    }
+
+    for ( i = 0 ; i < vl->numSurfaces ; i++ ) {
+        int     dlightBits;
+
+        if ( !vl->visible[i] ) {
+            continue;
+        }
+
+        if ( R_OcclusionActive() ) {
+            vec3_t  mins, maxs;
+
+            for ( j = 0 ; j < 3 ; j++ ) {
+                mins[j] = vl->surfaceBounds[j][i];
+                maxs[j] = vl->surfaceBounds[j + 3][i];
+            }
+
+            if ( R_OcclusionCullBox( mins, maxs ) ) {
+                tr.pc.c_occluded++;
+                continue;
+            }
+        }
+
+        dlightBits = 0;
+        for ( j = 0 ; j < tr.refdef.num_dlights ; j++ ) {
+            dlight_t    *dl = &tr.refdef.dlights[j];
+            float       d, distSquared;
+            int         k;
+
+            distSquared = 0;
+            for ( k = 0 ; k < 3 ; k++ ) {
+                if ( dl->origin[k] < vl->surfaceBounds[k][i] ) {
+                    d = vl->surfaceBounds[k][i] - dl->origin[k];
+                    distSquared += d * d;
+                } else if ( dl->origin[k] > vl->surfaceBounds[k + 3][i] ) {
+                    d = dl->origin[k] - vl->surfaceBounds[k + 3][i];
+                    distSquared += d * d;
+                }
+            }
+
+            if ( distSquared < dl->radius * dl->radius ) {
+                dlightBits |= ( 1 << j );
+            }
+        }
+
+        R_AddWorldSurface( vl->surfaces[i], dlightBits );
+    }
+}
+
+
 /*
 ===============
 R_PointInLeaf
@@ -556,18 +742,69 @@ qboolean R_inPVS( const vec3_t p1, const vec3_t p2 ) {
     return qtrue;
 }
 
+/*
+===============
+R_AddLeafToVisList
+
+Marks the leaf and its parents for R_RecursiveWorldNode and
+appends it and its new surfaces to the flat lists
+===============
+*/
+static void R_AddLeafToVisList( mnode_t *leaf ) {
+    visList_t   *vl;
+    mnode_t     *parent;
+    msurface_t  *surf, **mark;
+    float       *bounds;
+    int         i, n;
+
+    parent = leaf;
+    do {
+        if (parent->visframe == tr.visCount)
+            break;
+        parent->visframe = tr.visCount;
+        parent = parent->parent;
+    } while (parent);
+
+    vl = &tr.world->visList;
+
+    n = vl->numLeafs++;
+    vl->leafs[n] = leaf;
+    for ( i = 0 ; i < 3 ; i++ ) {
+        vl->leafBounds[i][n] = leaf->mins[i];
+        vl->leafBounds[i + 3][n] = leaf->maxs[i];
+    }
+
+    for ( mark = leaf->firstmarksurface ; mark < leaf->firstmarksurface + leaf->nummarksurfaces ; mark++ ) {
+        surf = *mark;
+
+        // the surface may be in several visible leafs
+        if ( surf->visCount == tr.visCount ) {
+            continue;
+        }
+        surf->visCount = tr.visCount;
+
+        bounds = tr.world->surfaceBounds[( surf - tr.world->surfaces ) * 2];
+
+        n = vl->numSurfaces++;
+        vl->surfaces[n] = surf;
+        for ( i = 0 ; i < 6 ; i++ ) {
+            vl->surfaceBounds[i][n] = bounds[i];
+        }
+    }
+}
+
 /*
 ===============
 R_MarkLeaves
 
 Mark the leaves and nodes that are in the PVS for the current
-cluster
+cluster and collect them with their surfaces in tr.world->visList
 ===============
 */
 static void R_MarkLeaves (void) {
     const byte  *vis;
-    mnode_t *leaf, *parent;
-    int     i;
+    mnode_t *leaf;
+    int     i, j;
     int     cluster;
 
     // lockpvs lets designers walk around to determine the
@@ -599,40 +836,45 @@ static void R_MarkLeaves (void) {
     tr.visCount++;
     tr.viewCluster = cluster;
 
+    tr.world->visList.numLeafs = 0;
+    tr.world->visList.numSurfaces = 0;
+
     if ( r_novis->integer || tr.viewCluster == -1 ) {
         for (i=0 ; i<tr.world->numnodes ; i++) {
             if (tr.world->nodes[i].contents != CONTENTS_SOLID) {
                 tr.world->nodes[i].visframe = tr.visCount;
             }
         }
+        for (i=tr.world->numDecisionNodes ; i<tr.world->numnodes ; i++) {
+            if (tr.world->nodes[i].contents != CONTENTS_SOLID) {
+                R_AddLeafToVisList( &tr.world->nodes[i] );
+            }
+        }
         return;
     }
 
     vis = R_ClusterPVS (tr.viewCluster);
 
-    for (i=0,leaf=tr.world->nodes ; i<tr.world->numnodes ; i++, leaf++) {
-        cluster = leaf->cluster;
-        if ( cluster < 0 || cluster >= tr.world->numClusters ) {
+    for (cluster=0 ; cluster<tr.world->numClusters ; cluster++) {
+        // check general pvs, a byte at a time where it is empty
+        if ( !vis[cluster>>3] ) {
+            cluster |= 7;
             continue;
         }
-
-        // check general pvs
         if ( !(vis[cluster>>3] & (1<<(cluster&7))) ) {
             continue;
         }
 
-        // check for door connection
-        if ( (tr.refdef.areamask[leaf->area>>3] & (1<<(leaf->area&7)) ) ) {
-            continue;       // not visible
-        }
+        for (j=tr.world->clusterFirstLeaf[cluster] ; j<tr.world->clusterFirstLeaf[cluster+1] ; j++) {
+            leaf = &tr.world->nodes[tr.world->clusterLeafs[j]];
 
-        parent = leaf;
-        do {
-            if (parent->visframe == tr.visCount)
-                break;
-            parent->visframe = tr.visCount;
-            parent = parent->parent;
-        } while (parent);
+            // check for door connection
+            if ( (tr.refdef.areamask[leaf->area>>3] & (1<<(leaf->area&7)) ) ) {
+                continue;       // not visible
+            }
+
+            R_AddLeafToVisList( leaf );
+        }
     }
 }
 
@@ -643,6 +885,9 @@ R_AddWorldSurfaces
 =============
 */
 void R_AddWorldSurfaces (void) {
+    // entities are only tested in views that drew occluders
+    R_OcclusionEndView();
+
     if ( !r_drawworld->integer ) {
         return;
     }
@@ -664,5 +909,13 @@ void R_AddWorldSurfaces (void) {
     if ( tr.refdef.num_dlights > MAX_DLIGHTS ) {
         tr.refdef.num_dlights = MAX_DLIGHTS ;
     }
-    R_RecursiveWorldNode( tr.world->nodes, 15, ( 1ULL << tr.refdef.num_dlights ) - 1 );
+    if ( r_worldVisLists->integer ) {
+        if ( r_occlusion->integer && !r_nocull->integer && !tr.viewParms.isPortal ) {
+            R_OcclusionBeginView( tr.viewParms.or.origin, tr.viewParms.or.axis, tr.viewParms.fovX, tr.viewParms.fovY );
+        }
+
+        R_AddVisListSurfaces();
+    } else {
+        R_RecursiveWorldNode( tr.world->nodes, 15, ( 1ULL << tr.refdef.num_dlights ) - 1 );
+    }
 }
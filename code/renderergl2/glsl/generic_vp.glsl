@@ -16,11 +16,26 @@ attribute vec4 attr_TexCoord0;
 attribute vec4 attr_TexCoord1;
 #endif
 
+#if defined(USE_INSTANCING)
+// rows of the model matrix, then lighting, one set per entity
+attribute vec4 attr_InstanceMatrix0;
+attribute vec4 attr_InstanceMatrix1;
+attribute vec4 attr_InstanceMatrix2;
+attribute vec4 attr_InstanceViewOrigin;
+attribute vec4 attr_InstanceAmbientLight;
+attribute vec4 attr_InstanceDirectedLight;
+attribute vec4 attr_InstanceLightDir;
+#endif
+
 uniform vec4   u_DiffuseTexMatrix;
 uniform vec4   u_DiffuseTexOffTurb;
 
 #if defined(USE_TCGEN) || defined(USE_RGBAGEN)
+  #if defined(USE_INSTANCING)
+#define u_LocalViewOrigin attr_InstanceViewOrigin.xyz
+  #else
 uniform vec3   u_LocalViewOrigin;
+  #endif
 #endif
 
 #if defined(USE_TCGEN)
@@ -42,6 +57,7 @@ uniform float  u_DeformParams[5];
 uniform float  u_Time;
 #endif
 
+// view projection only when instancing
 uniform mat4   u_ModelViewProjectionMatrix;
 uniform vec4   u_BaseColor;
 uniform vec4   u_VertColor;
@@ -49,9 +65,15 @@ uniform vec4   u_VertColor;
 #if defined(USE_RGBAGEN)
 uniform int    u_ColorGen;
 uniform int    u_AlphaGen;
+  #if defined(USE_INSTANCING)
+#define u_AmbientLight  attr_InstanceAmbientLight.rgb
+#define u_DirectedLight attr_InstanceDirectedLight.rgb
+#define u_ModelLightDir (attr_InstanceLightDir * InstanceMatrix()).xyz
+  #else
 uniform vec3   u_AmbientLight;
 uniform vec3   u_DirectedLight;
 uniform vec3   u_ModelLightDir;
+  #endif
 uniform float  u_PortalRange;
 #endif
 
@@ -64,6 +86,16 @@ uniform mat4 u_BoneMatrix[MAX_GLSL_BONES];
 varying vec2   var_DiffuseTex;
 varying vec4   var_Color;
 
+#if defined(USE_INSTANCING)
+mat4 InstanceMatrix()
+{
+	return mat4(attr_InstanceMatrix0.x, attr_InstanceMatrix1.x, attr_InstanceMatrix2.x, 0.0,
+	            attr_InstanceMatrix0.y, attr_InstanceMatrix1.y, attr_InstanceMatrix2.y, 0.0,
+	            attr_InstanceMatrix0.z, attr_InstanceMatrix1.z, attr_InstanceMatrix2.z, 0.0,
+	            attr_InstanceMatrix0.w, attr_InstanceMatrix1.w, attr_InstanceMatrix2.w, 1.0);
+}
+#endif
+
 #if defined(USE_DEFORM_VERTEXES)
 vec3 DeformPosition(const vec3 pos, const vec3 normal, const vec2 st)
 {
@@ -227,7 +259,11 @@ void main()
 	position = DeformPosition(position, normal, attr_TexCoord0.st);
 #endif
 
+#if defined(USE_INSTANCING)
+	gl_Position = u_ModelViewProjectionMatrix * (InstanceMatrix() * vec4(position, 1.0));
+#else
 	gl_Position = u_ModelViewProjectionMatrix * vec4(position, 1.0);
+#endif
 
 #if defined(USE_TCGEN)
 	vec2 tex = GenTexCoords(u_TCGen0, position, normal, u_TCGen0Vector0, u_TCGen0Vector1);
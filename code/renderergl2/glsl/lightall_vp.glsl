@@ -1,9 +1,11 @@
 attribute vec4 attr_TexCoord0;
 #if defined(USE_LIGHTMAP) || defined(USE_TCGEN)
 attribute vec4 attr_TexCoord1;
+  #if !defined(USE_INSTANCING)
 attribute vec4 attr_TexCoord2;
 attribute vec4 attr_TexCoord3;
 attribute vec4 attr_TexCoord4;
+  #endif
 #endif
 attribute vec4 attr_Color;
 
@@ -24,6 +26,17 @@ attribute vec4 attr_BoneWeights;
 attribute vec3 attr_LightDirection;
 #endif
 
+#if defined(USE_INSTANCING)
+// rows of the model matrix, then lighting, one set per entity
+attribute vec4 attr_InstanceMatrix0;
+attribute vec4 attr_InstanceMatrix1;
+attribute vec4 attr_InstanceMatrix2;
+attribute vec4 attr_InstanceViewOrigin;
+attribute vec4 attr_InstanceAmbientLight;
+attribute vec4 attr_InstanceDirectedLight;
+attribute vec4 attr_InstanceLightDir;
+#endif
+
 #if defined(USE_DELUXEMAP)
 uniform vec4   u_EnableTextures; // x = normal, y = deluxe, z = specular, w = cube
 #endif
@@ -36,7 +49,11 @@ uniform vec3   u_ViewOrigin;
 uniform int    u_TCGen0;
 uniform vec3   u_TCGen0Vector0;
 uniform vec3   u_TCGen0Vector1;
+  #if defined(USE_INSTANCING)
+#define u_LocalViewOrigin attr_InstanceViewOrigin.xyz
+  #else
 uniform vec3   u_LocalViewOrigin;
+  #endif
 #endif
 
 #if defined(USE_TCMOD)
@@ -44,11 +61,14 @@ uniform vec4   u_DiffuseTexMatrix;
 uniform vec4   u_DiffuseTexOffTurb;
 #endif
 
+// view projection only when instancing
 uniform mat4   u_ModelViewProjectionMatrix;
 uniform vec4   u_BaseColor;
 uniform vec4   u_VertColor;
 
-#if defined(USE_MODELMATRIX)
+#if defined(USE_INSTANCING)
+#define u_ModelMatrix InstanceMatrix()
+#elif defined(USE_MODELMATRIX)
 uniform mat4   u_ModelMatrix;
 #endif
 
@@ -59,10 +79,16 @@ uniform mat4 u_BoneMatrix[MAX_GLSL_BONES];
 #endif
 
 #if defined(USE_LIGHT_VECTOR)
+  #if defined(USE_INSTANCING)
+#define u_LightOrigin   attr_InstanceLightDir
+#define u_DirectedLight attr_InstanceDirectedLight.rgb
+#define u_AmbientLight  attr_InstanceAmbientLight.rgb
+  #else
 uniform vec4   u_LightOrigin;
-uniform float  u_LightRadius;
 uniform vec3   u_DirectedLight;
 uniform vec3   u_AmbientLight;
+  #endif
+uniform float  u_LightRadius;
 #endif
 
 #if defined(USE_PRIMARY_LIGHT) || defined(USE_SHADOWMAP)
@@ -91,6 +117,16 @@ varying vec4   var_LightDir;
 varying vec4   var_PrimaryLightDir;
 #endif
 
+#if defined(USE_INSTANCING)
+mat4 InstanceMatrix()
+{
+	return mat4(attr_InstanceMatrix0.x, attr_InstanceMatrix1.x, attr_InstanceMatrix2.x, 0.0,
+	            attr_InstanceMatrix0.y, attr_InstanceMatrix1.y, attr_InstanceMatrix2.y, 0.0,
+	            attr_InstanceMatrix0.z, attr_InstanceMatrix1.z, attr_InstanceMatrix2.z, 0.0,
+	            attr_InstanceMatrix0.w, attr_InstanceMatrix1.w, attr_InstanceMatrix2.w, 1.0);
+}
+#endif
+
 #if defined(USE_TCGEN)
 vec2 GenTexCoords(int TCGen, vec3 position, vec3 normal, vec3 TCGenVector0, vec3 TCGenVector1)
 {
@@ -100,6 +136,7 @@ vec2 GenTexCoords(int TCGen, vec3 position, vec3 normal, vec3 TCGenVector0, vec3
         case TCGEN_LIGHTMAP:
             tex = attr_TexCoord1.st;
             break;
+#if !defined(USE_INSTANCING)
         case TCGEN_LIGHTMAP1:
             tex = attr_TexCoord2.st;
             break;
@@ -109,6 +146,7 @@ vec2 GenTexCoords(int TCGen, vec3 position, vec3 normal, vec3 TCGenVector0, vec3
         case TCGEN_LIGHTMAP3:
             tex = attr_TexCoord4.st;
             break;
+#endif
         case TCGEN_ENVIRONMENT_MAPPED:
             vec3 viewer = normalize(u_LocalViewOrigin - position);
             vec2 ref = reflect(viewer, normal).yz;
@@ -201,7 +239,11 @@ void main()
 	var_TexCoords.xy = texCoords;
 #endif
 
+#if defined(USE_INSTANCING)
+	gl_Position = u_ModelViewProjectionMatrix * (u_ModelMatrix * vec4(position, 1.0));
+#else
 	gl_Position = u_ModelViewProjectionMatrix * vec4(position, 1.0);
+#endif
 
 #if defined(USE_MODELMATRIX)
 	position  = (u_ModelMatrix * vec4(position, 1.0)).xyz;
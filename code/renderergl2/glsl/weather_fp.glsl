@@ -0,0 +1,18 @@
+uniform vec4      u_Color;
+
+#if defined(USE_RAIN)
+uniform sampler2D u_DiffuseMap;
+
+varying vec2      var_Tex1;
+varying float     var_Alpha;
+#endif
+
+
+void main()
+{
+#if defined(USE_RAIN)
+	gl_FragColor = texture2D(u_DiffuseMap, var_Tex1) * vec4(u_Color.rgb, var_Alpha);
+#else
+	gl_FragColor = u_Color;
+#endif
+}
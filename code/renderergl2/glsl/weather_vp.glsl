@@ -0,0 +1,56 @@
+attribute vec3  attr_Position;
+
+attribute float attr_ParticleX;
+attribute float attr_ParticleY;
+attribute float attr_ParticleZ;
+#if defined(USE_SNOW)
+attribute float attr_ParticleFlags;
+#endif
+
+uniform mat4    u_ModelViewProjectionMatrix;
+uniform vec3    u_ViewLeft;
+uniform vec3    u_ViewUp;
+uniform vec4    u_Color;
+
+#if defined(USE_RAIN)
+uniform vec3    u_ViewOrigin;
+uniform vec2    u_WeatherWind;
+uniform vec3    u_WeatherDown;
+
+varying vec2    var_Tex1;
+varying float   var_Alpha;
+#endif
+
+
+void main()
+{
+#if defined(USE_RAIN)
+	// raindrops are kept as angle and distance around the viewer,
+	// leaning with the wind as they fall
+	vec3 position = vec3(sin(attr_ParticleX), cos(attr_ParticleX), 0.0) * attr_ParticleY;
+	position += vec3(u_WeatherWind, 1.0) * attr_ParticleZ;
+
+	// streak from the drop, one unit of each corner axis long
+	position += u_ViewLeft * attr_Position.x + u_WeatherDown * attr_Position.y;
+
+	gl_Position = u_ModelViewProjectionMatrix * vec4(u_ViewOrigin + position, 1.0);
+	var_Tex1 = vec2(1.0 - attr_Position.x, attr_Position.y);
+
+	// fade out the drops below and close to the viewer
+	var_Alpha = u_Color.a;
+	if (attr_ParticleZ < 0.0)
+		var_Alpha *= min(1.0, attr_ParticleY / -attr_ParticleZ);
+#else
+	// collapse the flakes that aren't outside
+	if (mod(attr_ParticleFlags, 2.0) < 0.5)
+	{
+		gl_Position = vec4(0.0);
+		return;
+	}
+
+	vec3 position = vec3(attr_ParticleX, attr_ParticleY, attr_ParticleZ);
+	position += u_ViewLeft * attr_Position.x + u_ViewUp * attr_Position.y;
+
+	gl_Position = u_ModelViewProjectionMatrix * vec4(position, 1.0);
+#endif
+}
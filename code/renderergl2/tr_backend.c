@@ -417,6 +417,148 @@ void RB_BeginDrawingView (void) {
 }
 
 
+/*
+==================
+RB_ShaderCanInstance
+
+Every stage has to pick its per-entity values from the instance attribs
+==================
+*/
+static qboolean RB_ShaderCanInstance( shader_t *shader ) {
+    int     stage;
+
+    if ( shader->numDeforms || shader->entityMergable ) {
+        return qfalse;
+    }
+
+    for ( stage = 0; stage < MAX_SHADER_STAGES; stage++ ) {
+        shaderStage_t *pStage = shader->stages[stage];
+        int lightType;
+
+        if ( !pStage || !pStage->active ) {
+            break;
+        }
+
+        if ( pStage->glslShaderGroup == tr.lightallShader ) {
+            lightType = pStage->glslShaderIndex & LIGHTDEF_LIGHTTYPE_MASK;
+            if ( lightType == LIGHTDEF_USE_LIGHTMAP || lightType == LIGHTDEF_USE_LIGHT_VERTEX ) {
+                return qfalse;
+            }
+        }
+    }
+
+    return qtrue;
+}
+
+/*
+==================
+RB_EntitiesCanInstance
+
+Anything a stage reads that isn't in mdvInstance_t has to match
+==================
+*/
+static qboolean RB_EntitiesCanInstance( trRefEntity_t *a, trRefEntity_t *b ) {
+    if ( ( a->e.renderfx | b->e.renderfx ) & RF_DEPTHHACK ) {
+        return qfalse;
+    }
+
+    if ( a->e.frame != b->e.frame || a->e.oldframe != b->e.oldframe ) {
+        return qfalse;
+    }
+
+    if ( a->e.frame != a->e.oldframe && a->e.backlerp != b->e.backlerp ) {
+        return qfalse;
+    }
+
+    if ( a->mirrored != b->mirrored || a->e.shaderTime != b->e.shaderTime ) {
+        return qfalse;
+    }
+
+    if ( memcmp( a->e.shaderRGBA, b->e.shaderRGBA, sizeof( a->e.shaderRGBA ) )
+        || a->e.shaderTexCoord[0] != b->e.shaderTexCoord[0] || a->e.shaderTexCoord[1] != b->e.shaderTexCoord[1] ) {
+        return qfalse;
+    }
+
+    return qtrue;
+}
+
+/*
+==================
+RB_SetMdvInstance
+==================
+*/
+static void RB_SetMdvInstance( trRefEntity_t *ent, mdvInstance_t *instance ) {
+    orientationr_t  or;
+    int             i;
+
+    R_RotateForEntity( ent, &backEnd.viewParms, &or );
+
+    for ( i = 0; i < 3; i++ ) {
+        instance->modelMatrix[i][0] = or.transformMatrix[i];
+        instance->modelMatrix[i][1] = or.transformMatrix[i + 4];
+        instance->modelMatrix[i][2] = or.transformMatrix[i + 8];
+        instance->modelMatrix[i][3] = or.transformMatrix[i + 12];
+    }
+
+    VectorCopy( or.viewOrigin, instance->localViewOrigin );
+    instance->localViewOrigin[3] = 1.0f;
+
+    VectorScale( ent->ambientLight, 1.0f / 255.0f, instance->ambientLight );
+    instance->ambientLight[3] = 1.0f;
+
+    VectorScale( ent->directedLight, 1.0f / 255.0f, instance->directedLight );
+    instance->directedLight[3] = 1.0f;
+
+    VectorCopy( ent->lightDir, instance->lightDir );
+    instance->lightDir[3] = 0.0f;
+}
+
+/*
+==================
+RB_GatherMdvInstances
+
+Collects the draw surfaces following drawSurfs[0] that only differ
+from it in their entity, so one instanced draw can replace them all.
+Returns the number of surfaces covered, 1 if there is nothing to merge.
+==================
+*/
+static int RB_GatherMdvInstances( drawSurf_t *drawSurfs, int numDrawSurfs ) {
+    trRefEntity_t   *first, *ent;
+    unsigned        entityMask;
+    int             entityNum;
+    int             numInstances;
+
+    entityMask = REFENTITYNUM_MASK << QSORT_REFENTITYNUM_SHIFT;
+    first = backEnd.currentEntity;
+
+    for ( numInstances = 1; numInstances < numDrawSurfs && numInstances < MAX_MDV_INSTANCES; numInstances++ ) {
+        drawSurf_t *drawSurf = &drawSurfs[numInstances];
+
+        if ( drawSurf->surface != drawSurfs[0].surface || drawSurf->cubemapIndex != drawSurfs[0].cubemapIndex
+            || ( drawSurf->sort & ~entityMask ) != ( drawSurfs[0].sort & ~entityMask ) ) {
+            break;
+        }
+
+        entityNum = ( drawSurf->sort >> QSORT_REFENTITYNUM_SHIFT ) & REFENTITYNUM_MASK;
+        if ( entityNum == REFENTITYNUM_WORLD ) {
+            break;
+        }
+
+        ent = &backEnd.refdef.entities[entityNum];
+        if ( !RB_EntitiesCanInstance( first, ent ) ) {
+            break;
+        }
+
+        RB_SetMdvInstance( ent, &backEnd.mdvInstances[numInstances] );
+    }
+
+    if ( numInstances > 1 ) {
+        RB_SetMdvInstance( first, &backEnd.mdvInstances[0] );
+    }
+
+    return numInstances;
+}
+
 /*
 ==================
 RB_RenderDrawSurfList
@@ -581,6 +723,31 @@ void RB_RenderDrawSurfList( drawSurf_t *drawSurfs, int numDrawSurfs ) {
             oldEntityNum = entityNum;
         }
 
+        // draw this md3 surface for all the entities that follow
+        // with it in one go
+        if ( *drawSurf->surface == SF_VAO_MDVMESH && tr.mdvInstancesVBO && entityNum != REFENTITYNUM_WORLD
+            && !fogNum && !dlighted && !pshadowed && !oldDepthRange
+            && !( backEnd.viewParms.flags & ( VPF_SHADOWMAP | VPF_DEPTHSHADOW ) ) && RB_ShaderCanInstance( shader ) ) {
+            int numInstances = RB_GatherMdvInstances( drawSurf, numDrawSurfs - i );
+
+            if ( numInstances > 1 ) {
+                backEnd.numMdvInstances = numInstances;
+                rb_surfaceTable[ *drawSurf->surface ]( drawSurf->surface );
+                backEnd.numMdvInstances = 0;
+
+                backEnd.pc.c_mdvInstanceDraws++;
+                backEnd.pc.c_mdvInstances += numInstances;
+
+                i += numInstances - 1;
+                drawSurf += numInstances - 1;
+
+                // the next surface has to set up its entity again
+                oldSort = -1;
+                oldEntityNum = -1;
+                continue;
+            }
+        }
+
         // add the triangles for this surface
         rb_surfaceTable[ *drawSurf->surface ]( drawSurf->surface );
     }
@@ -783,33 +950,88 @@ const void  *RB_SetColor( const void *data ) {
     return (const void *)(cmd + 1);
 }
 
+/*
+============================================================================
+
+2D BATCHING
+
+Stretch pics are collected until a command other than a color change
+or another pic comes along.  A pic joins the most recent batch with the
+same shader unless it overlaps a pic of a batch in between, so the
+screen looks the same as if the pics were drawn in order.
+
+============================================================================
+*/
+
+#define MAX_2D_PICS             4096
+#define MAX_2D_BATCHES          512
+#define MAX_2D_MERGE_DEPTH      16      // batches a pic can be moved in front of
+#define MAX_2D_OVERLAP_TESTS    64      // larger batches are only tested by their bounds
+
+typedef struct {
+    float       x, y, w, h;
+    float       s1, t1, s2, t2;
+    float       mins[2], maxs[2];
+    byte        color[4];
+    int         next;                   // next pic of the batch, -1 if last
+} pic2D_t;
+
+typedef struct {
+    shader_t    *shader;
+    float       mins[2], maxs[2];
+    int         firstPic, lastPic;
+    int         numPics;
+} batch2D_t;
+
+static pic2D_t      r2DPics[MAX_2D_PICS];
+static batch2D_t    r2DBatches[MAX_2D_BATCHES];
+static int          r2DNumPics;
+static int          r2DNumBatches;
+
 /*
 =============
-RB_StretchPic
+RB_2DBoundsOverlap
 =============
 */
-const void *RB_StretchPic ( const void *data ) {
-    const stretchPicCommand_t   *cmd;
-    shader_t *shader;
-    int     numVerts, numIndexes;
-
-    cmd = (const stretchPicCommand_t *)data;
+static qboolean RB_2DBoundsOverlap( const float *mins1, const float *maxs1, const float *mins2, const float *maxs2 ) {
+    // pics that only share an edge, like the glyphs of a word, don't overlap
+    return mins1[0] < maxs2[0] && maxs1[0] > mins2[0] && mins1[1] < maxs2[1] && maxs1[1] > mins2[1];
+}
 
-    // FIXME: HUGE hack
-    if (glRefConfig.framebufferObject)
-        FBO_Bind(backEnd.framePostProcessed ? NULL : tr.renderFbo);
+/*
+=============
+RB_2DBatchOverlaps
+=============
+*/
+static qboolean RB_2DBatchOverlaps( const batch2D_t *batch, const pic2D_t *pic ) {
+    const pic2D_t   *other;
+    int             i;
 
-    RB_SetGL2D();
+    if ( !RB_2DBoundsOverlap( batch->mins, batch->maxs, pic->mins, pic->maxs ) ) {
+        return qfalse;
+    }
+    if ( batch->numPics > MAX_2D_OVERLAP_TESTS ) {
+        return qtrue;
+    }
 
-    shader = cmd->shader;
-    if ( shader != tess.shader ) {
-        if ( tess.numIndexes ) {
-            RB_EndSurface();
+    for ( i = batch->firstPic; i != -1; i = other->next ) {
+        other = &r2DPics[i];
+        if ( RB_2DBoundsOverlap( other->mins, other->maxs, pic->mins, pic->maxs ) ) {
+            return qtrue;
         }
-        backEnd.currentEntity = &backEnd.entity2D;
-        RB_BeginSurface( shader, 0, 0 );
     }
 
+    return qfalse;
+}
+
+/*
+=============
+RB_Tess2DPic
+=============
+*/
+static void RB_Tess2DPic( const pic2D_t *pic ) {
+    int     numVerts, numIndexes;
+
     RB_CHECKOVERFLOW( 4, 6 );
     numVerts = tess.numVertexes;
     numIndexes = tess.numIndexes;
@@ -827,7 +1049,7 @@ const void *RB_StretchPic ( const void *data ) {
     {
         uint16_t color[4];
 
-        VectorScale4(backEnd.color2D, 257, color);
+        VectorScale4(pic->color, 257, color);
 
         VectorCopy4(color, tess.color[ numVerts ]);
         VectorCopy4(color, tess.color[ numVerts + 1]);
@@ -835,33 +1057,139 @@ const void *RB_StretchPic ( const void *data ) {
         VectorCopy4(color, tess.color[ numVerts + 3 ]);
     }
 
-    tess.xyz[ numVerts ][0] = cmd->x;
-    tess.xyz[ numVerts ][1] = cmd->y;
+    tess.xyz[ numVerts ][0] = pic->x;
+    tess.xyz[ numVerts ][1] = pic->y;
     tess.xyz[ numVerts ][2] = 0;
 
-    tess.texCoords[ numVerts ][0][0] = cmd->s1;
-    tess.texCoords[ numVerts ][0][1] = cmd->t1;
+    tess.texCoords[ numVerts ][0][0] = pic->s1;
+    tess.texCoords[ numVerts ][0][1] = pic->t1;
 
-    tess.xyz[ numVerts + 1 ][0] = cmd->x + cmd->w;
-    tess.xyz[ numVerts + 1 ][1] = cmd->y;
+    tess.xyz[ numVerts + 1 ][0] = pic->x + pic->w;
+    tess.xyz[ numVerts + 1 ][1] = pic->y;
     tess.xyz[ numVerts + 1 ][2] = 0;
 
-    tess.texCoords[ numVerts + 1 ][0][0] = cmd->s2;
-    tess.texCoords[ numVerts + 1 ][0][1] = cmd->t1;
+    tess.texCoords[ numVerts + 1 ][0][0] = pic->s2;
+    tess.texCoords[ numVerts + 1 ][0][1] = pic->t1;
 
-    tess.xyz[ numVerts + 2 ][0] = cmd->x + cmd->w;
-    tess.xyz[ numVerts + 2 ][1] = cmd->y + cmd->h;
+    tess.xyz[ numVerts + 2 ][0] = pic->x + pic->w;
+    tess.xyz[ numVerts + 2 ][1] = pic->y + pic->h;
     tess.xyz[ numVerts + 2 ][2] = 0;
 
-    tess.texCoords[ numVerts + 2 ][0][0] = cmd->s2;
-    tess.texCoords[ numVerts + 2 ][0][1] = cmd->t2;
+    tess.texCoords[ numVerts + 2 ][0][0] = pic->s2;
+    tess.texCoords[ numVerts + 2 ][0][1] = pic->t2;
 
-    tess.xyz[ numVerts + 3 ][0] = cmd->x;
-    tess.xyz[ numVerts + 3 ][1] = cmd->y + cmd->h;
+    tess.xyz[ numVerts + 3 ][0] = pic->x;
+    tess.xyz[ numVerts + 3 ][1] = pic->y + pic->h;
     tess.xyz[ numVerts + 3 ][2] = 0;
 
-    tess.texCoords[ numVerts + 3 ][0][0] = cmd->s1;
-    tess.texCoords[ numVerts + 3 ][0][1] = cmd->t2;
+    tess.texCoords[ numVerts + 3 ][0][0] = pic->s1;
+    tess.texCoords[ numVerts + 3 ][0][1] = pic->t2;
+}
+
+/*
+=============
+RB_Flush2DPics
+
+Draws the collected stretch pics, one surface per batch
+=============
+*/
+static void RB_Flush2DPics( void ) {
+    const batch2D_t *batch;
+    int             i, j;
+
+    if ( !r2DNumBatches ) {
+        return;
+    }
+
+    // FIXME: HUGE hack
+    if (glRefConfig.framebufferObject)
+        FBO_Bind(backEnd.framePostProcessed ? NULL : tr.renderFbo);
+
+    RB_SetGL2D();
+
+    backEnd.currentEntity = &backEnd.entity2D;
+
+    for ( i = 0, batch = r2DBatches; i < r2DNumBatches; i++, batch++ ) {
+        RB_BeginSurface( batch->shader, 0, 0 );
+
+        for ( j = batch->firstPic; j != -1; j = r2DPics[j].next ) {
+            RB_Tess2DPic( &r2DPics[j] );
+        }
+
+        RB_EndSurface();
+    }
+
+    r2DNumPics = 0;
+    r2DNumBatches = 0;
+}
+
+/*
+=============
+RB_StretchPic
+=============
+*/
+const void *RB_StretchPic ( const void *data ) {
+    const stretchPicCommand_t   *cmd;
+    pic2D_t     *pic;
+    batch2D_t   *batch;
+    int         i;
+
+    cmd = (const stretchPicCommand_t *)data;
+
+    if ( r2DNumPics == MAX_2D_PICS || r2DNumBatches == MAX_2D_BATCHES ) {
+        RB_Flush2DPics();
+    }
+
+    pic = &r2DPics[ r2DNumPics ];
+    pic->x = cmd->x;
+    pic->y = cmd->y;
+    pic->w = cmd->w;
+    pic->h = cmd->h;
+    pic->s1 = cmd->s1;
+    pic->t1 = cmd->t1;
+    pic->s2 = cmd->s2;
+    pic->t2 = cmd->t2;
+    pic->mins[0] = cmd->w < 0 ? cmd->x + cmd->w : cmd->x;
+    pic->mins[1] = cmd->h < 0 ? cmd->y + cmd->h : cmd->y;
+    pic->maxs[0] = pic->mins[0] + fabs( cmd->w );
+    pic->maxs[1] = pic->mins[1] + fabs( cmd->h );
+    *(int *)pic->color = *(int *)backEnd.color2D;
+    pic->next = -1;
+
+    // look for a batch of this shader the pic can join
+    batch = NULL;
+    for ( i = r2DNumBatches - 1; i >= 0 && r2DNumBatches - i <= MAX_2D_MERGE_DEPTH; i-- ) {
+        if ( r2DBatches[i].shader == cmd->shader ) {
+            batch = &r2DBatches[i];
+            break;
+        }
+        if ( RB_2DBatchOverlaps( &r2DBatches[i], pic ) ) {
+            break;
+        }
+    }
+
+    if ( batch ) {
+        r2DPics[ batch->lastPic ].next = r2DNumPics;
+        for ( i = 0; i < 2; i++ ) {
+            if ( pic->mins[i] < batch->mins[i] ) {
+                batch->mins[i] = pic->mins[i];
+            }
+            if ( pic->maxs[i] > batch->maxs[i] ) {
+                batch->maxs[i] = pic->maxs[i];
+            }
+        }
+        batch->numPics++;
+    } else {
+        batch = &r2DBatches[ r2DNumBatches++ ];
+        batch->shader = cmd->shader;
+        batch->firstPic = r2DNumPics;
+        batch->mins[0] = pic->mins[0];
+        batch->mins[1] = pic->mins[1];
+        batch->maxs[0] = pic->maxs[0];
+        batch->maxs[1] = pic->maxs[1];
+        batch->numPics = 1;
+    }
+    batch->lastPic = r2DNumPics++;
 
     return (const void *)(cmd + 1);
 }
@@ -1162,6 +1490,9 @@ const void  *RB_DrawSurfs( const void *data ) {
 
         // add light flares on lights that aren't obscured
         RB_RenderFlares();
+
+        // rain and snow
+        RB_RenderWorldEffectSystems();
     }
 
     if (glRefConfig.framebufferObject && tr.renderCubeFbo && backEnd.viewParms.targetFbo == tr.renderCubeFbo)
@@ -1742,6 +2073,11 @@ void RB_ExecuteRenderCommands( const void *data ) {
     while ( 1 ) {
         data = PADP(data, sizeof(void *));
 
+        // stretch pics are batched until something else is drawn
+        if ( *(const int *)data != RC_SET_COLOR && *(const int *)data != RC_STRETCH_PIC ) {
+            RB_Flush2DPics();
+        }
+
         switch ( *(const int *)data ) {
         case RC_SET_COLOR:
             data = RB_SetColor( data );
@@ -39,6 +39,7 @@ void RE_LoadWorldMap( const char *name );
 
 static  world_t     s_worldData;
 static  byte        *fileBase;
+static  byte        *s_shadersPrefetched;   // world shaders whose images went to R_PrefetchImages
 
 int         c_subdivisions;
 int         c_gridVerts;
@@ -609,6 +610,44 @@ static  void R_LoadVisibility( lump_t *l ) {
 //===============================================================================
 
 
+/*
+===============
+R_PrefetchWorldShaders
+
+Decodes the images of the world shaders from firstShader on,
+skipping the ones already handed over, in one go on the worker
+threads.  Surfaces register their shaders in no particular order,
+so this runs again for the first shader left out.
+===============
+*/
+static void R_PrefetchWorldShaders( int firstShader ) {
+    char        names[MAX_PREFETCH_IMAGES][MAX_QPATH];
+    const char  *namePtrs[MAX_PREFETCH_IMAGES];
+    int         numNames;
+    int         i;
+
+    numNames = 0;
+    for ( i = firstShader; i < s_worldData.numShaders; i++ ) {
+        if ( s_shadersPrefetched[i] ) {
+            continue;
+        }
+
+        // leave room for a shader with several stages
+        if ( numNames > MAX_PREFETCH_IMAGES - 16 ) {
+            break;
+        }
+
+        numNames += R_GetShaderImageNames( s_worldData.shaders[i].shader, names + numNames, MAX_PREFETCH_IMAGES - numNames );
+        s_shadersPrefetched[i] = qtrue;
+    }
+
+    for ( i = 0; i < numNames; i++ ) {
+        namePtrs[i] = names[i];
+    }
+
+    R_PrefetchImages( namePtrs, numNames );
+}
+
 /*
 ===============
 ShaderForShaderNum
@@ -625,6 +664,10 @@ static shader_t *ShaderForShaderNum( int shaderNum, const int *lightmapNum, cons
     }
     dsh = &s_worldData.shaders[ _shaderNum ];
 
+    if ( r_imagePrefetch->integer && !s_shadersPrefetched[ _shaderNum ] ) {
+        R_PrefetchWorldShaders( _shaderNum );
+    }
+
     if(lightmapNum[0] == LIGHTMAP_BY_VERTEX){
         styles = vertexStyles;
     }
@@ -1997,6 +2040,8 @@ static  void R_LoadShaders( lump_t *l ) {
     s_worldData.shaders = out;
     s_worldData.numShaders = count;
 
+    s_shadersPrefetched = ri.Hunk_Alloc( count, h_low );
+
     Com_Memcpy( out, in, count*sizeof(*out) );
 
     for ( i=0 ; i<count ; i++ ) {
@@ -2797,6 +2842,9 @@ void RE_LoadWorldMap( const char *name ) {
     // try will not look at the partially loaded version
     tr.world = NULL;
 
+    // left over from a load that was dropped
+    R_ClearPrefetchedImages();
+
     Com_Memset( &s_worldData, 0, sizeof( s_worldData ) );
     Q_strncpyz( s_worldData.name, name, sizeof( s_worldData.name ) );
 
@@ -2827,6 +2875,7 @@ void RE_LoadWorldMap( const char *name ) {
     R_LoadPlanes (&header->lumps[LUMP_PLANES]);
     R_LoadFogs( &header->lumps[LUMP_FOGS], &header->lumps[LUMP_BRUSHES], &header->lumps[LUMP_BRUSHSIDES] );
     R_LoadSurfaces( &header->lumps[LUMP_SURFACES], &header->lumps[LUMP_DRAWVERTS], &header->lumps[LUMP_DRAWINDEXES] );
+    R_ClearPrefetchedImages();
     R_LoadMarksurfaces (&header->lumps[LUMP_LEAFSURFACES]);
     R_LoadNodesAndLeafs (&header->lumps[LUMP_NODES], &header->lumps[LUMP_LEAFS]);
     R_LoadSubmodels (&header->lumps[LUMP_MODELS]);
@@ -3062,5 +3111,7 @@ void RE_LoadWorldMap( const char *name ) {
         R_RenderMissingCubemaps();
     }
 
+    R_InitWorldEffectContents( s_worldData.name, s_worldData.bmodels[0].bounds[0], s_worldData.bmodels[0].bounds[1] );
+
     ri.FS_FreeFile( buffer.v );
 }
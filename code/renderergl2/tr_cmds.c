@@ -46,6 +46,8 @@ void R_PerformanceCounters( void ) {
         ri.Printf (PRINT_ALL, "(md3) %i sin %i sclip  %i sout %i bin %i bclip %i bout\n",
             tr.pc.c_sphere_cull_md3_in, tr.pc.c_sphere_cull_md3_clip, tr.pc.c_sphere_cull_md3_out,
             tr.pc.c_box_cull_md3_in, tr.pc.c_box_cull_md3_clip, tr.pc.c_box_cull_md3_out );
+        ri.Printf (PRINT_ALL, "(occlusion) %i surfs %i ents\n",
+            tr.pc.c_occluded, tr.pc.c_occludedEntities );
     } else if (r_speeds->integer == 3) {
         ri.Printf (PRINT_ALL, "viewcluster: %i\n", tr.viewCluster );
     } else if (r_speeds->integer == 4) {
@@ -70,6 +72,9 @@ void R_PerformanceCounters( void ) {
             backEnd.pc.c_staticVaoDraws, backEnd.pc.c_dynamicVaoDraws);
         ri.Printf( PRINT_ALL, "GLSL binds: %i  draws: gen %i light %i fog %i dlight %i\n",
             backEnd.pc.c_glslShaderBinds, backEnd.pc.c_genericDraws, backEnd.pc.c_lightallDraws, backEnd.pc.c_fogDraws, backEnd.pc.c_dlightDraws);
+        ri.Printf( PRINT_ALL, "md3 instanced draws: %i instances: %i\n",
+            backEnd.pc.c_mdvInstanceDraws, backEnd.pc.c_mdvInstances);
+        ri.Printf( PRINT_ALL, "tess ring stalls: %i\n", backEnd.pc.c_tessRingStalls);
     }
 
     Com_Memset( &tr.pc, 0, sizeof( tr.pc ) );
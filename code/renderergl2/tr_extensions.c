@@ -104,6 +104,59 @@ void GLimp_InitExtraExtensions(void)
         ri.Printf(PRINT_ALL, result[2], extension);
     }
 
+    // OpenGL 3.3 - GL_ARB_instanced_arrays
+    extension = "GL_ARB_instanced_arrays";
+    glRefConfig.instancedArrays = qfalse;
+    if (QGL_VERSION_ATLEAST(3, 3))
+    {
+        glRefConfig.instancedArrays = !!r_arb_instanced_arrays->integer;
+
+        QGL_ARB_instanced_arrays_PROCS;
+
+        ri.Printf(PRINT_ALL, result[glRefConfig.instancedArrays], extension);
+    }
+    else
+    {
+        ri.Printf(PRINT_ALL, result[2], extension);
+    }
+
+    // OpenGL 4.1 - GL_ARB_get_program_binary
+    extension = "GL_ARB_get_program_binary";
+    glRefConfig.programBinary = qfalse;
+    if (QGL_VERSION_ATLEAST(4, 1) || SDL_GL_ExtensionSupported(extension))
+    {
+        GLint numFormats = 0;
+
+        QGL_ARB_get_program_binary_PROCS;
+
+        // some drivers expose the entry points but support no formats
+        qglGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+        if (numFormats > 0)
+            glRefConfig.programBinary = !!r_arb_get_program_binary->integer;
+
+        ri.Printf(PRINT_ALL, result[numFormats > 0 ? glRefConfig.programBinary : 2], extension);
+    }
+    else
+    {
+        ri.Printf(PRINT_ALL, result[2], extension);
+    }
+
+    // OpenGL 4.4 - GL_ARB_buffer_storage
+    extension = "GL_ARB_buffer_storage";
+    glRefConfig.bufferStorage = qfalse;
+    if (QGL_VERSION_ATLEAST(4, 4) || (QGL_VERSION_ATLEAST(3, 2) && SDL_GL_ExtensionSupported(extension)))
+    {
+        glRefConfig.bufferStorage = !!r_arb_buffer_storage->integer;
+
+        QGL_ARB_buffer_storage_PROCS;
+
+        ri.Printf(PRINT_ALL, result[glRefConfig.bufferStorage], extension);
+    }
+    else
+    {
+        ri.Printf(PRINT_ALL, result[2], extension);
+    }
+
     // OpenGL 3.0 - GL_ARB_texture_float
     extension = "GL_ARB_texture_float";
     glRefConfig.textureFloat = qfalse;
@@ -36,9 +36,11 @@ projected area of the light source.
 A surface that has been flagged as having a light flare will calculate the depth
 buffer value that its midpoint should have when the surface is added.
 
-After all opaque surfaces have been rendered, the depth buffer is read back for
-each flare in view.  If the point has not been obscured by a closer surface, the
-flare should be drawn.
+After all opaque surfaces have been rendered, an occlusion query is issued for
+each flare in view.  Its result is read back a frame or more later, when the GPU
+has finished with it, and if the point has not been obscured by a closer surface,
+the flare should be drawn.  Without occlusion queries the depth buffer is read
+back for each flare instead, which stalls until everything before it is drawn.
 
 Surfaces that have a repeated texture should never be flagged as flaring, because
 there will only be a single flare added at the midpoint of the polygon.
@@ -72,6 +74,9 @@ typedef struct flare_s {
     qboolean    visible;            // state of last test
     float       drawIntensity;      // may be non 0 even if !visible due to fading
 
+    qboolean    queryPending;       // occlusion query issued, result not read yet
+    qboolean    queryVisible;       // result of the last finished query
+
     int         windowX, windowY;
     float       eyeZ;
 
@@ -84,6 +89,10 @@ typedef struct flare_s {
 flare_t     r_flareStructs[MAX_FLARES];
 flare_t     *r_activeFlares, *r_inactiveFlares;
 
+// one occlusion query for each of r_flareStructs
+static GLuint   r_flareQueries[MAX_FLARES];
+static qboolean r_flareQueriesActive;
+
 int flareCoeff;
 
 /*
@@ -119,6 +128,36 @@ void R_ClearFlares( void ) {
     R_SetFlareCoeff();
 }
 
+/*
+==================
+R_InitFlareQueries
+==================
+*/
+void R_InitFlareQueries( void ) {
+    r_flareQueriesActive = qfalse;
+
+    if ( !glRefConfig.occlusionQuery ) {
+        return;
+    }
+
+    qglGenQueries( MAX_FLARES, r_flareQueries );
+    r_flareQueriesActive = qtrue;
+}
+
+/*
+==================
+R_ShutdownFlareQueries
+==================
+*/
+void R_ShutdownFlareQueries( void ) {
+    if ( !r_flareQueriesActive ) {
+        return;
+    }
+
+    qglDeleteQueries( MAX_FLARES, r_flareQueries );
+    r_flareQueriesActive = qfalse;
+}
+
 
 /*
 ==================
@@ -189,6 +228,10 @@ void RB_AddFlare( void *surface, int fogNum, vec3_t point, vec3_t color, vec3_t
         f->frameSceneNum = backEnd.viewParms.frameSceneNum;
         f->inPortal = backEnd.viewParms.isPortal;
         f->addedFrame = -1;
+
+        // a query still pending belongs to the previous owner
+        f->queryPending = qfalse;
+        f->queryVisible = qfalse;
     }
 
     if ( f->addedFrame != backEnd.viewParms.frameCount - 1 ) {
@@ -267,6 +310,32 @@ FLARE BACK END
 ===============================================================================
 */
 
+/*
+==================
+RB_TestFlareQuery
+
+Picks up the result of the query issued for this flare in an
+earlier frame if the GPU is done with it, it never waits
+==================
+*/
+static qboolean RB_TestFlareQuery( flare_t *f ) {
+    GLuint  query;
+    GLuint  available, samples;
+
+    if ( f->queryPending ) {
+        query = r_flareQueries[f - r_flareStructs];
+
+        qglGetQueryObjectuiv( query, GL_QUERY_RESULT_AVAILABLE, &available );
+        if ( available ) {
+            qglGetQueryObjectuiv( query, GL_QUERY_RESULT, &samples );
+            f->queryVisible = ( samples != 0 );
+            f->queryPending = qfalse;
+        }
+    }
+
+    return f->queryVisible;
+}
+
 /*
 ==================
 RB_TestFlare
@@ -281,30 +350,34 @@ void RB_TestFlare( flare_t *f ) {
 
     backEnd.pc.c_flareTests++;
 
-    // doing a readpixels is as good as doing a glFinish(), so
-    // don't bother with another sync
-    glState.finishCalled = qfalse;
+    if ( r_flareQueriesActive ) {
+        visible = RB_TestFlareQuery( f );
+    } else {
+        // doing a readpixels is as good as doing a glFinish(), so
+        // don't bother with another sync
+        glState.finishCalled = qfalse;
 
-    // if we're doing multisample rendering, read from the correct FBO
-    oldFbo = glState.currentFBO;
-    if (tr.msaaResolveFbo)
-    {
-        FBO_Bind(tr.msaaResolveFbo);
-    }
+        // if we're doing multisample rendering, read from the correct FBO
+        oldFbo = glState.currentFBO;
+        if (tr.msaaResolveFbo)
+        {
+            FBO_Bind(tr.msaaResolveFbo);
+        }
 
-    // read back the z buffer contents
-    qglReadPixels( f->windowX, f->windowY, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &depth );
+        // read back the z buffer contents
+        qglReadPixels( f->windowX, f->windowY, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &depth );
 
-    // if we're doing multisample rendering, switch to the old FBO
-    if (tr.msaaResolveFbo)
-    {
-        FBO_Bind(oldFbo);
-    }
+        // if we're doing multisample rendering, switch to the old FBO
+        if (tr.msaaResolveFbo)
+        {
+            FBO_Bind(oldFbo);
+        }
 
-    screenZ = backEnd.viewParms.projectionMatrix[14] /
-        ( ( 2*depth - 1 ) * backEnd.viewParms.projectionMatrix[11] - backEnd.viewParms.projectionMatrix[10] );
+        screenZ = backEnd.viewParms.projectionMatrix[14] /
+            ( ( 2*depth - 1 ) * backEnd.viewParms.projectionMatrix[11] - backEnd.viewParms.projectionMatrix[10] );
 
-    visible = ( -f->eyeZ - -screenZ ) < 24;
+        visible = ( -f->eyeZ - -screenZ ) < 24;
+    }
 
     if ( visible ) {
         if ( !f->visible ) {
@@ -331,6 +404,77 @@ void RB_TestFlare( flare_t *f ) {
 }
 
 
+/*
+==================
+RB_IssueFlareQueries
+
+Draws a pixel for every flare in this view that has no query in
+flight.  The pixel is pulled 24 units towards the eye, the same
+tolerance the depth readback uses, and counts as visible if any
+sample of it passes the depth test.  Expects an identity modelview.
+==================
+*/
+static void RB_IssueFlareQueries( void ) {
+    flare_t     *f;
+    float       *projection;
+    float       eyeZ, depth;
+    mat4_t      matrix;
+    vec4_t      quadVerts[4];
+    vec2_t      texCoords[4];
+
+    projection = backEnd.viewParms.projectionMatrix;
+
+    // window z is the depth buffer value
+    Mat4Ortho( backEnd.viewParms.viewportX, backEnd.viewParms.viewportX + backEnd.viewParms.viewportWidth,
+                   backEnd.viewParms.viewportY, backEnd.viewParms.viewportY + backEnd.viewParms.viewportHeight,
+                   0, 1, matrix );
+    GL_SetProjectionMatrix(matrix);
+
+    GL_BindToTMU( tr.whiteImage, TB_COLORMAP );
+    GL_Cull( CT_TWO_SIDED );
+    // depth tested, but leaves the color and depth buffers alone
+    GL_State( GLS_SRCBLEND_ZERO | GLS_DSTBLEND_ONE );
+
+    GLSL_BindProgram(&tr.textureColorShader);
+    GLSL_SetUniformMat4(&tr.textureColorShader, UNIFORM_MODELVIEWPROJECTIONMATRIX, glState.modelviewProjection);
+    GLSL_SetUniformVec4(&tr.textureColorShader, UNIFORM_COLOR, colorWhite);
+
+    VectorSet2(texCoords[0], 0.0f, 0.0f);
+    VectorSet2(texCoords[1], 1.0f, 0.0f);
+    VectorSet2(texCoords[2], 1.0f, 1.0f);
+    VectorSet2(texCoords[3], 0.0f, 1.0f);
+
+    for ( f = r_activeFlares ; f ; f = f->next ) {
+        if ( f->frameSceneNum != backEnd.viewParms.frameSceneNum
+            || f->inPortal != backEnd.viewParms.isPortal || f->queryPending ) {
+            continue;
+        }
+
+        eyeZ = f->eyeZ + 24;
+        if ( eyeZ > -r_znear->value ) {
+            depth = 0;
+        } else {
+            depth = 0.5f * ( projection[10] * eyeZ + projection[14] ) / ( projection[11] * eyeZ ) + 0.5f;
+            if ( depth < 0 ) {
+                depth = 0;
+            } else if ( depth > 1 ) {
+                depth = 1;
+            }
+        }
+
+        VectorSet4(quadVerts[0], f->windowX,     f->windowY,     depth, 1.0f);
+        VectorSet4(quadVerts[1], f->windowX + 1, f->windowY,     depth, 1.0f);
+        VectorSet4(quadVerts[2], f->windowX + 1, f->windowY + 1, depth, 1.0f);
+        VectorSet4(quadVerts[3], f->windowX,     f->windowY + 1, depth, 1.0f);
+
+        qglBeginQuery( GL_SAMPLES_PASSED, r_flareQueries[f - r_flareStructs] );
+        RB_InstantQuad2( quadVerts, texCoords );
+        qglEndQuery( GL_SAMPLES_PASSED );
+
+        f->queryPending = qtrue;
+    }
+}
+
 /*
 ==================
 RB_RenderFlare
@@ -491,7 +635,8 @@ void RB_RenderFlares (void) {
 
 //  RB_AddDlightFlares();
 
-    // perform z buffer readback on each flare in this view
+    // perform z buffer readback or collect the query results
+    // on each flare in this view
     draw = qfalse;
     prev = &r_activeFlares;
     while ( ( f = *prev ) != NULL ) {
@@ -510,7 +655,7 @@ void RB_RenderFlares (void) {
             RB_TestFlare( f );
             if ( f->drawIntensity ) {
                 draw = qtrue;
-            } else {
+            } else if ( !r_flareQueriesActive ) {
                 // this flare has completely faded out, so remove it from the chain
                 *prev = f->next;
                 f->next = r_inactiveFlares;
@@ -522,7 +667,9 @@ void RB_RenderFlares (void) {
         prev = &f->next;
     }
 
-    if ( !draw ) {
+    // with queries the occluded flares stay in the chain,
+    // they have to be tested again
+    if ( !draw && !r_flareQueriesActive ) {
         return;     // none visible
     }
 
@@ -530,6 +677,16 @@ void RB_RenderFlares (void) {
     Mat4Copy(glState.modelview, oldmodelview);
     Mat4Identity(matrix);
     GL_SetModelviewMatrix(matrix);
+
+    if ( r_flareQueriesActive ) {
+        RB_IssueFlareQueries();
+
+        if ( !draw ) {
+            GL_SetProjectionMatrix(oldprojection);
+            GL_SetModelviewMatrix(oldmodelview);
+            return;     // none visible
+        }
+    }
     Mat4Ortho( backEnd.viewParms.viewportX, backEnd.viewParms.viewportX + backEnd.viewParms.viewportWidth,
                    backEnd.viewParms.viewportY, backEnd.viewParms.viewportY + backEnd.viewParms.viewportHeight,
                    -99999, 99999, matrix );
@@ -52,6 +52,8 @@ extern const char *fallbackShader_texturecolor_vp;
 extern const char *fallbackShader_texturecolor_fp;
 extern const char *fallbackShader_tonemap_vp;
 extern const char *fallbackShader_tonemap_fp;
+extern const char *fallbackShader_weather_vp;
+extern const char *fallbackShader_weather_fp;
 
 typedef struct uniformInfo_s
 {
@@ -149,6 +151,9 @@ static uniformInfo_t uniformsInfo[] =
 
     { "u_AlphaTest", GLSL_INT },
 
+    { "u_WeatherWind", GLSL_VEC2 },
+    { "u_WeatherDown", GLSL_VEC3 },
+
     { "u_BoneMatrix", GLSL_MAT16_BONEMATRIX },
 };
 
@@ -160,6 +165,27 @@ typedef enum
 }
 glslPrintLog_t;
 
+// linked programs are cached in glslcache/ so later starts can skip
+// compiling and linking; .dat so a pure server doesn't hide them.
+// A file is named after the program and its defines only, so a
+// binary made stale by new source or a new driver is overwritten.
+#define GLSL_CACHE_IDENT    (('C'<<24)+('L'<<16)+('S'<<8)+'G')
+#define GLSL_CACHE_VERSION  1
+
+typedef struct
+{
+    int         ident;
+    int         version;
+    unsigned    driverHash;     // vendor, renderer and version strings
+    unsigned    sourceHash;     // both stages and attrib bindings
+    int         sourceLength;
+    GLenum      binaryFormat;
+    int         binaryLength;
+}
+glslCacheHeader_t;
+
+static unsigned glslCacheDriverHash;
+
 static void GLSL_PrintLog(GLuint programOrShader, glslPrintLog_t type, qboolean developerOnly)
 {
     char           *msg;
@@ -502,7 +528,150 @@ static void GLSL_ShowProgramUniforms(GLuint program)
     }
 }
 
-static int GLSL_InitGPUShader2(shaderProgram_t * program, const char *name, int attribs, const char *vpCode, const char *fpCode)
+static unsigned GLSL_HashString(unsigned hash, const char *string)
+{
+    // FNV-1a
+    while (*string)
+    {
+        hash ^= (byte)*string++;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static void GLSL_InitProgramCache(void)
+{
+    unsigned hash = 2166136261u;
+
+    hash = GLSL_HashString(hash, (char *)qglGetString(GL_VENDOR));
+    hash = GLSL_HashString(hash, (char *)qglGetString(GL_RENDERER));
+    hash = GLSL_HashString(hash, (char *)qglGetString(GL_VERSION));
+    hash = GLSL_HashString(hash, (char *)qglGetString(GL_SHADING_LANGUAGE_VERSION));
+
+    glslCacheDriverHash = hash;
+}
+
+static void GLSL_GetProgramCacheKey(const char *name, int attribs, const char *extra, const char *vpCode, const char *fpCode,
+    glslCacheHeader_t *header, char *filename, int filenameSize)
+{
+    unsigned hash = 2166136261u;
+    unsigned permutation = 2166136261u;
+
+    hash = GLSL_HashString(hash, vpCode);
+    if (fpCode)
+        hash = GLSL_HashString(hash, fpCode);
+    hash = GLSL_HashString(hash, va("%d", attribs));
+
+    Com_Memset(header, 0, sizeof(*header));
+    header->ident = GLSL_CACHE_IDENT;
+    header->version = GLSL_CACHE_VERSION;
+    header->driverHash = glslCacheDriverHash;
+    header->sourceHash = hash;
+    header->sourceLength = strlen(vpCode) + (fpCode ? strlen(fpCode) : 0);
+
+    if (extra)
+        permutation = GLSL_HashString(permutation, extra);
+    permutation = GLSL_HashString(permutation, va("%d", attribs));
+
+    Com_sprintf(filename, filenameSize, "glslcache/%s_%08x.dat", name, permutation);
+}
+
+/*
+====================
+GLSL_LoadProgramBinary
+
+Restores a program linked on an earlier start, returns qfalse if
+there is no cached binary or the driver refused it
+====================
+*/
+static qboolean GLSL_LoadProgramBinary(shaderProgram_t *program, const char *extra, const char *vpCode, const char *fpCode)
+{
+    glslCacheHeader_t   key, *header;
+    char                filename[MAX_QPATH];
+    void                *buffer;
+    long                size;
+    GLint               linked;
+
+    if (!glRefConfig.programBinary)
+        return qfalse;
+
+    GLSL_GetProgramCacheKey(program->name, program->attribs, extra, vpCode, fpCode, &key, filename, sizeof(filename));
+
+    size = ri.FS_ReadFile(filename, &buffer);
+    if (!buffer)
+        return qfalse;
+
+    header = buffer;
+    if (size < sizeof(*header) || header->ident != key.ident || header->version != key.version
+        || header->driverHash != key.driverHash || header->sourceHash != key.sourceHash
+        || header->sourceLength != key.sourceLength || header->binaryLength != size - sizeof(*header))
+    {
+        ri.Printf(PRINT_DEVELOPER, "...%s is stale\n", filename);
+        ri.FS_FreeFile(buffer);
+        return qfalse;
+    }
+
+    // report anything pending first, so only the errors the load raises are dropped
+    GL_CheckErrors();
+
+    qglProgramBinary(program->program, header->binaryFormat, header + 1, header->binaryLength);
+    ri.FS_FreeFile(buffer);
+
+    // a driver may reject binaries it wrote itself, that isn't an error
+    while (qglGetError() != GL_NO_ERROR)
+        ;
+
+    qglGetProgramiv(program->program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        ri.Printf(PRINT_DEVELOPER, "...%s rejected by driver\n", filename);
+        return qfalse;
+    }
+
+    ri.Printf(PRINT_DEVELOPER, "...loading '%s'\n", filename);
+
+    return qtrue;
+}
+
+/*
+====================
+GLSL_SaveProgramBinary
+====================
+*/
+static void GLSL_SaveProgramBinary(shaderProgram_t *program, const char *extra, const char *vpCode, const char *fpCode)
+{
+    glslCacheHeader_t   *header;
+    char                filename[MAX_QPATH];
+    GLint               length;
+    GLsizei             written;
+    byte                *buffer;
+
+    if (!glRefConfig.programBinary)
+        return;
+
+    length = 0;
+    qglGetProgramiv(program->program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    buffer = ri.Malloc(sizeof(*header) + length);
+    header = (glslCacheHeader_t *)buffer;
+
+    GLSL_GetProgramCacheKey(program->name, program->attribs, extra, vpCode, fpCode, header, filename, sizeof(filename));
+
+    written = 0;
+    qglGetProgramBinary(program->program, length, &written, &header->binaryFormat, header + 1);
+    if (written > 0)
+    {
+        header->binaryLength = written;
+        ri.FS_WriteFile(filename, buffer, sizeof(*header) + written);
+    }
+
+    ri.Free(buffer);
+}
+
+static int GLSL_InitGPUShader2(shaderProgram_t * program, const char *name, int attribs, const char *extra, const char *vpCode, const char *fpCode)
 {
     ri.Printf(PRINT_DEVELOPER, "------- GPU shader -------\n");
 
@@ -516,6 +685,19 @@ static int GLSL_InitGPUShader2(shaderProgram_t * program, const char *name, int
     program->program = qglCreateProgram();
     program->attribs = attribs;
 
+    if (GLSL_LoadProgramBinary(program, extra, vpCode, fpCode))
+    {
+        return 1;
+    }
+
+    if (glRefConfig.programBinary)
+    {
+        // the program may be left unusable by a rejected binary
+        qglDeleteProgram(program->program);
+        program->program = qglCreateProgram();
+        qglProgramParameteri(program->program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
     if (!(GLSL_CompileGPUShader(program->program, &program->vertexShader, vpCode, strlen(vpCode), GL_VERTEX_SHADER)))
     {
         ri.Printf(PRINT_ALL, "GLSL_InitGPUShader2: Unable to load \"%s\" as GL_VERTEX_SHADER\n", name);
@@ -581,8 +763,29 @@ static int GLSL_InitGPUShader2(shaderProgram_t * program, const char *name, int
     if(attribs & ATTR_TANGENT2)
         qglBindAttribLocation(program->program, ATTR_INDEX_TANGENT2, "attr_Tangent2");
 
+    if(attribs & ATTR_INSTANCED)
+    {
+        qglBindAttribLocation(program->program, ATTR_INDEX_INSTANCE_MATRIX0, "attr_InstanceMatrix0");
+        qglBindAttribLocation(program->program, ATTR_INDEX_INSTANCE_MATRIX1, "attr_InstanceMatrix1");
+        qglBindAttribLocation(program->program, ATTR_INDEX_INSTANCE_MATRIX2, "attr_InstanceMatrix2");
+        qglBindAttribLocation(program->program, ATTR_INDEX_INSTANCE_VIEWORIGIN, "attr_InstanceViewOrigin");
+        qglBindAttribLocation(program->program, ATTR_INDEX_INSTANCE_AMBIENT, "attr_InstanceAmbientLight");
+        qglBindAttribLocation(program->program, ATTR_INDEX_INSTANCE_DIRECTED, "attr_InstanceDirectedLight");
+        qglBindAttribLocation(program->program, ATTR_INDEX_INSTANCE_LIGHTDIR, "attr_InstanceLightDir");
+    }
+
+    if(attribs & ATTR_PARTICLES)
+    {
+        qglBindAttribLocation(program->program, ATTR_INDEX_PARTICLE_X, "attr_ParticleX");
+        qglBindAttribLocation(program->program, ATTR_INDEX_PARTICLE_Y, "attr_ParticleY");
+        qglBindAttribLocation(program->program, ATTR_INDEX_PARTICLE_Z, "attr_ParticleZ");
+        qglBindAttribLocation(program->program, ATTR_INDEX_PARTICLE_FLAGS, "attr_ParticleFlags");
+    }
+
     GLSL_LinkProgram(program->program);
 
+    GLSL_SaveProgramBinary(program, extra, vpCode, fpCode);
+
     return 1;
 }
 
@@ -633,7 +836,7 @@ static int GLSL_InitGPUShader(shaderProgram_t * program, const char *name,
         }
     }
 
-    result = GLSL_InitGPUShader2(program, name, attribs, vpCode, fragmentShader ? fpCode : NULL);
+    result = GLSL_InitGPUShader2(program, name, attribs, extra, vpCode, fragmentShader ? fpCode : NULL);
 
     return result;
 }
@@ -934,6 +1137,8 @@ void GLSL_InitGPUShaders(void)
 
     R_IssuePendingRenderCommands();
 
+    GLSL_InitProgramCache();
+
     startTime = ri.Milliseconds();
 
     for (i = 0; i < GENERICDEF_COUNT; i++)
@@ -944,6 +1149,11 @@ void GLSL_InitGPUShaders(void)
         if ((i & GENERICDEF_USE_BONE_ANIMATION) && !glRefConfig.glslMaxAnimatedBones)
             continue;
 
+        // only md3s without fog or deforms are instanced
+        if ((i & GENERICDEF_USE_INSTANCING) && (!glRefConfig.instancedArrays
+            || (i & (GENERICDEF_USE_DEFORM_VERTEXES | GENERICDEF_USE_FOG | GENERICDEF_USE_BONE_ANIMATION))))
+            continue;
+
         attribs = ATTR_POSITION | ATTR_TEXCOORD0 | ATTR_TEXCOORD1 | ATTR_NORMAL | ATTR_COLOR;
         extradefines[0] = '\0';
 
@@ -973,6 +1183,12 @@ void GLSL_InitGPUShaders(void)
         if (i & GENERICDEF_USE_RGBAGEN)
             Q_strcat(extradefines, 1024, "#define USE_RGBAGEN\n");
 
+        if (i & GENERICDEF_USE_INSTANCING)
+        {
+            Q_strcat(extradefines, 1024, "#define USE_INSTANCING\n");
+            attribs |= ATTR_INSTANCED;
+        }
+
         if (!GLSL_InitGPUShader(&tr.genericShader[i], "generic", attribs, qtrue, extradefines, qtrue, fallbackShader_generic_vp, fallbackShader_generic_fp))
         {
             ri.Error(ERR_FATAL, "Could not load generic shader!");
@@ -1084,6 +1300,11 @@ void GLSL_InitGPUShaders(void)
         if ((i & LIGHTDEF_ENTITY_BONE_ANIMATION) && !glRefConfig.glslMaxAnimatedBones)
             continue;
 
+        // only vertex animated entities lit by the light grid are instanced
+        if ((i & LIGHTDEF_USE_INSTANCING) && (!glRefConfig.instancedArrays || !(i & LIGHTDEF_ENTITY_VERTEX_ANIMATION)
+            || lightType == LIGHTDEF_USE_LIGHTMAP || lightType == LIGHTDEF_USE_LIGHT_VERTEX))
+            continue;
+
         attribs = ATTR_POSITION | ATTR_TEXCOORD0 | ATTR_COLOR | ATTR_NORMAL;
 
         extradefines[0] = '\0';
@@ -1193,6 +1414,12 @@ void GLSL_InitGPUShaders(void)
             attribs |= ATTR_BONE_INDEXES | ATTR_BONE_WEIGHTS;
         }
 
+        if (i & LIGHTDEF_USE_INSTANCING)
+        {
+            Q_strcat(extradefines, 1024, "#define USE_INSTANCING\n");
+            attribs |= ATTR_INSTANCED;
+        }
+
         if (!GLSL_InitGPUShader(&tr.lightallShader[i], "lightall", attribs, qtrue, extradefines, qtrue, fallbackShader_lightall_vp, fallbackShader_lightall_fp))
         {
             ri.Error(ERR_FATAL, "Could not load lightall shader!");
@@ -1422,6 +1649,32 @@ void GLSL_InitGPUShaders(void)
         numEtcShaders++;
     }
 
+    // weather particles are expanded from their instance data, so
+    // there's nothing to draw them with without instanced arrays
+    for (i = 0; i < WEATHERDEF_COUNT && glRefConfig.instancedArrays; i++)
+    {
+        attribs = ATTR_POSITION | ATTR_PARTICLES;
+        extradefines[0] = '\0';
+
+        if (i == WEATHERDEF_SNOW)
+            Q_strcat(extradefines, 1024, "#define USE_SNOW\n");
+        else
+            Q_strcat(extradefines, 1024, "#define USE_RAIN\n");
+
+        if (!GLSL_InitGPUShader(&tr.weatherShader[i], "weather", attribs, qtrue, extradefines, qtrue, fallbackShader_weather_vp, fallbackShader_weather_fp))
+        {
+            ri.Error(ERR_FATAL, "Could not load weather shader!");
+        }
+
+        GLSL_InitUniforms(&tr.weatherShader[i]);
+
+        GLSL_SetUniformInt(&tr.weatherShader[i], UNIFORM_DIFFUSEMAP, TB_DIFFUSEMAP);
+
+        GLSL_FinishGPUShader(&tr.weatherShader[i]);
+
+        numEtcShaders++;
+    }
+
 #if 0
     attribs = ATTR_POSITION | ATTR_TEXCOORD;
     extradefines[0] = '\0';
@@ -1489,6 +1742,9 @@ void GLSL_ShutdownGPUShaders(void)
 
     for ( i = 0; i < 4; i++)
         GLSL_DeleteGPUShader(&tr.depthBlurShader[i]);
+
+    for ( i = 0; i < WEATHERDEF_COUNT; i++)
+        GLSL_DeleteGPUShader(&tr.weatherShader[i]);
 }
 
 
@@ -1561,5 +1817,10 @@ shaderProgram_t *GLSL_GetGenericShaderProgram(int stage)
         shaderAttribs |= GENERICDEF_USE_TCGEN_AND_TCMOD;
     }
 
+    if (glState.instances)
+    {
+        shaderAttribs |= GENERICDEF_USE_INSTANCING;
+    }
+
     return &tr.genericShader[shaderAttribs];
 }
@@ -149,8 +149,9 @@ R_ImageList_f
 void R_ImageList_f( void ) {
     int i;
     int estTotalSize = 0;
+    int readTotal = 0, decodeTotal = 0, uploadTotal = 0;
 
-    ri.Printf(PRINT_ALL, "\n      -w-- -h-- -type-- -size- --name-------\n");
+    ri.Printf(PRINT_ALL, "\n      -w-- -h-- -type-- -size- -read -dec- -upl- --name-------\n");
 
     for ( i = 0 ; i < tr.numImages ; i++ )
     {
@@ -305,70 +306,22 @@ void R_ImageList_f( void ) {
             sizeSuffix = "Gb";
         }
 
-        ri.Printf(PRINT_ALL, "%4i: %4ix%4i %s %4i%s %s\n", i, image->uploadWidth, image->uploadHeight, format, displaySize, sizeSuffix, image->imgName);
+        ri.Printf(PRINT_ALL, "%4i: %4ix%4i %s %4i%s %5i %5i %5i %s\n", i, image->uploadWidth, image->uploadHeight, format, displaySize, sizeSuffix,
+                image->readMsec, image->decodeMsec, image->uploadMsec, image->imgName);
         estTotalSize += estSize;
+        readTotal += image->readMsec;
+        decodeTotal += image->decodeMsec;
+        uploadTotal += image->uploadMsec;
     }
 
     ri.Printf (PRINT_ALL, " ---------\n");
     ri.Printf (PRINT_ALL, " approx %i bytes\n", estTotalSize);
+    ri.Printf (PRINT_ALL, " %i msec read, %i msec decode, %i msec upload\n", readTotal, decodeTotal, uploadTotal);
     ri.Printf (PRINT_ALL, " %i total images\n\n", tr.numImages );
 }
 
 //=======================================================================
 
-/*
-================
-ResampleTexture
-
-Used to resample images in a more general than quartering fashion.
-
-This will only be filtered properly if the resampled size
-is greater than half the original size.
-
-If a larger shrinking is needed, use the mipmap function
-before or after.
-================
-*/
-static void ResampleTexture( byte *in, int inwidth, int inheight, byte *out,
-                            int outwidth, int outheight ) {
-    int     i, j;
-    byte    *inrow, *inrow2;
-    int     frac, fracstep;
-    int     p1[2048], p2[2048];
-    byte    *pix1, *pix2, *pix3, *pix4;
-
-    if (outwidth>2048)
-        ri.Error(ERR_DROP, "ResampleTexture: max width");
-
-    fracstep = inwidth*0x10000/outwidth;
-
-    frac = fracstep>>2;
-    for ( i=0 ; i<outwidth ; i++ ) {
-        p1[i] = 4*(frac>>16);
-        frac += fracstep;
-    }
-    frac = 3*(fracstep>>2);
-    for ( i=0 ; i<outwidth ; i++ ) {
-        p2[i] = 4*(frac>>16);
-        frac += fracstep;
-    }
-
-    for (i=0 ; i<outheight ; i++) {
-        inrow = in + 4*inwidth*(int)((i+0.25)*inheight/outheight);
-        inrow2 = in + 4*inwidth*(int)((i+0.75)*inheight/outheight);
-        for (j=0 ; j<outwidth ; j++) {
-            pix1 = inrow + p1[j];
-            pix2 = inrow + p2[j];
-            pix3 = inrow2 + p1[j];
-            pix4 = inrow2 + p2[j];
-            *out++ = (pix1[0] + pix2[0] + pix3[0] + pix4[0])>>2;
-            *out++ = (pix1[1] + pix2[1] + pix3[1] + pix4[1])>>2;
-            *out++ = (pix1[2] + pix2[2] + pix3[2] + pix4[2])>>2;
-            *out++ = (pix1[3] + pix2[3] + pix3[3] + pix4[3])>>2;
-        }
-    }
-}
-
 static void RGBAtoYCoCgA(const byte *in, byte *out, int width, int height)
 {
     int x, y;
@@ -1254,55 +1207,122 @@ lighting range
 */
 void R_LightScaleTexture (byte *in, int inwidth, int inheight, qboolean only_gamma )
 {
+    byte    table[256];
+    int     i;
+
     if ( only_gamma )
     {
-        if ( !glConfig.deviceSupportsGamma )
-        {
-            int     i, c;
-            byte    *p;
-
-            p = in;
+        if ( glConfig.deviceSupportsGamma )
+            return;
 
-            c = inwidth*inheight;
-            for (i=0 ; i<c ; i++, p+=4)
-            {
-                p[0] = s_gammatable[p[0]];
-                p[1] = s_gammatable[p[1]];
-                p[2] = s_gammatable[p[2]];
-            }
-        }
+        Com_Memcpy( table, s_gammatable, sizeof( table ) );
+    }
+    else if ( glConfig.deviceSupportsGamma )
+    {
+        Com_Memcpy( table, s_intensitytable, sizeof( table ) );
     }
     else
     {
-        int     i, c;
-        byte    *p;
+        // fold both lookups into one pass
+        for ( i = 0 ; i < 256 ; i++ )
+            table[i] = s_gammatable[s_intensitytable[i]];
+    }
 
-        p = in;
+    R_RemapTextureRGB( in, inwidth*inheight, table );
+}
 
-        c = inwidth*inheight;
 
-        if ( glConfig.deviceSupportsGamma )
+static float downmipSrgbLookup[256];
+static float downmipSrgbThresholds[256];
+static qboolean downmipSrgbLookupSet = qfalse;
+
+/*
+================
+R_InitDownmipSrgb
+
+downmipSrgbThresholds[k] is the smallest summed linear value that converts
+back to byte k, so the inverse can be found with a search instead of powf
+================
+*/
+static void R_InitDownmipSrgb( void )
+{
+    int x;
+
+    for (x = 0; x < 256; x++)
+        downmipSrgbLookup[x] = powf(x / 255.0f, 2.2f) * 0.25f;
+
+    downmipSrgbThresholds[0] = 0.0f;
+    for (x = 1; x < 256; x++)
+    {
+        floatint_t lo, hi, mid;
+
+        lo.f = 0.0f;
+        hi.f = 1.0f;
+        while (hi.ui - lo.ui > 1)
         {
-            for (i=0 ; i<c ; i++, p+=4)
-            {
-                p[0] = s_intensitytable[p[0]];
-                p[1] = s_intensitytable[p[1]];
-                p[2] = s_intensitytable[p[2]];
-            }
+            mid.ui = lo.ui + ((hi.ui - lo.ui) >> 1);
+            if ((int)(powf(mid.f, 1.0f / 2.2f) * 255.0f) >= x)
+                hi = mid;
+            else
+                lo = mid;
         }
-        else
-        {
-            for (i=0 ; i<c ; i++, p+=4)
-            {
-                p[0] = s_gammatable[s_intensitytable[p[0]]];
-                p[1] = s_gammatable[s_intensitytable[p[1]]];
-                p[2] = s_gammatable[s_intensitytable[p[2]]];
+        downmipSrgbThresholds[x] = hi.f;
+    }
+
+    downmipSrgbLookupSet = qtrue;
+}
+
+static ID_INLINE byte R_DownmipSrgbToByte( float total )
+{
+    int c = 0, step;
+
+    for (step = 128; step; step >>= 1)
+    {
+        if (c + step < 256 && downmipSrgbThresholds[c + step] <= total)
+            c += step;
+    }
+
+    return c;
+}
+
+typedef struct {
+    const byte  *in;
+    byte        *out;
+    int         width;      // output size
+    int         height;
+    int         rowsPerJob;
+} srgbMipJob_t;
+
+static void R_MipMapsRGBRows( void *data, int job )
+{
+    const srgbMipJob_t *mj = data;
+    const byte *in, *in2;
+    byte *out;
+    int x, y, c, last, stride;
+    float total;
+
+    stride = mj->width * 8;
+    y = job * mj->rowsPerJob;
+    last = MIN(y + mj->rowsPerJob, mj->height);
+
+    for (; y < last; y++) {
+        in = mj->in + y * stride * 2;
+        in2 = in + stride;
+        out = mj->out + y * mj->width * 4;
+
+        for (x = mj->width; x; x--) {
+            for (c = 3; c; c--, in++, in2++) {
+                total = downmipSrgbLookup[*(in)]  + downmipSrgbLookup[*(in + 4)]
+                      + downmipSrgbLookup[*(in2)] + downmipSrgbLookup[*(in2 + 4)];
+
+                *out++ = R_DownmipSrgbToByte(total);
             }
+
+            *out++ = (*(in) + *(in + 4) + *(in2) + *(in2 + 4)) >> 2; in += 5, in2 += 5;
         }
     }
 }
 
-
 /*
 ================
 R_MipMapsRGB
@@ -1313,18 +1333,13 @@ Colors are gamma correct
 */
 static void R_MipMapsRGB( byte *in, int inWidth, int inHeight)
 {
-    int x, y, c, stride;
-    const byte *in2;
+    int x, c, numJobs;
     float total;
-    static float downmipSrgbLookup[256];
-    static int downmipSrgbLookupSet = 0;
     byte *out = in;
+    srgbMipJob_t mj;
 
-    if (!downmipSrgbLookupSet) {
-        for (x = 0; x < 256; x++)
-            downmipSrgbLookup[x] = powf(x / 255.0f, 2.2f) * 0.25f;
-        downmipSrgbLookupSet = 1;
-    }
+    if (!downmipSrgbLookupSet)
+        R_InitDownmipSrgb();
 
     if (inWidth == 1 && inHeight == 1)
         return;
@@ -1334,7 +1349,7 @@ static void R_MipMapsRGB( byte *in, int inWidth, int inHeight)
             for (c = 3; c; c--, in++) {
                 total  = (downmipSrgbLookup[*(in)] + downmipSrgbLookup[*(in + 4)]) * 2.0f;
 
-                *out++ = (byte)(powf(total, 1.0f / 2.2f) * 255.0f);
+                *out++ = R_DownmipSrgbToByte(total);
             }
             *out++ = (*(in) + *(in + 4)) >> 1; in += 5;
         }
@@ -1342,22 +1357,22 @@ static void R_MipMapsRGB( byte *in, int inWidth, int inHeight)
         return;
     }
 
-    stride = inWidth * 4;
-    inWidth >>= 1; inHeight >>= 1;
-
-    in2 = in + stride;
-    for (y = inHeight; y; y--, in += stride, in2 += stride) {
-        for (x = inWidth; x; x--) {
-            for (c = 3; c; c--, in++, in2++) {
-                total = downmipSrgbLookup[*(in)]  + downmipSrgbLookup[*(in + 4)]
-                      + downmipSrgbLookup[*(in2)] + downmipSrgbLookup[*(in2 + 4)];
-
-                *out++ = (byte)(powf(total, 1.0f / 2.2f) * 255.0f);
-            }
+    mj.in = in;
+    mj.width = inWidth >> 1;
+    mj.height = inHeight >> 1;
+    numJobs = R_ImageJobRows(mj.width, mj.height, &mj.rowsPerJob);
 
-            *out++ = (*(in) + *(in + 4) + *(in2) + *(in2 + 4)) >> 2; in += 5, in2 += 5;
-        }
+    if (numJobs == 1) {
+        mj.out = in;
+        R_MipMapsRGBRows(&mj, 0);
+        return;
     }
+
+    // bands running side by side would overwrite each other's source rows
+    mj.out = ri.Hunk_AllocateTempMemory(mj.width * mj.height * 4);
+    GLimp_RunJobs(R_MipMapsRGBRows, &mj, numJobs);
+    Com_Memcpy(in, mj.out, mj.width * mj.height * 4);
+    ri.Hunk_FreeTempMemory(mj.out);
 }
 
 
@@ -1532,7 +1547,7 @@ static qboolean RawImage_ScaleToPower2( byte **data, int *inout_width, int *inou
         *resampledBuffer = ri.Hunk_AllocateTempMemory( finalwidth * finalheight * 4 );
 
         if (scaled_width != width || scaled_height != height)
-            ResampleTexture (*data, width, height, *resampledBuffer, scaled_width, scaled_height);
+            R_ResampleTextureRGBA( *data, width, height, *resampledBuffer, scaled_width, scaled_height );
         else
             Com_Memcpy(*resampledBuffer, *data, width * height * 4);
 
@@ -1563,7 +1578,7 @@ static qboolean RawImage_ScaleToPower2( byte **data, int *inout_width, int *inou
         if (data && resampledBuffer)
         {
             *resampledBuffer = ri.Hunk_AllocateTempMemory( scaled_width * scaled_height * 4 );
-            ResampleTexture (*data, width, height, *resampledBuffer, scaled_width, scaled_height);
+            R_ResampleTextureRGBA( *data, width, height, *resampledBuffer, scaled_width, scaled_height );
             *data = *resampledBuffer;
         }
     }
@@ -2087,6 +2102,41 @@ static void Upload32(byte *data, int x, int y, int width, int height, GLenum pic
 }
 
 
+/*
+===============
+UploadCached
+
+Uploads the levels of an image cache file as they are
+===============
+*/
+static void UploadCached(const cachedImage_t *cached, image_t *image)
+{
+    int width = cached->uploadWidth, height = cached->uploadHeight;
+    int i;
+
+    for (i = 0; i < cached->numLevels; i++)
+    {
+        if (cached->compressed)
+            qglCompressedTextureSubImage2DEXT(image->texnum, GL_TEXTURE_2D, i, 0, 0, width, height, cached->internalFormat, cached->levelSize[i], cached->levels[i]);
+        else
+            qglTextureSubImage2DEXT(image->texnum, GL_TEXTURE_2D, i, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, cached->levels[i]);
+
+        width = MAX(1, width >> 1);
+        height = MAX(1, height >> 1);
+    }
+
+    GL_CheckErrors();
+}
+
+
+// set by R_FindImageFile to have R_CreateImage2 upload a cache file
+// instead of processing the picture
+static const cachedImage_t  *uploadCache;
+
+// set by R_FindImageFile to have R_CreateImage2 re-bind a texture
+// a previous map left in the pool
+static const image_t        *uploadRetained;
+
 /*
 ================
 R_CreateImage2
@@ -2107,6 +2157,7 @@ image_t *R_CreateImage2( const char *name, byte *pic, int width, int height, GLe
     qboolean    lastMip;
     GLenum textureTarget = cubemap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
     GLenum dataFormat;
+    int         start;
 
     if (strlen(name) >= MAX_QPATH ) {
         ri.Error (ERR_DROP, "R_CreateImage: \"%s\" is too long", name);
@@ -2119,8 +2170,13 @@ image_t *R_CreateImage2( const char *name, byte *pic, int width, int height, GLe
         ri.Error( ERR_DROP, "R_CreateImage: MAX_DRAWIMAGES hit");
     }
 
+    start = ri.Milliseconds();
+
     image = tr.images[tr.numImages] = ri.Hunk_Alloc( sizeof( image_t ), h_low );
-    qglGenTextures(1, &image->texnum);
+    if (uploadRetained)
+        image->texnum = uploadRetained->texnum;
+    else
+        qglGenTextures(1, &image->texnum);
     tr.numImages++;
 
     image->type = type;
@@ -2135,14 +2191,29 @@ image_t *R_CreateImage2( const char *name, byte *pic, int width, int height, GLe
     else
         glWrapClampMode = GL_REPEAT;
 
-    if (!internalFormat)
+    if (uploadRetained)
+        internalFormat = uploadRetained->internalFormat;
+    else if (uploadCache)
+        internalFormat = uploadCache->internalFormat;
+    else if (!internalFormat)
         internalFormat = RawImage_GetFormat(pic, width * height, picFormat, isLightmap, image->type, image->flags);
 
     image->internalFormat = internalFormat;
 
     // Possibly scale image before uploading.
     // if not rgba8 and uploading an image, skip picmips.
-    if (!cubemap)
+    if (uploadRetained)
+    {
+        width = uploadRetained->uploadWidth;
+        height = uploadRetained->uploadHeight;
+    }
+    else if (uploadCache)
+    {
+        // cached levels were sized when they were first uploaded
+        width = uploadCache->uploadWidth;
+        height = uploadCache->uploadHeight;
+    }
+    else if (!cubemap)
     {
         if (rgba8)
             scaled = RawImage_ScaleToPower2(&pic, &width, &height, type, flags, &resampledBuffer);
@@ -2161,35 +2232,42 @@ image_t *R_CreateImage2( const char *name, byte *pic, int width, int height, GLe
     image->uploadWidth = width;
     image->uploadHeight = height;
 
-    // Allocate texture storage so we don't have to worry about it later.
-    dataFormat = PixelDataFormatFromInternalFormat(internalFormat);
-    mipWidth = width;
-    mipHeight = height;
-    miplevel = 0;
-    do
+    // A retained texture has its storage and levels already, only
+    // its parameters are set again below.
+    if (!uploadRetained)
     {
-        lastMip = !mipmap || (mipWidth == 1 && mipHeight == 1);
-        if (cubemap)
-        {
-            int i;
+        // Allocate texture storage so we don't have to worry about it later.
+        dataFormat = PixelDataFormatFromInternalFormat(internalFormat);
+        mipWidth = width;
+        mipHeight = height;
+        miplevel = 0;
+        do
+        {
+            lastMip = !mipmap || (mipWidth == 1 && mipHeight == 1);
+            if (cubemap)
+            {
+                int i;
 
-            for (i = 0; i < 6; i++)
-                qglTextureImage2DEXT(image->texnum, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, miplevel, internalFormat, mipWidth, mipHeight, 0, dataFormat, GL_UNSIGNED_BYTE, NULL);
-        }
-        else
-        {
-            qglTextureImage2DEXT(image->texnum, GL_TEXTURE_2D, miplevel, internalFormat, mipWidth, mipHeight, 0, dataFormat, GL_UNSIGNED_BYTE, NULL);
+                for (i = 0; i < 6; i++)
+                    qglTextureImage2DEXT(image->texnum, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, miplevel, internalFormat, mipWidth, mipHeight, 0, dataFormat, GL_UNSIGNED_BYTE, NULL);
+            }
+            else
+            {
+                qglTextureImage2DEXT(image->texnum, GL_TEXTURE_2D, miplevel, internalFormat, mipWidth, mipHeight, 0, dataFormat, GL_UNSIGNED_BYTE, NULL);
+            }
+
+            mipWidth  = MAX(1, mipWidth >> 1);
+            mipHeight = MAX(1, mipHeight >> 1);
+            miplevel++;
         }
+        while (!lastMip);
 
-        mipWidth  = MAX(1, mipWidth >> 1);
-        mipHeight = MAX(1, mipHeight >> 1);
-        miplevel++;
+        // Upload data.
+        if (uploadCache)
+            UploadCached(uploadCache, image);
+        else if (pic)
+            Upload32(pic, 0, 0, width, height, picFormat, numMips, image, scaled);
     }
-    while (!lastMip);
-
-    // Upload data.
-    if (pic)
-        Upload32(pic, 0, 0, width, height, picFormat, numMips, image, scaled);
 
     if (resampledBuffer != NULL)
         ri.Hunk_FreeTempMemory(resampledBuffer);
@@ -2225,6 +2303,8 @@ image_t *R_CreateImage2( const char *name, byte *pic, int width, int height, GLe
 
     GL_CheckErrors();
 
+    image->uploadMsec = ri.Milliseconds() - start;
+
     hash = generateHashValue(name);
     image->next = hashTable[hash];
     hashTable[hash] = image;
@@ -2256,12 +2336,6 @@ void R_UpdateSubImage( image_t *image, byte *pic, int x, int y, int width, int h
 // Prototype for dds loader function which isn't common to both renderers
 void R_LoadDDS(const char *filename, byte **pic, int *width, int *height, GLenum *picFormat, int *numMips);
 
-typedef struct
-{
-    char *ext;
-    void (*ImageLoader)( const char *, unsigned char **, int *, int * );
-} imageExtToLoaderMap_t;
-
 // Note that the ordering indicates the order of preference used
 // when there are multiple images of different formats available
 static imageExtToLoaderMap_t imageLoaders[ ] =
@@ -2276,15 +2350,15 @@ static imageExtToLoaderMap_t imageLoaders[ ] =
 
 static int numImageLoaders = ARRAY_LEN( imageLoaders );
 
+// timings of the last R_LoadImage, for R_FindImageFile
+static int loadReadMsec, loadDecodeMsec;
+
 /*
 =================
-R_LoadImage
-
-Loads any of the supported image types into a canonical
-32 bit format.
+R_LoadImageFile
 =================
 */
-void R_LoadImage( const char *name, byte **pic, int *width, int *height, GLenum *picFormat, int *numMips )
+static void R_LoadImageFile( const char *name, byte **pic, int *width, int *height )
 {
     qboolean orgNameFailed = qfalse;
     int orgLoader = -1;
@@ -2293,31 +2367,10 @@ void R_LoadImage( const char *name, byte **pic, int *width, int *height, GLenum
     const char *ext;
     char *altName;
 
-    *pic = NULL;
-    *width = 0;
-    *height = 0;
-    *picFormat = GL_RGBA8;
-    *numMips = 0;
-
     Q_strncpyz( localName, name, MAX_QPATH );
 
     ext = COM_GetExtension( localName );
 
-    // If compressed textures are enabled, try loading a DDS first, it'll load fastest
-    if (r_ext_compressed_textures->integer)
-    {
-        char ddsName[MAX_QPATH];
-
-        COM_StripExtension(name, ddsName, MAX_QPATH);
-        Q_strcat(ddsName, MAX_QPATH, ".dds");
-
-        R_LoadDDS(ddsName, pic, width, height, picFormat, numMips);
-
-        // If loaded, we're done.
-        if (*pic)
-            return;
-    }
-
     if( *ext )
     {
         // Look for the correct loader and use it
@@ -2375,6 +2428,140 @@ void R_LoadImage( const char *name, byte **pic, int *width, int *height, GLenum
     }
 }
 
+/*
+=================
+R_LoadImage
+
+Loads any of the supported image types into a canonical
+32 bit format.
+=================
+*/
+void R_LoadImage( const char *name, byte **pic, int *width, int *height, GLenum *picFormat, int *numMips )
+{
+    int     start;
+
+    *pic = NULL;
+    *width = 0;
+    *height = 0;
+    *picFormat = GL_RGBA8;
+    *numMips = 0;
+
+    R_ImageReadTime();
+    start = ri.Milliseconds();
+
+    // If compressed textures are enabled, try loading a DDS first, it'll load fastest
+    if (r_ext_compressed_textures->integer)
+    {
+        char ddsName[MAX_QPATH];
+
+        COM_StripExtension(name, ddsName, MAX_QPATH);
+        Q_strcat(ddsName, MAX_QPATH, ".dds");
+
+        R_LoadDDS(ddsName, pic, width, height, picFormat, numMips);
+    }
+
+    if ( !*pic ) {
+        if ( R_TakePrefetchedImage( name, pic, width, height, &loadReadMsec, &loadDecodeMsec ) ) {
+            return;
+        }
+
+        R_LoadImageFile( name, pic, width, height );
+    }
+
+    loadReadMsec = R_ImageReadTime();
+    loadDecodeMsec = ri.Milliseconds() - start - loadReadMsec;
+}
+
+/*
+=================
+R_HaveDDS
+
+True if R_LoadImage would load a DDS for name
+=================
+*/
+static qboolean R_HaveDDS( const char *name )
+{
+    char ddsName[MAX_QPATH];
+
+    if ( !r_ext_compressed_textures->integer ) {
+        return qfalse;
+    }
+
+    COM_StripExtension( name, ddsName, MAX_QPATH );
+    Q_strcat( ddsName, MAX_QPATH, ".dds" );
+
+    return ri.FS_ReadFile( ddsName, NULL ) > 0;
+}
+
+/*
+=================
+R_FindImageSource
+
+Resolves name to the file R_LoadImage would read, without reading it.
+Returns its length, or -1 if there is none.
+=================
+*/
+static long R_FindImageSource( const char *name, char *path, int pathSize )
+{
+    qboolean renamed;
+    long length;
+    int loader;
+
+    if ( r_ext_compressed_textures->integer ) {
+        COM_StripExtension( name, path, pathSize );
+        Q_strcat( path, pathSize, ".dds" );
+
+        length = ri.FS_ReadFile( path, NULL );
+        if ( length > 0 ) {
+            return length;
+        }
+    }
+
+    return R_ReadImageSource( name, imageLoaders, numImageLoaders, path, pathSize, &loader, &renamed, NULL );
+}
+
+/*
+=================
+R_PrefetchImages
+
+Decodes the named images on the worker threads ahead of
+their registration
+=================
+*/
+void R_PrefetchImages( const char **names, int numNames )
+{
+    const char  *unloaded[MAX_PREFETCH_IMAGES];
+    image_t     *image;
+    int         numUnloaded;
+    int         i;
+
+    if ( !r_imagePrefetch->integer ) {
+        return;
+    }
+
+    numUnloaded = 0;
+    for ( i = 0; i < numNames && numUnloaded < MAX_PREFETCH_IMAGES; i++ ) {
+        for ( image = hashTable[generateHashValue( names[i] )]; image; image = image->next ) {
+            if ( !strcmp( names[i], image->imgName ) ) {
+                break;
+            }
+        }
+
+        if ( image ) {
+            continue;
+        }
+
+        // a DDS would be loaded instead
+        if ( R_HaveDDS( names[i] ) ) {
+            continue;
+        }
+
+        unloaded[numUnloaded++] = names[i];
+    }
+
+    R_PrefetchImageFiles( unloaded, numUnloaded, imageLoaders, numImageLoaders );
+}
+
 /*
 =================
 R_LoadDataImage
@@ -2401,6 +2588,82 @@ void R_LoadDataImage(const char *name, byte **pic, int *width, int *height)
     R_LoadPNGDataFile(localName, pic, width, height);
 }
 
+/*
+===============
+R_ImageCacheParams
+
+Everything besides the picture that goes into an upload
+===============
+*/
+static void R_ImageCacheParams( imgType_t type, imgFlags_t flags, char *params, int size )
+{
+    Com_sprintf( params, size, "gl2 %i %i %i %i %i %i %g %g %g %i %i %i %i %i %i %i %i %i %i",
+            type, flags, r_picmip->integer, r_roundImagesDown->integer, r_texturebits->integer,
+            r_colorMipLevels->integer, r_intensity->value, r_greyscale->value,
+            glConfig.deviceSupportsGamma ? 0.0f : r_gamma->value, tr.overbrightBits,
+            glConfig.maxTextureSize, glConfig.textureCompression, glRefConfig.textureCompression,
+            glRefConfig.swizzleNormalmap, r_parallaxMapping->integer, r_imageUpsample->integer,
+            r_imageUpsampleMaxSize->integer, r_imageUpsampleType->integer, r_imageCacheCompress->integer );
+}
+
+/*
+===============
+R_ImageCacheEncodeFormat
+
+The block format to store an image in if the driver
+left it uncompressed
+===============
+*/
+static GLenum R_ImageCacheEncodeFormat( const image_t *image )
+{
+    if ( !r_imageCacheCompress->integer || ( image->flags & IMGFLAG_NO_COMPRESSION ) ) {
+        return 0;
+    }
+
+    if ( image->type == IMGTYPE_NORMAL ) {
+        if ( ( glRefConfig.textureCompression & TCR_RGTC ) && !glRefConfig.swizzleNormalmap ) {
+            return GL_COMPRESSED_RG_RGTC2;
+        }
+
+        return 0;
+    }
+
+    if ( image->type != IMGTYPE_COLORALPHA || glConfig.textureCompression != TC_S3TC_ARB ) {
+        return 0;
+    }
+
+    switch ( image->internalFormat ) {
+        case GL_RGBA:
+        case GL_RGBA4:
+        case GL_RGBA8:
+            return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case GL_RGB:
+        case GL_RGB5:
+        case GL_RGB8:
+            return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        default:
+            return 0;
+    }
+}
+
+/*
+===============
+R_BindRetainedImage
+
+Creates an image around a texture a previous map left in the pool
+===============
+*/
+static image_t *R_BindRetainedImage( const image_t *retained )
+{
+    image_t *image;
+
+    uploadRetained = retained;
+    image = R_CreateImage2( retained->imgName, NULL, retained->width, retained->height, GL_RGBA8, 0, retained->type, retained->flags, 0 );
+    uploadRetained = NULL;
+
+    return image;
+}
+
 /*
 ===============
 R_FindImageFile
@@ -2416,8 +2679,17 @@ image_t *R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags )
     byte    *pic;
     GLenum  picFormat;
     int picNumMips;
+    int readMsec, decodeMsec;
     long    hash;
     imgFlags_t checkFlagsTrue, checkFlagsFalse;
+    imageCacheKey_t cacheKey;
+    cachedImage_t   cached;
+    const image_t   *retained;
+    int     retainKey, brightKey;
+    qboolean brightened = qfalse;
+    char    params[MAX_STRING_CHARS];
+    char    source[MAX_QPATH];
+    long    sourceLength;
 
     if (!name) {
         return NULL;
@@ -2440,6 +2712,57 @@ image_t *R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags )
         }
     }
 
+    checkFlagsTrue = IMGFLAG_PICMIP | IMGFLAG_MIPMAP | IMGFLAG_GENNORMALMAP;
+    checkFlagsFalse = IMGFLAG_CUBEMAP;
+
+    // a picture brightened for a normal map generated from it is kept
+    // apart, and only re-bound together with that normal map
+    R_ImageCacheParams( type, flags, params, sizeof( params ) );
+    sourceLength = R_FindImageSource( name, source, sizeof( source ) );
+    retainKey = R_RetainedImageKey( params, source, sourceLength );
+    brightKey = R_RetainedImageKey( va( "%s _n", params ), source, sourceLength );
+
+    //
+    // re-bind the texture a previous map left behind
+    //
+    retained = R_AcquireRetainedImage( name, retainKey );
+    if ( !retained && r_normalMapping->integer && (type == IMGTYPE_COLORALPHA) &&
+        ((flags & checkFlagsTrue) == checkFlagsTrue) && !(flags & checkFlagsFalse) )
+    {
+        char normalName[MAX_QPATH];
+
+        COM_StripExtension(name, normalName, MAX_QPATH);
+        Q_strcat(normalName, MAX_QPATH, "_n");
+
+        if ( R_HaveRetainedImage( name, brightKey ) && R_HaveRetainedImage( normalName, brightKey ) )
+        {
+            R_BindRetainedImage( R_AcquireRetainedImage( normalName, brightKey ) );
+            retained = R_AcquireRetainedImage( name, brightKey );
+        }
+    }
+    if ( retained ) {
+        return R_BindRetainedImage( retained );
+    }
+
+    //
+    // upload a processed copy from the image cache, images that
+    // generate a normal map still need their picture
+    //
+    cacheKey.path[0] = '\0';
+    if (r_imageCache->integer && !(flags & IMGFLAG_CUBEMAP) && !R_HaveDDS(name) &&
+        !(r_normalMapping->integer && (type == IMGTYPE_COLORALPHA) && ((flags & checkFlagsTrue) == checkFlagsTrue)))
+    {
+        if ( R_FindCachedImage( name, params, imageLoaders, numImageLoaders, &cacheKey, &cached ) ) {
+            uploadCache = &cached;
+            image = R_CreateImage2( ( char * ) name, NULL, cached.width, cached.height, GL_RGBA8, 0, type, flags, 0 );
+            uploadCache = NULL;
+            image->readMsec = cached.readMsec;
+            R_FreeCachedImage( &cached );
+            R_RetainImage( image, retainKey );
+            return image;
+        }
+    }
+
     //
     // load the pic from disk
     //
@@ -2448,8 +2771,10 @@ image_t *R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags )
         return NULL;
     }
 
-    checkFlagsTrue = IMGFLAG_PICMIP | IMGFLAG_MIPMAP | IMGFLAG_GENNORMALMAP;
-    checkFlagsFalse = IMGFLAG_CUBEMAP;
+    // loading the normal map below replaces these
+    readMsec = loadReadMsec;
+    decodeMsec = loadDecodeMsec;
+
     if (r_normalMapping->integer && (picFormat == GL_RGBA8) && (type == IMGTYPE_COLORALPHA) &&
         ((flags & checkFlagsTrue) == checkFlagsTrue) && !(flags & checkFlagsFalse))
     {
@@ -2549,8 +2874,11 @@ image_t *R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags )
             }
 #endif
 
-            R_CreateImage( normalName, normalPic, normalWidth, normalHeight, IMGTYPE_NORMAL, normalFlags, 0 );
+            normalImage = R_CreateImage( normalName, normalPic, normalWidth, normalHeight, IMGTYPE_NORMAL, normalFlags, 0 );
             ri.Free( normalPic );
+
+            R_RetainImage( normalImage, brightKey );
+            brightened = qtrue;
         }
     }
 
@@ -2569,7 +2897,19 @@ image_t *R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags )
     }
 
     image = R_CreateImage2( ( char * ) name, pic, width, height, picFormat, picNumMips, type, flags, 0 );
+    image->readMsec = readMsec;
+    image->decodeMsec = decodeMsec;
     ri.Free( pic );
+
+    if ( cacheKey.path[0] && picFormat == GL_RGBA8 ) {
+        // the read back is from the active unit
+        GL_BindNullTextures();
+        GL_BindToTMU( image, TB_COLORMAP );
+        R_SaveCachedImage( &cacheKey, image, R_ImageCacheEncodeFormat( image ) );
+    }
+
+    R_RetainImage( image, brightened ? brightKey : retainKey );
+
     return image;
 }
 
@@ -2932,6 +3272,9 @@ R_InitImages
 */
 void    R_InitImages( void ) {
     Com_Memset(hashTable, 0, sizeof(hashTable));
+    uploadCache = NULL;     // in case a drop interrupted a cached upload
+    uploadRetained = NULL;
+    R_BeginRetainedImages();
     // build brightness translation tables
     R_SetColorMappings();
 
@@ -2948,7 +3291,10 @@ void R_DeleteTextures( void ) {
     int     i;
 
     for ( i=0; i<tr.numImages ; i++ ) {
-        qglDeleteTextures( 1, &tr.images[i]->texnum );
+        // textures of images from files can be kept for the next map
+        if ( !R_ReleaseRetainedImage( tr.images[i] ) ) {
+            qglDeleteTextures( 1, &tr.images[i]->texnum );
+        }
     }
     Com_Memset( tr.images, 0, sizeof( tr.images ) );
 
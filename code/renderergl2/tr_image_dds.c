@@ -244,7 +244,7 @@ void R_LoadDDS ( const char *filename, byte **pic, int *width, int *height, GLen
     //
     // load the file
     //
-    len = ri.FS_ReadFile( ( char * ) filename, &buffer.v);
+    len = R_ImageReadFile( ( char * ) filename, &buffer.v);
     if (!buffer.b || len < 0) {
         return;
     }
@@ -255,7 +255,7 @@ void R_LoadDDS ( const char *filename, byte **pic, int *width, int *height, GLen
     if (len < 4 + sizeof(*ddsHeader))
     {
         ri.Printf(PRINT_ALL, "File %s is too small to be a DDS file.\n", filename);
-        ri.FS_FreeFile(buffer.v);
+        R_ImageFreeFile(buffer.v);
         return;
     }
 
@@ -265,7 +265,7 @@ void R_LoadDDS ( const char *filename, byte **pic, int *width, int *height, GLen
     if (*((ui32_t *)(buffer.b)) != EncodeFourCC("DDS "))
     {
         ri.Printf(PRINT_ALL, "File %s is not a DDS file.\n", filename);
-        ri.FS_FreeFile(buffer.v);
+        R_ImageFreeFile(buffer.v);
         return;
     }
 
@@ -278,7 +278,7 @@ void R_LoadDDS ( const char *filename, byte **pic, int *width, int *height, GLen
         if (len < 4 + sizeof(*ddsHeader) + sizeof(*ddsHeaderDxt10))
         {
             ri.Printf(PRINT_ALL, "File %s indicates a DX10 header it is too small to contain.\n", filename);
-            ri.FS_FreeFile(buffer.v);
+            R_ImageFreeFile(buffer.v);
             return;
         }
 
@@ -391,7 +391,7 @@ void R_LoadDDS ( const char *filename, byte **pic, int *width, int *height, GLen
 
             default:
                 ri.Printf(PRINT_ALL, "DDS File %s has unsupported DXGI format %d.", filename, ddsHeaderDxt10->dxgiFormat);
-                ri.FS_FreeFile(buffer.v);
+                R_ImageFreeFile(buffer.v);
                 return;
                 break;
         }
@@ -425,7 +425,7 @@ void R_LoadDDS ( const char *filename, byte **pic, int *width, int *height, GLen
             else
             {
                 ri.Printf(PRINT_ALL, "DDS File %s has unsupported FourCC.", filename);
-                ri.FS_FreeFile(buffer.v);
+                R_ImageFreeFile(buffer.v);
                 return;
             }
         }
@@ -441,7 +441,7 @@ void R_LoadDDS ( const char *filename, byte **pic, int *width, int *height, GLen
         else
         {
             ri.Printf(PRINT_ALL, "DDS File %s has unsupported RGBA format.", filename);
-            ri.FS_FreeFile(buffer.v);
+            R_ImageFreeFile(buffer.v);
             return;
         }
     }
@@ -449,7 +449,7 @@ void R_LoadDDS ( const char *filename, byte **pic, int *width, int *height, GLen
     *pic = ri.Malloc(len);
     Com_Memcpy(*pic, data, len);
 
-    ri.FS_FreeFile(buffer.v);
+    R_ImageFreeFile(buffer.v);
 }
 
 void R_SaveDDS(const char *filename, byte *pic, int width, int height, int depth)
@@ -85,6 +85,20 @@ cvar_t  *r_speeds;
 cvar_t  *r_fullbright;
 cvar_t  *r_novis;
 cvar_t  *r_nocull;
+cvar_t  *r_occlusion;
+cvar_t  *r_occlusionDebug;
+
+cvar_t  *r_imageThreads;
+cvar_t  *r_imagePrefetch;
+cvar_t  *r_imageCache;
+cvar_t  *r_imageCacheCompress;
+cvar_t  *r_shaderCache;
+cvar_t  *r_retainImages;
+
+cvar_t  *r_weatherGrid;
+cvar_t  *r_weatherGridCache;
+cvar_t  *r_simd;
+cvar_t  *r_weatherThreads;
 cvar_t  *r_facePlaneCull;
 cvar_t  *r_showcluster;
 cvar_t  *r_nocurves;
@@ -103,6 +117,9 @@ cvar_t  *r_ext_texture_float;
 cvar_t  *r_ext_framebuffer_multisample;
 cvar_t  *r_arb_seamless_cube_map;
 cvar_t  *r_arb_vertex_array_object;
+cvar_t  *r_arb_get_program_binary;
+cvar_t  *r_arb_instanced_arrays;
+cvar_t  *r_arb_buffer_storage;
 cvar_t  *r_ext_direct_state_access;
 
 cvar_t  *r_cameraExposure;
@@ -1176,6 +1193,9 @@ void R_Register( void )
     r_ext_framebuffer_multisample = ri.Cvar_Get( "r_ext_framebuffer_multisample", "0", CVAR_ARCHIVE | CVAR_LATCH);
     r_arb_seamless_cube_map = ri.Cvar_Get( "r_arb_seamless_cube_map", "0", CVAR_ARCHIVE | CVAR_LATCH);
     r_arb_vertex_array_object = ri.Cvar_Get( "r_arb_vertex_array_object", "1", CVAR_ARCHIVE | CVAR_LATCH);
+    r_arb_get_program_binary = ri.Cvar_Get( "r_arb_get_program_binary", "1", CVAR_ARCHIVE | CVAR_LATCH);
+    r_arb_instanced_arrays = ri.Cvar_Get( "r_arb_instanced_arrays", "1", CVAR_ARCHIVE | CVAR_LATCH);
+    r_arb_buffer_storage = ri.Cvar_Get( "r_arb_buffer_storage", "1", CVAR_ARCHIVE | CVAR_LATCH);
     r_ext_direct_state_access = ri.Cvar_Get("r_ext_direct_state_access", "1", CVAR_ARCHIVE | CVAR_LATCH);
 
     r_ext_texture_filter_anisotropic = ri.Cvar_Get( "r_ext_texture_filter_anisotropic",
@@ -1203,6 +1223,23 @@ void R_Register( void )
     r_customheight = ri.Cvar_Get( "r_customheight", "1024", CVAR_ARCHIVE | CVAR_LATCH );
     r_customPixelAspect = ri.Cvar_Get( "r_customPixelAspect", "1", CVAR_ARCHIVE | CVAR_LATCH );
     r_simpleMipMaps = ri.Cvar_Get( "r_simpleMipMaps", "1", CVAR_ARCHIVE | CVAR_LATCH );
+    r_imageThreads = ri.Cvar_Get( "r_imageThreads", "-1", CVAR_ARCHIVE | CVAR_LATCH );
+    ri.Cvar_CheckRange( r_imageThreads, -1, 8, qtrue );
+    r_imagePrefetch = ri.Cvar_Get( "r_imagePrefetch", "1", CVAR_ARCHIVE );
+    r_imageCache = ri.Cvar_Get( "r_imageCache", "0", CVAR_ARCHIVE );
+    r_imageCacheCompress = ri.Cvar_Get( "r_imageCacheCompress", "1", CVAR_ARCHIVE );
+    r_shaderCache = ri.Cvar_Get( "r_shaderCache", "1", CVAR_ARCHIVE );
+    r_retainImages = ri.Cvar_Get( "r_retainImages", "256", CVAR_ARCHIVE );
+    r_weatherGrid = ri.Cvar_Get( "r_weatherGrid", "64", CVAR_ARCHIVE | CVAR_LATCH );
+    ri.Cvar_CheckRange( r_weatherGrid, 0, 512, qtrue );
+    r_weatherGridCache = ri.Cvar_Get( "r_weatherGridCache", "1", CVAR_ARCHIVE );
+    r_simd = ri.Cvar_Get( "r_simd", "1", CVAR_ARCHIVE | CVAR_LATCH );
+#if idsimd
+    if ( r_simd->integer && !RB_SIMDSupported() ) {
+        ri.Cvar_Set( "r_simd", "0" );   // we don't have it! Disable support!
+    }
+#endif
+    r_weatherThreads = ri.Cvar_Get( "r_weatherThreads", "1", CVAR_ARCHIVE );
     r_vertexLight = ri.Cvar_Get( "r_vertexLight", "0", CVAR_ARCHIVE | CVAR_LATCH );
     r_uiFullScreen = ri.Cvar_Get( "r_uifullscreen", "0", 0);
     r_subdivisions = ri.Cvar_Get ("r_subdivisions", "4", CVAR_ARCHIVE | CVAR_LATCH);
@@ -1339,6 +1376,8 @@ void R_Register( void )
     r_drawentities = ri.Cvar_Get ("r_drawentities", "1", CVAR_CHEAT );
     r_ignore = ri.Cvar_Get( "r_ignore", "1", CVAR_CHEAT );
     r_nocull = ri.Cvar_Get ("r_nocull", "0", CVAR_CHEAT);
+    r_occlusion = ri.Cvar_Get ("r_occlusion", "1", CVAR_ARCHIVE);
+    r_occlusionDebug = ri.Cvar_Get ("r_occlusionDebug", "0", CVAR_CHEAT);
     r_novis = ri.Cvar_Get ("r_novis", "0", CVAR_CHEAT);
     r_showcluster = ri.Cvar_Get ("r_showcluster", "0", CVAR_CHEAT);
     r_speeds = ri.Cvar_Get ("r_speeds", "0", CVAR_CHEAT);
@@ -1369,6 +1408,7 @@ void R_Register( void )
     // removed in R_Shutdown
     ri.Cmd_AddCommand( "imagelist", R_ImageList_f );
     ri.Cmd_AddCommand( "shaderlist", R_ShaderList_f );
+    ri.Cmd_AddCommand( "clearshadercache", R_ClearShaderCache_f );
     ri.Cmd_AddCommand( "skinlist", R_SkinList_f );
     ri.Cmd_AddCommand( "modellist", R_Modellist_f );
     ri.Cmd_AddCommand( "modelist", R_ModeList_f );
@@ -1388,6 +1428,8 @@ void R_InitQueries(void)
 
     if (r_drawSunRays->integer)
         qglGenQueries(ARRAY_LEN(tr.sunFlareQuery), tr.sunFlareQuery);
+
+    R_InitFlareQueries();
 }
 
 void R_ShutDownQueries(void)
@@ -1397,6 +1439,8 @@ void R_ShutDownQueries(void)
 
     if (r_drawSunRays->integer)
         qglDeleteQueries(ARRAY_LEN(tr.sunFlareQuery), tr.sunFlareQuery);
+
+    R_ShutdownFlareQueries();
 }
 
 /*
@@ -1475,6 +1519,8 @@ void R_Init( void ) {
 
     InitOpenGL();
 
+    GLimp_SpawnJobThreads( r_imageThreads->integer );
+
     R_InitImages();
 
     if (glRefConfig.framebufferObject)
@@ -1515,6 +1561,7 @@ void RE_Shutdown( qboolean destroyWindow ) {
 
     ri.Cmd_RemoveCommand( "imagelist" );
     ri.Cmd_RemoveCommand( "shaderlist" );
+    ri.Cmd_RemoveCommand( "clearshadercache" );
     ri.Cmd_RemoveCommand( "skinlist" );
     ri.Cmd_RemoveCommand( "modellist" );
     ri.Cmd_RemoveCommand( "modelist" );
@@ -1539,8 +1586,15 @@ void RE_Shutdown( qboolean destroyWindow ) {
 
     R_DoneFreeType();
 
+    R_ClearPrefetchedImages();
+    R_ShutdownImageCache();
+    GLimp_ShutdownJobThreads();
+
+    R_ClearWorldEffectContents();
+
     // shut down platform specific OpenGL stuff
     if ( destroyWindow ) {
+        R_ShutdownRetainedImages();
         GLimp_Shutdown();
 
         Com_Memset( &glConfig, 0, sizeof( glConfig ) );
@@ -1560,11 +1614,13 @@ void RE_Shutdown( qboolean destroyWindow ) {
 =============
 RE_EndRegistration
 
-Touch all images to make sure they are resident
+Touch all images to make sure they are resident, and let go of
+the textures earlier maps left that this one did not use
 =============
 */
 void RE_EndRegistration( void ) {
     R_IssuePendingRenderCommands();
+    R_EvictRetainedImages();
     if (!ri.Sys_LowPhysicalMemory()) {
         RB_ShowImages();
     }
@@ -47,6 +47,9 @@ QGL_3_0_PROCS;
 QGL_ARB_occlusion_query_PROCS;
 QGL_ARB_framebuffer_object_PROCS;
 QGL_ARB_vertex_array_object_PROCS;
+QGL_ARB_instanced_arrays_PROCS;
+QGL_ARB_get_program_binary_PROCS;
+QGL_ARB_buffer_storage_PROCS;
 QGL_EXT_direct_state_access_PROCS;
 #undef GLE
 
@@ -64,6 +67,7 @@ typedef unsigned int glIndex_t;
 #define MAX_FBOS      64
 #define MAX_VISCOUNTS 5
 #define MAX_VAOS      4096
+#define MAX_MDV_INSTANCES 256
 
 #define MAX_CALC_PSHADOWS    64
 #define MAX_DRAWN_PSHADOWS    16 // do not increase past 32, because bit flags are used on surfaces
@@ -549,6 +553,29 @@ enum
     ATTR_INDEX_COUNT          = 16
 };
 
+// per-instance data of instanced md3 draws, in slots a vertex
+// animated model never reads
+enum
+{
+    ATTR_INDEX_INSTANCE_MATRIX0   = ATTR_INDEX_TEXCOORD2,
+    ATTR_INDEX_INSTANCE_MATRIX1   = ATTR_INDEX_TEXCOORD3,
+    ATTR_INDEX_INSTANCE_MATRIX2   = ATTR_INDEX_TEXCOORD4,
+    ATTR_INDEX_INSTANCE_VIEWORIGIN = ATTR_INDEX_PAINTCOLOR,
+    ATTR_INDEX_INSTANCE_AMBIENT   = ATTR_INDEX_LIGHTDIRECTION,
+    ATTR_INDEX_INSTANCE_DIRECTED  = ATTR_INDEX_BONE_INDEXES,
+    ATTR_INDEX_INSTANCE_LIGHTDIR  = ATTR_INDEX_BONE_WEIGHTS,
+};
+
+// per-particle data of instanced weather draws, one float stream per
+// component of the particle arrays
+enum
+{
+    ATTR_INDEX_PARTICLE_X     = ATTR_INDEX_TEXCOORD0,
+    ATTR_INDEX_PARTICLE_Y     = ATTR_INDEX_TEXCOORD1,
+    ATTR_INDEX_PARTICLE_Z     = ATTR_INDEX_TEXCOORD2,
+    ATTR_INDEX_PARTICLE_FLAGS = ATTR_INDEX_TEXCOORD3,
+};
+
 enum
 {
     ATTR_POSITION =       1 << ATTR_INDEX_POSITION,
@@ -586,9 +613,23 @@ enum
                 ATTR_BONE_WEIGHTS |
                 ATTR_POSITION2 |
                 ATTR_TANGENT2 |
-                ATTR_NORMAL2
+                ATTR_NORMAL2,
+
+    // not a vertex attrib, binds the ATTR_INDEX_INSTANCE_* names
+    ATTR_INSTANCED = 1 << ATTR_INDEX_COUNT,
+
+    // not a vertex attrib, binds the ATTR_INDEX_PARTICLE_* names
+    ATTR_PARTICLES = 1 << (ATTR_INDEX_COUNT + 1)
 };
 
+typedef struct {
+    vec4_t      modelMatrix[3];     // rows of the entity's transformMatrix
+    vec4_t      localViewOrigin;
+    vec4_t      ambientLight;       // 0-1
+    vec4_t      directedLight;
+    vec4_t      lightDir;           // world space
+} mdvInstance_t;
+
 enum
 {
     GENERICDEF_USE_DEFORM_VERTEXES  = 0x0001,
@@ -597,8 +638,9 @@ enum
     GENERICDEF_USE_FOG              = 0x0008,
     GENERICDEF_USE_RGBAGEN          = 0x0010,
     GENERICDEF_USE_BONE_ANIMATION   = 0x0020,
-    GENERICDEF_ALL                  = 0x003F,
-    GENERICDEF_COUNT                = 0x0040,
+    GENERICDEF_USE_INSTANCING       = 0x0040,
+    GENERICDEF_ALL                  = 0x007F,
+    GENERICDEF_COUNT                = 0x0080,
 };
 
 enum
@@ -628,8 +670,9 @@ enum
     LIGHTDEF_USE_PARALLAXMAP     = 0x0010,
     LIGHTDEF_USE_SHADOWMAP       = 0x0020,
     LIGHTDEF_ENTITY_BONE_ANIMATION = 0x0040,
-    LIGHTDEF_ALL                 = 0x007F,
-    LIGHTDEF_COUNT               = 0x0080
+    LIGHTDEF_USE_INSTANCING      = 0x0080,
+    LIGHTDEF_ALL                 = 0x00FF,
+    LIGHTDEF_COUNT               = 0x0100
 };
 
 enum
@@ -640,6 +683,13 @@ enum
     SHADOWMAPDEF_COUNT                = 0x0004
 };
 
+enum
+{
+    WEATHERDEF_RAIN  = 0,
+    WEATHERDEF_SNOW  = 1,
+    WEATHERDEF_COUNT = 2
+};
+
 enum
 {
     GLSL_INT,
@@ -740,6 +790,9 @@ typedef enum
 
     UNIFORM_ALPHATEST,
 
+    UNIFORM_WEATHERWIND,
+    UNIFORM_WEATHERDOWN,
+
     UNIFORM_BONEMATRIX,
 
     UNIFORM_COUNT
@@ -1394,6 +1447,7 @@ typedef struct {
     int     c_box_cull_md3_in, c_box_cull_md3_clip, c_box_cull_md3_out;
 
     int     c_leafs;
+    int     c_occluded, c_occludedEntities;
     int     c_dlightSurfaces;
     int     c_dlightSurfacesCulled;
 } frontEndCounters_t;
@@ -1422,6 +1476,7 @@ typedef struct {
     mat4_t        modelview;
     mat4_t        projection;
     mat4_t      modelviewProjection;
+    int         instances;      // number of md3 instances in the current draw, 0 if not instanced
 } glstate_t;
 
 typedef enum {
@@ -1465,6 +1520,10 @@ typedef struct {
 
     qboolean vertexArrayObject;
     qboolean directStateAccess;
+
+    qboolean programBinary;
+    qboolean instancedArrays;
+    qboolean bufferStorage;
 } glRefConfig_t;
 
 
@@ -1493,6 +1552,11 @@ typedef struct {
     int     c_fogDraws;
     int     c_dlightDraws;
 
+    int     c_mdvInstanceDraws;
+    int     c_mdvInstances;
+
+    int     c_tessRingStalls;
+
     int     msec;           // total msec for backend run
 } backEndCounters_t;
 
@@ -1516,6 +1580,10 @@ typedef struct {
     qboolean    colorMask[4];
     qboolean    framePostProcessed;
     qboolean    depthFill;
+
+    // consecutive md3 draws merged into the next surface
+    mdvInstance_t   mdvInstances[MAX_MDV_INSTANCES];
+    int             numMdvInstances;
 } backEndState_t;
 
 /*
@@ -1636,6 +1704,7 @@ typedef struct {
     shaderProgram_t ssaoShader;
     shaderProgram_t depthBlurShader[4];
     shaderProgram_t testcubeShader;
+    shaderProgram_t weatherShader[WEATHERDEF_COUNT];
 
 
     // -----------------------------------------
@@ -1678,6 +1747,9 @@ typedef struct {
 
     int                     numVaos;
     vao_t                   *vaos[MAX_VAOS];
+    GLuint                  mdvInstancesVBO;
+    vao_t                   *weatherVao;            // corners of a raindrop and a snowflake
+    GLuint                  weatherParticlesVBO;
 
     // shader indexes from other modules will be looked up in tr.shaders[]
     // shader indexes from drawsurfs will be looked up in sortedShaders[]
@@ -1758,6 +1830,9 @@ extern  cvar_t  *r_ext_texture_float;
 extern  cvar_t  *r_ext_framebuffer_multisample;
 extern  cvar_t  *r_arb_seamless_cube_map;
 extern  cvar_t  *r_arb_vertex_array_object;
+extern  cvar_t  *r_arb_get_program_binary;
+extern  cvar_t  *r_arb_instanced_arrays;
+extern  cvar_t  *r_arb_buffer_storage;
 extern  cvar_t  *r_ext_direct_state_access;
 
 extern  cvar_t  *r_nobind;                      // turns off binding to appropriate textures
@@ -1781,7 +1856,6 @@ extern  cvar_t  *r_showsky;                     // forces sky in front of all su
 extern  cvar_t  *r_shownormals;                 // draws wireframe normals
 extern  cvar_t  *r_clear;                       // force screen clear every frame
 
-extern  cvar_t  *r_shadows;                     // controls shadows: 0 = none, 1 = blur, 2 = stencil, 3 = black planar projection
 extern  cvar_t  *r_flares;                      // light flares
 
 extern  cvar_t  *r_intensity;
@@ -2103,6 +2177,7 @@ typedef struct shaderCommands_s
     int         pshadowBits;
 
     int         firstIndex;
+    int         indexBase;  // offset of indexes[0] in the tess index buffer
     int         numIndexes;
     int         numVertexes;
 
@@ -2124,6 +2199,7 @@ void RB_CheckOverflow( int verts, int indexes );
 #define RB_CHECKOVERFLOW(v,i) if (tess.numVertexes + (v) >= SHADER_MAX_VERTEXES || tess.numIndexes + (i) >= SHADER_MAX_INDEXES ) {RB_CheckOverflow(v,i);}
 
 void R_DrawElements( int numIndexes, int firstIndex );
+void R_DrawElementsInstanced( int numIndexes, int firstIndex, int numInstances );
 void RB_StageIteratorGeneric( void );
 void RB_StageIteratorSky( void );
 
@@ -2135,6 +2211,8 @@ void RB_InstantQuad2(vec4_t quadVerts[4], vec2_t texCoords[4]);
 
 void RB_ShowImages( void );
 
+void RB_RenderWorldEffectSystems( void );
+
 
 /*
 ============================================================
@@ -2158,6 +2236,8 @@ FLARES
 */
 
 void R_ClearFlares( void );
+void R_InitFlareQueries( void );
+void R_ShutdownFlareQueries( void );
 
 void RB_AddFlare( void *surface, int fogNum, vec3_t point, vec3_t color, vec3_t normal );
 void RB_AddDlightFlares( void );
@@ -2253,6 +2333,10 @@ void            R_BindVao(vao_t *vao);
 void            R_BindNullVao(void);
 
 void Vao_SetVertexPointers(vao_t *vao);
+void R_BindMdvInstances(const mdvInstance_t *instances, int numInstances);
+void R_UnbindMdvInstances(void);
+void R_BindWeatherParticles(const worldEffectParticles_t *particles, int numParticles, qboolean flags);
+void R_UnbindWeatherParticles(void);
 
 void            R_InitVaos(void);
 void            R_ShutdownVaos(void);
@@ -1595,6 +1595,11 @@ static void R_AddEntitySurface (int entityNum)
         R_RotateForEntity( ent, &tr.viewParms, &tr.or );
 
         tr.currentModel = R_GetModelByHandle( ent->e.hModel );
+        if ( tr.currentModel && R_EntityOccluded( &ent->e, tr.or.origin, tr.or.axis ) ) {
+            tr.pc.c_occludedEntities++;
+            break;
+        }
+
         if (!tr.currentModel) {
             R_AddDrawSurf( &entitySurface, tr.defaultShader, 0, 0, 0, 0 /*cubeMap*/  );
         } else {
@@ -444,6 +444,31 @@ void RE_EndScene(void)
     r_firstScenePoly = r_numpolys;
 }
 
+/*
+=====================
+R_DrawOcclusionDebug
+
+Shows the occlusion buffer of the last view that filled one
+=====================
+*/
+static void R_DrawOcclusionDebug( void ) {
+    const byte  *pixels;
+
+    pixels = R_OcclusionDebugPixels();
+    if ( !pixels ) {
+        return;
+    }
+
+    RE_StretchRaw( 0, 0, OCC_WIDTH * 2, OCC_HEIGHT * 2, OCC_WIDTH, OCC_HEIGHT, pixels, 0, qtrue );
+
+    if ( r_occlusionDebug->integer > 1 ) {
+        int     numTris, numTested, numCulled;
+
+        R_OcclusionStats( &numTris, &numTested, &numCulled );
+        ri.Printf( PRINT_ALL, "occlusion: %i occluder tris, %i tested, %i culled\n", numTris, numTested, numCulled );
+    }
+}
+
 /*
 @@@@@@@@@@@@@@@@@@@@@
 RE_RenderScene
@@ -570,4 +595,8 @@ void RE_RenderScene( const refdef_t *fd ) {
     RE_EndScene();
 
     tr.frontEndMsec += ri.Milliseconds() - startTime;
+
+    if ( r_occlusionDebug->integer ) {
+        R_DrawOcclusionDebug();
+    }
 }
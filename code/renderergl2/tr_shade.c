@@ -73,9 +73,24 @@ R_DrawElements
 
 void R_DrawElements( int numIndexes, int firstIndex )
 {
+    if (glState.currentVao == tess.vao)
+        firstIndex += tess.indexBase;
+
     qglDrawElements(GL_TRIANGLES, numIndexes, GL_INDEX_TYPE, BUFFER_OFFSET(firstIndex * sizeof(glIndex_t)));
 }
 
+/*
+==================
+R_DrawElementsInstanced
+
+==================
+*/
+
+void R_DrawElementsInstanced( int numIndexes, int firstIndex, int numInstances )
+{
+    qglDrawElementsInstanced(GL_TRIANGLES, numIndexes, GL_INDEX_TYPE, BUFFER_OFFSET(firstIndex * sizeof(glIndex_t)), numInstances);
+}
+
 
 /*
 =============================================================
@@ -1065,10 +1080,18 @@ static void RB_IterateStagesGeneric( shaderCommands_t *input )
 
     qboolean renderToCubemap = tr.renderCubeFbo && glState.currentFBO == tr.renderCubeFbo;
 
+    mat4_t viewProjection;
+
     ComputeDeformValues(&deformGen, deformParams);
 
     ComputeFogValues(fogDistanceVector, fogDepthVector, &eyeT);
 
+    // instances carry their own model matrix
+    if (glState.instances)
+    {
+        Mat4Multiply(glState.projection, backEnd.viewParms.world.modelMatrix, viewProjection);
+    }
+
     for ( stage = 0; stage < MAX_SHADER_STAGES; stage++ )
     {
         shaderStage_t *pStage = input->xstages[stage];
@@ -1099,6 +1122,11 @@ static void RB_IterateStagesGeneric( shaderCommands_t *input )
                     }
                 }
 
+                if (glState.instances)
+                {
+                    index |= LIGHTDEF_USE_INSTANCING;
+                }
+
                 if (pStage->stateBits & GLS_ATEST_BITS)
                 {
                     index |= LIGHTDEF_USE_TCGEN_AND_TCMOD;
@@ -1129,6 +1157,11 @@ static void RB_IterateStagesGeneric( shaderCommands_t *input )
                     shaderAttribs |= GENERICDEF_USE_TCGEN_AND_TCMOD;
                 }
 
+                if (glState.instances)
+                {
+                    shaderAttribs |= GENERICDEF_USE_INSTANCING;
+                }
+
                 sp = &tr.genericShader[shaderAttribs];
             }
         }
@@ -1148,6 +1181,11 @@ static void RB_IterateStagesGeneric( shaderCommands_t *input )
                 }
             }
 
+            if (glState.instances)
+            {
+                index |= LIGHTDEF_USE_INSTANCING;
+            }
+
             if (r_sunlightMode->integer && (backEnd.viewParms.flags & VPF_USESUNLIGHT) && (index & LIGHTDEF_LIGHTTYPE_MASK))
             {
                 index |= LIGHTDEF_USE_SHADOWMAP;
@@ -1171,7 +1209,10 @@ static void RB_IterateStagesGeneric( shaderCommands_t *input )
 
         GLSL_BindProgram(sp);
 
-        GLSL_SetUniformMat4(sp, UNIFORM_MODELVIEWPROJECTIONMATRIX, glState.modelviewProjection);
+        if (glState.instances)
+            GLSL_SetUniformMat4(sp, UNIFORM_MODELVIEWPROJECTIONMATRIX, viewProjection);
+        else
+            GLSL_SetUniformMat4(sp, UNIFORM_MODELVIEWPROJECTIONMATRIX, glState.modelviewProjection);
         GLSL_SetUniformVec3(sp, UNIFORM_VIEWORIGIN, backEnd.viewParms.or.origin);
         GLSL_SetUniformVec3(sp, UNIFORM_LOCALVIEWORIGIN, backEnd.or.viewOrigin);
 
@@ -1457,7 +1498,10 @@ static void RB_IterateStagesGeneric( shaderCommands_t *input )
         //
         // draw
         //
-        R_DrawElements(input->numIndexes, input->firstIndex);
+        if (glState.instances)
+            R_DrawElementsInstanced(input->numIndexes, input->firstIndex, glState.instances);
+        else
+            R_DrawElements(input->numIndexes, input->firstIndex);
 
         // allow skipping out to show just lightmaps during development
         if ( r_lightmap->integer && ( pStage->bundle[0].isLightmap || pStage->bundle[1].isLightmap ) )
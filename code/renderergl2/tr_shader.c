@@ -23,8 +23,6 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 // tr_shader.c -- this file deals with the parsing and definition of shaders
 
-static char *s_shaderText;
-
 // the shader is parsed into these global variables, then copied into
 // dynamically allocated memory if it is valid.
 static  shaderStage_t   stages[MAX_SHADER_STAGES];
@@ -34,9 +32,6 @@ static  texModInfo_t    texMods[MAX_SHADER_STAGES][TR_MAX_TEXMODS];
 #define FILE_HASH_SIZE      1024
 static  shader_t*       hashTable[FILE_HASH_SIZE];
 
-#define MAX_SHADERTEXT_HASH     2048
-static char **shaderTextHashTable[MAX_SHADERTEXT_HASH];
-
 const int lightmapsNone[MAXLIGHTMAPS] =
 {
     LIGHTMAP_NONE,
@@ -3415,64 +3410,6 @@ static shader_t *FinishShader( void ) {
 
 //========================================================================================
 
-/*
-====================
-FindShaderInShaderText
-
-Scans the combined text description of all the shader files for
-the given shader name.
-
-return NULL if not found
-
-If found, it will return a valid shader
-=====================
-*/
-static char *FindShaderInShaderText( const char *shadername ) {
-
-    char *token, *p;
-
-    int i, hash;
-
-    hash = generateHashValue(shadername, MAX_SHADERTEXT_HASH);
-
-    if(shaderTextHashTable[hash])
-    {
-        for (i = 0; shaderTextHashTable[hash][i]; i++)
-        {
-            p = shaderTextHashTable[hash][i];
-            token = COM_ParseExt(&p, qtrue);
-
-            if(!Q_stricmp(token, shadername))
-                return p;
-        }
-    }
-
-    p = s_shaderText;
-
-    if ( !p ) {
-        return NULL;
-    }
-
-    // look for label
-    while ( 1 ) {
-        token = COM_ParseExt( &p, qtrue );
-        if ( token[0] == 0 ) {
-            break;
-        }
-
-        if ( !Q_stricmp( token, shadername ) ) {
-            return p;
-        }
-        else {
-            // skip the definition
-            SkipBracedSection( &p, 0 );
-        }
-    }
-
-    return NULL;
-}
-
-
 /*
 ==================
 R_FindShaderByName
@@ -3618,7 +3555,7 @@ shader_t *R_FindShader( const char *name, const int *lightmapIndex, const byte *
     //
     // attempt to define shader from an explicit parameter file
     //
-    shaderText = FindShaderInShaderText( strippedName );
+    shaderText = R_FindShaderText( strippedName );
     if ( shaderText ) {
         // enable this when building a pak file to get a global list
         // of all explicit shaders
@@ -3976,286 +3913,6 @@ void    R_ShaderList_f (void) {
     ri.Printf (PRINT_ALL, "------------------\n");
 }
 
-/*
-====================
-ScanAndLoadShaderFiles
-
-Finds and loads all .shader files, combining them into
-a single large text block that can be scanned for shader names
-=====================
-*/
-#define MAX_SHADER_FILES    4096
-static void ScanAndLoadShaderFiles( void )
-{
-    char **shaderFiles;
-    char *buffers[MAX_SHADER_FILES] = {NULL};
-    char *p;
-    int numShaderFiles;
-    int i;
-    char *oldp, *token, *hashMem, *textEnd;
-    int shaderTextHashTableSizes[MAX_SHADERTEXT_HASH], hash, size;
-    char shaderName[MAX_QPATH];
-    int shaderLine;
-
-    long sum = 0, summand;
-    // scan for shader files
-    shaderFiles = ri.FS_ListFiles( "shaders", ".shader", &numShaderFiles );
-
-    if ( !shaderFiles || !numShaderFiles )
-    {
-        ri.Printf( PRINT_WARNING, "WARNING: no shader files found\n" );
-        return;
-    }
-
-    if ( numShaderFiles > MAX_SHADER_FILES ) {
-        numShaderFiles = MAX_SHADER_FILES;
-    }
-
-    // load and parse shader files
-    for ( i = 0; i < numShaderFiles; i++ )
-    {
-        char filename[MAX_QPATH];
-
-        // look for a .mtr file first
-        {
-            char *ext;
-            Com_sprintf( filename, sizeof( filename ), "shaders/%s", shaderFiles[i] );
-            if ( (ext = strrchr(filename, '.')) )
-            {
-                strcpy(ext, ".mtr");
-            }
-
-            if ( ri.FS_ReadFile( filename, NULL ) <= 0 )
-            {
-                Com_sprintf( filename, sizeof( filename ), "shaders/%s", shaderFiles[i] );
-            }
-        }
-
-        ri.Printf( PRINT_DEVELOPER, "...loading '%s'\n", filename );
-        summand = ri.FS_ReadFile( filename, (void **)&buffers[i] );
-
-        if ( !buffers[i] )
-            ri.Error( ERR_DROP, "Couldn't load %s", filename );
-
-        // Do a simple check on the shader structure in that file to make sure one bad shader file cannot fuck up all other shaders.
-        p = buffers[i];
-        COM_BeginParseSession(filename);
-        while(1)
-        {
-            token = COM_ParseExt(&p, qtrue);
-
-            if(!*token)
-                break;
-
-            Q_strncpyz(shaderName, token, sizeof(shaderName));
-            shaderLine = COM_GetCurrentParseLine();
-
-            token = COM_ParseExt(&p, qtrue);
-            if(token[0] != '{' || token[1] != '\0')
-            {
-                ri.Printf(PRINT_WARNING, "WARNING: Ignoring shader file %s. Shader \"%s\" on line %d missing opening brace",
-                            filename, shaderName, shaderLine);
-                if (token[0])
-                {
-                    ri.Printf(PRINT_WARNING, " (found \"%s\" on line %d)", token, COM_GetCurrentParseLine());
-                }
-                ri.Printf(PRINT_WARNING, ".\n");
-                ri.FS_FreeFile(buffers[i]);
-                buffers[i] = NULL;
-                break;
-            }
-
-            if(!SkipBracedSection(&p, 1))
-            {
-                ri.Printf(PRINT_WARNING, "WARNING: Ignoring shader file %s. Shader \"%s\" on line %d missing closing brace.\n",
-                            filename, shaderName, shaderLine);
-                ri.FS_FreeFile(buffers[i]);
-                buffers[i] = NULL;
-                break;
-            }
-        }
-
-
-        if (buffers[i])
-            sum += summand;
-    }
-
-#ifndef STANDALONE
-    // FIXME BOE
-    // Scan for original Quake III shader files too
-    // while still using Quake III base.
-    char **q3ShaderFiles;
-    int numQ3ShaderFiles;
-
-    q3ShaderFiles = ri.FS_ListFiles( "scripts", ".shader", &numQ3ShaderFiles );
-
-    if ( !q3ShaderFiles || !numQ3ShaderFiles )
-    {
-        ri.Printf( PRINT_WARNING, "WARNING: no Quake III shader files found\n" );
-        return;
-    }
-
-    if ( numShaderFiles + numQ3ShaderFiles > MAX_SHADER_FILES ) {
-        numQ3ShaderFiles = MAX_SHADER_FILES;
-    }
-
-    // load and parse shader files
-    for ( i = numShaderFiles; i < numShaderFiles + numQ3ShaderFiles; i++ )
-    {
-        char filename[MAX_QPATH];
-
-        // look for a .mtr file first
-        {
-            char *ext;
-            Com_sprintf( filename, sizeof( filename ), "scripts/%s", q3ShaderFiles[i-numShaderFiles] );
-            if ( (ext = strrchr(filename, '.')) )
-            {
-                strcpy(ext, ".mtr");
-            }
-
-            if ( ri.FS_ReadFile( filename, NULL ) <= 0 )
-            {
-                Com_sprintf( filename, sizeof( filename ), "scripts/%s", q3ShaderFiles[i-numShaderFiles] );
-            }
-        }
-
-        ri.Printf( PRINT_DEVELOPER, "...loading '%s'\n", filename );
-        summand = ri.FS_ReadFile( filename, (void **)&buffers[i] );
-
-        if ( !buffers[i] )
-            ri.Error( ERR_DROP, "Couldn't load %s", filename );
-
-        // Do a simple check on the shader structure in that file to make sure one bad shader file cannot fuck up all other shaders.
-        p = buffers[i];
-        COM_BeginParseSession(filename);
-        while(1)
-        {
-            token = COM_ParseExt(&p, qtrue);
-
-            if(!*token)
-                break;
-
-            Q_strncpyz(shaderName, token, sizeof(shaderName));
-            shaderLine = COM_GetCurrentParseLine();
-
-            token = COM_ParseExt(&p, qtrue);
-            if(token[0] != '{' || token[1] != '\0')
-            {
-                ri.Printf(PRINT_WARNING, "WARNING: Ignoring shader file %s. Shader \"%s\" on line %d missing opening brace",
-                            filename, shaderName, shaderLine);
-                if (token[0])
-                {
-                    ri.Printf(PRINT_WARNING, " (found \"%s\" on line %d)", token, COM_GetCurrentParseLine());
-                }
-                ri.Printf(PRINT_WARNING, ".\n");
-                ri.FS_FreeFile(buffers[i]);
-                buffers[i] = NULL;
-                break;
-            }
-
-            if(!SkipBracedSection(&p, 1))
-            {
-                ri.Printf(PRINT_WARNING, "WARNING: Ignoring shader file %s. Shader \"%s\" on line %d missing closing brace.\n",
-                            filename, shaderName, shaderLine);
-                ri.FS_FreeFile(buffers[i]);
-                buffers[i] = NULL;
-                break;
-            }
-        }
-
-
-        if (buffers[i])
-            sum += summand;
-    }
-
-    // build single large buffer
-    s_shaderText = ri.Hunk_Alloc( sum + (numShaderFiles + numQ3ShaderFiles) *2, h_low );
-    s_shaderText[ 0 ] = '\0';
-    textEnd = s_shaderText;
-
-    // free in reverse order, so the temp files are all dumped
-    for ( i = numShaderFiles + numQ3ShaderFiles - 1; i >= 0 ; i-- )
-    {
-        if ( !buffers[i] )
-            continue;
-
-        strcat( textEnd, buffers[i] );
-        strcat( textEnd, "\n" );
-        textEnd += strlen( textEnd );
-        ri.FS_FreeFile( buffers[i] );
-    }
-#else
-    // build single large buffer
-    s_shaderText = ri.Hunk_Alloc( sum + numShaderFiles*2, h_low );
-    s_shaderText[ 0 ] = '\0';
-    textEnd = s_shaderText;
-
-    // free in reverse order, so the temp files are all dumped
-    for ( i = numShaderFiles - 1; i >= 0 ; i-- )
-    {
-        if ( !buffers[i] )
-            continue;
-
-        strcat( textEnd, buffers[i] );
-        strcat( textEnd, "\n" );
-        textEnd += strlen( textEnd );
-        ri.FS_FreeFile( buffers[i] );
-    }
-#endif
-
-    COM_Compress( s_shaderText );
-
-    // free up memory
-    ri.FS_FreeFileList( shaderFiles );
-
-    Com_Memset(shaderTextHashTableSizes, 0, sizeof(shaderTextHashTableSizes));
-    size = 0;
-
-    p = s_shaderText;
-    // look for shader names
-    while ( 1 ) {
-        token = COM_ParseExt( &p, qtrue );
-        if ( token[0] == 0 ) {
-            break;
-        }
-
-        hash = generateHashValue(token, MAX_SHADERTEXT_HASH);
-        shaderTextHashTableSizes[hash]++;
-        size++;
-        SkipBracedSection(&p, 0);
-    }
-
-    size += MAX_SHADERTEXT_HASH;
-
-    hashMem = ri.Hunk_Alloc( size * sizeof(char *), h_low );
-
-    for (i = 0; i < MAX_SHADERTEXT_HASH; i++) {
-        shaderTextHashTable[i] = (char **) hashMem;
-        hashMem = ((char *) hashMem) + ((shaderTextHashTableSizes[i] + 1) * sizeof(char *));
-    }
-
-    Com_Memset(shaderTextHashTableSizes, 0, sizeof(shaderTextHashTableSizes));
-
-    p = s_shaderText;
-    // look for shader names
-    while ( 1 ) {
-        oldp = p;
-        token = COM_ParseExt( &p, qtrue );
-        if ( token[0] == 0 ) {
-            break;
-        }
-
-        hash = generateHashValue(token, MAX_SHADERTEXT_HASH);
-        shaderTextHashTable[hash][shaderTextHashTableSizes[hash]++] = oldp;
-
-        SkipBracedSection(&p, 0);
-    }
-
-    return;
-
-}
-
-
 /*
 ====================
 CreateInternalShaders
@@ -4330,7 +3987,7 @@ void R_InitShaders( void ) {
 
     CreateInternalShaders();
 
-    ScanAndLoadShaderFiles();
+    R_LoadShaderDatabase( ".mtr" );
 
     CreateExternalShaders();
 }
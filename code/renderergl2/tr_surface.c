@@ -1366,8 +1366,19 @@ void RB_SurfaceVaoMdvMesh(srfVaoMdvMesh_t * surface)
         }
     }
 
+    // draw every entity RB_RenderDrawSurfList merged into this one
+    if (backEnd.numMdvInstances)
+    {
+        R_BindMdvInstances(backEnd.mdvInstances, backEnd.numMdvInstances);
+    }
+
     RB_EndSurface();
 
+    if (glState.instances)
+    {
+        R_UnbindMdvInstances();
+    }
+
     // So we don't lerp surfaces that shouldn't be lerped
     glState.vertexAnimation = qfalse;
 }
@@ -429,6 +429,314 @@ void R_BindNullVao(void)
 }
 
 
+static const int mdvInstanceAttribs[] =
+{
+    ATTR_INDEX_INSTANCE_MATRIX0,
+    ATTR_INDEX_INSTANCE_MATRIX1,
+    ATTR_INDEX_INSTANCE_MATRIX2,
+    ATTR_INDEX_INSTANCE_VIEWORIGIN,
+    ATTR_INDEX_INSTANCE_AMBIENT,
+    ATTR_INDEX_INSTANCE_DIRECTED,
+    ATTR_INDEX_INSTANCE_LIGHTDIR,
+};
+
+/*
+============
+R_BindMdvInstances
+
+Uploads the per-instance data of the next draw and points the
+instance attribs of the current vao at it
+============
+*/
+void R_BindMdvInstances(const mdvInstance_t *instances, int numInstances)
+{
+    int i;
+
+    qglBindBuffer(GL_ARRAY_BUFFER, tr.mdvInstancesVBO);
+
+    // orphan the previous contents, the GPU may still be reading them
+    qglBufferData(GL_ARRAY_BUFFER, sizeof(mdvInstance_t) * MAX_MDV_INSTANCES, NULL, GL_STREAM_DRAW);
+    qglBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(mdvInstance_t) * numInstances, instances);
+
+    for (i = 0; i < ARRAY_LEN(mdvInstanceAttribs); i++)
+    {
+        int attribIndex = mdvInstanceAttribs[i];
+
+        qglVertexAttribPointer(attribIndex, 4, GL_FLOAT, GL_FALSE, sizeof(mdvInstance_t), BUFFER_OFFSET(i * sizeof(vec4_t)));
+        qglVertexAttribDivisor(attribIndex, 1);
+        qglEnableVertexAttribArray(attribIndex);
+
+        if (!glRefConfig.vertexArrayObject)
+            glState.vertexAttribsEnabled |= 1 << attribIndex;
+    }
+
+    qglBindBuffer(GL_ARRAY_BUFFER, glState.currentVao->vertexesVBO);
+
+    glState.instances = numInstances;
+}
+
+/*
+============
+R_UnbindMdvInstances
+
+Puts the current vao back the way the non-instanced draws expect it
+============
+*/
+void R_UnbindMdvInstances(void)
+{
+    int i;
+
+    for (i = 0; i < ARRAY_LEN(mdvInstanceAttribs); i++)
+    {
+        int attribIndex = mdvInstanceAttribs[i];
+
+        qglVertexAttribDivisor(attribIndex, 0);
+        qglDisableVertexAttribArray(attribIndex);
+
+        if (!glRefConfig.vertexArrayObject)
+            glState.vertexAttribsEnabled &= ~(1 << attribIndex);
+    }
+
+    glState.instances = 0;
+}
+
+
+static const int weatherParticleAttribs[] =
+{
+    ATTR_INDEX_PARTICLE_X,
+    ATTR_INDEX_PARTICLE_Y,
+    ATTR_INDEX_PARTICLE_Z,
+    ATTR_INDEX_PARTICLE_FLAGS,
+};
+
+/*
+============
+R_BindWeatherParticles
+
+Uploads the particle positions, and the flags if asked for, and points
+the particle attribs of the current vao at them
+============
+*/
+void R_BindWeatherParticles(const worldEffectParticles_t *particles, int numParticles, qboolean flags)
+{
+    int size;
+    int numAttribs;
+    int i;
+
+    // the particle arrays are padded, see R_AllocWorldEffectParticles
+    size = WE_PADDED_PARTICLES(numParticles) * sizeof(float);
+    numAttribs = flags ? ARRAY_LEN(weatherParticleAttribs) : 3;
+
+    qglBindBuffer(GL_ARRAY_BUFFER, tr.weatherParticlesVBO);
+
+    // orphan the previous contents, the GPU may still be reading them
+    qglBufferData(GL_ARRAY_BUFFER, size * numAttribs, NULL, GL_STREAM_DRAW);
+
+    for (i = 0; i < numAttribs; i++)
+    {
+        int attribIndex = weatherParticleAttribs[i];
+
+        if (attribIndex == ATTR_INDEX_PARTICLE_FLAGS)
+        {
+            qglBufferSubData(GL_ARRAY_BUFFER, i * size, size, particles->flags);
+            qglVertexAttribPointer(attribIndex, 1, GL_UNSIGNED_INT, GL_FALSE, 0, BUFFER_OFFSET(i * size));
+        }
+        else
+        {
+            qglBufferSubData(GL_ARRAY_BUFFER, i * size, size, particles->pos[i]);
+            qglVertexAttribPointer(attribIndex, 1, GL_FLOAT, GL_FALSE, 0, BUFFER_OFFSET(i * size));
+        }
+
+        qglVertexAttribDivisor(attribIndex, 1);
+        qglEnableVertexAttribArray(attribIndex);
+
+        if (!glRefConfig.vertexArrayObject)
+            glState.vertexAttribsEnabled |= 1 << attribIndex;
+    }
+
+    qglBindBuffer(GL_ARRAY_BUFFER, glState.currentVao->vertexesVBO);
+}
+
+/*
+============
+R_UnbindWeatherParticles
+============
+*/
+void R_UnbindWeatherParticles(void)
+{
+    int i;
+
+    for (i = 0; i < ARRAY_LEN(weatherParticleAttribs); i++)
+    {
+        int attribIndex = weatherParticleAttribs[i];
+
+        qglVertexAttribDivisor(attribIndex, 0);
+        qglDisableVertexAttribArray(attribIndex);
+
+        if (!glRefConfig.vertexArrayObject)
+            glState.vertexAttribsEnabled &= ~(1 << attribIndex);
+    }
+}
+
+// persistently mapped ring buffers for tess data, split into sections that
+// are fenced as the write position leaves them
+#define TESS_RING_SECTIONS 8
+#define TESS_RING_ALIGN    16
+
+typedef struct
+{
+    GLenum  target;
+    byte   *data;
+    int     sectionSize;
+    int     section;
+    int     sectionOffset;
+    GLsync  fences[TESS_RING_SECTIONS];
+}
+tessRing_t;
+
+static tessRing_t tessVertexRing;
+static tessRing_t tessIndexRing;
+
+/*
+============
+R_InitTessRing
+
+Replaces the buffer with immutable storage and maps it for good
+============
+*/
+static qboolean R_InitTessRing(tessRing_t *ring, GLenum target, GLuint *buffer, int sectionSize)
+{
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    int size = sectionSize * TESS_RING_SECTIONS;
+
+    Com_Memset(ring, 0, sizeof(*ring));
+
+    qglDeleteBuffers(1, buffer);
+    qglGenBuffers(1, buffer);
+    qglBindBuffer(target, *buffer);
+
+    qglBufferStorage(target, size, NULL, flags);
+    ring->data = qglMapBufferRange(target, 0, size, flags);
+
+    if (!ring->data)
+        return qfalse;
+
+    ring->target = target;
+    ring->sectionSize = sectionSize;
+
+    return qtrue;
+}
+
+/*
+============
+R_ShutdownTessRing
+============
+*/
+static void R_ShutdownTessRing(tessRing_t *ring)
+{
+    int i;
+
+    // deleting the buffer unmaps it
+    for (i = 0; i < TESS_RING_SECTIONS; i++)
+    {
+        if (ring->fences[i])
+            qglDeleteSync(ring->fences[i]);
+    }
+
+    Com_Memset(ring, 0, sizeof(*ring));
+}
+
+/*
+============
+RB_AllocTessRing
+
+Returns the buffer offset of size free bytes.  One flush must come from a
+single allocation, so all of its data lands in one section and is covered
+by that section's fence.
+============
+*/
+static int RB_AllocTessRing(tessRing_t *ring, int size)
+{
+    int offset;
+
+    if (ring->sectionOffset + size > ring->sectionSize)
+    {
+        GLsync fence;
+
+        // fence the section we are leaving, then wait for the GPU to finish
+        // reading the one we are entering
+        ring->fences[ring->section] = qglFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        ring->section = (ring->section + 1) % TESS_RING_SECTIONS;
+        ring->sectionOffset = 0;
+
+        fence = ring->fences[ring->section];
+        if (fence)
+        {
+            GLenum result = qglClientWaitSync(fence, 0, 0);
+
+            if (result == GL_TIMEOUT_EXPIRED)
+            {
+                backEnd.pc.c_tessRingStalls++;
+
+                do
+                {
+                    result = qglClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+                }
+                while (result == GL_TIMEOUT_EXPIRED);
+            }
+
+            qglDeleteSync(fence);
+            ring->fences[ring->section] = NULL;
+        }
+    }
+
+    offset = ring->section * ring->sectionSize + ring->sectionOffset;
+    ring->sectionOffset += PAD(size, TESS_RING_ALIGN);
+
+    return offset;
+}
+
+/*
+============
+R_InitWeatherVao
+
+A raindrop is a triangle and a snowflake a quad, both expanded from
+these corners in the weather shader
+============
+*/
+static void R_InitWeatherVao(void)
+{
+    static const vec3_t corners[] =
+    {
+        // raindrop, the x axis goes left and the y axis down
+        { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 0.0f },
+
+        // snowflake, the x axis goes left and the y axis up
+        { -1.0f, -1.0f, 0.0f }, { 1.0f, -1.0f, 0.0f }, { 1.0f, 1.0f, 0.0f }, { -1.0f, 1.0f, 0.0f }
+    };
+    static const glIndex_t indexes[] =
+    {
+        0, 1, 2,
+        3, 4, 5, 3, 5, 6
+    };
+
+    tr.weatherVao = R_CreateVao("weather_VAO", (byte *)corners, sizeof(corners), (byte *)indexes, sizeof(indexes), VAO_USAGE_STATIC);
+
+    tr.weatherVao->attribs[ATTR_INDEX_POSITION].enabled    = 1;
+    tr.weatherVao->attribs[ATTR_INDEX_POSITION].count      = 3;
+    tr.weatherVao->attribs[ATTR_INDEX_POSITION].type       = GL_FLOAT;
+    tr.weatherVao->attribs[ATTR_INDEX_POSITION].normalized = GL_FALSE;
+    tr.weatherVao->attribs[ATTR_INDEX_POSITION].offset     = 0;
+    tr.weatherVao->attribs[ATTR_INDEX_POSITION].stride     = sizeof(corners[0]);
+
+    Vao_SetVertexPointers(tr.weatherVao);
+
+    R_BindNullVao();
+
+    qglGenBuffers(1, &tr.weatherParticlesVBO);
+}
+
 /*
 ============
 R_InitVaos
@@ -534,10 +842,47 @@ void R_InitVaos(void)
     tess.attribPointers[ATTR_INDEX_COLOR]          = tess.color;
     tess.attribPointers[ATTR_INDEX_LIGHTDIRECTION] = tess.lightdir;
 
+    if (glRefConfig.bufferStorage)
+    {
+        // tess.vao is still bound, so the new buffers go into it
+        if (R_InitTessRing(&tessVertexRing, GL_ARRAY_BUFFER, &tess.vao->vertexesVBO, MAX(vertexesSize, 1 << 20))
+            && R_InitTessRing(&tessIndexRing, GL_ELEMENT_ARRAY_BUFFER, &tess.vao->indexesIBO, MAX(indexesSize, 1 << 18)))
+        {
+            tess.vao->vertexesSize = tessVertexRing.sectionSize * TESS_RING_SECTIONS;
+            tess.vao->indexesSize = tessIndexRing.sectionSize * TESS_RING_SECTIONS;
+        }
+        else
+        {
+            ri.Printf(PRINT_WARNING, "WARNING: Couldn't map tess buffers, streaming with glBufferSubData\n");
+            R_ShutdownTessRing(&tessVertexRing);
+            R_ShutdownTessRing(&tessIndexRing);
+
+            qglDeleteBuffers(1, &tess.vao->vertexesVBO);
+            qglGenBuffers(1, &tess.vao->vertexesVBO);
+            qglBindBuffer(GL_ARRAY_BUFFER, tess.vao->vertexesVBO);
+            qglBufferData(GL_ARRAY_BUFFER, vertexesSize, NULL, GL_DYNAMIC_DRAW);
+
+            qglDeleteBuffers(1, &tess.vao->indexesIBO);
+            qglGenBuffers(1, &tess.vao->indexesIBO);
+            qglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, tess.vao->indexesIBO);
+            qglBufferData(GL_ELEMENT_ARRAY_BUFFER, indexesSize, NULL, GL_DYNAMIC_DRAW);
+        }
+    }
+
     Vao_SetVertexPointers(tess.vao);
 
     R_BindNullVao();
 
+    if (glRefConfig.instancedArrays)
+    {
+        qglGenBuffers(1, &tr.mdvInstancesVBO);
+        qglBindBuffer(GL_ARRAY_BUFFER, tr.mdvInstancesVBO);
+        qglBufferData(GL_ARRAY_BUFFER, sizeof(mdvInstance_t) * MAX_MDV_INSTANCES, NULL, GL_STREAM_DRAW);
+        qglBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        R_InitWeatherVao();
+    }
+
     VaoCache_Init();
 
     GL_CheckErrors();
@@ -557,6 +902,9 @@ void R_ShutdownVaos(void)
 
     R_BindNullVao();
 
+    R_ShutdownTessRing(&tessVertexRing);
+    R_ShutdownTessRing(&tessIndexRing);
+
     for(i = 0; i < tr.numVaos; i++)
     {
         vao = tr.vaos[i];
@@ -576,6 +924,20 @@ void R_ShutdownVaos(void)
     }
 
     tr.numVaos = 0;
+
+    if (tr.mdvInstancesVBO)
+    {
+        qglDeleteBuffers(1, &tr.mdvInstancesVBO);
+        tr.mdvInstancesVBO = 0;
+    }
+
+    tr.weatherVao = NULL;
+
+    if (tr.weatherParticlesVBO)
+    {
+        qglDeleteBuffers(1, &tr.weatherParticlesVBO);
+        tr.weatherParticlesVBO = 0;
+    }
 }
 
 /*
@@ -641,18 +1003,35 @@ void RB_UpdateTessVao(unsigned int attribBits)
     {
         int attribIndex;
         int attribUpload;
+        int vertexOffset = 0;
 
         R_BindVao(tess.vao);
 
-        // orphan old vertex buffer so we don't stall on it
-        qglBufferData(GL_ARRAY_BUFFER, tess.vao->vertexesSize, NULL, GL_DYNAMIC_DRAW);
-
         // if nothing to set, set everything
         if(!(attribBits & ATTR_BITS))
             attribBits = ATTR_BITS;
 
         attribUpload = attribBits;
 
+        if (tessVertexRing.data)
+        {
+            int size = 0;
+
+            // one allocation for the whole flush
+            for (attribIndex = 0; attribIndex < ATTR_INDEX_COUNT; attribIndex++)
+            {
+                if (attribUpload & (1 << attribIndex))
+                    size += PAD(tess.numVertexes * tess.vao->attribs[attribIndex].stride, TESS_RING_ALIGN);
+            }
+
+            vertexOffset = RB_AllocTessRing(&tessVertexRing, size);
+        }
+        else
+        {
+            // orphan old vertex buffer so we don't stall on it
+            qglBufferData(GL_ARRAY_BUFFER, tess.vao->vertexesSize, NULL, GL_DYNAMIC_DRAW);
+        }
+
         for (attribIndex = 0; attribIndex < ATTR_INDEX_COUNT; attribIndex++)
         {
             uint32_t attribBit = 1 << attribIndex;
@@ -660,13 +1039,26 @@ void RB_UpdateTessVao(unsigned int attribBits)
 
             if (attribUpload & attribBit)
             {
-                // note: tess has a VBO where stride == size
-                qglBufferSubData(GL_ARRAY_BUFFER, vAtb->offset, tess.numVertexes * vAtb->stride, tess.attribPointers[attribIndex]);
+                if (tessVertexRing.data)
+                {
+                    int size = tess.numVertexes * vAtb->stride;
+
+                    // the ring is mapped, so this is the only copy made
+                    Com_Memcpy(tessVertexRing.data + vertexOffset, tess.attribPointers[attribIndex], size);
+                    qglVertexAttribPointer(attribIndex, vAtb->count, vAtb->type, vAtb->normalized, vAtb->stride, BUFFER_OFFSET(vertexOffset));
+
+                    vertexOffset += PAD(size, TESS_RING_ALIGN);
+                }
+                else
+                {
+                    // note: tess has a VBO where stride == size
+                    qglBufferSubData(GL_ARRAY_BUFFER, vAtb->offset, tess.numVertexes * vAtb->stride, tess.attribPointers[attribIndex]);
+                }
             }
 
             if (attribBits & attribBit)
             {
-                if (!glRefConfig.vertexArrayObject)
+                if (!glRefConfig.vertexArrayObject && !tessVertexRing.data)
                     qglVertexAttribPointer(attribIndex, vAtb->count, vAtb->type, vAtb->normalized, vAtb->stride, BUFFER_OFFSET(vAtb->offset));
 
                 if (!(glState.vertexAttribsEnabled & attribBit))
@@ -685,10 +1077,21 @@ void RB_UpdateTessVao(unsigned int attribBits)
             }
         }
 
-        // orphan old index buffer so we don't stall on it
-        qglBufferData(GL_ELEMENT_ARRAY_BUFFER, tess.vao->indexesSize, NULL, GL_DYNAMIC_DRAW);
+        if (tessIndexRing.data)
+        {
+            int size = tess.numIndexes * sizeof(tess.indexes[0]);
+            int indexOffset = RB_AllocTessRing(&tessIndexRing, size);
 
-        qglBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, tess.numIndexes * sizeof(tess.indexes[0]), tess.indexes);
+            Com_Memcpy(tessIndexRing.data + indexOffset, tess.indexes, size);
+            tess.indexBase = indexOffset / sizeof(tess.indexes[0]);
+        }
+        else
+        {
+            // orphan old index buffer so we don't stall on it
+            qglBufferData(GL_ELEMENT_ARRAY_BUFFER, tess.vao->indexesSize, NULL, GL_DYNAMIC_DRAW);
+
+            qglBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, tess.numIndexes * sizeof(tess.indexes[0]), tess.indexes);
+        }
     }
 }
 
@@ -23,6 +23,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "tr_local.h"
 
+#define SNOWFLAKE_RADIUS    0.4f    // about the size of the flakes drawn as points by the GL1 renderer
+
 /*
 =============================================
 ----------------
@@ -83,27 +85,6 @@ void RB_MistyFogEffectRender(worldEffectSystem_t *weSystem, worldEffect_t *effec
 
 }
 
-/*
-=============================================
------------
-Wind effect
------------
-=============================================
-*/
-
-/*
-==================
-RB_WindEffectUpdate
-
-TODO: Implement.
-==================
-*/
-
-void RB_WindEffectUpdate(worldEffectSystem_t *weSystem, worldEffect_t *effect, float elapsedTime)
-{
-
-}
-
 /*
 =============================================
 -----------
@@ -116,38 +97,72 @@ Rain system
 ==================
 RB_LoadRainImage
 
-TODO: Implement.
+Loads the specified rain image file.
 ==================
 */
 
 void RB_LoadRainImage(rainSystem_t *rainSystem, const char *fileName)
 {
+    rainSystem->image = R_FindImageFile(fileName, IMGTYPE_COLORALPHA, IMGFLAG_NO_COMPRESSION);
 
-}
-/*
-==================
-RB_RainSystemUpdate
-
-TODO: Implement.
-==================
-*/
-
-void RB_RainSystemUpdate(worldEffectSystem_t *weSystem, float elapsedTime)
-{
-
+    if(rainSystem->image){
+        qglTextureParameterfEXT(rainSystem->image->texnum, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        qglTextureParameterfEXT(rainSystem->image->texnum, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
 }
 
 /*
 ==================
 RB_RainSystemRender
 
-TODO: Implement.
+Renders all rain particles as one
+instanced draw, the weather shader
+turns each raindrop into a streak.
 ==================
 */
 
 void RB_RainSystemRender(worldEffectSystem_t *weSystem)
 {
-
+    rainSystem_t            *rainSystem;
+    shaderProgram_t         *sp;
+    vec4_t                  color;
+    vec3_t                  left, down;
+    vec2_t                  wind;
+
+    rainSystem  = (rainSystem_t *)weSystem;
+    sp          = &tr.weatherShader[WEATHERDEF_RAIN];
+
+    // Only render the player is currently outside
+    // or if the effect is currently fading out.
+    if(!weSystem->isRendering){
+        return;
+    }
+
+    VectorScale(backEnd.viewParms.or.axis[1], 0.2f, left);
+    wind[0] = rainSystem->windDirection[0] * rainSystem->windAngle;
+    wind[1] = rainSystem->windDirection[1] * rainSystem->windAngle;
+    VectorSet(down, -wind[0] * rainSystem->rainHeight, -wind[1] * rainSystem->rainHeight, -rainSystem->rainHeight);
+    VectorSet4(color, 1.0f, 1.0f, 1.0f, rainSystem->alpha * rainSystem->fadeAlpha);
+
+    GL_BindToTMU(rainSystem->image, TB_DIFFUSEMAP);
+
+    GL_State(GLS_ALPHA);
+    GL_Cull(CT_TWO_SIDED);
+
+    GLSL_BindProgram(sp);
+    GLSL_SetUniformMat4(sp, UNIFORM_MODELVIEWPROJECTIONMATRIX, glState.modelviewProjection);
+    GLSL_SetUniformVec3(sp, UNIFORM_VIEWORIGIN, backEnd.viewParms.or.origin);
+    GLSL_SetUniformVec3(sp, UNIFORM_VIEWLEFT, left);
+    GLSL_SetUniformVec2(sp, UNIFORM_WEATHERWIND, wind);
+    GLSL_SetUniformVec3(sp, UNIFORM_WEATHERDOWN, down);
+    GLSL_SetUniformVec4(sp, UNIFORM_COLOR, color);
+
+    R_BindVao(tr.weatherVao);
+    R_BindWeatherParticles(&weSystem->particles, weSystem->numParticles, qfalse);
+
+    R_DrawElementsInstanced(3, 0, weSystem->numParticles);
+
+    R_UnbindWeatherParticles();
 }
 
 /*
@@ -160,26 +175,99 @@ Snow system
 
 /*
 ==================
-RB_SnowSystemUpdate
+RB_SnowSystemRender
 
-TODO: Implement.
+Renders all snow particles
+currently marked to be
+rendered.  The flakes that
+aren't are collapsed by the
+weather shader.
 ==================
 */
 
-void RB_SnowSystemUpdate(worldEffectSystem_t *weSystem, float elapsedTime)
+void RB_SnowSystemRender(worldEffectSystem_t *weSystem)
 {
+    snowSystem_t            *snowSystem;
+    shaderProgram_t         *sp;
+    vec4_t                  color;
+    vec3_t                  left, up;
+
+    snowSystem  = (snowSystem_t *)weSystem;
+    sp          = &tr.weatherShader[WEATHERDEF_SNOW];
+
+    // Only render if any particle is currently outside.
+    if(!weSystem->isRendering){
+        return;
+    }
+
+    R_RenderWorldEffects(weSystem);
+
+    VectorScale(backEnd.viewParms.or.axis[1], SNOWFLAKE_RADIUS, left);
+    VectorScale(backEnd.viewParms.or.axis[2], SNOWFLAKE_RADIUS, up);
+    VectorSet4(color, 0.8f, 0.8f, 0.8f, snowSystem->alpha);
+
+    GL_State(GLS_ALPHA);
+    GL_Cull(CT_TWO_SIDED);
 
+    GLSL_BindProgram(sp);
+    GLSL_SetUniformMat4(sp, UNIFORM_MODELVIEWPROJECTIONMATRIX, glState.modelviewProjection);
+    GLSL_SetUniformVec3(sp, UNIFORM_VIEWLEFT, left);
+    GLSL_SetUniformVec3(sp, UNIFORM_VIEWUP, up);
+    GLSL_SetUniformVec4(sp, UNIFORM_COLOR, color);
+
+    R_BindVao(tr.weatherVao);
+    R_BindWeatherParticles(&weSystem->particles, weSystem->numParticles, qtrue);
+
+    R_DrawElementsInstanced(6, 3, weSystem->numParticles);
+
+    R_UnbindWeatherParticles();
 }
 
+//==============================================
+
 /*
 ==================
-RB_SnowSystemRender
+RB_RenderWorldEffectSystems
 
-TODO: Implement.
+Updates and renders all active world
+effect systems along with their
+associated world effects.  Only the
+main view of the world gets them, so
+the particles move once per frame.
 ==================
 */
 
-void RB_SnowSystemRender(worldEffectSystem_t *weSystem)
+void RB_RenderWorldEffectSystems(void)
 {
+    static int  lastTime;
+    float       frameTime;
+
+    // Only render world effect systems if there is a world
+    // and it is being rendered.
+    if(backEnd.refdef.rdflags & RDF_NOWORLDMODEL || !tr.world){
+        return;
+    }
+
+    if(backEnd.viewParms.isPortal || backEnd.viewParms.flags & (VPF_SHADOWMAP | VPF_DEPTHSHADOW)){
+        return;
+    }
+
+    if(tr.renderCubeFbo && backEnd.viewParms.targetFbo == tr.renderCubeFbo){
+        return;
+    }
+
+    // The particles are expanded by the weather shader,
+    // which needs instanced arrays.
+    if(!tr.weatherVao){
+        return;
+    }
+
+    frameTime   = Com_Clamp(0, 500, backEnd.refdef.time - lastTime);
+    lastTime    = backEnd.refdef.time;
+
+    GL_SetModelviewMatrix(backEnd.viewParms.world.modelMatrix);
 
+    // Let the world effect system handler update
+    // and render all systems initialized.
+    R_RenderWorldEffectSystems(frameTime * 0.001f, backEnd.viewParms.or.origin);
 }
@@ -733,6 +733,70 @@ static void R_MarkLeaves (void) {
 }
 
 
+/*
+================
+R_AddWorldOccluders
+
+Rasterizes the large surfaces flagged by R_RecursiveWorldNode into the
+occlusion buffer, faces only when they face the view
+================
+*/
+static void R_AddWorldOccluders( void ) {
+    int     i, j;
+
+    for ( i = 0 ; i < tr.world->numWorldSurfaces ; i++ ) {
+        msurface_t      *surf;
+        srfBspSurface_t *bsp;
+
+        if ( tr.world->surfacesViewCount[i] != tr.viewCount ) {
+            continue;
+        }
+
+        surf = tr.world->surfaces + i;
+
+        if ( !( surf->cullinfo.type & CULLINFO_BOX ) ) {
+            continue;
+        }
+
+        for ( j = 0 ; j < 3 ; j++ ) {
+            if ( surf->cullinfo.bounds[1][j] - surf->cullinfo.bounds[0][j] >= OCC_OCCLUDER_SIZE ) {
+                break;
+            }
+        }
+        if ( j == 3 ) {
+            continue;
+        }
+
+        if ( !R_ShaderIsOccluder( surf->shader ) ) {
+            continue;
+        }
+
+        switch ( *surf->data ) {
+        case SF_FACE:
+            if ( surf->cullinfo.type & CULLINFO_PLANE ) {
+                float d = DotProduct( tr.viewParms.or.origin, surf->cullinfo.plane.normal ) - surf->cullinfo.plane.dist;
+
+                if ( surf->shader->cullType == CT_FRONT_SIDED && d < 0 ) {
+                    continue;
+                }
+                if ( surf->shader->cullType == CT_BACK_SIDED && d > 0 ) {
+                    continue;
+                }
+            }
+            // fall through
+        case SF_GRID:
+        case SF_TRIANGLES:
+            bsp = (srfBspSurface_t *)surf->data;
+            R_OcclusionAddTriangles( bsp->verts[0].xyz, sizeof( bsp->verts[0] ), (const int *)bsp->indexes, bsp->numIndexes );
+            break;
+        default:
+            break;
+        }
+    }
+
+    R_OcclusionFinishOccluders( r_occlusionDebug->integer != 0 );
+}
+
 /*
 =============
 R_AddWorldSurfaces
@@ -741,6 +805,9 @@ R_AddWorldSurfaces
 void R_AddWorldSurfaces (void) {
     uint32_t planeBits, dlightBits, pshadowBits;
 
+    // entities are only tested in views that drew occluders
+    R_OcclusionEndView();
+
     if ( !r_drawworld->integer ) {
         return;
     }
@@ -788,6 +855,13 @@ void R_AddWorldSurfaces (void) {
 
     R_RecursiveWorldNode( tr.world->nodes, planeBits, dlightBits, pshadowBits);
 
+    if ( r_occlusion->integer && !r_nocull->integer && !tr.viewParms.isPortal
+        && !( tr.viewParms.flags & ( VPF_SHADOWMAP | VPF_DEPTHSHADOW | VPF_ORTHOGRAPHIC ) ) )
+    {
+        R_OcclusionBeginView( tr.viewParms.or.origin, tr.viewParms.or.axis, tr.viewParms.fovX, tr.viewParms.fovY );
+        R_AddWorldOccluders();
+    }
+
     // now add all the potentially visible surfaces
     // also mask invisible dlights for next frame
     {
@@ -800,6 +874,13 @@ void R_AddWorldSurfaces (void) {
             if (tr.world->surfacesViewCount[i] != tr.viewCount)
                 continue;
 
+            if ( R_OcclusionActive() && ( tr.world->surfaces[i].cullinfo.type & CULLINFO_BOX )
+                && R_OcclusionCullBox( tr.world->surfaces[i].cullinfo.bounds[0], tr.world->surfaces[i].cullinfo.bounds[1] ) )
+            {
+                tr.pc.c_occluded++;
+                continue;
+            }
+
             R_AddWorldSurface( tr.world->surfaces + i, tr.world->surfacesDlightBits[i], tr.world->surfacesPshadowBits[i] );
             tr.refdef.dlightMask |= tr.world->surfacesDlightBits[i];
         }
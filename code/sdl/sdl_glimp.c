@@ -48,6 +48,8 @@ typedef enum
 SDL_Window *SDL_window = NULL;
 static SDL_GLContext SDL_glContext = NULL;
 
+static SDL_Thread *renderThread = NULL;
+
 cvar_t *r_allowSoftwareGL; // Don't abort out if a hardware visual can't be obtained
 cvar_t *r_allowResize; // make window resizable
 cvar_t *r_centerWindow;
@@ -80,6 +82,9 @@ QGL_3_0_PROCS;
 QGL_ARB_occlusion_query_PROCS;
 QGL_ARB_framebuffer_object_PROCS;
 QGL_ARB_vertex_array_object_PROCS;
+QGL_ARB_instanced_arrays_PROCS;
+QGL_ARB_get_program_binary_PROCS;
+QGL_ARB_buffer_storage_PROCS;
 QGL_EXT_direct_state_access_PROCS;
 #undef GLE
 
@@ -90,6 +95,8 @@ GLimp_Shutdown
 */
 void GLimp_Shutdown( void )
 {
+    GLimp_ShutdownRenderThread();
+
     ri.IN_Shutdown();
 
     SDL_QuitSubSystem( SDL_INIT_VIDEO );
@@ -353,6 +360,9 @@ static void GLimp_ClearProcAddresses( void ) {
     QGL_ARB_occlusion_query_PROCS;
     QGL_ARB_framebuffer_object_PROCS;
     QGL_ARB_vertex_array_object_PROCS;
+    QGL_ARB_instanced_arrays_PROCS;
+    QGL_ARB_get_program_binary_PROCS;
+    QGL_ARB_buffer_storage_PROCS;
     QGL_EXT_direct_state_access_PROCS;
 
     qglActiveTextureARB = NULL;
@@ -946,6 +956,97 @@ static void GLimp_InitExtensions( qboolean fixedFunction )
             ri.Printf( PRINT_ALL, "...GL_EXT_compiled_vertex_array not found\n" );
         }
 
+        // GL_ARB_texture_compression, core in OpenGL 1.3, for the image cache
+        qglCompressedTexImage2D = NULL;
+        qglGetCompressedTexImage = NULL;
+        if ( glConfig.textureCompression == TC_S3TC_ARB )
+        {
+            if ( QGL_VERSION_ATLEAST( 1, 3 ) )
+            {
+                qglCompressedTexImage2D = SDL_GL_GetProcAddress( "glCompressedTexImage2D" );
+                qglGetCompressedTexImage = SDL_GL_GetProcAddress( "glGetCompressedTexImage" );
+            }
+            else
+            {
+                qglCompressedTexImage2D = SDL_GL_GetProcAddress( "glCompressedTexImage2DARB" );
+                qglGetCompressedTexImage = SDL_GL_GetProcAddress( "glGetCompressedTexImageARB" );
+            }
+        }
+        if ( !qglCompressedTexImage2D || !qglGetCompressedTexImage )
+        {
+            qglCompressedTexImage2D = NULL;
+            qglGetCompressedTexImage = NULL;
+        }
+
+        // GL_ARB_vertex_buffer_object, core in OpenGL 1.5
+        qglBindBuffer = NULL;
+        qglDeleteBuffers = NULL;
+        qglGenBuffers = NULL;
+        qglBufferData = NULL;
+        qglBufferSubData = NULL;
+        if ( QGL_VERSION_ATLEAST( 1, 5 ) )
+        {
+            ri.Printf( PRINT_ALL, "...using OpenGL 1.5 vertex buffer objects\n" );
+            qglBindBuffer = SDL_GL_GetProcAddress( "glBindBuffer" );
+            qglDeleteBuffers = SDL_GL_GetProcAddress( "glDeleteBuffers" );
+            qglGenBuffers = SDL_GL_GetProcAddress( "glGenBuffers" );
+            qglBufferData = SDL_GL_GetProcAddress( "glBufferData" );
+            qglBufferSubData = SDL_GL_GetProcAddress( "glBufferSubData" );
+        }
+        else if ( SDL_GL_ExtensionSupported( "GL_ARB_vertex_buffer_object" ) )
+        {
+            ri.Printf( PRINT_ALL, "...using GL_ARB_vertex_buffer_object\n" );
+            qglBindBuffer = SDL_GL_GetProcAddress( "glBindBufferARB" );
+            qglDeleteBuffers = SDL_GL_GetProcAddress( "glDeleteBuffersARB" );
+            qglGenBuffers = SDL_GL_GetProcAddress( "glGenBuffersARB" );
+            qglBufferData = SDL_GL_GetProcAddress( "glBufferDataARB" );
+            qglBufferSubData = SDL_GL_GetProcAddress( "glBufferSubDataARB" );
+        }
+        else
+        {
+            ri.Printf( PRINT_ALL, "...GL_ARB_vertex_buffer_object not found\n" );
+        }
+        if ( !qglBindBuffer || !qglDeleteBuffers || !qglGenBuffers || !qglBufferData || !qglBufferSubData )
+        {
+            qglGenBuffers = NULL;
+        }
+
+        // GL_ARB_occlusion_query, core in OpenGL 1.5
+        qglGenQueries = NULL;
+        qglDeleteQueries = NULL;
+        qglBeginQuery = NULL;
+        qglEndQuery = NULL;
+        qglGetQueryObjectiv = NULL;
+        qglGetQueryObjectuiv = NULL;
+        if ( QGL_VERSION_ATLEAST( 1, 5 ) )
+        {
+            ri.Printf( PRINT_ALL, "...using OpenGL 1.5 occlusion queries\n" );
+            qglGenQueries = SDL_GL_GetProcAddress( "glGenQueries" );
+            qglDeleteQueries = SDL_GL_GetProcAddress( "glDeleteQueries" );
+            qglBeginQuery = SDL_GL_GetProcAddress( "glBeginQuery" );
+            qglEndQuery = SDL_GL_GetProcAddress( "glEndQuery" );
+            qglGetQueryObjectiv = SDL_GL_GetProcAddress( "glGetQueryObjectiv" );
+            qglGetQueryObjectuiv = SDL_GL_GetProcAddress( "glGetQueryObjectuiv" );
+        }
+        else if ( SDL_GL_ExtensionSupported( "GL_ARB_occlusion_query" ) )
+        {
+            ri.Printf( PRINT_ALL, "...using GL_ARB_occlusion_query\n" );
+            qglGenQueries = SDL_GL_GetProcAddress( "glGenQueriesARB" );
+            qglDeleteQueries = SDL_GL_GetProcAddress( "glDeleteQueriesARB" );
+            qglBeginQuery = SDL_GL_GetProcAddress( "glBeginQueryARB" );
+            qglEndQuery = SDL_GL_GetProcAddress( "glEndQueryARB" );
+            qglGetQueryObjectiv = SDL_GL_GetProcAddress( "glGetQueryObjectivARB" );
+            qglGetQueryObjectuiv = SDL_GL_GetProcAddress( "glGetQueryObjectuivARB" );
+        }
+        else
+        {
+            ri.Printf( PRINT_ALL, "...GL_ARB_occlusion_query not found\n" );
+        }
+        if ( !qglGenQueries || !qglDeleteQueries || !qglBeginQuery || !qglEndQuery || !qglGetQueryObjectuiv )
+        {
+            qglGenQueries = NULL;
+        }
+
         // GL_EXT_point_parameters
         if ( SDL_GL_ExtensionSupported( "GL_EXT_point_parameters" ) )
         {
@@ -1100,19 +1201,13 @@ success:
 
 /*
 ===============
-GLimp_EndFrame
+GLimp_CheckFullscreen
 
-Responsible for doing a swapbuffers
+Applies r_fullscreen changes, the window belongs to the main thread
 ===============
 */
-void GLimp_EndFrame( void )
+static void GLimp_CheckFullscreen( void )
 {
-    // don't flip if drawing to front buffer
-    if ( Q_stricmp( r_drawBuffer->string, "GL_FRONT" ) != 0 )
-    {
-        SDL_GL_SwapWindow( SDL_window );
-    }
-
     if( r_fullscreen->modified )
     {
         int         fullscreen;
@@ -1146,3 +1241,528 @@ void GLimp_EndFrame( void )
         r_fullscreen->modified = qfalse;
     }
 }
+
+/*
+===============
+GLimp_EndFrame
+
+Responsible for doing a swapbuffers
+===============
+*/
+void GLimp_EndFrame( void )
+{
+    // don't flip if drawing to front buffer
+    if ( Q_stricmp( r_drawBuffer->string, "GL_FRONT" ) != 0 )
+    {
+        SDL_GL_SwapWindow( SDL_window );
+    }
+
+    // the render thread leaves this to GLimp_WakeRenderer
+    if( !renderThread )
+    {
+        GLimp_CheckFullscreen( );
+    }
+}
+
+/*
+===========================================================
+
+SMP acceleration
+
+The render thread and the front end hand the GL context
+back and forth: the front end gives it up when it wakes the
+renderer, the renderer only gives it up again when the front
+end asks for it to do GL work of its own.
+
+===========================================================
+*/
+
+static SDL_mutex *smpMutex = NULL;
+static SDL_cond *renderCommandsEvent = NULL;
+static SDL_cond *renderCompletedEvent = NULL;
+static void (*renderThreadFunction)( void ) = NULL;
+
+static void *smpData = NULL;
+static qboolean smpDataReady;
+static qboolean smpContextRequested;
+
+static qboolean rendererBusy;           // only touched by the render thread
+static qboolean rendererHasContext;     // only touched by the render thread
+static qboolean frontEndHasContext;     // only touched by the front end
+
+/*
+===============
+GLimp_RenderThreadWrapper
+===============
+*/
+static int GLimp_RenderThreadWrapper( void *arg )
+{
+    renderThreadFunction();
+
+    if( rendererHasContext )
+    {
+        SDL_GL_MakeCurrent( SDL_window, NULL );
+        rendererHasContext = qfalse;
+    }
+
+    return 0;
+}
+
+/*
+===============
+GLimp_SpawnRenderThread
+===============
+*/
+qboolean GLimp_SpawnRenderThread( void (*function)( void ) )
+{
+    if( renderThread )
+    {
+        ri.Printf( PRINT_WARNING, "Already running a render thread\n" );
+        return qfalse;
+    }
+
+    smpMutex = SDL_CreateMutex( );
+    renderCommandsEvent = SDL_CreateCond( );
+    renderCompletedEvent = SDL_CreateCond( );
+
+    if( !smpMutex || !renderCommandsEvent || !renderCompletedEvent )
+    {
+        ri.Printf( PRINT_ALL, "smp primitives failed: %s\n", SDL_GetError( ) );
+        GLimp_ShutdownRenderThread( );
+        return qfalse;
+    }
+
+    smpData = NULL;
+    smpDataReady = qfalse;
+    smpContextRequested = qfalse;
+    rendererBusy = qfalse;
+    rendererHasContext = qfalse;
+    frontEndHasContext = qtrue;
+
+    renderThreadFunction = function;
+    renderThread = SDL_CreateThread( GLimp_RenderThreadWrapper, "renderer", NULL );
+
+    if( !renderThread )
+    {
+        ri.Printf( PRINT_ALL, "SDL_CreateThread() failed: %s\n", SDL_GetError( ) );
+        GLimp_ShutdownRenderThread( );
+        return qfalse;
+    }
+
+    return qtrue;
+}
+
+/*
+===============
+GLimp_ShutdownRenderThread
+===============
+*/
+void GLimp_ShutdownRenderThread( void )
+{
+    if( renderThread )
+    {
+        GLimp_FrontEndSleep( );
+        GLimp_WakeRenderer( NULL );
+        SDL_WaitThread( renderThread, NULL );
+        renderThread = NULL;
+
+        // the front end owns the context again
+        SDL_GL_MakeCurrent( SDL_window, SDL_glContext );
+        frontEndHasContext = qtrue;
+    }
+
+    if( smpMutex )
+    {
+        SDL_DestroyMutex( smpMutex );
+        smpMutex = NULL;
+    }
+
+    if( renderCommandsEvent )
+    {
+        SDL_DestroyCond( renderCommandsEvent );
+        renderCommandsEvent = NULL;
+    }
+
+    if( renderCompletedEvent )
+    {
+        SDL_DestroyCond( renderCompletedEvent );
+        renderCompletedEvent = NULL;
+    }
+
+    renderThreadFunction = NULL;
+}
+
+/*
+===============
+GLimp_RendererSleep
+
+Called by the render thread when it is done with a command list,
+returns the next one or NULL when it should exit
+===============
+*/
+void *GLimp_RendererSleep( void )
+{
+    void *data;
+
+    SDL_LockMutex( smpMutex );
+    {
+        if( rendererBusy )
+        {
+            smpData = NULL;
+            rendererBusy = qfalse;
+
+            // after this, the front end can exit GLimp_FrontEndSleep
+            SDL_CondSignal( renderCompletedEvent );
+        }
+
+        for( ;; )
+        {
+            if( smpContextRequested )
+            {
+                if( rendererHasContext )
+                {
+                    SDL_GL_MakeCurrent( SDL_window, NULL );
+                    rendererHasContext = qfalse;
+                }
+
+                smpContextRequested = qfalse;
+                SDL_CondSignal( renderCompletedEvent );
+            }
+
+            if( smpDataReady )
+                break;
+
+            SDL_CondWait( renderCommandsEvent, smpMutex );
+        }
+
+        smpDataReady = qfalse;
+        data = smpData;
+        rendererBusy = ( data != NULL );
+    }
+    SDL_UnlockMutex( smpMutex );
+
+    if( data && !rendererHasContext )
+    {
+        SDL_GL_MakeCurrent( SDL_window, SDL_glContext );
+        rendererHasContext = qtrue;
+    }
+
+    return data;
+}
+
+/*
+===============
+GLimp_FrontEndSleep
+
+Waits until the render thread has finished the last command list
+===============
+*/
+void GLimp_FrontEndSleep( void )
+{
+    SDL_LockMutex( smpMutex );
+    {
+        while( smpData )
+            SDL_CondWait( renderCompletedEvent, smpMutex );
+    }
+    SDL_UnlockMutex( smpMutex );
+}
+
+/*
+===============
+GLimp_FrontEndAcquireContext
+
+Waits for the render thread and makes the context current
+on the front end, so it can call GL directly
+===============
+*/
+void GLimp_FrontEndAcquireContext( void )
+{
+    if( frontEndHasContext )
+        return;
+
+    SDL_LockMutex( smpMutex );
+    {
+        while( smpData )
+            SDL_CondWait( renderCompletedEvent, smpMutex );
+
+        smpContextRequested = qtrue;
+        SDL_CondSignal( renderCommandsEvent );
+
+        while( smpContextRequested )
+            SDL_CondWait( renderCompletedEvent, smpMutex );
+    }
+    SDL_UnlockMutex( smpMutex );
+
+    SDL_GL_MakeCurrent( SDL_window, SDL_glContext );
+    frontEndHasContext = qtrue;
+}
+
+/*
+===============
+GLimp_WakeRenderer
+
+Hands a command list to the idle render thread, NULL makes it exit
+===============
+*/
+void GLimp_WakeRenderer( void *data )
+{
+    // the renderer is idle, so the window can be changed safely
+    if( data )
+        GLimp_CheckFullscreen( );
+
+    if( frontEndHasContext )
+    {
+        SDL_GL_MakeCurrent( SDL_window, NULL );
+        frontEndHasContext = qfalse;
+    }
+
+    SDL_LockMutex( smpMutex );
+    {
+        assert( smpData == NULL );
+        smpData = data;
+        smpDataReady = qtrue;
+
+        // after this, the renderer can continue through GLimp_RendererSleep
+        SDL_CondSignal( renderCommandsEvent );
+    }
+    SDL_UnlockMutex( smpMutex );
+}
+
+/*
+===============
+GLimp_RendererActive
+
+Returns qtrue if the render thread is still working on a command list
+===============
+*/
+qboolean GLimp_RendererActive( void )
+{
+    qboolean active;
+
+    SDL_LockMutex( smpMutex );
+    active = smpData != NULL;
+    SDL_UnlockMutex( smpMutex );
+
+    return active;
+}
+
+/*
+===========================================================
+
+Worker threads
+
+A small pool for CPU-side texture work.  GLimp_RunJobs
+spreads a loop over the workers and the calling thread and
+returns once every index has run.  Workers never touch GL,
+so uploads stay on whichever thread owns the context.
+
+===========================================================
+*/
+
+#define MAX_JOB_THREADS 8
+
+static SDL_Thread *jobThreads[MAX_JOB_THREADS];
+static int numJobThreads = 0;
+
+static SDL_mutex *jobMutex = NULL;
+static SDL_cond *jobStartEvent = NULL;
+static SDL_cond *jobDoneEvent = NULL;
+
+static void (*jobFunction)( void *data, int index ) = NULL;
+static void *jobData = NULL;
+static int jobNext, jobCount, jobPending;
+static qboolean jobQuit;
+
+/*
+===============
+GLimp_JobThreadWrapper
+===============
+*/
+static int GLimp_JobThreadWrapper( void *arg )
+{
+    SDL_LockMutex( jobMutex );
+
+    for( ;; )
+    {
+        int index;
+
+        while( !jobQuit && jobNext >= jobCount )
+            SDL_CondWait( jobStartEvent, jobMutex );
+
+        if( jobQuit )
+            break;
+
+        index = jobNext++;
+        SDL_UnlockMutex( jobMutex );
+
+        jobFunction( jobData, index );
+
+        SDL_LockMutex( jobMutex );
+        if( --jobPending == 0 )
+            SDL_CondSignal( jobDoneEvent );
+    }
+
+    SDL_UnlockMutex( jobMutex );
+
+    return 0;
+}
+
+/*
+===============
+GLimp_SpawnJobThreads
+
+A negative count picks one worker per spare CPU core
+===============
+*/
+void GLimp_SpawnJobThreads( int count )
+{
+    int i;
+
+    if( numJobThreads )
+        return;
+
+    if( count < 0 )
+        count = SDL_GetCPUCount( ) - 1;
+
+    if( count > MAX_JOB_THREADS )
+        count = MAX_JOB_THREADS;
+
+    if( count <= 0 )
+        return;
+
+    jobMutex = SDL_CreateMutex( );
+    jobStartEvent = SDL_CreateCond( );
+    jobDoneEvent = SDL_CreateCond( );
+
+    if( !jobMutex || !jobStartEvent || !jobDoneEvent )
+    {
+        ri.Printf( PRINT_ALL, "job primitives failed: %s\n", SDL_GetError( ) );
+        GLimp_ShutdownJobThreads( );
+        return;
+    }
+
+    jobNext = jobCount = jobPending = 0;
+    jobQuit = qfalse;
+
+    for( i = 0; i < count; i++ )
+    {
+        jobThreads[i] = SDL_CreateThread( GLimp_JobThreadWrapper, "rjob", NULL );
+
+        if( !jobThreads[i] )
+        {
+            ri.Printf( PRINT_ALL, "SDL_CreateThread() failed: %s\n", SDL_GetError( ) );
+            break;
+        }
+
+        numJobThreads++;
+    }
+
+    if( !numJobThreads )
+    {
+        GLimp_ShutdownJobThreads( );
+        return;
+    }
+
+    ri.Printf( PRINT_ALL, "Using %d worker threads for image processing\n", numJobThreads );
+}
+
+/*
+===============
+GLimp_ShutdownJobThreads
+===============
+*/
+void GLimp_ShutdownJobThreads( void )
+{
+    int i;
+
+    if( numJobThreads )
+    {
+        SDL_LockMutex( jobMutex );
+        jobQuit = qtrue;
+        SDL_CondBroadcast( jobStartEvent );
+        SDL_UnlockMutex( jobMutex );
+
+        for( i = 0; i < numJobThreads; i++ )
+        {
+            SDL_WaitThread( jobThreads[i], NULL );
+            jobThreads[i] = NULL;
+        }
+
+        numJobThreads = 0;
+    }
+
+    if( jobMutex )
+    {
+        SDL_DestroyMutex( jobMutex );
+        jobMutex = NULL;
+    }
+
+    if( jobStartEvent )
+    {
+        SDL_DestroyCond( jobStartEvent );
+        jobStartEvent = NULL;
+    }
+
+    if( jobDoneEvent )
+    {
+        SDL_DestroyCond( jobDoneEvent );
+        jobDoneEvent = NULL;
+    }
+}
+
+/*
+===============
+GLimp_RunJobs
+
+Calls function( data, i ) for every i below count and waits for
+all of them.  Only one thread may hand out jobs at a time.
+===============
+*/
+void GLimp_RunJobs( void (*function)( void *data, int index ), void *data, int count )
+{
+    int i;
+
+    if( !numJobThreads || count < 2 )
+    {
+        for( i = 0; i < count; i++ )
+            function( data, i );
+
+        return;
+    }
+
+    SDL_LockMutex( jobMutex );
+    {
+        jobFunction = function;
+        jobData = data;
+        jobNext = 0;
+        jobCount = count;
+        jobPending = count;
+        SDL_CondBroadcast( jobStartEvent );
+
+        // help out instead of just waiting
+        while( jobNext < jobCount )
+        {
+            i = jobNext++;
+            SDL_UnlockMutex( jobMutex );
+
+            function( data, i );
+
+            SDL_LockMutex( jobMutex );
+            jobPending--;
+        }
+
+        while( jobPending )
+            SDL_CondWait( jobDoneEvent, jobMutex );
+    }
+    SDL_UnlockMutex( jobMutex );
+}
+
+/*
+===============
+GLimp_NumJobThreads
+===============
+*/
+int GLimp_NumJobThreads( void )
+{
+    return numJobThreads;
+}
@@ -212,10 +212,12 @@ typedef struct client_s {
 // to make it a bit harder to DOS one single IP address from connecting
 // while not allowing a single ip to grab all challenge resources
 #define MAX_CHALLENGES_MULTI (MAX_CHALLENGES / 2)
+// challenges are chained by address hash, power of 2
+#define CHALLENGE_HASH_SIZE 1024
 
 #define AUTHORIZE_TIMEOUT   5000
 
-typedef struct {
+typedef struct challenge_s {
     netadr_t    adr;
     int         challenge;
     int         clientChallenge;        // challenge number coming from the client
@@ -224,6 +226,9 @@ typedef struct {
     int         firstTime;          // time the adr was first used, for authorize timeout checks
     qboolean    wasrefused;
     qboolean    connected;
+
+    int         hash;               // address hash chain + 1, 0 if not linked
+    struct challenge_s  *hashNext;
 } challenge_t;
 
 // this structure will be cleared only when the game dll changes
@@ -240,6 +245,8 @@ typedef struct {
     entityState_t   *snapshotEntities;      // [numSnapshotEntities]
     int         nextHeartbeatTime;
     challenge_t challenges[MAX_CHALLENGES]; // to prevent invalid IPs from connecting
+    challenge_t *challengeHash[CHALLENGE_HASH_SIZE];
+    int         nextChallenge;              // slot handed out by the next getchallenge
     netadr_t    redirectAddress;            // for rcon return messages
 #ifndef STANDALONE
     netadr_t    authorizeAddress;           // authorize server address
@@ -331,6 +338,7 @@ extern leakyBucket_t outboundLeakyBucket;
 
 qboolean SVC_RateLimit( leakyBucket_t *bucket, int burst, int period );
 qboolean SVC_RateLimitAddress( netadr_t from, int burst, int period );
+void SV_InvalidateQueryCache( void );
 
 void SV_FinalMessage (char *message);
 void QDECL SV_SendServerCommand( client_t *cl, const char *fmt, ...) __attribute__ ((format (printf, 2, 3)));
@@ -364,6 +372,7 @@ void SV_SpawnServer( char *server, qboolean killBots );
 // sv_client.c
 //
 void SV_GetChallenge(netadr_t from);
+void SV_RebuildBanTrie(void);
 
 void SV_DirectConnect( netadr_t from );
 
@@ -627,23 +627,18 @@ static void SV_BanNum_f( void ) {
 
 /*
 ==================
-SV_RehashBans_f
+SV_LoadBans
 
 Load saved bans from file.
 ==================
 */
-static void SV_RehashBans_f(void)
+static void SV_LoadBans(void)
 {
     int index, filelen;
     fileHandle_t readfrom;
     char *textbuf, *curpos, *maskpos, *newlinepos, *endpos;
     char filepath[MAX_QPATH];
 
-    // make sure server is running
-    if ( !com_sv_running->integer ) {
-        return;
-    }
-
     serverBansCount = 0;
 
     if(!sv_banFile->string || !*sv_banFile->string)
@@ -712,6 +707,22 @@ static void SV_RehashBans_f(void)
     }
 }
 
+/*
+==================
+SV_RehashBans_f
+==================
+*/
+static void SV_RehashBans_f(void)
+{
+    // make sure server is running
+    if ( !com_sv_running->integer ) {
+        return;
+    }
+
+    SV_LoadBans();
+    SV_RebuildBanTrie();
+}
+
 /*
 ==================
 SV_WriteBans
@@ -954,6 +965,7 @@ static void SV_AddBanToList(qboolean isexception)
 
     serverBansCount++;
 
+    SV_RebuildBanTrie();
     SV_WriteBans();
 
     Com_Printf("Added %s: %s/%d\n", isexception ? "ban exception" : "ban",
@@ -1048,6 +1060,7 @@ static void SV_DelBanFromList(qboolean isexception)
         }
     }
 
+    SV_RebuildBanTrie();
     SV_WriteBans();
 }
 
@@ -1114,6 +1127,7 @@ static void SV_FlushBans_f(void)
     }
 
     serverBansCount = 0;
+    SV_RebuildBanTrie();
 
     // empty the ban file.
     SV_WriteBans();
@@ -25,6 +25,90 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 static void SV_CloseDownload( client_t *cl );
 
+/*
+==============================================================================
+
+CHALLENGE HASHING
+
+Challenges are chained by a hash of their address so lookups for an
+address don't have to scan all of svs.challenges. An address that holds
+MAX_CHALLENGES_MULTI challenges reuses its oldest one, any other request
+takes a fresh slot. Those are handed out round robin, skipping connected
+clients, which reuses the oldest one just like searching for the
+smallest time did.
+
+==============================================================================
+*/
+
+static int SV_HashChallengeAdr(netadr_t *adr)
+{
+    unsigned int hash;
+    int i, len;
+    byte *addr;
+
+    if(adr->type == NA_IP6)
+    {
+        addr = adr->ip6;
+        len = sizeof(adr->ip6);
+    }
+    else
+    {
+        addr = adr->ip;
+        len = sizeof(adr->ip);
+    }
+
+    hash = adr->type * 31 + adr->port;
+    for(i = 0; i < len; i++)
+        hash = hash * 33 + addr[i];
+
+    return (hash ^ (hash >> 12)) & (CHALLENGE_HASH_SIZE - 1);
+}
+
+static void SV_UnlinkChallenge(challenge_t *challenge)
+{
+    challenge_t **link;
+
+    if(!challenge->hash)
+        return;
+
+    for(link = &svs.challengeHash[challenge->hash - 1]; *link; link = &(*link)->hashNext)
+    {
+        if(*link == challenge)
+        {
+            *link = challenge->hashNext;
+            break;
+        }
+    }
+    challenge->hashNext = NULL;
+    challenge->hash = 0;
+}
+
+/*
+=================
+SV_ClearChallenge
+=================
+*/
+static void SV_ClearChallenge(challenge_t *challenge)
+{
+    SV_UnlinkChallenge(challenge);
+    Com_Memset(challenge, 0, sizeof(*challenge));
+}
+
+/*
+=================
+SV_SetChallengeAdr
+=================
+*/
+static void SV_SetChallengeAdr(challenge_t *challenge, netadr_t adr)
+{
+    SV_UnlinkChallenge(challenge);
+
+    challenge->adr = adr;
+    challenge->hash = SV_HashChallengeAdr(&adr) + 1;
+    challenge->hashNext = svs.challengeHash[challenge->hash - 1];
+    svs.challengeHash[challenge->hash - 1] = challenge;
+}
+
 /*
 =================
 SV_GetChallenge
@@ -52,13 +136,12 @@ v4-only auth server for these new types of connections.
 */
 void SV_GetChallenge(netadr_t from)
 {
-    int     i;
-    int     oldest;
-    int     oldestTime;
     int     oldestClientTime;
     int     clientChallenge;
+    int     numClientChallenges;
+    int     i;
     challenge_t *challenge;
-    qboolean wasfound = qfalse;
+    challenge_t *oldestClient;
     char *gameName;
     qboolean gameMismatch;
 
@@ -99,45 +182,49 @@ void SV_GetChallenge(netadr_t from)
         return;
     }
 
-    oldest = 0;
-    oldestClientTime = oldestTime = 0x7fffffff;
+    oldestClient = NULL;
+    oldestClientTime = 0x7fffffff;
+    numClientChallenges = 0;
 
     // see if we already have a challenge for this ip
-    challenge = &svs.challenges[0];
     clientChallenge = atoi(Cmd_Argv(1));
 
-    for(i = 0 ; i < MAX_CHALLENGES ; i++, challenge++)
+    for(challenge = svs.challengeHash[SV_HashChallengeAdr(&from)]; challenge; challenge = challenge->hashNext)
     {
         if(!challenge->connected && NET_CompareAdr(from, challenge->adr))
         {
-            wasfound = qtrue;
+            numClientChallenges++;
 
             if(challenge->time < oldestClientTime)
+            {
                 oldestClientTime = challenge->time;
+                oldestClient = challenge;
+            }
         }
+    }
 
-        if(wasfound && i >= MAX_CHALLENGES_MULTI)
+    if(numClientChallenges >= MAX_CHALLENGES_MULTI)
+    {
+        // don't let a single address cycle out everyone else's challenges
+        challenge = oldestClient;
+    }
+    else
+    {
+        // take the oldest slot that no connected client uses
+        for(i = 0; i < MAX_CHALLENGES; i++)
         {
-            i = MAX_CHALLENGES;
-            break;
-        }
+            challenge = &svs.challenges[svs.nextChallenge];
+            svs.nextChallenge = (svs.nextChallenge + 1) % MAX_CHALLENGES;
 
-        if(challenge->time < oldestTime)
-        {
-            oldestTime = challenge->time;
-            oldest = i;
+            if(!challenge->connected)
+                break;
         }
     }
 
-    if (i == MAX_CHALLENGES)
-    {
-        // this is the first time this client has asked for a challenge
-        challenge = &svs.challenges[oldest];
-        challenge->clientChallenge = clientChallenge;
-        challenge->adr = from;
-        challenge->firstTime = svs.time;
-        challenge->connected = qfalse;
-    }
+    challenge->clientChallenge = clientChallenge;
+    SV_SetChallengeAdr(challenge, from);
+    challenge->firstTime = svs.time;
+    challenge->connected = qfalse;
 
     // always generate a new challenge number, so the client cannot circumvent sv_maxping
     challenge->challenge = ( ((unsigned int)rand() << 16) ^ (unsigned int)rand() ) ^ svs.time;
@@ -246,7 +333,7 @@ void SV_AuthorizeIpPacket( netadr_t from ) {
         // they are a demo client trying to connect to a real server
         NET_OutOfBandPrint( NS_SERVER, challengeptr->adr, "print\nServer is not a demo server\n" );
         // clear the challenge record so it won't timeout and let them through
-        Com_Memset( challengeptr, 0, sizeof( *challengeptr ) );
+        SV_ClearChallenge( challengeptr );
         return;
     }
     if ( !Q_stricmp( s, "accept" ) ) {
@@ -261,7 +348,7 @@ void SV_AuthorizeIpPacket( netadr_t from ) {
             NET_OutOfBandPrint( NS_SERVER, challengeptr->adr, "print\n%s\n", r);
         }
         // clear the challenge record so it won't timeout and let them through
-        Com_Memset( challengeptr, 0, sizeof( *challengeptr ) );
+        SV_ClearChallenge( challengeptr );
         return;
     }
 
@@ -273,10 +360,107 @@ void SV_AuthorizeIpPacket( netadr_t from ) {
     }
 
     // clear the challenge record so it won't timeout and let them through
-    Com_Memset( challengeptr, 0, sizeof(*challengeptr) );
+    SV_ClearChallenge( challengeptr );
 }
 #endif
 
+/*
+==============================================================================
+
+BAN MATCHING
+
+serverBans is mirrored into a binary prefix trie per address family, so
+checking a connecting address walks down its bits once instead of doing a
+CIDR compare against every entry.
+
+==============================================================================
+*/
+
+#define BANTRIE_BAN         1
+#define BANTRIE_EXCEPTION   2
+
+typedef struct {
+    int     child[2];       // 0 if there is none
+    int     flags;          // BANTRIE_* of the entries ending on this prefix
+} banTrieNode_t;
+
+static banTrieNode_t    *banTrie;
+static int              banTrieRoots[2];    // NA_IP, NA_IP6
+static int              banTrieLoopback;    // flags of loopback entries
+
+/*
+==================
+SV_RebuildBanTrie
+
+Must be called whenever serverBans changes
+==================
+*/
+void SV_RebuildBanTrie(void)
+{
+    int index, numNodes, maxNodes;
+    int bit, bits, node, *child;
+    serverBan_t *curban;
+    byte *addr;
+
+    if(banTrie)
+        Z_Free(banTrie);
+    banTrie = NULL;
+    banTrieLoopback = 0;
+
+    if(!serverBansCount)
+        return;
+
+    // node 0 is the null child, then one root per family and at most
+    // one new node per prefix bit
+    maxNodes = 3;
+    for(index = 0; index < serverBansCount; index++)
+        maxNodes += (serverBans[index].ip.type == NA_IP6) ? 128 : 32;
+
+    banTrie = Z_Malloc(maxNodes * sizeof(*banTrie));
+    banTrieRoots[0] = 1;
+    banTrieRoots[1] = 2;
+    numNodes = 3;
+
+    for(index = 0; index < serverBansCount; index++)
+    {
+        curban = &serverBans[index];
+
+        if(curban->ip.type == NA_LOOPBACK)
+        {
+            banTrieLoopback |= curban->isexception ? BANTRIE_EXCEPTION : BANTRIE_BAN;
+            continue;
+        }
+
+        // same clamping as NET_CompareBaseAdrMask
+        if(curban->ip.type == NA_IP)
+        {
+            addr = curban->ip.ip;
+            node = banTrieRoots[0];
+            bits = (curban->subnet < 0 || curban->subnet > 32) ? 32 : curban->subnet;
+        }
+        else if(curban->ip.type == NA_IP6)
+        {
+            addr = curban->ip.ip6;
+            node = banTrieRoots[1];
+            bits = (curban->subnet < 0 || curban->subnet > 128) ? 128 : curban->subnet;
+        }
+        else
+            continue;
+
+        for(bit = 0; bit < bits; bit++)
+        {
+            child = &banTrie[node].child[(addr[bit >> 3] >> (7 - (bit & 7))) & 1];
+
+            if(!*child)
+                *child = numNodes++;
+
+            node = *child;
+        }
+
+        banTrie[node].flags |= curban->isexception ? BANTRIE_EXCEPTION : BANTRIE_BAN;
+    }
+}
+
 /*
 ==================
 SV_IsBanned
@@ -287,28 +471,49 @@ Check whether a certain address is banned
 
 static qboolean SV_IsBanned(netadr_t *from, qboolean isexception)
 {
-    int index;
-    serverBan_t *curban;
+    int bit, bits, node, flags;
+    byte *addr;
 
-    if(!isexception)
-    {
-        // If this is a query for a ban, first check whether the client is excepted
-        if(SV_IsBanned(from, qtrue))
-            return qfalse;
-    }
+    if(!banTrie)
+        return qfalse;
 
-    for(index = 0; index < serverBansCount; index++)
+    if(from->type == NA_LOOPBACK)
+        flags = banTrieLoopback;
+    else
     {
-        curban = &serverBans[index];
+        if(from->type == NA_IP)
+        {
+            addr = from->ip;
+            node = banTrieRoots[0];
+            bits = 32;
+        }
+        else if(from->type == NA_IP6)
+        {
+            addr = from->ip6;
+            node = banTrieRoots[1];
+            bits = 128;
+        }
+        else
+            return qfalse;
 
-        if(curban->isexception == isexception)
+        // collect every ban and exception along the address prefix
+        flags = banTrie[node].flags;
+        for(bit = 0; bit < bits; bit++)
         {
-            if(NET_CompareBaseAdrMask(curban->ip, *from, curban->subnet))
-                return qtrue;
+            node = banTrie[node].child[(addr[bit >> 3] >> (7 - (bit & 7))) & 1];
+
+            if(!node)
+                break;
+
+            flags |= banTrie[node].flags;
         }
     }
 
-    return qfalse;
+    if(isexception)
+        return (flags & BANTRIE_EXCEPTION) != 0;
+
+    // an exception always wins over a ban
+    return (flags & BANTRIE_BAN) && !(flags & BANTRIE_EXCEPTION);
 }
 
 /*
@@ -405,22 +610,22 @@ void SV_DirectConnect( netadr_t from ) {
         int ping;
         challenge_t *challengeptr;
 
-        for (i=0; i<MAX_CHALLENGES; i++)
+        for (challengeptr = svs.challengeHash[SV_HashChallengeAdr(&from)]; challengeptr; challengeptr = challengeptr->hashNext)
         {
-            if (NET_CompareAdr(from, svs.challenges[i].adr))
+            if (NET_CompareAdr(from, challengeptr->adr))
             {
-                if(challenge == svs.challenges[i].challenge)
+                if(challenge == challengeptr->challenge)
                     break;
             }
         }
 
-        if (i == MAX_CHALLENGES)
+        if (!challengeptr)
         {
             NET_OutOfBandPrint( NS_SERVER, from, "print\nNo or bad challenge for your address.\n" );
             return;
         }
 
-        challengeptr = &svs.challenges[i];
+        i = challengeptr - svs.challenges;
 
         if(challengeptr->wasrefused)
         {
@@ -644,13 +849,11 @@ void SV_DropClient( client_t *drop, const char *reason ) {
 
     if ( !isBot ) {
         // see if we already have a challenge for this ip
-        challenge = &svs.challenges[0];
-
-        for (i = 0 ; i < MAX_CHALLENGES ; i++, challenge++)
+        for (challenge = svs.challengeHash[SV_HashChallengeAdr(&drop->netchan.remoteAddress)]; challenge; challenge = challenge->hashNext)
         {
             if(NET_CompareAdr(drop->netchan.remoteAddress, challenge->adr))
             {
-                Com_Memset(challenge, 0, sizeof(*challenge));
+                SV_ClearChallenge(challenge);
                 break;
             }
         }
@@ -1395,6 +1598,7 @@ void SV_UserinfoChanged( client_t *cl ) {
 
     // name for C code
     Q_strncpyz( cl->name, Info_ValueForKey (cl->userinfo, "name"), sizeof(cl->name) );
+    SV_InvalidateQueryCache();
 
     // rate command
 
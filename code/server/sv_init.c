@@ -124,6 +124,8 @@ void SV_SetConfigstring (int index, const char *val) {
     Z_Free( sv.configstrings[index] );
     sv.configstrings[index] = CopyString( val );
 
+    SV_InvalidateQueryCache();
+
     // send it to all the clients if we aren't
     // spawning a new server
     if ( sv.state == SS_GAME || sv.restarting ) {
@@ -515,6 +515,81 @@ qboolean SVC_RateLimitAddress( netadr_t from, int burst, int period ) {
     return SVC_RateLimit( bucket, burst, period );
 }
 
+/*
+==============================================================================
+
+CONNECTIONLESS QUERY CACHE
+
+infoResponse and statusResponse are built from server info cvars and the
+player list, which change far less often than servers get polled, so the
+text is rendered once and reused with only the caller's challenge spliced in.
+
+==============================================================================
+*/
+
+typedef struct {
+    qboolean    infoValid;
+    int         infoCount;
+    int         infoHumans;
+    int         infoNeedPass;
+    char        info[MAX_INFO_STRING];          // infoResponse minus challenge
+
+    qboolean    statusValid;
+    int         statusNumClients;
+    qboolean    statusConnected[MAX_CLIENTS];
+    int         statusScores[MAX_CLIENTS];
+    int         statusPings[MAX_CLIENTS];
+    char        statusInfo[MAX_INFO_STRING];    // serverinfo minus challenge
+    char        status[MAX_MSGLEN];             // player lines
+} queryCache_t;
+
+static queryCache_t svQueryCache;
+
+/*
+================
+SV_InvalidateQueryCache
+
+Called whenever something that shows up in getinfo / getstatus
+responses changes outside of the per-request checks below.
+================
+*/
+void SV_InvalidateQueryCache( void ) {
+    svQueryCache.infoValid = qfalse;
+    svQueryCache.statusValid = qfalse;
+}
+
+/*
+================
+SV_CheckQueryCvars
+
+Server info cvars are reported through cvar_modifiedFlags, which the
+frame loop clears only after it has pushed them into configstrings.
+================
+*/
+static void SV_CheckQueryCvars( void ) {
+    if ( cvar_modifiedFlags & ( CVAR_SERVERINFO | CVAR_SYSTEMINFO ) ) {
+        SV_InvalidateQueryCache();
+    }
+}
+
+/*
+================
+SV_ValidChallengeValue
+
+Mirrors the checks Info_SetValueForKey does so the challenge can be
+appended directly without echoing anything it would have rejected.
+================
+*/
+static qboolean SV_ValidChallengeValue( const char *s ) {
+    if ( !*s ) {
+        return qfalse;
+    }
+    if ( strchr( s, '\\' ) || strchr( s, ';' ) || strchr( s, '\"' ) ) {
+        return qfalse;
+    }
+    return qtrue;
+}
+
 /*
 ================
 SVC_Status
@@ -526,12 +601,13 @@ the simple info query.
 */
 static void SVC_Status( netadr_t from ) {
     char    player[1024];
-    char    status[MAX_MSGLEN];
     int     i;
     client_t    *cl;
     playerState_t   *ps;
     int     statusLength;
     int     playerLength;
+    qboolean    full;
+    char    *challenge;
     char    infostring[MAX_INFO_STRING];
 
     // ignore if we are in single player
@@ -554,34 +630,80 @@ static void SVC_Status( netadr_t from ) {
     }
 
     // A maximum challenge length of 128 should be more than plenty.
-    if(strlen(Cmd_Argv(1)) > 128)
+    challenge = Cmd_Argv(1);
+    if(strlen(challenge) > 128)
         return;
 
-    strcpy( infostring, Cvar_InfoString( CVAR_SERVERINFO ) );
-
-    // echo back the parameter to status. so master servers can use it as a challenge
-    // to prevent timed spoofed reply packets that add ghost servers
-    Info_SetValueForKey( infostring, "challenge", Cmd_Argv(1) );
-
-    status[0] = 0;
-    statusLength = 0;
+    SV_CheckQueryCvars();
 
-    for (i=0 ; i < sv_maxclients->integer ; i++) {
-        cl = &svs.clients[i];
-        if ( cl->state >= CS_CONNECTED ) {
+    // the player list is cheap to compare against, so the cache is
+    // checked here instead of hooking every score and ping update
+    if ( svQueryCache.statusValid && svQueryCache.statusNumClients == sv_maxclients->integer ) {
+        for ( i = 0 ; i < sv_maxclients->integer ; i++ ) {
+            cl = &svs.clients[i];
+            if ( ( cl->state >= CS_CONNECTED ) != svQueryCache.statusConnected[i] ) {
+                break;
+            }
+            if ( !svQueryCache.statusConnected[i] ) {
+                continue;
+            }
             ps = SV_GameClientNum( i );
-            Com_sprintf (player, sizeof(player), "%i %i \"%s\"\n",
-                ps->persistant[PERS_SCORE], cl->ping, cl->name);
-            playerLength = strlen(player);
-            if (statusLength + playerLength >= sizeof(status) ) {
-                break;      // can't hold any more
+            if ( ps->persistant[PERS_SCORE] != svQueryCache.statusScores[i] ||
+                cl->ping != svQueryCache.statusPings[i] ) {
+                break;
+            }
+        }
+        if ( i != sv_maxclients->integer ) {
+            svQueryCache.statusValid = qfalse;
+        }
+    } else {
+        svQueryCache.statusValid = qfalse;
+    }
+
+    if ( !svQueryCache.statusValid ) {
+        Q_strncpyz( svQueryCache.statusInfo, Cvar_InfoString( CVAR_SERVERINFO ), sizeof( svQueryCache.statusInfo ) );
+        Info_RemoveKey( svQueryCache.statusInfo, "challenge" );
+
+        svQueryCache.status[0] = 0;
+        statusLength = 0;
+        full = qfalse;
+
+        for (i=0 ; i < sv_maxclients->integer ; i++) {
+            cl = &svs.clients[i];
+            svQueryCache.statusConnected[i] = ( cl->state >= CS_CONNECTED );
+            if ( svQueryCache.statusConnected[i] ) {
+                ps = SV_GameClientNum( i );
+                svQueryCache.statusScores[i] = ps->persistant[PERS_SCORE];
+                svQueryCache.statusPings[i] = cl->ping;
+                if ( full ) {
+                    continue;       // keep tracking for the cache check
+                }
+                Com_sprintf (player, sizeof(player), "%i %i \"%s\"\n",
+                    ps->persistant[PERS_SCORE], cl->ping, cl->name);
+                playerLength = strlen(player);
+                if (statusLength + playerLength >= sizeof(svQueryCache.status) ) {
+                    full = qtrue;   // can't hold any more
+                    continue;
+                }
+                strcpy (svQueryCache.status + statusLength, player);
+                statusLength += playerLength;
             }
-            strcpy (status + statusLength, player);
-            statusLength += playerLength;
         }
+
+        svQueryCache.statusNumClients = sv_maxclients->integer;
+        svQueryCache.statusValid = qtrue;
+    }
+
+    // echo back the parameter to status. so master servers can use it as a challenge
+    // to prevent timed spoofed reply packets that add ghost servers
+    if ( SV_ValidChallengeValue( challenge ) &&
+        strlen( svQueryCache.statusInfo ) + strlen( challenge ) + 11 < sizeof( infostring ) ) {
+        Com_sprintf( infostring, sizeof( infostring ), "\\challenge\\%s%s", challenge, svQueryCache.statusInfo );
+    } else {
+        Q_strncpyz( infostring, svQueryCache.statusInfo, sizeof( infostring ) );
     }
 
-    NET_OutOfBandPrint( NS_SERVER, from, "statusResponse\n%s\n%s", infostring, status );
+    NET_OutOfBandPrint( NS_SERVER, from, "statusResponse\n%s\n%s", infostring, svQueryCache.status );
 }
 
 /*
@@ -593,9 +715,10 @@ if a user is interested in a server to do a full status
 ================
 */
 void SVC_Info( netadr_t from ) {
-    int     i, count, humans;
+    int     i, count, humans, needpass;
     char    *gamedir;
-    char    infostring[MAX_INFO_STRING];
+    char    *challenge;
+    char    *infostring;
 
     // ignore if we are in single player
     if ( Cvar_VariableValue( "g_gametype" ) == GT_SINGLE_PLAYER || Cvar_VariableValue("ui_singlePlayerActive")) {
@@ -622,7 +745,8 @@ void SVC_Info( netadr_t from ) {
      */
 
     // A maximum challenge length of 128 should be more than plenty.
-    if(strlen(Cmd_Argv(1)) > 128)
+    challenge = Cmd_Argv(1);
+    if(strlen(challenge) > 128)
         return;
 
     // don't count privateclients
@@ -636,49 +760,68 @@ void SVC_Info( netadr_t from ) {
         }
     }
 
-    infostring[0] = 0;
+    // g_needpass is owned by the game module and need not be a serverinfo cvar
+    needpass = Cvar_VariableIntegerValue("g_needpass");
 
-    // echo back the parameter to status. so servers can use it as a challenge
-    // to prevent timed spoofed reply packets that add ghost servers
-    Info_SetValueForKey( infostring, "challenge", Cmd_Argv(1) );
+    SV_CheckQueryCvars();
+
+    if ( !svQueryCache.infoValid || count != svQueryCache.infoCount ||
+        humans != svQueryCache.infoHumans || needpass != svQueryCache.infoNeedPass ) {
+        infostring = svQueryCache.info;
+        infostring[0] = 0;
 
-    Info_SetValueForKey( infostring, "gamename", com_gamename->string );
+        Info_SetValueForKey( infostring, "gamename", com_gamename->string );
 
 #ifdef LEGACY_PROTOCOL
-    if(com_legacyprotocol->integer > 0)
-        Info_SetValueForKey(infostring, "protocol", va("%i", com_legacyprotocol->integer));
-    else
+        if(com_legacyprotocol->integer > 0)
+            Info_SetValueForKey(infostring, "protocol", va("%i", com_legacyprotocol->integer));
+        else
 #endif
-        Info_SetValueForKey(infostring, "protocol", va("%i", com_protocol->integer));
-
-    Info_SetValueForKey( infostring, "hostname", sv_hostname->string );
-    Info_SetValueForKey( infostring, "mapname", sv_mapname->string );
-    Info_SetValueForKey( infostring, "clients", va("%i", count) );
-    Info_SetValueForKey(infostring, "g_humanplayers", va("%i", humans));
-    Info_SetValueForKey( infostring, "sv_maxclients",
-        va("%i", sv_maxclients->integer - sv_privateClients->integer ) );
-    Info_SetValueForKey( infostring, "gametype", va("%i", sv_gametype->integer ) );
-    Info_SetValueForKey( infostring, "pure", va("%i", sv_pure->integer ) );
-    Info_SetValueForKey(infostring, "g_needpass", va("%d", Cvar_VariableIntegerValue("g_needpass")));
+            Info_SetValueForKey(infostring, "protocol", va("%i", com_protocol->integer));
+
+        Info_SetValueForKey( infostring, "hostname", sv_hostname->string );
+        Info_SetValueForKey( infostring, "mapname", sv_mapname->string );
+        Info_SetValueForKey( infostring, "clients", va("%i", count) );
+        Info_SetValueForKey(infostring, "g_humanplayers", va("%i", humans));
+        Info_SetValueForKey( infostring, "sv_maxclients",
+            va("%i", sv_maxclients->integer - sv_privateClients->integer ) );
+        Info_SetValueForKey( infostring, "gametype", va("%i", sv_gametype->integer ) );
+        Info_SetValueForKey( infostring, "pure", va("%i", sv_pure->integer ) );
+        Info_SetValueForKey(infostring, "g_needpass", va("%d", needpass));
 
 #ifdef USE_VOIP
-    if (sv_voipProtocol->string && *sv_voipProtocol->string) {
-        Info_SetValueForKey( infostring, "voip", sv_voipProtocol->string );
-    }
+        if (sv_voipProtocol->string && *sv_voipProtocol->string) {
+            Info_SetValueForKey( infostring, "voip", sv_voipProtocol->string );
+        }
 #endif
 
-    if( sv_minPing->integer ) {
-        Info_SetValueForKey( infostring, "minPing", va("%i", sv_minPing->integer) );
-    }
-    if( sv_maxPing->integer ) {
-        Info_SetValueForKey( infostring, "maxPing", va("%i", sv_maxPing->integer) );
-    }
-    gamedir = Cvar_VariableString( "fs_game" );
-    if( *gamedir ) {
-        Info_SetValueForKey( infostring, "game", gamedir );
+        if( sv_minPing->integer ) {
+            Info_SetValueForKey( infostring, "minPing", va("%i", sv_minPing->integer) );
+        }
+        if( sv_maxPing->integer ) {
+            Info_SetValueForKey( infostring, "maxPing", va("%i", sv_maxPing->integer) );
+        }
+        gamedir = Cvar_VariableString( "fs_game" );
+        if( *gamedir ) {
+            Info_SetValueForKey( infostring, "game", gamedir );
+        }
+
+        svQueryCache.infoCount = count;
+        svQueryCache.infoHumans = humans;
+        svQueryCache.infoNeedPass = needpass;
+        svQueryCache.infoValid = qtrue;
     }
 
-    NET_OutOfBandPrint( NS_SERVER, from, "infoResponse\n%s", infostring );
+    // echo back the parameter to status. so servers can use it as a challenge
+    // to prevent timed spoofed reply packets that add ghost servers.
+    // Info_SetValueForKey prepends, so the challenge set first always ended
+    // up last in the string.
+    if ( SV_ValidChallengeValue( challenge ) &&
+        strlen( svQueryCache.info ) + strlen( challenge ) + 11 < MAX_INFO_STRING ) {
+        NET_OutOfBandPrint( NS_SERVER, from, "infoResponse\n%s\\challenge\\%s", svQueryCache.info, challenge );
+    } else {
+        NET_OutOfBandPrint( NS_SERVER, from, "infoResponse\n%s", svQueryCache.info );
+    }
 }
 
 /*
@@ -256,6 +256,80 @@ qboolean Sys_Mkdir( const char *path )
     return qtrue;
 }
 
+/*
+==================
+Sys_StatFile
+
+Size and modification time of a regular file
+==================
+*/
+qboolean Sys_StatFile( const char *ospath, int *size, int *mtime )
+{
+    struct stat buf;
+
+    if( stat( ospath, &buf ) || !S_ISREG( buf.st_mode ) )
+        return qfalse;
+
+    *size = (int)buf.st_size;
+    *mtime = (int)buf.st_mtime;
+    return qtrue;
+}
+
+/*
+==================
+Sys_MapFile
+
+Maps length bytes at offset of an open file copy-on-write, so the view
+can be modified without touching the file. The byte following the data
+is set to 0, which is only possible if it still lies within the file or
+within the last page of it. Returns NULL if the file can't be mapped.
+==================
+*/
+void *Sys_MapFile( FILE *f, int offset, int length, void **mapBase, int *mapSize )
+{
+    struct stat buf;
+    long    page;
+    int     aligned, size;
+    byte    *p;
+
+    if( fstat( fileno( f ), &buf ) )
+        return NULL;
+
+    page = sysconf( _SC_PAGESIZE );
+    if( page <= 0 )
+        return NULL;
+
+    size = length;
+    if( offset + length < buf.st_size )
+        size++;
+    else if( offset + length > buf.st_size || !( buf.st_size % page ) )
+        return NULL;
+
+    aligned = offset - offset % page;
+    size += offset - aligned;
+
+    p = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno( f ), aligned );
+    if( p == MAP_FAILED )
+        return NULL;
+
+    *mapBase = p;
+    *mapSize = size;
+
+    p += offset - aligned;
+    p[length] = 0;
+    return p;
+}
+
+/*
+==================
+Sys_UnmapFile
+==================
+*/
+void Sys_UnmapFile( void *mapBase, int mapSize )
+{
+    munmap( mapBase, mapSize );
+}
+
 /*
 ==================
 Sys_Mkfifo
@@ -38,6 +38,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <shlobj.h>
 #include <psapi.h>
 #include <float.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #ifndef KEY_WOW64_32KEY
 #define KEY_WOW64_32KEY 0x0200
@@ -384,6 +386,86 @@ qboolean Sys_Mkdir( const char *path )
     return qtrue;
 }
 
+/*
+==================
+Sys_StatFile
+
+Size and modification time of a regular file
+==================
+*/
+qboolean Sys_StatFile( const char *ospath, int *size, int *mtime )
+{
+    struct _stat buf;
+
+    if( _stat( ospath, &buf ) || !( buf.st_mode & _S_IFREG ) )
+        return qfalse;
+
+    *size = (int)buf.st_size;
+    *mtime = (int)buf.st_mtime;
+    return qtrue;
+}
+
+/*
+==================
+Sys_MapFile
+
+Maps length bytes at offset of an open file copy-on-write, so the view
+can be modified without touching the file. The byte following the data
+is set to 0, which is only possible if it still lies within the file or
+within the last page of it. Returns NULL if the file can't be mapped.
+==================
+*/
+void *Sys_MapFile( FILE *f, int offset, int length, void **mapBase, int *mapSize )
+{
+    SYSTEM_INFO si;
+    HANDLE  file, mapping;
+    LARGE_INTEGER fileSize;
+    int     aligned, size;
+    byte    *p;
+
+    file = (HANDLE)_get_osfhandle( _fileno( f ) );
+    if( file == INVALID_HANDLE_VALUE || !GetFileSizeEx( file, &fileSize ) )
+        return NULL;
+
+    GetSystemInfo( &si );
+
+    // views are whole pages, so the terminator may land in the slack
+    // after the end of the file
+    size = length;
+    if( offset + length < fileSize.QuadPart )
+        size++;
+    else if( offset + length > fileSize.QuadPart || !( fileSize.QuadPart % si.dwPageSize ) )
+        return NULL;
+
+    aligned = offset - offset % si.dwAllocationGranularity;
+
+    mapping = CreateFileMapping( file, NULL, PAGE_WRITECOPY, 0, 0, NULL );
+    if( !mapping )
+        return NULL;
+
+    p = MapViewOfFile( mapping, FILE_MAP_COPY, 0, aligned, ( offset - aligned ) + size );
+    CloseHandle( mapping );
+    if( !p )
+        return NULL;
+
+    *mapBase = p;
+    *mapSize = ( offset - aligned ) + size;
+
+    p += offset - aligned;
+    p[length] = 0;
+    return p;
+}
+
+/*
+==================
+Sys_UnmapFile
+==================
+*/
+void Sys_UnmapFile( void *mapBase, int mapSize )
+{
+    UnmapViewOfFile( mapBase );
+}
+
 /*
 ==================
 Sys_Mkfifo